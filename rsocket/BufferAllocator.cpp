@@ -0,0 +1,129 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/BufferAllocator.h"
+
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventBaseLocal.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace rsocket {
+
+namespace {
+
+class HeapBufferAllocator : public BufferAllocator {
+ public:
+  std::unique_ptr<folly::IOBuf> allocate(size_t size) override {
+    return folly::IOBuf::createCombined(size);
+  }
+};
+
+constexpr size_t kSlabAlignment = alignof(std::max_align_t);
+
+size_t alignUp(size_t size) {
+  return (size + kSlabAlignment - 1) & ~(kSlabAlignment - 1);
+}
+
+} // namespace
+
+const std::shared_ptr<BufferAllocator>& BufferAllocator::heap() {
+  static const std::shared_ptr<BufferAllocator> allocator =
+      std::make_shared<HeapBufferAllocator>();
+  return allocator;
+}
+
+constexpr size_t SlabBufferAllocator::kDefaultSlabSize;
+constexpr size_t SlabBufferAllocator::kDefaultMaxAllocationSize;
+
+/// Header placed in front of the memory of every slab.  The allocator holds
+/// one reference to the slab it is currently carving from, and every buffer
+/// carved out of it holds another.
+struct SlabBufferAllocator::Slab {
+  std::atomic<size_t> refs{1};
+
+  static Slab* create(size_t size) {
+    auto mem = std::malloc(alignUp(sizeof(Slab)) + size);
+    if (!mem) {
+      throw std::bad_alloc();
+    }
+    return new (mem) Slab;
+  }
+
+  uint8_t* data() {
+    return reinterpret_cast<uint8_t*>(this) + alignUp(sizeof(Slab));
+  }
+
+  void decref() {
+    if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      this->~Slab();
+      std::free(this);
+    }
+  }
+};
+
+SlabBufferAllocator::SlabBufferAllocator(
+    size_t slabSize,
+    size_t maxAllocationSize)
+    : slabSize_{alignUp(slabSize)},
+      maxAllocationSize_{std::min(maxAllocationSize, slabSize_)} {}
+
+SlabBufferAllocator::~SlabBufferAllocator() {
+  if (current_) {
+    current_->decref();
+  }
+}
+
+std::unique_ptr<folly::IOBuf> SlabBufferAllocator::allocate(size_t size) {
+  if (size == 0 || size > maxAllocationSize_) {
+    ++heapAllocations_;
+    return folly::IOBuf::createCombined(size);
+  }
+
+  const auto aligned = alignUp(size);
+  if (!current_ || offset_ + aligned > slabSize_) {
+    if (current_) {
+      current_->decref();
+    }
+    current_ = Slab::create(slabSize_);
+    offset_ = 0;
+    ++slabs_;
+  }
+
+  auto const slab = current_;
+  auto const data = slab->data() + offset_;
+  offset_ += aligned;
+  ++slabAllocations_;
+
+  slab->refs.fetch_add(1, std::memory_order_relaxed);
+  return folly::IOBuf::takeOwnership(
+      data, aligned, 0, &SlabBufferAllocator::release, slab);
+}
+
+void SlabBufferAllocator::release(void*, void* userData) {
+  static_cast<Slab*>(userData)->decref();
+}
+
+std::shared_ptr<SlabBufferAllocator> SlabBufferAllocator::forEventBase(
+    folly::EventBase& evb) {
+  static folly::EventBaseLocal<std::shared_ptr<SlabBufferAllocator>> local;
+  return local.getOrCreateFn(
+      evb, [] { return std::make_shared<SlabBufferAllocator>(); });
+}
+
+} // namespace rsocket
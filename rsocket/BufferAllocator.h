@@ -0,0 +1,107 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/io/IOBuf.h>
+
+#include <functional>
+#include <memory>
+
+namespace folly {
+class EventBase;
+}
+
+namespace rsocket {
+
+/// Hook used by Payload and FrameSerializer to get memory for new buffers.
+///
+/// The buffers handed out must be unshared and have at least the requested
+/// amount of tailroom.  They can be released on any thread.
+class BufferAllocator {
+ public:
+  virtual ~BufferAllocator() = default;
+
+  virtual std::unique_ptr<folly::IOBuf> allocate(size_t size) = 0;
+
+  /// Allocator that creates every buffer with IOBuf::createCombined().  Used
+  /// when nothing else is configured.
+  static const std::shared_ptr<BufferAllocator>& heap();
+};
+
+/// Produces the allocator a connection running on the given EventBase should
+/// use.  Invoked on that EventBase.
+using BufferAllocatorFactory =
+    std::function<std::shared_ptr<BufferAllocator>(folly::EventBase&)>;
+
+/// Carves small buffers out of large slabs.  A slab is returned to the heap in
+/// one go once every buffer carved out of it has been released, so the
+/// per-frame cost is a pointer bump instead of a trip through malloc for the
+/// data.
+///
+/// Allocation is not thread safe: an instance is meant to be shared by all the
+/// connections of one EventBase, see forEventBase().  Buffers may be released
+/// from any thread.
+class SlabBufferAllocator : public BufferAllocator {
+ public:
+  static constexpr size_t kDefaultSlabSize{64 * 1024};
+  static constexpr size_t kDefaultMaxAllocationSize{1024};
+
+  explicit SlabBufferAllocator(
+      size_t slabSize = kDefaultSlabSize,
+      size_t maxAllocationSize = kDefaultMaxAllocationSize);
+  ~SlabBufferAllocator() override;
+
+  SlabBufferAllocator(const SlabBufferAllocator&) = delete;
+  SlabBufferAllocator& operator=(const SlabBufferAllocator&) = delete;
+
+  /// Requests larger than maxAllocationSize fall back to the heap.
+  std::unique_ptr<folly::IOBuf> allocate(size_t size) override;
+
+  /// Allocator shared by every connection on the given EventBase.  Must be
+  /// called from the EventBase's thread.
+  static std::shared_ptr<SlabBufferAllocator> forEventBase(folly::EventBase&);
+
+  /// Number of buffers carved out of slabs.
+  size_t slabAllocations() const {
+    return slabAllocations_;
+  }
+
+  /// Number of buffers that fell back to the heap.
+  size_t heapAllocations() const {
+    return heapAllocations_;
+  }
+
+  /// Number of slabs allocated over the lifetime of the allocator.
+  size_t slabs() const {
+    return slabs_;
+  }
+
+ private:
+  struct Slab;
+
+  static void release(void* buf, void* userData);
+
+  const size_t slabSize_;
+  const size_t maxAllocationSize_;
+
+  Slab* current_{nullptr};
+  size_t offset_{0};
+
+  size_t slabAllocations_{0};
+  size_t heapAllocations_{0};
+  size_t slabs_{0};
+};
+
+} // namespace rsocket
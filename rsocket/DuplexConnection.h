@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <functional>
+#include <limits>
 #include <memory>
 
 #include <folly/io/IOBuf.h>
@@ -22,6 +24,15 @@
 
 namespace rsocket {
 
+/// Thresholds on the number of bytes a connection buffers for sending.
+struct WriteWatermarks {
+  /// The connection becomes writable again once the buffered bytes drained
+  /// down to this.
+  size_t low{0};
+  /// The connection becomes unwritable once more than this is buffered.
+  size_t high{std::numeric_limits<size_t>::max()};
+};
+
 /// Represents a connection of the underlying protocol, on top of which the
 /// RSocket protocol is layered.  The underlying protocol MUST provide an
 /// ordered, guaranteed, bidirectional transport of frames.  Moreover, frame
@@ -41,6 +52,10 @@ class DuplexConnection {
  public:
   using Subscriber = yarpl::flowable::Subscriber<std::unique_ptr<folly::IOBuf>>;
 
+  /// Called with false when the connection becomes unwritable and with true
+  /// when it becomes writable again.
+  using WritabilityCallback = std::function<void(bool writable)>;
+
   virtual ~DuplexConnection() = default;
 
   /// Sets a Subscriber that will consume received frames (a reader).
@@ -54,6 +69,13 @@ class DuplexConnection {
   /// Does nothing if the underlying connection is closed.
   virtual void send(std::unique_ptr<folly::IOBuf>) = 0;
 
+  /// Reports when the bytes buffered for sending cross the watermarks.  Frames
+  /// passed to send() while unwritable are still buffered, it is up to the
+  /// caller to stop producing them.
+  ///
+  /// Connections that don't buffer outgoing data never call the callback.
+  virtual void setWriteWatermarks(WriteWatermarks, WritabilityCallback) {}
+
   /// Whether the duplex connection respects frame boundaries.
   virtual bool isFramed() const {
     return false;
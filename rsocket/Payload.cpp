@@ -17,7 +17,11 @@
 #include <folly/String.h>
 #include <folly/io/Cursor.h>
 
+#include <cstring>
+
+#include "rsocket/BufferAllocator.h"
 #include "rsocket/internal/Common.h"
+#include "rsocket/internal/FileRange.h"
 
 namespace rsocket {
 
@@ -31,6 +35,19 @@ std::string cloneIOBufToString(std::unique_ptr<folly::IOBuf> const& buf) {
   return buf ? buf->cloneAsValue().moveToFbString().toStdString() : "";
 }
 
+std::unique_ptr<folly::IOBuf> copyBuffer(
+    folly::StringPiece str,
+    BufferAllocator& allocator,
+    size_t headroom = 0) {
+  auto buf = allocator.allocate(headroom + str.size());
+  buf->advance(headroom);
+  if (!str.empty()) {
+    std::memcpy(buf->writableTail(), str.data(), str.size());
+    buf->append(str.size());
+  }
+  return buf;
+}
+
 } // namespace
 
 Payload::Payload(
@@ -45,6 +62,44 @@ Payload::Payload(folly::StringPiece d, folly::StringPiece m)
   }
 }
 
+Payload::Payload(
+    folly::StringPiece d,
+    folly::StringPiece m,
+    BufferAllocator& allocator)
+    : data{copyBuffer(d, allocator)} {
+  if (!m.empty()) {
+    metadata = copyBuffer(m, allocator);
+  }
+}
+
+constexpr size_t Payload::kFrameHeadroom;
+
+Payload Payload::withFrameHeadroom(
+    folly::StringPiece d,
+    folly::StringPiece m,
+    BufferAllocator* allocator) {
+  auto& alloc = allocator ? *allocator : *BufferAllocator::heap();
+
+  // The header is written in front of the first buffer of the frame, which is
+  // the metadata when there is any.
+  Payload payload;
+  if (m.empty()) {
+    payload.data = copyBuffer(d, alloc, kFrameHeadroom);
+  } else {
+    payload.metadata = copyBuffer(m, alloc, kFrameHeadroom);
+    payload.data = copyBuffer(d, alloc);
+  }
+  return payload;
+}
+
+Payload Payload::fromFile(
+    const folly::File& file,
+    off_t offset,
+    size_t length,
+    std::unique_ptr<folly::IOBuf> metadata) {
+  return Payload(mapFileRange(file, offset, length), std::move(metadata));
+}
+
 std::ostream& operator<<(std::ostream& os, const Payload& payload) {
   return os << "Metadata("
             << (payload.metadata ? payload.metadata->computeChainDataLength()
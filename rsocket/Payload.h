@@ -15,11 +15,18 @@
 #pragma once
 
 #include <folly/io/IOBuf.h>
+#include <sys/types.h>
 #include <memory>
 #include <string>
 
+namespace folly {
+class File;
+}
+
 namespace rsocket {
 
+class BufferAllocator;
+
 /// The type of a read-only view on a binary buffer.
 /// MUST manage the lifetime of the underlying buffer.
 struct Payload {
@@ -33,6 +40,37 @@ struct Payload {
       folly::StringPiece data,
       folly::StringPiece metadata = folly::StringPiece{});
 
+  /// Copies data and metadata into buffers obtained from the allocator.
+  Payload(
+      folly::StringPiece data,
+      folly::StringPiece metadata,
+      BufferAllocator& allocator);
+
+  /// Headroom reserved by withFrameHeadroom(): enough for the largest frame
+  /// header that carries a payload, the metadata length and the frame length
+  /// prefix.
+  static constexpr size_t kFrameHeadroom{16};
+
+  /// Copies data and metadata into buffers that reserve kFrameHeadroom bytes in
+  /// front of the payload.  The serializer writes the frame header into that
+  /// space, so a frame without metadata goes out as a single buffer.
+  static Payload withFrameHeadroom(
+      folly::StringPiece data,
+      folly::StringPiece metadata = folly::StringPiece{},
+      BufferAllocator* allocator = nullptr);
+
+  /// Uses `length` bytes of `file`, starting at `offset`, as the data without
+  /// reading them.  The data IOBuf maps the range, and the TCP transport sends
+  /// it with sendfile().  It can be fragmented like any other data.
+  ///
+  /// The file must not shrink while the payload, or any frame carrying it, is
+  /// alive.  Throws if the range is past the end of the file.
+  static Payload fromFile(
+      const folly::File& file,
+      off_t offset,
+      size_t length,
+      std::unique_ptr<folly::IOBuf> metadata = nullptr);
+
   explicit operator bool() const {
     return data != nullptr || metadata != nullptr;
   }
@@ -51,6 +89,15 @@ struct Payload {
   std::unique_ptr<folly::IOBuf> metadata;
 };
 
+/// A fragment of a payload, delivered in fragment-streaming mode before the
+/// rest of the payload has arrived.
+struct PayloadChunk {
+  Payload payload;
+
+  /// Whether this is the final fragment of the payload.
+  bool last{true};
+};
+
 struct ErrorWithPayload : public std::exception {
   explicit ErrorWithPayload(Payload&& payload);
 
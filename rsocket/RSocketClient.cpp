@@ -174,6 +174,45 @@ folly::Future<folly::Unit> RSocketClient::disconnect(
   return folly::via(evb_, work);
 }
 
+void RSocketClient::setBufferAllocator(
+    std::shared_ptr<BufferAllocator> allocator) {
+  CHECK(stateMachine_);
+  evb_->runImmediatelyOrRunInEventBaseThreadAndWait(
+      [&] { stateMachine_->setBufferAllocator(std::move(allocator)); });
+}
+
+void RSocketClient::setMaxReassemblySize(size_t size) {
+  CHECK(stateMachine_);
+  evb_->runImmediatelyOrRunInEventBaseThreadAndWait(
+      [&] { stateMachine_->setMaxReassemblySize(size); });
+}
+
+void RSocketClient::setWriteWatermarks(WriteWatermarks watermarks) {
+  CHECK(stateMachine_);
+  evb_->runImmediatelyOrRunInEventBaseThreadAndWait(
+      [&] { stateMachine_->setWriteWatermarks(watermarks); });
+}
+
+void RSocketClient::setPendingOutputLimits(PendingOutputLimits limits) {
+  CHECK(stateMachine_);
+  evb_->runImmediatelyOrRunInEventBaseThreadAndWait(
+      [&] { stateMachine_->setPendingOutputLimits(limits); });
+}
+
+void RSocketClient::setFlightRecorder(FlightRecorder::Options options) {
+  CHECK(stateMachine_);
+  evb_->runImmediatelyOrRunInEventBaseThreadAndWait(
+      [&] { stateMachine_->setFlightRecorder(options); });
+}
+
+std::string RSocketClient::dumpFlightRecorder() {
+  CHECK(stateMachine_);
+  std::string dump;
+  evb_->runImmediatelyOrRunInEventBaseThreadAndWait(
+      [&] { dump = stateMachine_->dumpFlightRecorder(); });
+  return dump;
+}
+
 void RSocketClient::fromConnection(
     std::unique_ptr<DuplexConnection> connection,
     folly::EventBase& transportEvb,
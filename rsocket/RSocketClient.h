@@ -16,6 +16,7 @@
 
 #include <folly/futures/Future.h>
 
+#include "rsocket/BufferAllocator.h"
 #include "rsocket/ColdResumeHandler.h"
 #include "rsocket/ConnectionFactory.h"
 #include "rsocket/DuplexConnection.h"
@@ -25,6 +26,8 @@
 #include "rsocket/RSocketResponder.h"
 #include "rsocket/RSocketStats.h"
 #include "rsocket/ResumeManager.h"
+#include "rsocket/internal/FlightRecorder.h"
+#include "rsocket/statemachine/StreamsWriter.h"
 
 namespace rsocket {
 
@@ -68,6 +71,31 @@ class RSocketClient {
   // Disconnect the underlying transport.
   folly::Future<folly::Unit> disconnect(folly::exception_wrapper = {});
 
+  // Serialize outgoing frames into buffers from the given allocator, e.g.
+  // SlabBufferAllocator::forEventBase() of the client's EventBase.
+  void setBufferAllocator(std::shared_ptr<BufferAllocator> allocator);
+
+  // Fail streams whose fragmented payloads grow beyond `size` bytes while
+  // being reassembled.  Unlimited by default.
+  void setMaxReassemblySize(size_t size);
+
+  // Stop pulling from the Flowables of publishing streams while the transport
+  // buffers more than the high watermark worth of unsent bytes.
+  void setWriteWatermarks(WriteWatermarks watermarks);
+
+  // Bound the frames queued up while a resumable client is disconnected.
+  // Publishing streams are paused as the queue fills up, and
+  // `limits.overflow` decides what happens to frames that still don't fit.
+  void setPendingOutputLimits(PendingOutputLimits limits);
+
+  // Size the ring of recent frames and state transitions kept for the
+  // connection, which starts over empty, and whether it is logged when the
+  // connection closes with an error.  See FlightRecorder.
+  void setFlightRecorder(FlightRecorder::Options options);
+
+  // What the connection's flight recorder holds.
+  std::string dumpFlightRecorder();
+
  private:
   // Private constructor.  RSocket class should be used to create instances
   // of RSocketClient.
@@ -24,6 +24,9 @@ std::ostream& operator<<(
             << " dataMimeType: " << setupPayload.dataMimeType
             << " payload: " << setupPayload.payload
             << " token: " << setupPayload.token
-            << " resumable: " << setupPayload.resumable;
+            << " resumable: " << setupPayload.resumable
+            << " compression: " << setupPayload.compression
+            << " metadataDictionarySize: "
+            << setupPayload.metadataDictionarySize;
 }
 } // namespace rsocket
@@ -21,6 +21,8 @@
 
 #include "rsocket/Payload.h"
 #include "rsocket/framing/Frame.h"
+#include "rsocket/framing/MetadataDictionary.h"
+#include "rsocket/framing/PayloadCompressor.h"
 
 namespace rsocket {
 
@@ -56,6 +58,20 @@ class SetupParameters : public RSocketParameters {
   std::string dataMimeType;
   Payload payload;
   ResumeIdentificationToken token;
+
+  /// Codec to compress the data of payloads with, "zstd" or "lz4".  A client
+  /// proposes it in its SETUP frame and the server rejects the SETUP unless
+  /// it accepts the codec.  Empty means no compression.
+  std::string compression;
+
+  /// How the client compresses the payloads it sends.  Unused on the server.
+  PayloadCompressor::Options compressionOptions;
+
+  /// Number of IDs each end interns the metadata it sends under, see
+  /// MetadataDictionary.  A client proposes it in its SETUP frame and the
+  /// server rejects the SETUP if it's more than it accepts.  Zero means no
+  /// interning, as do resumable connections.
+  size_t metadataDictionarySize{0};
 };
 
 std::ostream& operator<<(std::ostream&, const SetupParameters&);
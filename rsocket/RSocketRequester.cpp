@@ -15,6 +15,16 @@
 #include "rsocket/RSocketRequester.h"
 
 #include <folly/ExceptionWrapper.h>
+#include <folly/ScopeGuard.h>
+
+#if FOLLY_HAS_COROUTINES
+#include <folly/CancellationToken.h>
+#include <folly/experimental/coro/Baton.h>
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#endif
 
 #include "rsocket/internal/ScheduledSingleObserver.h"
 #include "rsocket/internal/ScheduledSubscriber.h"
@@ -36,6 +46,180 @@ void runOnCorrectThread(folly::EventBase& evb, Fn fn) {
   }
 }
 
+#if FOLLY_HAS_COROUTINES
+
+/// Observer which hands the response over to an awaiting coroutine.  Signals
+/// arrive on the EventBase, the coroutine resumes on its own executor.
+class CoroSingleObserver : public yarpl::single::SingleObserver<Payload> {
+ public:
+  void onSubscribe(std::shared_ptr<yarpl::single::SingleSubscription>
+                       subscription) override {
+    if (cancelled_) {
+      subscription->cancel();
+      return;
+    }
+    subscription_ = std::move(subscription);
+  }
+
+  void onSuccess(Payload payload) override {
+    subscription_.reset();
+    complete(folly::Try<Payload>(std::move(payload)));
+  }
+
+  void onError(folly::exception_wrapper ex) override {
+    subscription_.reset();
+    complete(folly::Try<Payload>(std::move(ex)));
+  }
+
+  /// Has to be called on the EventBase.
+  void cancel() {
+    cancelled_ = true;
+    if (auto subscription = std::move(subscription_)) {
+      subscription->cancel();
+    }
+    complete(folly::Try<Payload>(folly::make_exception_wrapper<
+                                 folly::OperationCancelled>()));
+  }
+
+  folly::coro::Baton& baton() {
+    return baton_;
+  }
+
+  folly::Try<Payload> takeResult() {
+    return std::move(result_);
+  }
+
+ private:
+  void complete(folly::Try<Payload> result) {
+    if (done_) {
+      return;
+    }
+    done_ = true;
+    result_ = std::move(result);
+    baton_.post();
+  }
+
+  std::shared_ptr<yarpl::single::SingleSubscription> subscription_;
+  folly::Try<Payload> result_;
+  folly::coro::Baton baton_;
+  // only accessed on the EventBase
+  bool done_{false};
+  bool cancelled_{false};
+};
+
+/// Subscriber which buffers the stream for a consuming AsyncGenerator.
+/// Signals arrive on the EventBase and are handed over through a queue, the
+/// credits are replenished in batches rather than per item.
+class CoroStreamSubscriber
+    : public yarpl::flowable::Subscriber<Payload>,
+      public std::enable_shared_from_this<CoroStreamSubscriber> {
+ public:
+  CoroStreamSubscriber(folly::EventBase& eventBase, int64_t prefetch)
+      : eventBase_(eventBase), prefetch_(std::max<int64_t>(prefetch, 1)) {}
+
+  void onSubscribe(
+      std::shared_ptr<yarpl::flowable::Subscription> subscription) override {
+    if (cancelled_) {
+      subscription->cancel();
+      return;
+    }
+    subscription_ = std::move(subscription);
+    subscription_->request(prefetch_);
+  }
+
+  void onNext(Payload payload) override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queue_.push_back(std::move(payload));
+    }
+    baton_.post();
+  }
+
+  void onComplete() override {
+    subscription_.reset();
+    terminate(folly::exception_wrapper());
+  }
+
+  void onError(folly::exception_wrapper ex) override {
+    subscription_.reset();
+    terminate(std::move(ex));
+  }
+
+  /// Moves the next item into `payload`.  Returns false when nothing is
+  /// buffered; `done` is set once the stream has terminated, with `error`
+  /// holding the failure, if any.  Resets the baton when returning false
+  /// with the stream still running, so it can be awaited.
+  bool poll(Payload& payload, bool& done, folly::exception_wrapper& error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!queue_.empty()) {
+      payload = std::move(queue_.front());
+      queue_.pop_front();
+      return true;
+    }
+    done = terminated_;
+    if (done) {
+      error = std::move(error_);
+    } else {
+      baton_.reset();
+    }
+    return false;
+  }
+
+  folly::coro::Baton& baton() {
+    return baton_;
+  }
+
+  /// Called by the consumer for every item it took.
+  void consumed() {
+    if (++consumed_ < (prefetch_ + 1) / 2) {
+      return;
+    }
+    eventBase_.runInEventBaseThread(
+        [self = shared_from_this(), n = std::exchange(consumed_, 0)] {
+          if (self->subscription_) {
+            self->subscription_->request(n);
+          }
+        });
+  }
+
+  void cancel() {
+    eventBase_.runInEventBaseThread([self = shared_from_this()] {
+      self->cancelled_ = true;
+      if (auto subscription = std::move(self->subscription_)) {
+        subscription->cancel();
+      }
+    });
+  }
+
+ private:
+  void terminate(folly::exception_wrapper ex) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      terminated_ = true;
+      error_ = std::move(ex);
+    }
+    baton_.post();
+  }
+
+  folly::EventBase& eventBase_;
+  const int64_t prefetch_;
+
+  // only accessed on the EventBase
+  std::shared_ptr<yarpl::flowable::Subscription> subscription_;
+  bool cancelled_{false};
+
+  // only accessed by the consumer
+  int64_t consumed_{0};
+
+  std::mutex mutex_;
+  std::deque<Payload> queue_;
+  bool terminated_{false};
+  folly::exception_wrapper error_;
+  folly::coro::Baton baton_;
+};
+
+#endif
+
 } // namespace
 
 RSocketRequester::RSocketRequester(
@@ -130,6 +314,25 @@ RSocketRequester::requestStream(Payload request) {
       });
 }
 
+std::shared_ptr<yarpl::flowable::Flowable<PayloadChunk>>
+RSocketRequester::requestChunkedStream(Payload request) {
+  CHECK(stateMachine_);
+
+  return yarpl::flowable::internal::flowableFromSubscriber<PayloadChunk>(
+      [eb = eventBase_, req = std::move(request), srs = stateMachine_](
+          std::shared_ptr<yarpl::flowable::Subscriber<PayloadChunk>>
+              subscriber) {
+        auto lambda =
+            [eb, r = req.clone(), srs, subs = std::move(subscriber)]() mutable {
+              auto scheduled = std::make_shared<
+                  ScheduledSubscriptionSubscriber<PayloadChunk>>(
+                  std::move(subs), *eb);
+              srs->requestChunkedStream(std::move(r), std::move(scheduled));
+            };
+        runOnCorrectThread(*eb, std::move(lambda));
+      });
+}
+
 std::shared_ptr<yarpl::single::Single<rsocket::Payload>>
 RSocketRequester::requestResponse(Payload request) {
   CHECK(stateMachine_);
@@ -178,4 +381,76 @@ void RSocketRequester::metadataPush(std::unique_ptr<folly::IOBuf> metadata) {
       });
 }
 
+#if FOLLY_HAS_COROUTINES
+
+folly::coro::Task<Payload> RSocketRequester::co_requestResponse(
+    Payload request) {
+  CHECK(stateMachine_);
+
+  auto observer = std::make_shared<CoroSingleObserver>();
+  runOnCorrectThread(
+      *eventBase_,
+      [srs = stateMachine_, observer, r = std::move(request)]() mutable {
+        srs->requestResponse(std::move(r), std::move(observer));
+      });
+
+  {
+    folly::CancellationCallback onCancel(
+        co_await folly::coro::co_current_cancellation_token,
+        [eb = eventBase_, observer] {
+          eb->runInEventBaseThread([observer] { observer->cancel(); });
+        });
+    co_await observer->baton();
+  }
+
+  co_return observer->takeResult().value();
+}
+
+folly::coro::AsyncGenerator<Payload&&> RSocketRequester::co_requestStream(
+    Payload request,
+    int64_t prefetch) {
+  CHECK(stateMachine_);
+
+  auto subscriber =
+      std::make_shared<CoroStreamSubscriber>(*eventBase_, prefetch);
+  runOnCorrectThread(
+      *eventBase_,
+      [srs = stateMachine_, subscriber, r = std::move(request)]() mutable {
+        srs->requestStream(std::move(r), std::move(subscriber));
+      });
+
+  // the consumer may stop iterating at any point
+  auto cancelGuard = folly::makeGuard([subscriber] { subscriber->cancel(); });
+
+  auto token = co_await folly::coro::co_current_cancellation_token;
+  folly::CancellationCallback onCancel(
+      token, [subscriber] { subscriber->baton().post(); });
+
+  Payload payload;
+  bool done = false;
+  folly::exception_wrapper error;
+  while (!token.isCancellationRequested()) {
+    if (!subscriber->poll(payload, done, error)) {
+      if (done) {
+        cancelGuard.dismiss();
+        if (error) {
+          error.throw_exception();
+        }
+        co_return;
+      }
+      // a cancellation could have posted the baton before poll() reset it
+      if (token.isCancellationRequested()) {
+        break;
+      }
+      co_await subscriber->baton();
+      continue;
+    }
+
+    subscriber->consumed();
+    co_yield std::move(payload);
+  }
+}
+
+#endif
+
 } // namespace rsocket
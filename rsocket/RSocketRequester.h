@@ -14,8 +14,14 @@
 
 #pragma once
 
+#include <folly/Portability.h>
 #include <folly/io/async/EventBase.h>
 
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/AsyncGenerator.h>
+#include <folly/experimental/coro/Task.h>
+#endif
+
 #include "yarpl/Flowable.h"
 #include "yarpl/Single.h"
 
@@ -66,6 +72,16 @@ class RSocketRequester {
   virtual std::shared_ptr<yarpl::flowable::Flowable<rsocket::Payload>>
   requestStream(rsocket::Payload request);
 
+  /**
+   * Like requestStream(), but hands out payload fragments as they arrive
+   * instead of reassembling them first.  PayloadChunk::last marks the final
+   * fragment of each payload.
+   *
+   * Requested credits count chunks rather than whole payloads.
+   */
+  virtual std::shared_ptr<yarpl::flowable::Flowable<rsocket::PayloadChunk>>
+  requestChunkedStream(rsocket::Payload request);
+
   /**
    * Start a channel (streams in both directions).
    *
@@ -118,6 +134,32 @@ class RSocketRequester {
 
   virtual void closeSocket();
 
+#if FOLLY_HAS_COROUTINES
+  /// Number of items co_requestStream() keeps requested ahead of the consumer.
+  static constexpr int64_t kDefaultStreamPrefetch{128};
+
+  /**
+   * Coroutine flavour of requestResponse().
+   *
+   * The response is delivered straight to the awaiting coroutine, without the
+   * Single and scheduling wrappers of the Rx API.  Cancelling the awaiting
+   * coroutine cancels the request.
+   */
+  virtual folly::coro::Task<rsocket::Payload> co_requestResponse(
+      rsocket::Payload request);
+
+  /**
+   * Coroutine flavour of requestStream().
+   *
+   * Keeps up to `prefetch` items requested from the responder and replenishes
+   * the credits in batches as the generator is consumed.  Destroying the
+   * generator (or cancelling the consuming coroutine) cancels the stream.
+   */
+  virtual folly::coro::AsyncGenerator<rsocket::Payload&&> co_requestStream(
+      rsocket::Payload request,
+      int64_t prefetch = kDefaultStreamPrefetch);
+#endif
+
  protected:
   virtual std::shared_ptr<yarpl::flowable::Flowable<rsocket::Payload>>
   requestChannel(
@@ -15,13 +15,168 @@
 #include "rsocket/RSocketResponder.h"
 
 #include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventBaseManager.h>
 #include <yarpl/flowable/CancelingSubscriber.h>
 
+#if FOLLY_HAS_COROUTINES
+#include <folly/CancellationToken.h>
+#include <folly/executors/GlobalExecutor.h>
+#include <folly/experimental/coro/Baton.h>
+#include <folly/experimental/coro/WithCancellation.h>
+#endif
+
 namespace rsocket {
 
 using namespace yarpl::flowable;
 using namespace yarpl::single;
 
+#if FOLLY_HAS_COROUTINES
+namespace {
+
+folly::EventBase* currentEventBase() {
+  auto eventBase = folly::EventBaseManager::get()->getExistingEventBase();
+  return eventBase ? eventBase : folly::getEventBase();
+}
+
+/// Runs a request-response handler coroutine on the EventBase and delivers
+/// its result to the response observer.
+void runRequestResponse(
+    folly::coro::Task<Payload> task,
+    std::shared_ptr<SingleObserver<Payload>> response,
+    folly::EventBase& eventBase) {
+  folly::CancellationSource cancelSource;
+  response->onSubscribe(SingleSubscriptions::create(
+      [cancelSource]() mutable { cancelSource.requestCancellation(); }));
+
+  folly::coro::co_withCancellation(
+      cancelSource.getToken(),
+      folly::coro::co_invoke(
+          [task = std::move(task), response = std::move(response)]() mutable
+          -> folly::coro::Task<void> {
+            folly::Try<Payload> result;
+            try {
+              result.emplace(co_await std::move(task));
+            } catch (const std::exception& ex) {
+              result.emplaceException(std::current_exception(), ex);
+            } catch (...) {
+              result.emplaceException(std::current_exception());
+            }
+
+            if (result.hasValue()) {
+              response->onSuccess(std::move(result).value());
+            } else {
+              response->onError(std::move(result).exception());
+            }
+          }))
+      .scheduleOn(&eventBase)
+      .start();
+}
+
+/// Subscription of a stream produced by a coroutine.  All the signals happen
+/// on the EventBase the generator runs on, so no synchronization is needed.
+class CoroStreamSubscription : public Subscription {
+ public:
+  void request(int64_t n) override {
+    if (n <= 0) {
+      return;
+    }
+    requested_ = yarpl::credits::add(requested_, n);
+    baton_.post();
+  }
+
+  void cancel() override {
+    cancelSource_.requestCancellation();
+    baton_.post();
+  }
+
+  folly::CancellationToken token() const {
+    return cancelSource_.getToken();
+  }
+
+  bool isCancelled() const {
+    return cancelSource_.isCancellationRequested();
+  }
+
+  bool hasCredits() const {
+    return requested_ > 0;
+  }
+
+  folly::coro::Baton& baton() {
+    return baton_;
+  }
+
+  void consume() {
+    if (requested_ != yarpl::credits::kNoFlowControl) {
+      --requested_;
+    }
+  }
+
+ private:
+  int64_t requested_{0};
+  folly::coro::Baton baton_;
+  folly::CancellationSource cancelSource_;
+};
+
+/// Runs a request-stream handler coroutine on the EventBase and emits its
+/// items to the response subscriber as credits arrive.
+void runRequestStream(
+    folly::coro::AsyncGenerator<Payload&&> generator,
+    std::shared_ptr<Subscriber<Payload>> response,
+    folly::EventBase& eventBase) {
+  auto subscription = std::make_shared<CoroStreamSubscription>();
+  response->onSubscribe(subscription);
+
+  auto token = subscription->token();
+  folly::coro::co_withCancellation(
+      std::move(token),
+      folly::coro::co_invoke(
+          [generator = std::move(generator),
+           response = std::move(response),
+           subscription = std::move(subscription)]() mutable
+          -> folly::coro::Task<void> {
+            while (true) {
+              while (!subscription->hasCredits() &&
+                     !subscription->isCancelled()) {
+                subscription->baton().reset();
+                co_await subscription->baton();
+              }
+              if (subscription->isCancelled()) {
+                co_return;
+              }
+
+              try {
+                auto item = co_await generator.next();
+                if (subscription->isCancelled()) {
+                  co_return;
+                }
+                if (!item.has_value()) {
+                  response->onComplete();
+                  co_return;
+                }
+                subscription->consume();
+                response->onNext(std::move(*item));
+                continue;
+              } catch (const std::exception& ex) {
+                if (!subscription->isCancelled()) {
+                  response->onError(folly::exception_wrapper(
+                      std::current_exception(), ex));
+                }
+              } catch (...) {
+                if (!subscription->isCancelled()) {
+                  response->onError(
+                      folly::exception_wrapper(std::current_exception()));
+                }
+              }
+              co_return;
+            }
+          }))
+      .scheduleOn(&eventBase)
+      .start();
+}
+
+} // namespace
+#endif
+
 void RSocketResponderCore::handleRequestStream(
     Payload,
     StreamId,
@@ -88,6 +243,51 @@ void RSocketResponder::handleMetadataPush(std::unique_ptr<folly::IOBuf>) {
   // No default implementation, no error response to provide.
 }
 
+#if FOLLY_HAS_COROUTINES
+folly::coro::Task<Payload> RSocketCoroResponder::co_handleRequestResponse(
+    Payload,
+    StreamId) {
+  throw std::logic_error("handleRequestResponse not implemented");
+  co_return Payload();
+}
+
+folly::coro::AsyncGenerator<Payload&&>
+RSocketCoroResponder::co_handleRequestStream(Payload, StreamId) {
+  throw std::logic_error("handleRequestStream not implemented");
+  co_return;
+}
+
+std::shared_ptr<Single<Payload>> RSocketCoroResponder::handleRequestResponse(
+    Payload request,
+    StreamId streamId) {
+  return Single<Payload>::create(
+      [task = co_handleRequestResponse(std::move(request), streamId)](
+          std::shared_ptr<SingleObserver<Payload>> observer) mutable {
+        runRequestResponse(
+            std::move(task), std::move(observer), *currentEventBase());
+      });
+}
+
+std::shared_ptr<Flowable<Payload>> RSocketCoroResponder::handleRequestStream(
+    Payload request,
+    StreamId streamId) {
+  return internal::flowableFromSubscriber<Payload>(
+      [generator = co_handleRequestStream(std::move(request), streamId)](
+          std::shared_ptr<Subscriber<Payload>> subscriber) mutable {
+        runRequestStream(
+            std::move(generator), std::move(subscriber), *currentEventBase());
+      });
+}
+#endif
+
+RSocketResponderAdapter::RSocketResponderAdapter(
+    std::shared_ptr<RSocketResponder> inner)
+    : inner_(std::move(inner)) {
+#if FOLLY_HAS_COROUTINES
+  coroInner_ = std::dynamic_pointer_cast<RSocketCoroResponder>(inner_);
+#endif
+}
+
 /// Handles a new Channel requested by the other end.
 std::shared_ptr<Subscriber<Payload>>
 RSocketResponderAdapter::handleRequestChannel(
@@ -172,6 +372,15 @@ void RSocketResponderAdapter::handleRequestStream(
     Payload request,
     StreamId streamId,
     std::shared_ptr<Subscriber<Payload>> response) noexcept {
+#if FOLLY_HAS_COROUTINES
+  if (coroInner_) {
+    runRequestStream(
+        coroInner_->co_handleRequestStream(std::move(request), streamId),
+        std::move(response),
+        *currentEventBase());
+    return;
+  }
+#endif
   auto flowable =
       inner_->handleRequestStream(std::move(request), std::move(streamId));
   flowable->subscribe(std::move(response));
@@ -182,6 +391,15 @@ void RSocketResponderAdapter::handleRequestResponse(
     Payload request,
     StreamId streamId,
     std::shared_ptr<SingleObserver<Payload>> responseObserver) noexcept {
+#if FOLLY_HAS_COROUTINES
+  if (coroInner_) {
+    runRequestResponse(
+        coroInner_->co_handleRequestResponse(std::move(request), streamId),
+        std::move(responseObserver),
+        *currentEventBase());
+    return;
+  }
+#endif
   auto single = inner_->handleRequestResponse(std::move(request), streamId);
   single->subscribe(std::move(responseObserver));
 }
@@ -14,6 +14,13 @@
 
 #pragma once
 
+#include <folly/Portability.h>
+
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/AsyncGenerator.h>
+#include <folly/experimental/coro/Task.h>
+#endif
+
 #include "rsocket/Payload.h"
 #include "rsocket/framing/FrameHeader.h"
 #include "yarpl/Flowable.h"
@@ -115,10 +122,41 @@ class RSocketResponder {
   virtual void handleMetadataPush(std::unique_ptr<folly::IOBuf> metadata);
 };
 
+#if FOLLY_HAS_COROUTINES
+/**
+ * Responder whose request-response and request-stream handlers are written as
+ * coroutines.
+ *
+ * When used directly as the responder of a connection, requests are dispatched
+ * from the stream state machines to the coroutines without building a Single
+ * or Flowable.  The coroutines are started on the connection's EventBase and
+ * stream items are emitted as the requester's credits allow.
+ */
+class RSocketCoroResponder : public RSocketResponder {
+ public:
+  virtual folly::coro::Task<Payload> co_handleRequestResponse(
+      Payload request,
+      StreamId streamId);
+
+  virtual folly::coro::AsyncGenerator<Payload&&> co_handleRequestStream(
+      Payload request,
+      StreamId streamId);
+
+  /// Rx entry points, used when this responder is decorated by another one
+  /// (e.g. ScheduledRSocketResponder).
+  std::shared_ptr<yarpl::single::Single<Payload>> handleRequestResponse(
+      Payload request,
+      StreamId streamId) override;
+
+  std::shared_ptr<yarpl::flowable::Flowable<Payload>> handleRequestStream(
+      Payload request,
+      StreamId streamId) override;
+};
+#endif
+
 class RSocketResponderAdapter : public RSocketResponderCore {
  public:
-  explicit RSocketResponderAdapter(std::shared_ptr<RSocketResponder> inner)
-      : inner_(std::move(inner)) {}
+  explicit RSocketResponderAdapter(std::shared_ptr<RSocketResponder> inner);
   virtual ~RSocketResponderAdapter() = default;
 
   /// Internal method for handling channel requests, not intended to be used by
@@ -150,5 +188,9 @@ class RSocketResponderAdapter : public RSocketResponderCore {
 
  private:
   std::shared_ptr<RSocketResponder> inner_;
+#if FOLLY_HAS_COROUTINES
+  // set when inner_ can be dispatched to without the Rx wrappers
+  std::shared_ptr<RSocketCoroResponder> coroInner_;
+#endif
 };
 } // namespace rsocket
@@ -97,6 +97,47 @@ void RSocketServer::setSingleThreadedResponder() {
   useScheduledResponder_ = false;
 }
 
+void RSocketServer::setBufferAllocatorFactory(BufferAllocatorFactory factory) {
+  bufferAllocatorFactory_ = std::move(factory);
+}
+
+void RSocketServer::setMaxReassemblySize(size_t size) {
+  maxReassemblySize_ = size;
+}
+
+void RSocketServer::setWriteWatermarks(WriteWatermarks watermarks) {
+  writeWatermarks_ = watermarks;
+}
+
+void RSocketServer::setMaxFramesPerLoop(size_t maxFrames) {
+  maxFramesPerLoop_ = maxFrames;
+}
+
+void RSocketServer::setPayloadCompression(PayloadCompressor::Options options) {
+  payloadCompression_ = options;
+}
+
+void RSocketServer::setMaxMetadataDictionarySize(size_t maxSize) {
+  CHECK_LE(maxSize, MetadataDictionary::kMaxSize);
+  maxMetadataDictionarySize_ = maxSize;
+}
+
+void RSocketServer::setPendingOutputLimits(PendingOutputLimits limits) {
+  pendingOutputLimits_ = limits;
+}
+
+void RSocketServer::setFrameCapture(std::shared_ptr<FrameCapture> capture) {
+  frameCapture_ = std::move(capture);
+}
+
+void RSocketServer::setFlightRecorder(FlightRecorder::Options options) {
+  flightRecorder_ = options;
+}
+
+std::vector<std::string> RSocketServer::dumpFlightRecorders() {
+  return connectionSet_->dumpFlightRecorders();
+}
+
 void RSocketServer::acceptConnection(
     std::unique_ptr<DuplexConnection> connection,
     folly::EventBase&,
@@ -114,6 +155,10 @@ void RSocketServer::acceptConnection(
     framedConnection = std::make_unique<FramedDuplexConnection>(
         std::move(connection), ProtocolVersion::Unknown);
   }
+  if (frameCapture_) {
+    framedConnection = std::make_unique<CapturingDuplexConnection>(
+        std::move(framedConnection), frameCapture_);
+  }
 
   auto* acceptor = setupResumeAcceptors_.get();
 
@@ -123,7 +168,15 @@ void RSocketServer::acceptConnection(
       std::move(framedConnection),
       [serviceHandler,
        weakConSet = std::weak_ptr<ConnectionSet>(connectionSet_),
-       scheduledResponder = useScheduledResponder_](
+       scheduledResponder = useScheduledResponder_,
+       bufferAllocatorFactory = bufferAllocatorFactory_,
+       maxReassemblySize = maxReassemblySize_,
+       writeWatermarks = writeWatermarks_,
+       maxFramesPerLoop = maxFramesPerLoop_,
+       payloadCompression = payloadCompression_,
+       maxMetadataDictionarySize = maxMetadataDictionarySize_,
+       pendingOutputLimits = pendingOutputLimits_,
+       flightRecorder = flightRecorder_](
           std::unique_ptr<DuplexConnection> conn,
           SetupParameters params) mutable {
         if (auto connectionSet = weakConSet.lock()) {
@@ -131,6 +184,14 @@ void RSocketServer::acceptConnection(
               serviceHandler,
               std::move(connectionSet),
               scheduledResponder,
+              bufferAllocatorFactory,
+              maxReassemblySize,
+              writeWatermarks,
+              maxFramesPerLoop,
+              payloadCompression,
+              maxMetadataDictionarySize,
+              pendingOutputLimits,
+              flightRecorder,
               std::move(conn),
               std::move(params));
         }
@@ -147,11 +208,45 @@ void RSocketServer::onRSocketSetup(
     std::shared_ptr<RSocketServiceHandler> serviceHandler,
     std::shared_ptr<ConnectionSet> connectionSet,
     bool scheduledResponder,
+    BufferAllocatorFactory bufferAllocatorFactory,
+    size_t maxReassemblySize,
+    folly::Optional<WriteWatermarks> writeWatermarks,
+    size_t maxFramesPerLoop,
+    folly::Optional<PayloadCompressor::Options> payloadCompression,
+    size_t maxMetadataDictionarySize,
+    folly::Optional<PendingOutputLimits> pendingOutputLimits,
+    folly::Optional<FlightRecorder::Options> flightRecorder,
     std::unique_ptr<DuplexConnection> connection,
     SetupParameters setupParams) {
   const auto eventBase = folly::EventBaseManager::get()->getExistingEventBase();
   VLOG(2) << "Received new setup payload on " << eventBase->getName();
   CHECK(eventBase);
+  std::shared_ptr<PayloadCompressor> compressor;
+  if (!setupParams.compression.empty()) {
+    // The client already compresses the frames following its SETUP, so they
+    // can't be read without the codec.
+    if (!payloadCompression ||
+        !PayloadCompressor::isSupported(setupParams.compression)) {
+      VLOG(3) << "Terminating SETUP attempt from client. Unsupported "
+              << "payload compression " << setupParams.compression;
+      connection->send(
+          FrameSerializer::createFrameSerializer(setupParams.protocolVersion)
+              ->serializeOut(Frame_ERROR::unsupportedSetup(
+                  "Unsupported payload compression")));
+      return;
+    }
+    compressor = PayloadCompressor::create(
+        setupParams.compression, *payloadCompression);
+  }
+  if (setupParams.metadataDictionarySize > maxMetadataDictionarySize) {
+    VLOG(3) << "Terminating SETUP attempt from client. Metadata dictionary "
+            << "of " << setupParams.metadataDictionarySize << " is too large";
+    connection->send(
+        FrameSerializer::createFrameSerializer(setupParams.protocolVersion)
+            ->serializeOut(Frame_ERROR::unsupportedSetup(
+                "Unsupported metadata dictionary size")));
+    return;
+  }
   auto result = serviceHandler->onNewSetup(setupParams);
   if (result.hasError()) {
     VLOG(3) << "Terminating SETUP attempt from client. "
@@ -170,6 +265,12 @@ void RSocketServer::onRSocketSetup(
                 "Received invalid Responder from server")));
     return;
   }
+  auto resumeManager = ResumeManager::makeEmpty();
+  if (setupParams.resumable) {
+    resumeManager = connectionParams.resumeManager
+        ? std::move(connectionParams.resumeManager)
+        : std::make_shared<WarmResumeManager>(connectionParams.stats);
+  }
   const auto rs = std::make_shared<RSocketStateMachine>(
       scheduledResponder
           ? std::make_shared<ScheduledRSocketResponder>(
@@ -179,10 +280,28 @@ void RSocketServer::onRSocketSetup(
       RSocketMode::SERVER,
       connectionParams.stats,
       std::move(connectionParams.connectionEvents),
-      setupParams.resumable
-          ? std::make_shared<WarmResumeManager>(connectionParams.stats)
-          : ResumeManager::makeEmpty(),
+      std::move(resumeManager),
       nullptr /* coldResumeHandler */);
+  if (bufferAllocatorFactory) {
+    rs->setBufferAllocator(bufferAllocatorFactory(*eventBase));
+  }
+  rs->setMaxReassemblySize(maxReassemblySize);
+  if (writeWatermarks) {
+    rs->setWriteWatermarks(*writeWatermarks);
+  }
+  rs->setMaxFramesPerLoop(maxFramesPerLoop);
+  if (compressor) {
+    rs->setPayloadCompressor(std::move(compressor));
+  }
+  if (setupParams.metadataDictionarySize > 0) {
+    rs->setMetadataDictionarySize(setupParams.metadataDictionarySize);
+  }
+  if (pendingOutputLimits) {
+    rs->setPendingOutputLimits(*pendingOutputLimits);
+  }
+  if (flightRecorder) {
+    rs->setFlightRecorder(*flightRecorder);
+  }
 
   if (!connectionSet->insert(rs, eventBase)) {
     VLOG(1) << "Server is closed, so ignore the connection";
@@ -14,18 +14,28 @@
 
 #pragma once
 
+#include <limits>
 #include <mutex>
+#include <string>
+#include <vector>
 
+#include <folly/Optional.h>
 #include <folly/Synchronized.h>
 #include <folly/ThreadLocal.h>
 #include <folly/synchronization/Baton.h>
 
+#include "rsocket/BufferAllocator.h"
 #include "rsocket/ConnectionAcceptor.h"
 #include "rsocket/RSocketParameters.h"
 #include "rsocket/RSocketResponder.h"
 #include "rsocket/RSocketServiceHandler.h"
+#include "rsocket/framing/FrameCapture.h"
+#include "rsocket/framing/MetadataDictionary.h"
+#include "rsocket/framing/PayloadCompressor.h"
 #include "rsocket/internal/ConnectionSet.h"
+#include "rsocket/internal/FlightRecorder.h"
 #include "rsocket/internal/SetupResumeAcceptor.h"
+#include "rsocket/statemachine/StreamsWriter.h"
 
 namespace rsocket {
 
@@ -103,6 +113,76 @@ class RSocketServer {
    */
   void setSingleThreadedResponder();
 
+  /**
+   * Serialize outgoing frames of new connections into buffers from the
+   * allocator the factory returns for the connection's EventBase, e.g.
+   * SlabBufferAllocator::forEventBase.
+   */
+  void setBufferAllocatorFactory(BufferAllocatorFactory factory);
+
+  /**
+   * Fail streams of new connections whose fragmented payloads grow beyond
+   * `size` bytes while being reassembled.  Unlimited by default.
+   */
+  void setMaxReassemblySize(size_t size);
+
+  /**
+   * Stop pulling from the Flowables of publishing streams while a connection
+   * buffers more than the high watermark worth of unsent bytes, until it
+   * drains to the low watermark.
+   */
+  void setWriteWatermarks(WriteWatermarks watermarks);
+
+  /**
+   * Process at most `maxFrames` inbound frames of a connection per event loop
+   * iteration.  Reading from the socket pauses in between, so a client
+   * flooding the server is held back by TCP flow control.  Unlimited (zero) by
+   * default.
+   */
+  void setMaxFramesPerLoop(size_t maxFrames);
+
+  /**
+   * Accept clients that propose to compress payloads with a supported codec
+   * in their SETUP frame, and compress the payloads sent back to them with
+   * `options`.  SETUP frames proposing compression are rejected by default.
+   */
+  void setPayloadCompression(PayloadCompressor::Options options);
+
+  /**
+   * Accept clients that propose to intern metadata under at most `maxSize`
+   * IDs in their SETUP frame, see MetadataDictionary.  SETUP frames proposing
+   * interning are rejected by default.
+   */
+  void setMaxMetadataDictionarySize(size_t maxSize);
+
+  /**
+   * Bound the frames a resumable connection queues up while its client is
+   * disconnected.  Publishing streams are paused as the queue fills up, and
+   * `limits.overflow` decides what happens to frames that still don't fit.
+   * Unbounded by default.
+   */
+  void setPendingOutputLimits(PendingOutputLimits limits);
+
+  /**
+   * Record every frame exchanged on the connections accepted from now on to
+   * `capture`, to replay the traffic later.  Nothing is recorded by default.
+   */
+  void setFrameCapture(std::shared_ptr<FrameCapture> capture);
+
+  /**
+   * Size the ring of recent frames and state transitions kept for each
+   * connection accepted from now on, and whether it is logged when the
+   * connection closes with an error.  See FlightRecorder.
+   */
+  void setFlightRecorder(FlightRecorder::Options options);
+
+  /**
+   * What the flight recorder of each active connection holds.  Blocks until
+   * every connection's EventBase got to it, so don't call it from more than
+   * one of the server's threads at a time.
+   */
+  std::vector<std::string> dumpFlightRecorders();
+
   /**
    * Number of active connections to this server.
    */
@@ -113,6 +193,14 @@ class RSocketServer {
       std::shared_ptr<RSocketServiceHandler> serviceHandler,
       std::shared_ptr<ConnectionSet> connectionSet,
       bool scheduledResponder,
+      BufferAllocatorFactory bufferAllocatorFactory,
+      size_t maxReassemblySize,
+      folly::Optional<WriteWatermarks> writeWatermarks,
+      size_t maxFramesPerLoop,
+      folly::Optional<PayloadCompressor::Options> payloadCompression,
+      size_t maxMetadataDictionarySize,
+      folly::Optional<PendingOutputLimits> pendingOutputLimits,
+      folly::Optional<FlightRecorder::Options> flightRecorder,
       std::unique_ptr<DuplexConnection> connection,
       rsocket::SetupParameters setupPayload);
   void onRSocketResume(
@@ -139,5 +227,23 @@ class RSocketServer {
    * be scheduled to another event base.
    */
   bool useScheduledResponder_{true};
+
+  BufferAllocatorFactory bufferAllocatorFactory_;
+
+  size_t maxReassemblySize_{std::numeric_limits<size_t>::max()};
+
+  folly::Optional<WriteWatermarks> writeWatermarks_;
+
+  size_t maxFramesPerLoop_{0};
+
+  folly::Optional<PayloadCompressor::Options> payloadCompression_;
+
+  size_t maxMetadataDictionarySize_{0};
+
+  folly::Optional<PendingOutputLimits> pendingOutputLimits_;
+
+  std::shared_ptr<FrameCapture> frameCapture_;
+
+  folly::Optional<FlightRecorder::Options> flightRecorder_;
 };
 } // namespace rsocket
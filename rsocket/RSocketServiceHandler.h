@@ -22,6 +22,7 @@
 #include "rsocket/RSocketResponder.h"
 #include "rsocket/RSocketServerState.h"
 #include "rsocket/RSocketStats.h"
+#include "rsocket/ResumeManager.h"
 #include "rsocket/internal/Common.h"
 
 namespace rsocket {
@@ -44,6 +45,9 @@ struct RSocketConnectionParams {
   std::shared_ptr<RSocketResponder> responder;
   std::shared_ptr<RSocketStats> stats;
   std::shared_ptr<RSocketConnectionEvents> connectionEvents;
+  // Keeps the frames sent on a resumable connection until the client
+  // acknowledges them.  Defaults to an in-memory WarmResumeManager of 1MB.
+  std::shared_ptr<ResumeManager> resumeManager;
 };
 
 // This class has to be implemented by the application.  The methods can be
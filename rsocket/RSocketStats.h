@@ -34,6 +34,15 @@ class RSocketStats {
 
   static std::shared_ptr<RSocketStats> noop();
 
+  /// Whether the frame and byte counts of a connection can be added up and
+  /// delivered once per EventBase loop, instead of a call per frame and per
+  /// socket read or write.  Batched frame counts arrive through framesRead()
+  /// and framesWritten(), batched byte counts and stream buffer deltas as
+  /// sums through the usual methods.
+  virtual bool acceptsBatchedCounts() const {
+    return false;
+  }
+
   virtual void socketCreated() {}
   virtual void socketConnected() {}
   virtual void socketDisconnected() {}
@@ -54,14 +63,37 @@ class RSocketStats {
       ResumeOutcome /* outcome */) {}
   virtual void bytesWritten(size_t /* bytes */) {}
   virtual void bytesRead(size_t /* bytes */) {}
+  /// A frame was written with MSG_ZEROCOPY.  The kernel may still copy it,
+  /// e.g. on loopback.
+  virtual void zeroCopyRequested(size_t /* bytes */) {}
+  /// A frame large enough for MSG_ZEROCOPY was copied into the kernel instead,
+  /// because the socket doesn't support zerocopy or the kernel recently
+  /// copied zerocopy writes anyway.
+  virtual void zeroCopyFallback(size_t /* bytes */) {}
+  /// Metadata was replaced by the ID the peer interned it under.
+  virtual void metadataBytesSaved(size_t /* bytes */) {}
   virtual void frameWritten(FrameType /* frameType */) {}
   virtual void frameRead(FrameType /* frameType */) {}
+  /// `count` frames of the type were written, see acceptsBatchedCounts().
+  virtual void framesWritten(FrameType frameType, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      frameWritten(frameType);
+    }
+  }
+  /// `count` frames of the type were read, see acceptsBatchedCounts().
+  virtual void framesRead(FrameType frameType, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      frameRead(frameType);
+    }
+  }
   virtual void resumeBufferChanged(
       int /* framesCountDelta */,
       int /* dataSizeDelta */) {}
   virtual void streamBufferChanged(
       int64_t /* framesCountDelta */,
       int64_t /* dataSizeDelta */) {}
+  /// A frame didn't fit into the queue of frames waiting for the connection.
+  virtual void pendingOutputOverflow() {}
   virtual void resumeFailedNoState() {}
   virtual void keepaliveSent() {}
   virtual void keepaliveReceived() {}
@@ -14,14 +14,36 @@
 
 #include <folly/Benchmark.h>
 #include <folly/init/Init.h>
+#include <folly/portability/GFlags.h>
+
+#include "rsocket/internal/Tracing.h"
+
+DEFINE_string(
+    trace,
+    "",
+    "write the tracing spans recorded while running to this file, as a "
+    "Chrome trace; needs a library built with RSOCKET_TRACING");
 
 int main(int argc, char** argv) {
   folly::init(&argc, &argv);
 
   FLAGS_logtostderr = true;
 
+  if (!FLAGS_trace.empty()) {
+#ifndef RSOCKET_TRACING
+    LOG(WARNING) << "Built without RSOCKET_TRACING, the trace will be empty";
+#endif
+    rsocket::Tracer::start();
+  }
+
   LOG(INFO) << "Running benchmarks... (takes minutes)";
   folly::runBenchmarks();
 
+  if (!FLAGS_trace.empty()) {
+    rsocket::Tracer::stop();
+    rsocket::Tracer::writeChromeTrace(FLAGS_trace);
+    LOG(INFO) << "Wrote the trace to " << FLAGS_trace;
+  }
+
   return 0;
 }
@@ -0,0 +1,88 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/benchmarks/Fixture.h"
+#include "rsocket/benchmarks/Throughput.h"
+
+#include <folly/Benchmark.h>
+#include <folly/portability/GFlags.h>
+
+#include "rsocket/RSocket.h"
+#include "yarpl/Flowable.h"
+
+using namespace rsocket;
+
+DEFINE_int32(items, 1000000, "number of items sent in each direction");
+DEFINE_int32(message_len, 32, "length of the messages");
+
+namespace {
+
+/// Echoes every item of a channel back to the requester.
+class EchoResponder : public RSocketResponder {
+ public:
+  std::shared_ptr<yarpl::flowable::Flowable<Payload>> handleRequestChannel(
+      Payload,
+      std::shared_ptr<yarpl::flowable::Flowable<Payload>> requestStream,
+      StreamId) override {
+    return requestStream;
+  }
+};
+
+/// Sends items over a channel and waits for all of them to be echoed back,
+/// so every item crosses the connection once in each direction.
+void channelThroughput(unsigned, Fixture::Transport transport) {
+  Latch latch{1};
+  std::unique_ptr<Fixture> fixture;
+
+  BENCHMARK_SUSPEND {
+    Fixture::Options opts;
+    opts.serverThreads = 1;
+    opts.clients = 1;
+    opts.transport = transport;
+    fixture =
+        std::make_unique<Fixture>(opts, std::make_shared<EchoResponder>());
+
+    LOG(INFO) << "  Echoing " << FLAGS_items << " items of "
+              << FLAGS_message_len << " bytes.";
+  }
+
+  auto requests = yarpl::flowable::Flowable<Payload>::fromGenerator(
+                      [msg = folly::IOBuf::copyBuffer(
+                           std::string(FLAGS_message_len, 'a'))] {
+                        return Payload(msg->clone());
+                      })
+                      ->take(FLAGS_items);
+
+  fixture->clients.front()
+      ->getRequester()
+      ->requestChannel(Payload("Channel"), std::move(requests))
+      ->subscribe(std::make_shared<BoundedSubscriber>(latch, FLAGS_items));
+
+  constexpr std::chrono::minutes timeout{5};
+  if (!latch.timed_wait(timeout)) {
+    LOG(ERROR) << "Timed out!";
+  }
+
+  BENCHMARK_SUSPEND {
+    fixture.reset();
+  }
+}
+
+} // namespace
+
+BENCHMARK_NAMED_PARAM(channelThroughput, tcp, Fixture::Transport::Tcp)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    channelThroughput,
+    memory,
+    Fixture::Transport::Memory)
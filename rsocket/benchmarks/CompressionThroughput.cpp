@@ -0,0 +1,120 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/benchmarks/CpuTime.h"
+#include "rsocket/benchmarks/Fixture.h"
+#include "rsocket/benchmarks/Throughput.h"
+
+#include <folly/Benchmark.h>
+#include <folly/Conv.h>
+#include <folly/portability/GFlags.h>
+
+#include <atomic>
+
+#include "rsocket/RSocket.h"
+
+using namespace rsocket;
+
+DEFINE_int32(items, 20000, "number of items in stream");
+DEFINE_int32(message_len, 4096, "length of the streamed messages");
+DEFINE_int32(threshold, 256, "compress messages of at least this many bytes");
+
+namespace {
+
+/// Counts the bytes the server writes to its connections.
+class BytesWrittenStats : public RSocketStats {
+ public:
+  void bytesWritten(size_t bytes) override {
+    written += bytes;
+  }
+
+  std::atomic<size_t> written{0};
+};
+
+/// JSON-like records, so the codecs have something realistic to work with.
+std::string makeMessage(size_t length) {
+  std::string message;
+  for (size_t i = 0; message.size() < length; ++i) {
+    message += folly::to<std::string>(
+        "{\"id\":",
+        i,
+        ",\"user\":\"user-",
+        i % 97,
+        "\",\"score\":",
+        i * 7 % 1000,
+        ",\"tags\":[\"rsocket\",\"benchmark\"]}");
+  }
+  message.resize(length);
+  return message;
+}
+
+/// Streams messages from the server to a client over memory, compressing
+/// them with the codec at the level unless the codec is empty.
+void streamThroughput(unsigned, const std::string& codec, int level) {
+  if (!codec.empty() && !PayloadCompressor::isSupported(codec)) {
+    LOG(WARNING) << "This build doesn't support " << codec << ", skipping";
+    return;
+  }
+
+  Latch latch{1};
+  std::unique_ptr<Fixture> fixture;
+  auto const stats = std::make_shared<BytesWrittenStats>();
+  std::chrono::microseconds cpuStart;
+
+  BENCHMARK_SUSPEND {
+    Fixture::Options opts;
+    opts.serverThreads = 1;
+    opts.clients = 1;
+    opts.transport = Fixture::Transport::Memory;
+    opts.serverStats = stats;
+    opts.compression = codec;
+    opts.compressionOptions.level = level;
+    opts.compressionOptions.threshold = FLAGS_threshold;
+
+    auto responder =
+        std::make_shared<FixedResponder>(makeMessage(FLAGS_message_len));
+    fixture = std::make_unique<Fixture>(opts, std::move(responder));
+
+    cpuStart = cpuTime();
+  }
+
+  fixture->clients.front()
+      ->getRequester()
+      ->requestStream(Payload("CompressedStream"))
+      ->subscribe(std::make_shared<BoundedSubscriber>(latch, FLAGS_items));
+
+  constexpr std::chrono::minutes timeout{5};
+  if (!latch.timed_wait(timeout)) {
+    LOG(ERROR) << "Timed out!";
+  }
+
+  BENCHMARK_SUSPEND {
+    auto const cpu = cpuTime() - cpuStart;
+    auto const data = static_cast<size_t>(FLAGS_items) * FLAGS_message_len;
+    LOG(INFO) << "  " << (codec.empty() ? "uncompressed" : codec)
+              << " level " << level << ": used " << cpu.count()
+              << "us of CPU time, wrote " << stats->written << " bytes for "
+              << data << " bytes of data.";
+    fixture.reset();
+  }
+}
+
+} // namespace
+
+BENCHMARK_NAMED_PARAM(streamThroughput, uncompressed, "", 0)
+BENCHMARK_RELATIVE_NAMED_PARAM(streamThroughput, lz4_fast, "lz4", 1)
+BENCHMARK_RELATIVE_NAMED_PARAM(streamThroughput, lz4_high, "lz4", 2)
+BENCHMARK_RELATIVE_NAMED_PARAM(streamThroughput, zstd_1, "zstd", 1)
+BENCHMARK_RELATIVE_NAMED_PARAM(streamThroughput, zstd_3, "zstd", 3)
+BENCHMARK_RELATIVE_NAMED_PARAM(streamThroughput, zstd_9, "zstd", 9)
@@ -0,0 +1,30 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/portability/SysResource.h>
+
+#include <chrono>
+
+/// User and system CPU time of the whole process.
+inline std::chrono::microseconds cpuTime() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  auto const toMicros = [](const timeval& tv) {
+    return std::chrono::seconds{tv.tv_sec} +
+        std::chrono::microseconds{tv.tv_usec};
+  };
+  return toMicros(usage.ru_utime) + toMicros(usage.ru_stime);
+}
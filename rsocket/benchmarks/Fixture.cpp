@@ -14,33 +14,157 @@
 
 #include "rsocket/benchmarks/Fixture.h"
 
+#include <folly/Format.h>
+
+#include <unistd.h>
+
+#include <atomic>
+
 #include "rsocket/RSocket.h"
+#include "rsocket/benchmarks/MemoryTransport.h"
+#include "rsocket/transports/shm/ShmConnectionAcceptor.h"
+#include "rsocket/transports/shm/ShmConnectionFactory.h"
 #include "rsocket/transports/tcp/TcpConnectionAcceptor.h"
 #include "rsocket/transports/tcp/TcpConnectionFactory.h"
+#include "rsocket/transports/uds/UdsConnectionAcceptor.h"
+#include "rsocket/transports/uds/UdsConnectionFactory.h"
+
+#ifdef RSOCKET_HAVE_IO_URING
+#include "rsocket/transports/io_uring/IoUringConnectionAcceptor.h"
+#include "rsocket/transports/io_uring/IoUringConnectionFactory.h"
+#endif
 
 namespace rsocket {
 
 namespace {
 
+[[noreturn]] void throwIoUringUnavailable() {
+  throw std::runtime_error{"This build doesn't have the io_uring transport"};
+}
+
+/// Unique socket path for the UDS or shared memory server of a fixture.
+std::string makeSocketPath() {
+  static std::atomic<int> counter{0};
+  return folly::sformat(
+      "/tmp/rsocket-benchmark-{}-{}.sock", getpid(), counter++);
+}
+
+std::unique_ptr<ConnectionAcceptor> makeAcceptor(
+    const Fixture::Options& options,
+    const std::string& socketPath) {
+  if (options.transport == Fixture::Transport::Memory) {
+    return std::make_unique<MemoryConnectionAcceptor>(
+        options.serverThreads, options.serverStats);
+  }
+  if (options.transport == Fixture::Transport::Uds) {
+    UdsConnectionAcceptor::Options opts;
+    opts.path = socketPath;
+    opts.threads = options.serverThreads;
+    opts.stats = options.serverStats;
+    return std::make_unique<UdsConnectionAcceptor>(std::move(opts));
+  }
+  if (options.transport == Fixture::Transport::Shm) {
+    ShmConnectionAcceptor::Options opts;
+    opts.path = socketPath;
+    opts.threads = options.serverThreads;
+    opts.stats = options.serverStats;
+    return std::make_unique<ShmConnectionAcceptor>(std::move(opts));
+  }
+
+  TcpConnectionAcceptor::Options opts;
+  opts.address = folly::SocketAddress{"0.0.0.0", 0};
+  opts.threads = options.serverThreads;
+  opts.zeroCopyThreshold = options.zeroCopyThreshold;
+  opts.stats = options.serverStats;
+
+  if (options.transport == Fixture::Transport::IoUring) {
+#ifdef RSOCKET_HAVE_IO_URING
+    return std::make_unique<IoUringConnectionAcceptor>(std::move(opts));
+#else
+    throwIoUringUnavailable();
+#endif
+  }
+  return std::make_unique<TcpConnectionAcceptor>(std::move(opts));
+}
+
 std::shared_ptr<RSocketClient> makeClient(
+    const Fixture::Options& options,
     folly::EventBase* eventBase,
-    folly::SocketAddress address) {
-  auto factory =
-      std::make_unique<TcpConnectionFactory>(*eventBase, std::move(address));
-  return RSocket::createConnectedClient(std::move(factory)).get();
+    RSocketServer& server,
+    const std::string& socketPath,
+    MemoryConnectionAcceptor* memoryAcceptor) {
+  auto const transport = options.transport;
+  std::unique_ptr<ConnectionFactory> factory;
+  if (transport == Fixture::Transport::Memory) {
+    factory =
+        std::make_unique<MemoryConnectionFactory>(*eventBase, *memoryAcceptor);
+  } else if (transport == Fixture::Transport::Uds) {
+    factory = std::make_unique<UdsConnectionFactory>(*eventBase, socketPath);
+  } else if (transport == Fixture::Transport::Shm) {
+    factory = std::make_unique<ShmConnectionFactory>(*eventBase, socketPath);
+  } else {
+    folly::SocketAddress address{"127.0.0.1", *server.listeningPort()};
+    if (transport == Fixture::Transport::IoUring) {
+#ifdef RSOCKET_HAVE_IO_URING
+      factory = std::make_unique<IoUringConnectionFactory>(
+          *eventBase, std::move(address));
+#else
+      throwIoUringUnavailable();
+#endif
+    } else {
+      auto tcpFactory = std::make_unique<TcpConnectionFactory>(
+          *eventBase, std::move(address));
+      tcpFactory->setZeroCopyThreshold(options.zeroCopyThreshold);
+      factory = std::move(tcpFactory);
+    }
+  }
+  SetupParameters setupParameters;
+  setupParameters.compression = options.compression;
+  setupParameters.compressionOptions = options.compressionOptions;
+  return RSocket::createConnectedClient(
+             std::move(factory), std::move(setupParameters))
+      .get();
 }
 } // namespace
 
+Fixture::Transport Fixture::parseTransport(const std::string& name) {
+  if (name == "tcp") {
+    return Transport::Tcp;
+  }
+  if (name == "uds") {
+    return Transport::Uds;
+  }
+  if (name == "shm") {
+    return Transport::Shm;
+  }
+  if (name == "io_uring") {
+    return Transport::IoUring;
+  }
+  if (name == "memory") {
+    return Transport::Memory;
+  }
+  throw std::invalid_argument{"Unknown transport: " + name};
+}
+
 Fixture::Fixture(
     Fixture::Options fixtureOpts,
     std::shared_ptr<RSocketResponder> responder)
-    : options{std::move(fixtureOpts)} {
-  TcpConnectionAcceptor::Options opts;
-  opts.address = folly::SocketAddress{"0.0.0.0", 0};
-  opts.threads = options.serverThreads;
+    : options{std::move(fixtureOpts)}, socketPath_{makeSocketPath()} {
+  auto acceptor = makeAcceptor(options, socketPath_);
+  if (options.transport == Transport::Memory) {
+    memoryAcceptor_ = static_cast<MemoryConnectionAcceptor*>(acceptor.get());
+  }
 
-  auto acceptor = std::make_unique<TcpConnectionAcceptor>(std::move(opts));
   server = std::make_unique<RSocketServer>(std::move(acceptor));
+  if (options.slabAllocator) {
+    server->setBufferAllocatorFactory(&SlabBufferAllocator::forEventBase);
+  }
+  if (!options.compression.empty()) {
+    server->setPayloadCompression(options.compressionOptions);
+  }
+  if (options.flightRecorder) {
+    server->setFlightRecorder(*options.flightRecorder);
+  }
   server->start([responder](const SetupParameters&) { return responder; });
 
   auto const numWorkers =
@@ -50,12 +174,26 @@ Fixture::Fixture(
         "rsocket-client-thread"));
   }
 
-  const folly::SocketAddress actual{"127.0.0.1", *server->listeningPort()};
+  addClients(options.clients);
+}
 
-  for (size_t i = 0; i < options.clients; ++i) {
+void Fixture::addClients(size_t count) {
+  CHECK(!workers.empty() || count == 0) << "Fixture has no client threads";
+  for (size_t i = 0; i < count; ++i) {
     auto worker = std::move(workers.front());
     workers.pop_front();
-    clients.push_back(makeClient(worker->getEventBase(), actual));
+    auto const evb = worker->getEventBase();
+    clients.push_back(
+        makeClient(options, evb, *server, socketPath_, memoryAcceptor_));
+    if (options.slabAllocator) {
+      evb->runInEventBaseThreadAndWait([&] {
+        clients.back()->setBufferAllocator(
+            SlabBufferAllocator::forEventBase(*evb));
+      });
+    }
+    if (options.flightRecorder) {
+      clients.back()->setFlightRecorder(*options.flightRecorder);
+    }
     workers.push_back(std::move(worker));
   }
 }
@@ -21,15 +21,34 @@
 #include <folly/io/async/ScopedEventBaseThread.h>
 
 #include <deque>
+#include <string>
 #include <vector>
 
 namespace rsocket {
 
+class MemoryConnectionAcceptor;
+
 /// Benchmarks fixture object that contains a server, along with a list of
 /// clients and their worker threads.
 ///
-/// Uses TCP as the transport.
+/// Uses loopback TCP as the transport unless told otherwise.
 struct Fixture {
+  enum class Transport {
+    Tcp,
+    /// Unix domain socket.
+    Uds,
+    /// Shared memory rings, set up over a Unix domain socket.
+    Shm,
+    /// Only available when built with liburing.
+    IoUring,
+    /// Frames handed over between EventBases in memory, no socket at all.
+    Memory,
+  };
+
+  /// Parses the value of a --transport flag: "tcp", "uds", "shm", "io_uring"
+  /// or "memory".
+  static Transport parseTransport(const std::string&);
+
   struct Options {
     /// Number of threads the server will run.
     size_t serverThreads{8};
@@ -40,15 +59,47 @@ struct Fixture {
     /// Number of worker threads driving the clients.  A default value means to
     /// use one thread per client.
     folly::Optional<size_t> clientThreads;
+
+    /// Serialize frames into per-EventBase slabs on both the server and the
+    /// clients, see SlabBufferAllocator.
+    bool slabAllocator{false};
+
+    /// Transport the server and the clients talk over.
+    Transport transport{Transport::Tcp};
+
+    /// Frames of at least this many bytes are written with MSG_ZEROCOPY, over
+    /// TCP only.  Zero disables it.
+    size_t zeroCopyThreshold{0};
+
+    /// Stats of the server's connections.
+    std::shared_ptr<RSocketStats> serverStats{RSocketStats::noop()};
+
+    /// Codec the clients and the server compress payload data with, e.g.
+    /// "zstd".  Empty disables compression.
+    std::string compression;
+
+    /// Level and threshold of the compression, on both ends.
+    PayloadCompressor::Options compressionOptions;
+
+    /// Flight recorder of every connection, on both ends.  The library's
+    /// default if unset.
+    folly::Optional<FlightRecorder::Options> flightRecorder;
   };
 
   Fixture(Options, std::shared_ptr<RSocketResponder>);
 
+  /// Connects `count` more clients, spread over the workers.
+  void addClients(size_t count);
+
   // State is public, have at it.
 
   std::unique_ptr<RSocketServer> server;
   std::deque<std::unique_ptr<folly::ScopedEventBaseThread>> workers;
   std::vector<std::shared_ptr<RSocketClient>> clients;
   const Options options;
+
+ private:
+  const std::string socketPath_;
+  MemoryConnectionAcceptor* memoryAcceptor_{nullptr};
 };
 } // namespace rsocket
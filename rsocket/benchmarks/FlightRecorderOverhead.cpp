@@ -0,0 +1,119 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/benchmarks/Fixture.h"
+#include "rsocket/benchmarks/Throughput.h"
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/portability/GFlags.h>
+
+#include <algorithm>
+
+#include "rsocket/RSocket.h"
+#include "rsocket/framing/Frame.h"
+#include "rsocket/framing/FrameSerializer.h"
+#include "rsocket/internal/FlightRecorder.h"
+#include "yarpl/Flowable.h"
+
+using namespace rsocket;
+
+constexpr size_t kMessageLen = 32;
+
+DEFINE_string(transport, "memory", "tcp, uds, shm, io_uring or memory");
+DEFINE_int32(items, 1000000, "number of items streamed in each round");
+DEFINE_int32(rounds, 5, "number of rounds with and without the recorder");
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// Streams --items items over a single connection, and returns how long it
+/// took.
+Clock::duration streamOnce(FlightRecorder::Options recorder) {
+  Fixture::Options opts;
+  opts.serverThreads = 1;
+  opts.clients = 1;
+  opts.transport = Fixture::parseTransport(FLAGS_transport);
+  opts.flightRecorder = recorder;
+
+  auto responder =
+      std::make_shared<FixedResponder>(std::string(kMessageLen, 'a'));
+  Fixture fixture{opts, std::move(responder)};
+  Latch latch{1};
+
+  auto const start = Clock::now();
+  fixture.clients.front()
+      ->getRequester()
+      ->requestStream(Payload("FlightRecorder"))
+      ->subscribe(std::make_shared<BoundedSubscriber>(latch, FLAGS_items));
+
+  constexpr std::chrono::minutes timeout{5};
+  if (!latch.timed_wait(timeout)) {
+    LOG(ERROR) << "Timed out!";
+  }
+  return Clock::now() - start;
+}
+
+double millis(Clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+} // namespace
+
+BENCHMARK(RecordFrame, n) {
+  FlightRecorder recorder;
+  std::unique_ptr<folly::IOBuf> frame;
+
+  BENCHMARK_SUSPEND {
+    frame = FrameSerializer::createFrameSerializer(ProtocolVersion::Latest)
+                ->serializeOut(Frame_PAYLOAD(
+                    1,
+                    FrameFlags::NEXT,
+                    Payload(std::string(kMessageLen, 'a'))));
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    recorder.sent(*frame);
+  }
+  folly::doNotOptimizeAway(recorder);
+}
+
+BENCHMARK(StreamThroughputOverhead, n) {
+  (void)n;
+
+  FlightRecorder::Options off;
+  off.capacity = 0;
+  const FlightRecorder::Options on;
+
+  LOG(INFO) << "  Streaming " << FLAGS_items << " items over "
+            << FLAGS_transport << ", " << FLAGS_rounds
+            << " rounds without and with the flight recorder";
+
+  // Interleave the rounds so that drift in the machine's load hits both
+  // alike, and take the best of each to leave out the noise.
+  auto without = Clock::duration::max();
+  auto with = Clock::duration::max();
+  for (int i = 0; i < FLAGS_rounds; ++i) {
+    without = std::min(without, streamOnce(off));
+    with = std::min(with, streamOnce(on));
+  }
+
+  LOG(INFO) << folly::sformat(
+      "  {:.1f}ms without, {:.1f}ms with the flight recorder: "
+      "{:+.2f}% overhead",
+      millis(without),
+      millis(with),
+      (millis(with) / millis(without) - 1) * 100);
+}
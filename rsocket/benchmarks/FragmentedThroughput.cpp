@@ -0,0 +1,121 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/benchmarks/Fixture.h"
+#include "rsocket/benchmarks/Throughput.h"
+
+#include <folly/Benchmark.h>
+#include <folly/portability/GFlags.h>
+
+#include <algorithm>
+
+#include "rsocket/RSocket.h"
+
+using namespace rsocket;
+
+DEFINE_int64(
+    bytes,
+    1 << 30,
+    "total number of payload bytes to stream for each payload size");
+
+namespace {
+
+/// Streams payloads of `size` bytes from the server to a client.  Frames are
+/// capped just under 16MB, so payloads of 16MB and more are written as several
+/// fragments and reassembled by the client.
+void fragmentedThroughput(
+    unsigned,
+    Fixture::Transport transport,
+    size_t size) {
+  Latch latch{1};
+  std::unique_ptr<Fixture> fixture;
+  auto const items =
+      std::max<size_t>(1, static_cast<size_t>(FLAGS_bytes) / size);
+
+  BENCHMARK_SUSPEND {
+    Fixture::Options opts;
+    opts.serverThreads = 1;
+    opts.clients = 1;
+    opts.transport = transport;
+
+    auto responder = std::make_shared<FixedResponder>(std::string(size, 'a'));
+    fixture = std::make_unique<Fixture>(opts, std::move(responder));
+
+    LOG(INFO) << "  Streaming " << items << " payloads of " << size
+              << " bytes.";
+  }
+
+  fixture->clients.front()
+      ->getRequester()
+      ->requestStream(Payload("Fragmented"))
+      ->subscribe(std::make_shared<BoundedSubscriber>(latch, items));
+
+  constexpr std::chrono::minutes timeout{5};
+  if (!latch.timed_wait(timeout)) {
+    LOG(ERROR) << "Timed out!";
+  }
+
+  BENCHMARK_SUSPEND {
+    fixture.reset();
+  }
+}
+
+constexpr size_t kKB = 1 << 10;
+constexpr size_t kMB = 1 << 20;
+
+} // namespace
+
+BENCHMARK_NAMED_PARAM(
+    fragmentedThroughput,
+    tcp_64KB,
+    Fixture::Transport::Tcp,
+    64 * kKB)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    fragmentedThroughput,
+    tcp_1MB,
+    Fixture::Transport::Tcp,
+    kMB)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    fragmentedThroughput,
+    tcp_16MB,
+    Fixture::Transport::Tcp,
+    16 * kMB)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    fragmentedThroughput,
+    tcp_64MB,
+    Fixture::Transport::Tcp,
+    64 * kMB)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_NAMED_PARAM(
+    fragmentedThroughput,
+    memory_64KB,
+    Fixture::Transport::Memory,
+    64 * kKB)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    fragmentedThroughput,
+    memory_1MB,
+    Fixture::Transport::Memory,
+    kMB)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    fragmentedThroughput,
+    memory_16MB,
+    Fixture::Transport::Memory,
+    16 * kMB)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    fragmentedThroughput,
+    memory_64MB,
+    Fixture::Transport::Memory,
+    64 * kMB)
@@ -0,0 +1,99 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/benchmarks/HdrHistogram.h"
+
+#include <folly/lang/Bits.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace rsocket {
+
+HdrHistogram::HdrHistogram(uint64_t highest, int significantDigits)
+    : highest_{std::max<uint64_t>(highest, 2)} {
+  CHECK_GE(significantDigits, 1);
+  CHECK_LE(significantDigits, 5);
+
+  // Enough slots per power of two to tell apart values that differ in their
+  // last significant digit.
+  const auto largestSingleUnitResolution =
+      2 * static_cast<uint64_t>(std::pow(10, significantDigits));
+  const auto subBucketMagnitude =
+      folly::findLastSet(largestSingleUnitResolution - 1);
+  subBucketHalfMagnitude_ = subBucketMagnitude - 1;
+  subBucketMask_ = (uint64_t{1} << subBucketMagnitude) - 1;
+
+  counts_.resize(countsIndex(highest_) + 1);
+}
+
+size_t HdrHistogram::countsIndex(uint64_t value) const {
+  const auto bucket = static_cast<uint32_t>(
+      folly::findLastSet(value | subBucketMask_) - subBucketHalfMagnitude_ - 1);
+  const auto subBucket = value >> bucket;
+  return (static_cast<size_t>(bucket + 1) << subBucketHalfMagnitude_) +
+      (subBucket - (uint64_t{1} << subBucketHalfMagnitude_));
+}
+
+uint64_t HdrHistogram::highestEquivalentValue(size_t index) const {
+  const auto halfCount = uint64_t{1} << subBucketHalfMagnitude_;
+  uint64_t bucket = index >> subBucketHalfMagnitude_;
+  uint64_t subBucket = (index & (halfCount - 1)) + halfCount;
+  if (bucket == 0) {
+    subBucket -= halfCount;
+  } else {
+    --bucket;
+  }
+  const auto lowest = subBucket << bucket;
+  return lowest + (uint64_t{1} << bucket) - 1;
+}
+
+void HdrHistogram::record(uint64_t value) {
+  value = std::min(value, highest_);
+  ++counts_[countsIndex(value)];
+  ++count_;
+  min_ = std::min(min_, value);
+  max_ = std::max(max_, value);
+}
+
+void HdrHistogram::merge(const HdrHistogram& other) {
+  CHECK_EQ(counts_.size(), other.counts_.size());
+  for (size_t i = 0; i < counts_.size(); ++i) {
+    counts_[i] += other.counts_[i];
+  }
+  count_ += other.count_;
+  min_ = std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+}
+
+uint64_t HdrHistogram::valueAtPercentile(double percentile) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  percentile = std::min(std::max(percentile, 0.0), 100.0);
+  const auto target = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(percentile / 100 * count_)));
+
+  uint64_t seen = 0;
+  for (size_t i = 0; i < counts_.size(); ++i) {
+    seen += counts_[i];
+    if (seen >= target) {
+      return std::min(highestEquivalentValue(i), max_);
+    }
+  }
+  return max_;
+}
+
+} // namespace rsocket
@@ -0,0 +1,76 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rsocket {
+
+/// High dynamic range histogram of latencies, or any other positive integer
+/// values.  Buckets are log-linear: each power of two range is split into
+/// enough equal slots to keep `significantDigits` decimal digits of precision,
+/// so recording a value is a couple of bit operations and an increment, and
+/// the memory used does not depend on how many values are recorded.
+///
+/// Not thread-safe.  Record into one histogram per thread and merge them.
+class HdrHistogram {
+ public:
+  /// Tracks values from 1 up to `highest`, larger values are recorded as
+  /// `highest`.  Precision is between 1 and 5 significant digits.
+  explicit HdrHistogram(uint64_t highest, int significantDigits = 3);
+
+  void record(uint64_t value);
+
+  /// Adds all values recorded by `other`, which must have been created with
+  /// the same arguments.
+  void merge(const HdrHistogram& other);
+
+  /// The value that `percentile` percent of the recorded values are at or
+  /// below, e.g. 99.9.  Accurate to the precision of the histogram, and never
+  /// above max().  Zero if nothing was recorded.
+  uint64_t valueAtPercentile(double percentile) const;
+
+  uint64_t count() const {
+    return count_;
+  }
+
+  uint64_t min() const {
+    return count_ == 0 ? 0 : min_;
+  }
+
+  uint64_t max() const {
+    return max_;
+  }
+
+ private:
+  size_t countsIndex(uint64_t value) const;
+  uint64_t highestEquivalentValue(size_t index) const;
+
+  const uint64_t highest_;
+  /// Every bucket past the first covers a power of two range with
+  /// 2^subBucketHalfMagnitude_ slots.  The first one covers twice as many
+  /// values with unit slots.
+  uint32_t subBucketHalfMagnitude_;
+  uint64_t subBucketMask_;
+
+  std::vector<uint64_t> counts_;
+  uint64_t count_{0};
+  uint64_t min_{UINT64_MAX};
+  uint64_t max_{0};
+};
+
+} // namespace rsocket
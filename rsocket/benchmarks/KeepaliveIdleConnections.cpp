@@ -0,0 +1,90 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/benchmarks/CpuTime.h"
+
+#include <folly/Benchmark.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/portability/GFlags.h>
+
+#include "rsocket/internal/KeepaliveTimer.h"
+
+using namespace rsocket;
+
+DEFINE_int32(connections, 100000, "number of idle connections");
+DEFINE_int32(keepalive_ms, 1000, "keepalive period of every connection");
+DEFINE_int32(seconds, 10, "how long to keep the connections idle");
+
+namespace {
+
+/// Connection that doesn't carry any traffic but promptly answers keepalives,
+/// so all the CPU spent on it is keepalive bookkeeping.
+class IdleConnection : public FrameSink {
+ public:
+  void disconnectOrCloseWithError(Frame_ERROR&&) override {
+    LOG(ERROR) << "Idle connection missed a keepalive";
+  }
+
+  void sendKeepalive(std::unique_ptr<folly::IOBuf>) override {
+    ++keepalives;
+    timer->keepaliveReceived();
+  }
+
+  KeepaliveTimer* timer{nullptr};
+  size_t keepalives{0};
+};
+
+} // namespace
+
+BENCHMARK(KeepaliveIdleConnections, n) {
+  (void)n;
+
+  folly::EventBase evb;
+  std::vector<std::shared_ptr<IdleConnection>> connections;
+  std::vector<std::unique_ptr<KeepaliveTimer>> timers;
+
+  BENCHMARK_SUSPEND {
+    LOG(INFO) << "  Keeping " << FLAGS_connections
+              << " idle connections alive every " << FLAGS_keepalive_ms
+              << "ms for " << FLAGS_seconds << "s.";
+
+    for (int i = 0; i < FLAGS_connections; ++i) {
+      connections.push_back(std::make_shared<IdleConnection>());
+      timers.push_back(std::make_unique<KeepaliveTimer>(
+          std::chrono::milliseconds{FLAGS_keepalive_ms}, evb));
+      connections.back()->timer = timers.back().get();
+      timers.back()->start(connections.back());
+    }
+  }
+
+  auto const start = cpuTime();
+  evb.runAfterDelay(
+      [&evb] { evb.terminateLoopSoon(); }, FLAGS_seconds * 1000);
+  evb.loopForever();
+  auto const cpu = cpuTime() - start;
+
+  BENCHMARK_SUSPEND {
+    size_t keepalives = 0;
+    for (auto& connection : connections) {
+      keepalives += connection->keepalives;
+    }
+    LOG(INFO) << "  Sent " << keepalives << " keepalives using "
+              << cpu.count() / FLAGS_seconds << "us of CPU per second.";
+
+    for (auto& timer : timers) {
+      timer->stop();
+    }
+    timers.clear();
+  }
+}
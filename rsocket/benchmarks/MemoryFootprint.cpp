@@ -0,0 +1,343 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/benchmarks/Fixture.h"
+
+#include <folly/Benchmark.h>
+#include <folly/json.h>
+#include <folly/portability/GFlags.h>
+
+#include <malloc.h>
+#include <sys/resource.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <thread>
+
+#include "rsocket/RSocket.h"
+#include "yarpl/Flowable.h"
+#include "yarpl/Single.h"
+
+using namespace rsocket;
+
+DEFINE_int32(connections, 10000, "number of idle connections to open");
+DEFINE_int32(streams, 10000, "number of streams of each type to open");
+DEFINE_int32(stream_connections, 10, "connections the streams are spread on");
+DEFINE_int32(server_threads, 4, "number of server threads to run");
+DEFINE_int32(client_threads, 4, "number of threads driving the clients");
+DEFINE_string(transport, "tcp", "tcp, uds, shm, io_uring or memory");
+DEFINE_string(
+    output,
+    "",
+    "file to write the results to as JSON lines, stdout if empty");
+
+// Every allocation made through operator new is counted, from any thread.
+// Buffers that folly mallocs directly, like those of IOBufs, are only seen
+// by the heap usage the C library reports.
+
+namespace {
+
+std::atomic<int64_t> gAllocatedBytes{0};
+std::atomic<int64_t> gAllocations{0};
+
+void* countedAlloc(size_t size) noexcept {
+  auto const ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr) {
+    gAllocatedBytes.fetch_add(
+        malloc_usable_size(ptr), std::memory_order_relaxed);
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+  }
+  return ptr;
+}
+
+void countedFree(void* ptr) noexcept {
+  if (ptr) {
+    gAllocatedBytes.fetch_sub(
+        malloc_usable_size(ptr), std::memory_order_relaxed);
+    gAllocations.fetch_sub(1, std::memory_order_relaxed);
+    std::free(ptr);
+  }
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+  if (auto const ptr = countedAlloc(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return countedAlloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return countedAlloc(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  countedFree(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  countedFree(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  countedFree(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+  countedFree(ptr);
+}
+
+namespace {
+
+/// Live memory of the whole process at one point in time.
+struct Usage {
+  static Usage now() {
+    Usage usage;
+    usage.bytes = gAllocatedBytes.load();
+    usage.allocations = gAllocations.load();
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    auto const info = mallinfo2();
+    usage.heapBytes = static_cast<int64_t>(info.uordblks + info.hblkhd);
+#endif
+    return usage;
+  }
+
+  int64_t bytes{0};
+  int64_t allocations{0};
+  /// Everything malloc handed out, or zero where the C library doesn't say.
+  int64_t heapBytes{0};
+};
+
+/// Writes one result per line, so runs are easy to diff and to track.  The
+/// output file only keeps the results of the last run.
+class Report {
+ public:
+  Report() {
+    if (!FLAGS_output.empty()) {
+      file_.open(FLAGS_output);
+    }
+  }
+
+  /// Records what holding `count` of `what` costs, given the usage before
+  /// and after they were opened.
+  void add(
+      const std::string& what,
+      size_t count,
+      const Usage& before,
+      const Usage& after) {
+    auto const per = [count](int64_t delta) {
+      return static_cast<double>(delta) / count;
+    };
+    folly::dynamic result = folly::dynamic::object("what", what)(
+        "transport", FLAGS_transport)("count", count)(
+        "bytes_per", per(after.bytes - before.bytes))(
+        "allocations_per", per(after.allocations - before.allocations))(
+        "heap_bytes_per", per(after.heapBytes - before.heapBytes));
+
+    auto& out = file_.is_open() ? file_ : std::cout;
+    out << folly::toJson(result) << std::endl;
+  }
+
+ private:
+  std::ofstream file_;
+};
+
+/// Waits for the server to catch up with the clients, then for the threads
+/// to settle, so the memory they free on the way isn't counted.
+void settle(const std::atomic<size_t>& counter, size_t expected) {
+  auto const deadline =
+      std::chrono::steady_clock::now() + std::chrono::minutes{1};
+  while (counter < expected && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds{1});
+  }
+  if (counter < expected) {
+    LOG(ERROR) << "Timed out!";
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds{100});
+}
+
+/// Subscriber that asks for a single item it will never get.
+class PendingSubscriber : public yarpl::flowable::BaseSubscriber<Payload> {
+ public:
+  void onSubscribeImpl() override {
+    this->request(1);
+  }
+
+  void onNextImpl(Payload) override {}
+  void onCompleteImpl() override {}
+  void onErrorImpl(folly::exception_wrapper) override {}
+};
+
+/// Holds every request open: streams and responses never produce anything.
+class Responder : public RSocketResponder {
+ public:
+  std::shared_ptr<yarpl::flowable::Flowable<Payload>> handleRequestStream(
+      Payload,
+      StreamId) override {
+    ++requests;
+    return yarpl::flowable::Flowable<Payload>::never();
+  }
+
+  std::shared_ptr<yarpl::flowable::Flowable<Payload>> handleRequestChannel(
+      Payload,
+      std::shared_ptr<yarpl::flowable::Flowable<Payload>> requestStream,
+      StreamId) override {
+    ++requests;
+    requestStream->subscribe(std::make_shared<PendingSubscriber>());
+    return yarpl::flowable::Flowable<Payload>::never();
+  }
+
+  std::shared_ptr<yarpl::single::Single<Payload>> handleRequestResponse(
+      Payload,
+      StreamId) override {
+    ++requests;
+    return yarpl::single::Singles::create<Payload>(
+        [](std::shared_ptr<yarpl::single::SingleObserver<Payload>> observer) {
+          observer->onSubscribe(yarpl::single::SingleSubscriptions::empty());
+        });
+  }
+
+  void handleFireAndForget(Payload, StreamId) override {
+    ++requests;
+  }
+
+  void handleMetadataPush(std::unique_ptr<folly::IOBuf>) override {
+    ++requests;
+  }
+
+  std::atomic<size_t> requests{0};
+};
+
+/// Every connection takes up one or two file descriptors on each end.
+void raiseFileLimit() {
+  rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0 &&
+      limit.rlim_cur < limit.rlim_max) {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+}
+
+std::unique_ptr<Fixture> makeFixture(std::shared_ptr<Responder> responder) {
+  Fixture::Options opts;
+  opts.serverThreads = FLAGS_server_threads;
+  opts.clients = 0;
+  opts.clientThreads = FLAGS_client_threads;
+  opts.transport = Fixture::parseTransport(FLAGS_transport);
+  return std::make_unique<Fixture>(opts, std::move(responder));
+}
+
+/// Opens `FLAGS_streams` requests of one type with `open`, spread over the
+/// clients, and reports what each of them costs while it stays open.
+template <typename Open>
+void measureStreams(
+    Report& report,
+    const std::string& what,
+    Fixture& fixture,
+    Responder& responder,
+    Open open) {
+  auto const streams = static_cast<size_t>(FLAGS_streams);
+  auto const before = Usage::now();
+  auto const start = responder.requests.load();
+
+  for (size_t i = 0; i < streams; ++i) {
+    open(*fixture.clients[i % fixture.clients.size()]->getRequester());
+  }
+  settle(responder.requests, start + streams);
+
+  report.add(what, streams, before, Usage::now());
+}
+
+} // namespace
+
+BENCHMARK(MemoryFootprint, n) {
+  (void)n;
+
+  Report report;
+  auto const responder = std::make_shared<Responder>();
+  std::unique_ptr<Fixture> fixture;
+
+  BENCHMARK_SUSPEND {
+    raiseFileLimit();
+    LOG(INFO) << "  Opening " << FLAGS_connections << " connections and "
+              << FLAGS_streams << " streams of each type over "
+              << FLAGS_transport << ".";
+    fixture = makeFixture(responder);
+  }
+
+  // Each client pushes metadata once, so the server is known to have set up
+  // its end of the connection.
+  {
+    auto const connections = static_cast<size_t>(FLAGS_connections);
+    auto const before = Usage::now();
+    fixture->addClients(connections);
+    for (auto& client : fixture->clients) {
+      client->getRequester()->metadataPush(folly::IOBuf::copyBuffer("hi"));
+    }
+    settle(responder->requests, connections);
+    report.add("connection", connections, before, Usage::now());
+  }
+
+  BENCHMARK_SUSPEND {
+    fixture.reset();
+    fixture = makeFixture(responder);
+    fixture->addClients(FLAGS_stream_connections);
+  }
+
+  measureStreams(
+      report, "request_stream", *fixture, *responder, [](auto& requester) {
+        requester.requestStream(Payload("stream"))
+            ->subscribe(std::make_shared<PendingSubscriber>());
+      });
+
+  measureStreams(
+      report, "request_channel", *fixture, *responder, [](auto& requester) {
+        requester
+            .requestChannel(
+                Payload("channel"),
+                yarpl::flowable::Flowable<Payload>::never())
+            ->subscribe(std::make_shared<PendingSubscriber>());
+      });
+
+  measureStreams(
+      report, "request_response", *fixture, *responder, [](auto& requester) {
+        requester.requestResponse(Payload("response"))
+            ->subscribe(
+                std::make_shared<yarpl::single::SingleObserverBase<Payload>>());
+      });
+
+  measureStreams(
+      report, "fire_and_forget", *fixture, *responder, [](auto& requester) {
+        requester.fireAndForget(Payload("fnf"))
+            ->subscribe(
+                std::make_shared<yarpl::single::SingleObserverBase<void>>());
+      });
+
+  BENCHMARK_SUSPEND {
+    fixture.reset();
+  }
+}
@@ -0,0 +1,125 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/benchmarks/MemoryTransport.h"
+
+#include <folly/futures/Future.h>
+
+namespace rsocket {
+
+namespace {
+
+/// State shared across the two ends of a connection.
+struct State {
+  /// Whether one of the two ends has been destroyed.
+  folly::Synchronized<bool> destroyed;
+};
+
+/// DuplexConnection that talks to another DirectDuplexConnection via memory.
+class DirectDuplexConnection : public DuplexConnection {
+ public:
+  DirectDuplexConnection(
+      std::shared_ptr<State> state,
+      folly::EventBase& evb,
+      std::shared_ptr<RSocketStats> stats)
+      : state_{std::move(state)}, evb_{evb}, stats_{std::move(stats)} {}
+
+  ~DirectDuplexConnection() override {
+    *state_->destroyed.wlock() = true;
+  }
+
+  // Tie two DirectDuplexConnections together so they can talk to each other.
+  void tie(DirectDuplexConnection* other) {
+    other_ = other;
+    other_->other_ = this;
+  }
+
+  void setInput(std::shared_ptr<DuplexConnection::Subscriber> input) override {
+    input_ = std::move(input);
+  }
+
+  void send(std::unique_ptr<folly::IOBuf> buf) override {
+    auto destroyed = state_->destroyed.rlock();
+    if (*destroyed || !other_) {
+      return;
+    }
+
+    stats_->bytesWritten(buf->computeChainDataLength());
+    other_->evb_.runInEventBaseThread(
+        [state = state_, other = other_, b = std::move(buf)]() mutable {
+          auto destroyed = state->destroyed.rlock();
+          if (*destroyed || !other->input_) {
+            return;
+          }
+
+          other->input_->onNext(std::move(b));
+        });
+  }
+
+ private:
+  std::shared_ptr<State> state_;
+  folly::EventBase& evb_;
+  std::shared_ptr<RSocketStats> stats_;
+
+  DirectDuplexConnection* other_{nullptr};
+
+  std::shared_ptr<DuplexConnection::Subscriber> input_;
+};
+
+} // namespace
+
+MemoryConnectionAcceptor::MemoryConnectionAcceptor(
+    size_t threads,
+    std::shared_ptr<RSocketStats> stats)
+    : stats_{std::move(stats)} {
+  CHECK_GT(threads, 0u);
+  for (size_t i = 0; i < threads; ++i) {
+    workers_.push_back(std::make_unique<folly::ScopedEventBaseThread>(
+        "rsocket-memory-acceptor"));
+  }
+}
+
+void MemoryConnectionAcceptor::start(OnDuplexConnectionAccept onAccept) {
+  onAccept_ = std::move(onAccept);
+}
+
+std::unique_ptr<DuplexConnection> MemoryConnectionAcceptor::connect(
+    folly::EventBase& clientEvb) {
+  CHECK(onAccept_) << "MemoryConnectionAcceptor is not started";
+
+  auto const serverEvb =
+      workers_[nextWorker_++ % workers_.size()]->getEventBase();
+  auto const state = std::make_shared<State>();
+  auto client = std::make_unique<DirectDuplexConnection>(
+      state, clientEvb, RSocketStats::noop());
+  auto server =
+      std::make_unique<DirectDuplexConnection>(state, *serverEvb, stats_);
+  server->tie(client.get());
+
+  // Runs before any frame the client sends reaches the server end.
+  serverEvb->runInEventBaseThread(
+      [this, serverEvb, server = std::move(server)]() mutable {
+        onAccept_(std::move(server), *serverEvb);
+      });
+  return client;
+}
+
+folly::Future<ConnectionFactory::ConnectedDuplexConnection>
+MemoryConnectionFactory::connect(ProtocolVersion, ResumeStatus) {
+  return folly::via(&eventBase_, [this] {
+    return ConnectedDuplexConnection{acceptor_.connect(eventBase_), eventBase_};
+  });
+}
+
+} // namespace rsocket
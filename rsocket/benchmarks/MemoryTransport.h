@@ -0,0 +1,78 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "rsocket/ConnectionAcceptor.h"
+#include "rsocket/ConnectionFactory.h"
+#include "rsocket/RSocketStats.h"
+
+namespace rsocket {
+
+/// Acceptor for connections that pass frames to their peer through memory,
+/// without any socket in between.  Clients connect to it with a
+/// MemoryConnectionFactory.
+class MemoryConnectionAcceptor : public ConnectionAcceptor {
+ public:
+  /// Counts the bytes written by the server end of the connections to
+  /// `stats`.
+  MemoryConnectionAcceptor(
+      size_t threads,
+      std::shared_ptr<RSocketStats> stats = RSocketStats::noop());
+
+  void start(OnDuplexConnectionAccept) override;
+
+  /// The server checks on its own whether it still accepts connections, and
+  /// closes its existing ones on the workers, so they stay up.
+  void stop() override {}
+
+  folly::Optional<uint16_t> listeningPort() const override {
+    return folly::none;
+  }
+
+  /// Hands the server end of a new connection to the server and returns the
+  /// client end, which runs on `clientEvb`.
+  std::unique_ptr<DuplexConnection> connect(folly::EventBase& clientEvb);
+
+ private:
+  std::vector<std::unique_ptr<folly::ScopedEventBaseThread>> workers_;
+  std::atomic<size_t> nextWorker_{0};
+  std::shared_ptr<RSocketStats> stats_;
+  OnDuplexConnectionAccept onAccept_;
+};
+
+class MemoryConnectionFactory : public ConnectionFactory {
+ public:
+  MemoryConnectionFactory(
+      folly::EventBase& eventBase,
+      MemoryConnectionAcceptor& acceptor)
+      : eventBase_{eventBase}, acceptor_{acceptor} {}
+
+  folly::Future<ConnectedDuplexConnection> connect(
+      ProtocolVersion,
+      ResumeStatus) override;
+
+ private:
+  folly::EventBase& eventBase_;
+  MemoryConnectionAcceptor& acceptor_;
+};
+
+} // namespace rsocket
@@ -0,0 +1,87 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/benchmarks/Fixture.h"
+#include "rsocket/benchmarks/Latch.h"
+
+#include <folly/Benchmark.h>
+#include <folly/portability/GFlags.h>
+
+#include "rsocket/RSocket.h"
+
+using namespace rsocket;
+
+DEFINE_int32(server_threads, 8, "number of server threads to run");
+DEFINE_int32(clients, 100, "number of connections to fan out to");
+DEFINE_int32(items, 10000, "number of metadata pushes, per connection");
+DEFINE_int32(metadata_len, 32, "length of the pushed metadata");
+
+namespace {
+
+class Responder : public RSocketResponder {
+ public:
+  explicit Responder(Latch& latch) : latch_{latch} {}
+
+  void handleMetadataPush(std::unique_ptr<folly::IOBuf>) override {
+    latch_.post();
+  }
+
+ private:
+  Latch& latch_;
+};
+
+/// Pushes each metadata update to every connection from a single thread, the
+/// way a config or routing update is broadcast.  Done once the server saw all
+/// of them.
+void metadataPushFanOut(unsigned, Fixture::Transport transport) {
+  Latch latch{static_cast<size_t>(FLAGS_items) * FLAGS_clients};
+  std::unique_ptr<Fixture> fixture;
+
+  BENCHMARK_SUSPEND {
+    Fixture::Options opts;
+    opts.serverThreads = FLAGS_server_threads;
+    opts.clients = FLAGS_clients;
+    opts.transport = transport;
+    fixture =
+        std::make_unique<Fixture>(opts, std::make_shared<Responder>(latch));
+
+    LOG(INFO) << "  Pushing " << FLAGS_items << " updates to "
+              << FLAGS_clients << " connections.";
+  }
+
+  auto const metadata =
+      folly::IOBuf::copyBuffer(std::string(FLAGS_metadata_len, 'a'));
+  for (int i = 0; i < FLAGS_items; ++i) {
+    for (auto& client : fixture->clients) {
+      client->getRequester()->metadataPush(metadata->clone());
+    }
+  }
+
+  constexpr std::chrono::minutes timeout{5};
+  if (!latch.timed_wait(timeout)) {
+    LOG(ERROR) << "Timed out!";
+  }
+
+  BENCHMARK_SUSPEND {
+    fixture.reset();
+  }
+}
+
+} // namespace
+
+BENCHMARK_NAMED_PARAM(metadataPushFanOut, tcp, Fixture::Transport::Tcp)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    metadataPushFanOut,
+    memory,
+    Fixture::Transport::Memory)
@@ -0,0 +1,162 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/benchmarks/Fixture.h"
+#include "rsocket/benchmarks/Throughput.h"
+
+#include <folly/Benchmark.h>
+#include <folly/portability/GFlags.h>
+
+#include "rsocket/RSocket.h"
+#include "yarpl/Flowable.h"
+#include "yarpl/flowable/MulticastProcessor.h"
+
+using namespace rsocket;
+
+constexpr size_t kMessageLen = 32;
+
+DEFINE_int32(subscribers, 1000, "number of local subscribers to fan out to");
+DEFINE_int32(items, 100000, "number of items delivered to each subscriber");
+DEFINE_int32(buffer, 128, "size of the per-subscriber ring buffer");
+DEFINE_int32(quorum, 0, "pace upstream by the quorum-th fastest subscriber");
+DEFINE_int32(batch, 64, "number of items each subscriber requests at a time");
+
+namespace {
+
+struct ClonePayload {
+  Payload operator()(const Payload& payload) const {
+    return payload.clone();
+  }
+};
+
+using PayloadMulticastProcessor =
+    yarpl::flowable::MulticastProcessor<Payload, ClonePayload>;
+
+/// Subscriber that requests items in batches and cancels once it received
+/// enough of them.  Signals a latch when it is done.
+class BatchedSubscriber : public yarpl::flowable::BaseSubscriber<Payload> {
+ public:
+  BatchedSubscriber(Latch& latch, size_t items, int64_t batch)
+      : latch_{latch}, items_{items}, batch_{batch} {}
+
+  void onSubscribeImpl() override {
+    this->request(batch_);
+  }
+
+  void onNextImpl(Payload) override {
+    if (++received_ == items_) {
+      latch_.post();
+      this->cancel();
+      return;
+    }
+    if (--pending_ <= batch_ / 2) {
+      const auto delta = batch_ - pending_;
+      pending_ += delta;
+      this->request(delta);
+    }
+  }
+
+  void onCompleteImpl() override {
+    if (received_ < items_) {
+      latch_.post();
+    }
+  }
+
+  void onErrorImpl(folly::exception_wrapper) override {
+    if (received_ < items_) {
+      latch_.post();
+    }
+  }
+
+ private:
+  Latch& latch_;
+  const size_t items_;
+  const int64_t batch_;
+  int64_t pending_{batch_};
+  size_t received_{0};
+};
+
+std::shared_ptr<PayloadMulticastProcessor> makeProcessor(Latch& latch) {
+  auto processor =
+      PayloadMulticastProcessor::create(FLAGS_buffer, FLAGS_quorum);
+  for (int i = 0; i < FLAGS_subscribers; ++i) {
+    processor->subscribe(
+        std::make_shared<BatchedSubscriber>(latch, FLAGS_items, FLAGS_batch));
+  }
+  return processor;
+}
+
+void logOptions() {
+  LOG(INFO) << "  Fanning out " << FLAGS_items << " items to "
+            << FLAGS_subscribers << " subscribers with buffers of "
+            << FLAGS_buffer << " items, quorum " << FLAGS_quorum << ".";
+}
+
+} // namespace
+
+BENCHMARK(MulticastFanOutLocal, n) {
+  (void)n;
+
+  Latch latch{static_cast<size_t>(FLAGS_subscribers)};
+  std::shared_ptr<PayloadMulticastProcessor> processor;
+
+  BENCHMARK_SUSPEND {
+    logOptions();
+    processor = makeProcessor(latch);
+  }
+
+  yarpl::flowable::Flowable<Payload>::fromGenerator(
+      [msg = folly::IOBuf::copyBuffer(std::string(kMessageLen, 'a'))] {
+        return Payload(msg->clone());
+      })
+      ->take(FLAGS_items)
+      ->subscribe(processor);
+
+  constexpr std::chrono::minutes timeout{5};
+  if (!latch.timed_wait(timeout)) {
+    LOG(ERROR) << "Timed out!";
+  }
+}
+
+BENCHMARK(MulticastFanOutTcp, n) {
+  (void)n;
+
+  Latch latch{static_cast<size_t>(FLAGS_subscribers)};
+  std::shared_ptr<PayloadMulticastProcessor> processor;
+  std::unique_ptr<Fixture> fixture;
+
+  BENCHMARK_SUSPEND {
+    logOptions();
+
+    Fixture::Options opts;
+    opts.serverThreads = 1;
+    opts.clients = 1;
+
+    auto responder =
+        std::make_shared<FixedResponder>(std::string(kMessageLen, 'a'));
+    fixture = std::make_unique<Fixture>(opts, std::move(responder));
+    processor = makeProcessor(latch);
+  }
+
+  fixture->clients.front()
+      ->getRequester()
+      ->requestStream(Payload("TcpMulticast"))
+      ->take(FLAGS_items)
+      ->subscribe(processor);
+
+  constexpr std::chrono::minutes timeout{5};
+  if (!latch.timed_wait(timeout)) {
+    LOG(ERROR) << "Timed out!";
+  }
+}
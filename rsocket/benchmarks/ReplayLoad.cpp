@@ -0,0 +1,489 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/benchmarks/Fixture.h"
+#include "rsocket/benchmarks/HdrHistogram.h"
+#include "rsocket/benchmarks/Latch.h"
+#include "rsocket/benchmarks/Throughput.h"
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/Optional.h>
+#include <folly/SocketAddress.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/portability/GFlags.h>
+
+#include <unistd.h>
+
+#include <atomic>
+#include <limits>
+#include <thread>
+#include <unordered_map>
+
+#include "rsocket/RSocket.h"
+#include "rsocket/framing/FrameCapture.h"
+#include "rsocket/framing/FrameSerializer.h"
+#include "rsocket/framing/FramedDuplexConnection.h"
+#include "rsocket/transports/tcp/TcpConnectionFactory.h"
+#include "yarpl/Single.h"
+
+using namespace rsocket;
+
+DEFINE_string(
+    capture,
+    "",
+    "frame capture of a server to replay, see RSocketServer::setFrameCapture; "
+    "records one of synthetic traffic if empty");
+DEFINE_string(
+    address,
+    "",
+    "host:port of the server to replay against, an in-process one if empty");
+DEFINE_double(
+    speed,
+    1.0,
+    "replay speed relative to the capture, 0 for as fast as possible");
+DEFINE_int32(threads, 4, "number of threads driving the replayed connections");
+DEFINE_int32(server_threads, 4, "number of threads of the in-process server");
+DEFINE_int32(
+    drain_ms,
+    1000,
+    "how long to wait for outstanding responses after the last frame");
+DEFINE_int32(record_seconds, 2, "how long to record synthetic traffic for");
+DEFINE_int32(record_clients, 4, "number of clients of the synthetic traffic");
+DEFINE_int32(record_rate, 1000, "requests per second of synthetic traffic");
+DEFINE_int32(message_len, 32, "length of the synthetic requests and responses");
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// Latencies above a minute are recorded as a minute.
+constexpr uint64_t kHighestLatencyNs = 60'000'000'000;
+
+/// Every this many synthetic requests is a stream instead of a
+/// request/response.
+constexpr size_t kStreamEvery = 4;
+constexpr size_t kStreamItems = 10;
+
+uint64_t nanos(Clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(duration)
+      .count();
+}
+
+bool isRequest(FrameType type) {
+  switch (type) {
+    case FrameType::REQUEST_RESPONSE:
+    case FrameType::REQUEST_FNF:
+    case FrameType::REQUEST_STREAM:
+    case FrameType::REQUEST_CHANNEL:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/// Counters over all the replayed connections.
+struct Totals {
+  std::atomic<uint64_t> frames{0};
+  std::atomic<uint64_t> bytes{0};
+  /// Frames not replayed: resumption, streams started by the server, or
+  /// anything sent after the server closed the connection.
+  std::atomic<uint64_t> dropped{0};
+  std::atomic<uint64_t> requests{0};
+  /// Requests other than fire-and-forget.
+  std::atomic<uint64_t> awaiting{0};
+  std::atomic<uint64_t> responses{0};
+};
+
+/// Thread that a share of the replayed connections run on.
+struct Worker {
+  explicit Worker(folly::SocketAddress address)
+      : factory{*thread.getEventBase(), std::move(address)} {}
+
+  folly::ScopedEventBaseThread thread{"rsocket-replay-thread"};
+  TcpConnectionFactory factory;
+
+  /// Only touched on the thread.
+  HdrHistogram latencies{kHighestLatencyNs};
+};
+
+/// Plays the frames a client sent on one captured connection to the server,
+/// under stream IDs of its own, and records how long the server takes to
+/// respond to each request.  Lives on the EventBase of its worker.
+class ReplayConnection
+    : public DuplexConnection::Subscriber,
+      public std::enable_shared_from_this<ReplayConnection> {
+ public:
+  ReplayConnection(Worker& worker, Totals& totals)
+      : worker_{worker},
+        totals_{totals},
+        serializer_{
+            FrameSerializer::createFrameSerializer(ProtocolVersion::Latest)} {}
+
+  folly::EventBase& eventBase() const {
+    return *worker_.thread.getEventBase();
+  }
+
+  void connect() {
+    worker_.factory.connect(ProtocolVersion::Latest, ResumeStatus::NEW_SESSION)
+        .via(worker_.thread.getEventBase())
+        .thenValue([self = shared_from_this()](
+                       ConnectionFactory::ConnectedDuplexConnection connected) {
+          self->onConnected(std::move(connected.connection));
+        })
+        .thenError([self = shared_from_this()](folly::exception_wrapper ex) {
+          LOG(ERROR) << "Failed to connect: " << ex;
+          self->close();
+        });
+  }
+
+  /// Sends a frame the captured client sent, once connected.
+  void replay(std::unique_ptr<folly::IOBuf> frame) {
+    if (closed_) {
+      ++totals_.dropped;
+      return;
+    }
+
+    auto const type = serializer_->peekFrameType(*frame);
+    auto const capturedId = serializer_->peekStreamId(*frame, false);
+    if (!capturedId || type == FrameType::RESUME) {
+      ++totals_.dropped;
+      return;
+    }
+
+    if (*capturedId != 0) {
+      if (isRequest(type)) {
+        // The captured client may have reused the ID, always start afresh.
+        auto const id = nextStreamId_;
+        nextStreamId_ += 2;
+        streams_[*capturedId] = id;
+
+        ++totals_.requests;
+        if (type != FrameType::REQUEST_FNF) {
+          pending_[id] = Clock::now();
+          ++totals_.awaiting;
+        }
+      }
+
+      auto const it = streams_.find(*capturedId);
+      if (it == streams_.end()) {
+        ++totals_.dropped;
+        return;
+      }
+      folly::io::RWPrivateCursor cur{frame.get()};
+      cur.writeBE<uint32_t>(it->second);
+    }
+
+    ++totals_.frames;
+    totals_.bytes += frame->computeChainDataLength();
+    if (connection_) {
+      connection_->send(std::move(frame));
+    } else {
+      queued_.push_back(std::move(frame));
+    }
+  }
+
+  void close() {
+    if (closed_) {
+      return;
+    }
+    closed_ = true;
+    queued_.clear();
+    connection_.reset();
+    if (auto subscription = std::move(input_)) {
+      subscription->cancel();
+    }
+  }
+
+  // Subscriber.
+
+  void onSubscribe(
+      std::shared_ptr<yarpl::flowable::Subscription> subscription) override {
+    input_ = std::move(subscription);
+    input_->request(std::numeric_limits<int64_t>::max());
+  }
+
+  void onNext(std::unique_ptr<folly::IOBuf> frame) override {
+    auto const type = serializer_->peekFrameType(*frame);
+    if (type != FrameType::PAYLOAD && type != FrameType::ERROR) {
+      return;
+    }
+    auto const id = serializer_->peekStreamId(*frame, false);
+    if (!id) {
+      return;
+    }
+    if (*id == 0) {
+      LOG(ERROR) << "Server closed a replayed connection";
+      return;
+    }
+
+    auto const it = pending_.find(*id);
+    if (it != pending_.end()) {
+      worker_.latencies.record(nanos(Clock::now() - it->second));
+      pending_.erase(it);
+      ++totals_.responses;
+    }
+  }
+
+  void onComplete() override {
+    input_.reset();
+    close();
+  }
+
+  void onError(folly::exception_wrapper) override {
+    input_.reset();
+    close();
+  }
+
+ private:
+  void onConnected(std::unique_ptr<DuplexConnection> connection) {
+    if (closed_) {
+      return;
+    }
+    connection_ = std::make_unique<FramedDuplexConnection>(
+        std::move(connection), ProtocolVersion::Latest);
+    connection_->setInput(shared_from_this());
+
+    // Don't charge the connection setup to the requests queued up meanwhile.
+    auto const now = Clock::now();
+    for (auto& request : pending_) {
+      request.second = now;
+    }
+    for (auto& frame : queued_) {
+      connection_->send(std::move(frame));
+    }
+    queued_.clear();
+  }
+
+  Worker& worker_;
+  Totals& totals_;
+  const std::unique_ptr<FrameSerializer> serializer_;
+
+  std::unique_ptr<DuplexConnection> connection_;
+  std::shared_ptr<yarpl::flowable::Subscription> input_;
+  std::vector<std::unique_ptr<folly::IOBuf>> queued_;
+  bool closed_{false};
+
+  /// Captured stream ID to the one it is replayed under.
+  std::unordered_map<StreamId, StreamId> streams_;
+  StreamId nextStreamId_{1};
+
+  /// When each request still waiting for its first response went out.
+  std::unordered_map<StreamId, Clock::time_point> pending_;
+};
+
+std::string formatLatency(uint64_t ns) {
+  return folly::sformat("{:.1f}us", ns / 1000.0);
+}
+
+/// Records a capture of --record_seconds of requests from --record_clients
+/// clients, a mix of request/responses and short streams.
+void record(const std::string& path) {
+  auto capture = std::make_shared<FrameCapture>(path);
+
+  Fixture::Options opts;
+  opts.serverThreads = FLAGS_server_threads;
+  opts.clients = 0;
+  opts.clientThreads = FLAGS_record_clients;
+
+  auto responder = std::make_shared<FixedResponder>(
+      std::string(static_cast<size_t>(FLAGS_message_len), 'a'));
+  Fixture fixture{opts, std::move(responder)};
+  fixture.server->setFrameCapture(capture);
+  fixture.addClients(FLAGS_record_clients);
+
+  auto const clients = fixture.clients.size();
+  auto const perClient =
+      static_cast<size_t>(FLAGS_record_rate) * FLAGS_record_seconds / clients;
+  if (perClient == 0) {
+    LOG(ERROR) << "Rate " << FLAGS_record_rate << "/s is too low to record any "
+               << "requests";
+    return;
+  }
+  auto const interval = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::nanoseconds(1'000'000'000 * clients / FLAGS_record_rate));
+  Latch latch{perClient * clients};
+
+  auto const start = Clock::now();
+  std::vector<std::thread> senders;
+  for (size_t i = 0; i < clients; ++i) {
+    senders.emplace_back([&, i] {
+      auto const requester = fixture.clients[i]->getRequester();
+      auto const request =
+          folly::IOBuf::copyBuffer(std::string(FLAGS_message_len, 'a'));
+      for (size_t j = 0; j < perClient; ++j) {
+        std::this_thread::sleep_until(start + interval * (j * clients + i));
+        if (j % kStreamEvery == 0) {
+          requester->requestStream(Payload(request->clone()))
+              ->subscribe(
+                  std::make_shared<BoundedSubscriber>(latch, kStreamItems));
+        } else {
+          requester->requestResponse(Payload(request->clone()))
+              ->subscribe(
+                  [&latch](Payload) { latch.post(); },
+                  [&latch](folly::exception_wrapper) { latch.post(); });
+        }
+      }
+    });
+  }
+  for (auto& sender : senders) {
+    sender.join();
+  }
+
+  constexpr std::chrono::minutes timeout{1};
+  if (!latch.timed_wait(timeout)) {
+    LOG(ERROR) << "Timed out recording!";
+  }
+}
+
+/// Replays the frames the clients sent in the capture at `path` to the server
+/// at `address`, and logs throughput and latencies.
+void replay(const std::string& path, const folly::SocketAddress& address) {
+  std::vector<std::unique_ptr<Worker>> workers;
+  for (int i = 0; i < FLAGS_threads; ++i) {
+    workers.push_back(std::make_unique<Worker>(address));
+  }
+
+  Totals totals;
+  std::unordered_map<uint32_t, std::shared_ptr<ReplayConnection>> connections;
+  Clock::duration behind{0};
+
+  FrameCaptureReader reader{path};
+  folly::Optional<std::chrono::nanoseconds> first;
+  auto const start = Clock::now();
+
+  while (auto captured = reader.next()) {
+    if (captured->direction != FrameCapture::Direction::RECEIVED) {
+      continue;
+    }
+    if (!first) {
+      first = captured->time;
+    }
+    if (FLAGS_speed > 0) {
+      auto const due = start +
+          std::chrono::duration_cast<Clock::duration>(
+                           std::chrono::duration<double, std::nano>(
+                               captured->time - *first) /
+                           FLAGS_speed);
+      auto const now = Clock::now();
+      if (now < due) {
+        std::this_thread::sleep_until(due);
+      } else {
+        behind = std::max(behind, now - due);
+      }
+    }
+
+    auto& connection = connections[captured->connection];
+    if (!connection) {
+      auto& worker = *workers[(connections.size() - 1) % workers.size()];
+      connection = std::make_shared<ReplayConnection>(worker, totals);
+      connection->eventBase().runInEventBaseThread(
+          [connection] { connection->connect(); });
+    }
+    connection->eventBase().runInEventBaseThread(
+        [connection, frame = std::move(captured->frame)]() mutable {
+          connection->replay(std::move(frame));
+        });
+  }
+  auto const replayTime = Clock::now() - start;
+
+  auto const deadline =
+      Clock::now() + std::chrono::milliseconds{FLAGS_drain_ms};
+  while (totals.responses < totals.awaiting && Clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds{1});
+  }
+
+  for (auto const& entry : connections) {
+    auto const& connection = entry.second;
+    connection->eventBase().runInEventBaseThreadAndWait(
+        [&connection] { connection->close(); });
+  }
+
+  HdrHistogram latencies{kHighestLatencyNs};
+  for (auto const& worker : workers) {
+    latencies.merge(worker->latencies);
+  }
+
+  auto const seconds = std::chrono::duration<double>(replayTime).count();
+  LOG(INFO) << folly::sformat(
+      "  Replayed {} frames of {} connections in {:.2f}s at {}x, {} dropped",
+      totals.frames.load(),
+      connections.size(),
+      seconds,
+      FLAGS_speed,
+      totals.dropped.load());
+  LOG(INFO) << folly::sformat(
+      "  {:.0f} frames/s, {:.1f} MB/s, {:.0f} requests/s, fell behind the "
+      "capture by up to {}",
+      totals.frames / seconds,
+      totals.bytes / seconds / (1 << 20),
+      totals.requests / seconds,
+      formatLatency(nanos(behind)));
+  LOG(INFO) << folly::sformat(
+      "  {} of {} requests answered",
+      totals.responses.load(),
+      totals.awaiting.load());
+  LOG(INFO) << folly::sformat(
+      "    p50 {:>10} p90 {:>10} p99 {:>10} p999 {:>10} max {:>10}",
+      formatLatency(latencies.valueAtPercentile(50)),
+      formatLatency(latencies.valueAtPercentile(90)),
+      formatLatency(latencies.valueAtPercentile(99)),
+      formatLatency(latencies.valueAtPercentile(99.9)),
+      formatLatency(latencies.max()));
+}
+
+} // namespace
+
+BENCHMARK(ReplayLoad, n) {
+  (void)n;
+
+  std::string path = FLAGS_capture;
+  bool recorded = false;
+  std::unique_ptr<Fixture> fixture;
+  folly::SocketAddress address;
+
+  BENCHMARK_SUSPEND {
+    if (path.empty()) {
+      path = folly::sformat("/tmp/rsocket-replay-{}.bin", getpid());
+      recorded = true;
+      LOG(INFO) << "Recording " << FLAGS_record_seconds
+                << "s of synthetic traffic to " << path;
+      record(path);
+    }
+
+    if (FLAGS_address.empty()) {
+      Fixture::Options opts;
+      opts.serverThreads = FLAGS_server_threads;
+      opts.clients = 0;
+
+      auto responder = std::make_shared<FixedResponder>(
+          std::string(static_cast<size_t>(FLAGS_message_len), 'a'));
+      fixture = std::make_unique<Fixture>(opts, std::move(responder));
+      address = folly::SocketAddress{
+          "127.0.0.1", *fixture->server->listeningPort()};
+    } else {
+      address.setFromHostPort(FLAGS_address);
+    }
+  }
+
+  replay(path, address);
+
+  BENCHMARK_SUSPEND {
+    fixture.reset();
+    if (recorded) {
+      unlink(path.c_str());
+    }
+  }
+}
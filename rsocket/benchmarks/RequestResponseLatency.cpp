@@ -0,0 +1,80 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/benchmarks/Fixture.h"
+#include "rsocket/benchmarks/Throughput.h"
+
+#include <folly/Benchmark.h>
+#include <folly/portability/GFlags.h>
+#include <folly/synchronization/Baton.h>
+
+#include "rsocket/RSocket.h"
+#include "yarpl/Single.h"
+
+using namespace rsocket;
+
+DEFINE_int32(message_len, 32, "length of the requests and responses");
+
+namespace {
+
+/// Sends `n` request-responses back to back over a single connection, each
+/// one only after the previous response arrived.  The time per iteration is
+/// the round trip latency.
+void runLatency(Fixture::Transport transport, size_t n) {
+  std::unique_ptr<Fixture> fixture;
+
+  BENCHMARK_SUSPEND {
+    Fixture::Options opts;
+    opts.serverThreads = 1;
+    opts.clients = 1;
+    opts.transport = transport;
+
+    auto responder = std::make_shared<FixedResponder>(
+        std::string(static_cast<size_t>(FLAGS_message_len), 'a'));
+    fixture = std::make_unique<Fixture>(opts, std::move(responder));
+  }
+
+  auto const requester = fixture->clients.front()->getRequester();
+  auto const request =
+      folly::IOBuf::copyBuffer(std::string(FLAGS_message_len, 'a'));
+
+  for (size_t i = 0; i < n; ++i) {
+    folly::Baton<> baton;
+    requester->requestResponse(Payload(request->clone()))
+        ->subscribe([&baton](Payload) { baton.post(); },
+                    [&baton](folly::exception_wrapper ex) {
+                      LOG(ERROR) << "Request failed: " << ex;
+                      baton.post();
+                    });
+    baton.wait();
+  }
+
+  BENCHMARK_SUSPEND {
+    fixture.reset();
+  }
+}
+
+} // namespace
+
+BENCHMARK(RequestResponseLatencyTcp, n) {
+  runLatency(Fixture::Transport::Tcp, n);
+}
+
+BENCHMARK_RELATIVE(RequestResponseLatencyUds, n) {
+  runLatency(Fixture::Transport::Uds, n);
+}
+
+BENCHMARK_RELATIVE(RequestResponseLatencyShm, n) {
+  runLatency(Fixture::Transport::Shm, n);
+}
@@ -0,0 +1,227 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/benchmarks/Fixture.h"
+#include "rsocket/benchmarks/HdrHistogram.h"
+#include "rsocket/benchmarks/Latch.h"
+#include "rsocket/benchmarks/Throughput.h"
+
+#include <folly/Benchmark.h>
+#include <folly/Conv.h>
+#include <folly/Format.h>
+#include <folly/String.h>
+#include <folly/portability/GFlags.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "rsocket/RSocket.h"
+#include "yarpl/Single.h"
+
+using namespace rsocket;
+
+DEFINE_string(transport, "tcp", "tcp, uds, shm, io_uring or memory");
+DEFINE_string(
+    rates,
+    "1000,10000,50000,100000",
+    "comma separated list of request rates per second to sweep");
+DEFINE_int32(seconds, 10, "how long to send requests at each rate");
+DEFINE_int32(server_threads, 1, "number of server threads");
+DEFINE_int32(clients, 1, "number of clients the requests are spread over");
+DEFINE_int32(message_len, 32, "length of the requests and responses");
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// Latencies above a minute are recorded as a minute.
+constexpr uint64_t kHighestLatencyNs = 60'000'000'000;
+
+uint64_t nanos(Clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(duration)
+      .count();
+}
+
+struct Latencies {
+  /// From the time a request was scheduled to go out until its response
+  /// arrived.  A sender or a connection falling behind the schedule is
+  /// charged to every request that was due meanwhile, which corrects for
+  /// coordinated omission.
+  HdrHistogram response{kHighestLatencyNs};
+
+  /// From the time a request actually went out until its response arrived,
+  /// i.e. what a closed-loop benchmark would report.
+  HdrHistogram service{kHighestLatencyNs};
+};
+
+/// What the responses of a run are recorded into.  Shared with the callbacks,
+/// as responses may still arrive after the run timed out.
+struct Run {
+  Run(size_t clients, size_t requests) : latencies(clients), latch{requests} {}
+
+  /// One per client.
+  std::vector<Latencies> latencies;
+  std::atomic<size_t> errors{0};
+  Latch latch;
+};
+
+/// Issues `requests` requests over the `client`th client at fixed intervals
+/// starting at `start`, without ever waiting for responses.  Responses are
+/// recorded into the client's latencies on its EventBase thread.
+void sendOnSchedule(
+    RSocketClient& client,
+    size_t clientIndex,
+    Clock::time_point start,
+    Clock::duration interval,
+    size_t requests,
+    const std::shared_ptr<Run>& run) {
+  auto const requester = client.getRequester();
+  auto const request =
+      folly::IOBuf::copyBuffer(std::string(FLAGS_message_len, 'a'));
+
+  for (size_t i = 0; i < requests; ++i) {
+    auto const scheduled = start + interval * i;
+    if (Clock::now() < scheduled) {
+      std::this_thread::sleep_until(scheduled);
+    }
+
+    auto const sent = Clock::now();
+    requester->requestResponse(Payload(request->clone()))
+        ->subscribe(
+            [run, clientIndex, scheduled, sent](Payload) {
+              auto const now = Clock::now();
+              auto& latencies = run->latencies[clientIndex];
+              latencies.response.record(nanos(now - scheduled));
+              latencies.service.record(nanos(now - sent));
+              run->latch.post();
+            },
+            [run](folly::exception_wrapper ex) {
+              if (run->errors++ == 0) {
+                LOG(ERROR) << "Request failed: " << ex;
+              }
+              run->latch.post();
+            });
+  }
+}
+
+std::string formatLatency(uint64_t ns) {
+  return folly::sformat("{:.1f}us", ns / 1000.0);
+}
+
+void logLatencies(const char* what, const HdrHistogram& histogram) {
+  LOG(INFO) << folly::sformat(
+      "    {:<8} p50 {:>10} p90 {:>10} p99 {:>10} p999 {:>10} max {:>10}",
+      what,
+      formatLatency(histogram.valueAtPercentile(50)),
+      formatLatency(histogram.valueAtPercentile(90)),
+      formatLatency(histogram.valueAtPercentile(99)),
+      formatLatency(histogram.valueAtPercentile(99.9)),
+      formatLatency(histogram.max()));
+}
+
+/// Sends requests at `rate` per second for --seconds, spread evenly over all
+/// the clients, and logs the latency percentiles.
+void runRate(Fixture& fixture, uint64_t rate) {
+  auto const clients = fixture.clients.size();
+  auto const perClient = rate * FLAGS_seconds / clients;
+  if (perClient == 0) {
+    LOG(ERROR) << "Rate " << rate << "/s is too low to send any requests";
+    return;
+  }
+  auto const interval = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::nanoseconds(1'000'000'000 * clients / rate));
+
+  auto const run = std::make_shared<Run>(clients, perClient * clients);
+
+  // Let all the senders start at the same time, with their schedules
+  // interleaved.
+  auto const start = Clock::now() + std::chrono::milliseconds{10};
+  std::vector<std::thread> senders;
+  for (size_t i = 0; i < clients; ++i) {
+    senders.emplace_back([&, i] {
+      sendOnSchedule(
+          *fixture.clients[i],
+          i,
+          start + interval * i / clients,
+          interval,
+          perClient,
+          run);
+    });
+  }
+  for (auto& sender : senders) {
+    sender.join();
+  }
+  auto const sendTime = Clock::now() - start;
+
+  constexpr std::chrono::minutes timeout{5};
+  if (!run->latch.timed_wait(timeout)) {
+    LOG(ERROR) << "Timed out!";
+    return;
+  }
+
+  Latencies total;
+  for (auto const& client : run->latencies) {
+    total.response.merge(client.response);
+    total.service.merge(client.service);
+  }
+
+  auto const achieved = perClient * clients /
+      std::chrono::duration<double>(sendTime).count();
+  LOG(INFO) << folly::sformat(
+      "  {}/s target, {:.0f}/s sent, {} errors",
+      rate,
+      achieved,
+      run->errors.load());
+  logLatencies("response", total.response);
+  logLatencies("service", total.service);
+}
+
+} // namespace
+
+BENCHMARK(RequestResponseLatencyOpenLoop, n) {
+  (void)n;
+
+  std::vector<uint64_t> rates;
+  std::unique_ptr<Fixture> fixture;
+
+  BENCHMARK_SUSPEND {
+    std::vector<folly::StringPiece> pieces;
+    folly::split(',', FLAGS_rates, pieces, true);
+    for (auto const piece : pieces) {
+      rates.push_back(folly::to<uint64_t>(folly::trimWhitespace(piece)));
+    }
+
+    Fixture::Options opts;
+    opts.serverThreads = FLAGS_server_threads;
+    opts.clients = FLAGS_clients;
+    opts.transport = Fixture::parseTransport(FLAGS_transport);
+
+    auto responder = std::make_shared<FixedResponder>(
+        std::string(static_cast<size_t>(FLAGS_message_len), 'a'));
+    fixture = std::make_unique<Fixture>(opts, std::move(responder));
+
+    LOG(INFO) << "Running for " << FLAGS_seconds << "s at each rate over "
+              << FLAGS_clients << " clients.";
+  }
+
+  for (auto const rate : rates) {
+    runRate(*fixture, rate);
+  }
+
+  BENCHMARK_SUSPEND {
+    fixture.reset();
+  }
+}
@@ -17,12 +17,18 @@
 #include "rsocket/benchmarks/Throughput.h"
 
 #include <folly/Benchmark.h>
+#include <folly/Portability.h>
 #include <folly/init/Init.h>
 #include <folly/portability/GFlags.h>
 
 #include "rsocket/RSocket.h"
 #include "yarpl/Single.h"
 
+#if FOLLY_HAS_COROUTINES
+#include <folly/executors/InlineExecutor.h>
+#include <folly/experimental/coro/Task.h>
+#endif
+
 using namespace rsocket;
 
 constexpr size_t kMessageLen = 32;
@@ -33,6 +39,10 @@ DEFINE_int32(
     0,
     "control the number of client threads (defaults to the number of clients)");
 DEFINE_int32(clients, 10, "number of clients to run");
+DEFINE_string(
+    transport,
+    "tcp",
+    "transport to run over: tcp, uds, shm, io_uring or memory");
 DEFINE_int32(
     items,
     1000000,
@@ -63,21 +73,29 @@ class Observer : public yarpl::single::SingleObserverBase<Payload> {
  private:
   Latch& latch_;
 };
-} // namespace
-
-BENCHMARK(RequestResponseThroughput, n) {
-  (void)n;
 
+void runThroughput(bool coro, bool slab) {
   Latch latch{static_cast<size_t>(FLAGS_items)};
 
   std::unique_ptr<Fixture> fixture;
   Fixture::Options opts;
 
   BENCHMARK_SUSPEND {
-    auto responder =
-        std::make_shared<FixedResponder>(std::string(kMessageLen, 'a'));
+    std::shared_ptr<RSocketResponder> responder;
+#if FOLLY_HAS_COROUTINES
+    if (coro) {
+      responder =
+          std::make_shared<FixedCoroResponder>(std::string(kMessageLen, 'a'));
+    }
+#endif
+    if (!responder) {
+      responder =
+          std::make_shared<FixedResponder>(std::string(kMessageLen, 'a'));
+    }
 
     opts.serverThreads = FLAGS_server_threads;
+    opts.transport = Fixture::parseTransport(FLAGS_transport);
+    opts.slabAllocator = slab;
     opts.clients = FLAGS_clients;
     if (FLAGS_override_client_threads > 0) {
       opts.clientThreads = FLAGS_override_client_threads;
@@ -86,14 +104,39 @@ BENCHMARK(RequestResponseThroughput, n) {
     fixture = std::make_unique<Fixture>(opts, std::move(responder));
 
     LOG(INFO) << "Running:";
-    LOG(INFO) << "  Server with " << opts.serverThreads << " threads.";
+    LOG(INFO) << "  Server with " << opts.serverThreads << " threads, over "
+              << FLAGS_transport << ".";
     LOG(INFO) << "  " << opts.clients << " clients across "
               << fixture->workers.size() << " threads.";
-    LOG(INFO) << "  Running " << FLAGS_items << " requests in total";
+    LOG(INFO) << "  Running " << FLAGS_items << " requests in total"
+              << (coro ? " using coroutines" : "")
+              << (slab ? " with slab allocated frames" : "");
   }
 
+#if FOLLY_HAS_COROUTINES
+  // resume the requests inline on the client EventBase which fulfils them
+  auto& inlineExecutor = folly::InlineExecutor::instance();
+#endif
+
   for (int i = 0; i < FLAGS_items; ++i) {
     auto& client = fixture->clients[i % opts.clients];
+#if FOLLY_HAS_COROUTINES
+    if (coro) {
+      folly::coro::co_invoke(
+          [requester = client->getRequester(),
+           &latch]() -> folly::coro::Task<void> {
+            try {
+              co_await requester->co_requestResponse(
+                  Payload("RequestResponseTcp"));
+            } catch (const std::exception&) {
+            }
+            latch.post();
+          })
+          .scheduleOn(&inlineExecutor)
+          .start();
+      continue;
+    }
+#endif
     client->getRequester()
         ->requestResponse(Payload("RequestResponseTcp"))
         ->subscribe(std::make_shared<Observer>(latch));
@@ -104,3 +147,21 @@ BENCHMARK(RequestResponseThroughput, n) {
     LOG(ERROR) << "Timed out!";
   }
 }
+} // namespace
+
+BENCHMARK(RequestResponseThroughput, n) {
+  (void)n;
+  runThroughput(false, false);
+}
+
+BENCHMARK_RELATIVE(RequestResponseThroughputSlab, n) {
+  (void)n;
+  runThroughput(false, true);
+}
+
+#if FOLLY_HAS_COROUTINES
+BENCHMARK_RELATIVE(RequestResponseThroughputCoro, n) {
+  (void)n;
+  runThroughput(true, false);
+}
+#endif
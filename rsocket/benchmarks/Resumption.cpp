@@ -0,0 +1,380 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/benchmarks/CpuTime.h"
+#include "rsocket/benchmarks/Latch.h"
+#include "rsocket/benchmarks/Throughput.h"
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/Synchronized.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/portability/GFlags.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <thread>
+
+#include "rsocket/RSocket.h"
+#include "rsocket/internal/WarmResumeManager.h"
+#include "rsocket/test/test_utils/ColdResumeManager.h"
+#include "rsocket/transports/tcp/TcpConnectionAcceptor.h"
+#include "rsocket/transports/tcp/TcpConnectionFactory.h"
+
+using namespace rsocket;
+
+DEFINE_int32(mb, 64, "megabytes of frames left unacknowledged at disconnect");
+DEFINE_int32(streams, 16, "number of streams the frames are spread over");
+DEFINE_int32(message_len, 4096, "length of the streamed messages");
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::chrono::microseconds micros(Clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(duration);
+}
+
+/// Counts the payloads the server hands to its connections, and the bytes it
+/// replays when a client resumes.
+class ServerStats : public RSocketStats {
+ public:
+  void frameWritten(FrameType frameType) override {
+    if (frameType == FrameType::PAYLOAD) {
+      ++payloadsWritten;
+    }
+  }
+
+  void serverResume(
+      folly::Optional<int64_t>,
+      int64_t,
+      int64_t serverDelta,
+      ResumeOutcome outcome) override {
+    replayed = outcome == ResumeOutcome::SUCCESS ? serverDelta : -1;
+  }
+
+  std::atomic<size_t> payloadsWritten{0};
+  std::atomic<int64_t> replayed{0};
+};
+
+/// Keeps the state of every connection around for its client to resume, with
+/// a resume buffer large enough for all the frames of a run.
+class ServiceHandler : public RSocketServiceHandler {
+ public:
+  ServiceHandler(std::shared_ptr<ServerStats> stats, size_t resumeCapacity)
+      : responder_{std::make_shared<FixedResponder>(
+            std::string(FLAGS_message_len, 'a'))},
+        stats_{std::move(stats)},
+        resumeCapacity_{resumeCapacity} {}
+
+  folly::Expected<RSocketConnectionParams, RSocketException> onNewSetup(
+      const SetupParameters&) override {
+    RSocketConnectionParams params{responder_, stats_};
+    params.resumeManager =
+        std::make_shared<WarmResumeManager>(stats_, resumeCapacity_);
+    return params;
+  }
+
+  void onNewRSocketState(
+      std::shared_ptr<RSocketServerState> state,
+      ResumeIdentificationToken token) override {
+    (*states_.wlock())[token] = std::move(state);
+  }
+
+  folly::Expected<std::shared_ptr<RSocketServerState>, RSocketException>
+  onResume(ResumeIdentificationToken token) override {
+    auto states = states_.rlock();
+    auto const it = states->find(token);
+    if (it == states->end()) {
+      return folly::makeUnexpected(RSocketException("No ServerState"));
+    }
+    return it->second;
+  }
+
+ private:
+  const std::shared_ptr<RSocketResponder> responder_;
+  const std::shared_ptr<ServerStats> stats_;
+  const size_t resumeCapacity_;
+  folly::Synchronized<
+      std::map<ResumeIdentificationToken, std::shared_ptr<RSocketServerState>>>
+      states_;
+};
+
+/// Items received across all the streams of a run, before and after resuming.
+struct Progress {
+  explicit Progress(size_t items) : done{items} {}
+
+  void onItem() {
+    ++received;
+    if (resuming) {
+      Clock::rep none = 0;
+      firstResumedItem.compare_exchange_strong(
+          none, Clock::now().time_since_epoch().count());
+    }
+    done.post();
+  }
+
+  Latch done;
+  std::atomic<size_t> received{0};
+  std::atomic<bool> resuming{false};
+  std::atomic<Clock::rep> firstResumedItem{0};
+};
+
+/// Subscriber that requests items when subscribed, unless it takes over a
+/// stream whose items were already requested, and cancels the stream once
+/// `items` of them arrived.
+class CountingSubscriber : public yarpl::flowable::BaseSubscriber<Payload> {
+ public:
+  CountingSubscriber(Progress& progress, size_t items, bool request)
+      : progress_{progress}, items_{items}, request_{request} {}
+
+  void onSubscribeImpl() override {
+    if (items_ == 0) {
+      this->cancel();
+    } else if (request_) {
+      this->request(items_);
+    }
+  }
+
+  void onNextImpl(Payload) override {
+    progress_.onItem();
+    if (++received_ == items_) {
+      this->cancel();
+    }
+  }
+
+  void onCompleteImpl() override {}
+  void onErrorImpl(folly::exception_wrapper) override {}
+
+ private:
+  Progress& progress_;
+  const size_t items_;
+  const bool request_;
+  size_t received_{0};
+};
+
+/// Hands the streams of a cold resumed client to new subscribers, which
+/// expect the items that were requested but didn't arrive before the restart.
+class ResumeHandler : public ColdResumeHandler {
+ public:
+  explicit ResumeHandler(Progress& progress) : progress_{progress} {}
+
+  std::shared_ptr<yarpl::flowable::Subscriber<Payload>>
+  handleRequesterResumeStream(std::string, size_t consumerAllowance)
+      override {
+    return std::make_shared<CountingSubscriber>(
+        progress_, consumerAllowance, false);
+  }
+
+ private:
+  Progress& progress_;
+};
+
+/// A server and the thread its client runs on, for one run.
+struct Run {
+  Run()
+      : itemsPerStream{std::max<size_t>(
+            1,
+            (static_cast<size_t>(FLAGS_mb) << 20) /
+                (FLAGS_streams * FLAGS_message_len))},
+        items{itemsPerStream * FLAGS_streams},
+        progress{items} {
+    TcpConnectionAcceptor::Options opts;
+    opts.address = folly::SocketAddress{"0.0.0.0", 0};
+    opts.threads = 1;
+    server = RSocket::createServer(
+        std::make_unique<TcpConnectionAcceptor>(std::move(opts)));
+
+    // Room for every payload frame with its header, and the frames around
+    // them.
+    auto const capacity = items * (FLAGS_message_len + 64) + (1 << 20);
+    server->start(std::make_shared<ServiceHandler>(stats, capacity));
+
+    LOG(INFO) << "  Streaming " << FLAGS_streams << " streams of "
+              << itemsPerStream << " items of " << FLAGS_message_len
+              << " bytes each.";
+  }
+
+  std::shared_ptr<ConnectionFactory> makeFactory() {
+    return std::make_shared<TcpConnectionFactory>(
+        *worker.getEventBase(),
+        folly::SocketAddress{"127.0.0.1", *server->listeningPort()});
+  }
+
+  /// Opens the streams, then blocks the client's EventBase so it stops
+  /// reading until the server handed every item to the connection, and kills
+  /// the connection.  Whatever the client didn't read is left unacknowledged
+  /// in the server's resume buffer.
+  void buildUpAndDisconnect(RSocketClient& client) {
+    auto const evb = worker.getEventBase();
+    evb->runInEventBaseThread([&] {
+      for (int i = 0; i < FLAGS_streams; ++i) {
+        client.getRequester()
+            ->requestStream(Payload("Resumption"))
+            ->subscribe(std::make_shared<CountingSubscriber>(
+                progress, itemsPerStream, true));
+      }
+    });
+
+    evb->runInEventBaseThreadAndWait([&] {
+      auto const deadline = Clock::now() + std::chrono::minutes{1};
+      while (stats->payloadsWritten < items && Clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+      }
+      client.disconnect(std::runtime_error{"Killing the connection"});
+    });
+
+    LOG(INFO) << "  Left " << items - progress.received << " of " << items
+              << " items unacknowledged.";
+  }
+
+  /// Waits for the rest of the items and logs how resuming went.
+  void finish(
+      Clock::time_point start,
+      Clock::time_point resumed,
+      std::chrono::microseconds cpuStart) {
+    constexpr std::chrono::minutes timeout{5};
+    if (!progress.done.timed_wait(timeout)) {
+      LOG(ERROR) << "Timed out!";
+      return;
+    }
+    auto const end = Clock::now();
+    auto const cpu = cpuTime() - cpuStart;
+
+    LOG(INFO) << "  Replayed " << stats->replayed << " bytes.";
+    LOG(INFO) << "  Resumed after " << micros(resumed - start).count()
+              << "us, all items arrived after "
+              << micros(end - start).count() << "us.";
+    if (auto const firstItem = progress.firstResumedItem.load()) {
+      auto const delay = Clock::time_point{Clock::duration{firstItem}} - start;
+      LOG(INFO) << "  First item after resuming arrived after "
+                << micros(delay).count() << "us.";
+    }
+    LOG(INFO) << "  Used " << cpu.count() << "us of CPU time.";
+  }
+
+  const size_t itemsPerStream;
+  const size_t items;
+  Progress progress;
+  const std::shared_ptr<ServerStats> stats{std::make_shared<ServerStats>()};
+  std::unique_ptr<RSocketServer> server;
+  folly::ScopedEventBaseThread worker;
+};
+
+} // namespace
+
+BENCHMARK(WarmResumption, n) {
+  (void)n;
+
+  std::unique_ptr<Run> run;
+  std::unique_ptr<RSocketClient> client;
+
+  BENCHMARK_SUSPEND {
+    run = std::make_unique<Run>();
+
+    SetupParameters setupParameters;
+    setupParameters.resumable = true;
+    client = RSocket::createConnectedClient(
+                 run->makeFactory(),
+                 std::move(setupParameters),
+                 std::make_shared<RSocketResponder>(),
+                 kDefaultKeepaliveInterval,
+                 RSocketStats::noop(),
+                 nullptr, // connectionEvents
+                 std::make_shared<WarmResumeManager>(RSocketStats::noop()))
+                 .get();
+
+    run->buildUpAndDisconnect(*client);
+  }
+
+  auto const start = Clock::now();
+  auto const cpuStart = cpuTime();
+  run->progress.resuming = true;
+
+  client->resume().get();
+  auto const resumed = Clock::now();
+
+  run->finish(start, resumed, cpuStart);
+
+  BENCHMARK_SUSPEND {
+    client.reset();
+    run.reset();
+  }
+}
+
+BENCHMARK(ColdResumption, n) {
+  (void)n;
+
+  std::unique_ptr<Run> run;
+  std::unique_ptr<RSocketClient> client;
+  std::shared_ptr<ResumeHandler> resumeHandler;
+  auto const token = ResumeIdentificationToken::generateNew();
+  auto const path =
+      folly::sformat("/tmp/rsocket-resumption-{}.json", getpid());
+
+  BENCHMARK_SUSPEND {
+    run = std::make_unique<Run>();
+    resumeHandler = std::make_shared<ResumeHandler>(run->progress);
+
+    SetupParameters setupParameters;
+    setupParameters.resumable = true;
+    setupParameters.token = token;
+    auto resumeManager =
+        std::make_shared<ColdResumeManager>(RSocketStats::noop());
+    client = RSocket::createConnectedClient(
+                 run->makeFactory(),
+                 std::move(setupParameters),
+                 std::make_shared<RSocketResponder>(),
+                 kDefaultKeepaliveInterval,
+                 RSocketStats::noop(),
+                 nullptr, // connectionEvents
+                 resumeManager,
+                 resumeHandler)
+                 .get();
+
+    run->buildUpAndDisconnect(*client);
+
+    // Stand in for the client process going away.
+    auto const persistStart = Clock::now();
+    run->worker.getEventBase()->runInEventBaseThreadAndWait(
+        [&] { resumeManager->persistState(path); });
+    LOG(INFO) << "  Persisted the client's state in "
+              << micros(Clock::now() - persistStart).count() << "us.";
+    client.reset();
+  }
+
+  auto const start = Clock::now();
+  auto const cpuStart = cpuTime();
+  run->progress.resuming = true;
+
+  client = RSocket::createResumedClient(
+               run->makeFactory(),
+               token,
+               std::make_shared<ColdResumeManager>(RSocketStats::noop(), path),
+               resumeHandler)
+               .get();
+  auto const resumed = Clock::now();
+
+  run->finish(start, resumed, cpuStart);
+
+  BENCHMARK_SUSPEND {
+    client.reset();
+    run.reset();
+    std::remove(path.c_str());
+  }
+}
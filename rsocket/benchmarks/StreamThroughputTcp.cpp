@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "rsocket/benchmarks/CpuTime.h"
 #include "rsocket/benchmarks/Fixture.h"
 #include "rsocket/benchmarks/Throughput.h"
 
@@ -19,20 +20,49 @@
 #include <folly/portability/GFlags.h>
 #include <folly/synchronization/Baton.h>
 
+#include <atomic>
+
 #include "rsocket/RSocket.h"
 
 using namespace rsocket;
 
-constexpr size_t kMessageLen = 32;
-
 DEFINE_int32(server_threads, 8, "number of server threads to run");
 DEFINE_int32(
     override_client_threads,
     0,
     "control the number of client threads (defaults to the number of clients)");
 DEFINE_int32(clients, 10, "number of clients to run");
+DEFINE_string(
+    transport,
+    "tcp",
+    "transport to run over: tcp, uds, shm, io_uring or memory");
 DEFINE_int32(items, 1000000, "number of items in stream, per client");
 DEFINE_int32(streams, 1, "number of streams, per client");
+DEFINE_int32(message_len, 32, "length of the streamed messages");
+DEFINE_int32(
+    zerocopy_threshold,
+    0,
+    "write frames of at least this many bytes with MSG_ZEROCOPY over tcp, "
+    "0 to disable");
+
+namespace {
+
+/// Counts how the server wrote the frames that were eligible for zerocopy.
+class ZeroCopyStats : public RSocketStats {
+ public:
+  void zeroCopyRequested(size_t) override {
+    ++requested;
+  }
+
+  void zeroCopyFallback(size_t) override {
+    ++fallbacks;
+  }
+
+  std::atomic<size_t> requested{0};
+  std::atomic<size_t> fallbacks{0};
+};
+
+} // namespace
 
 BENCHMARK(StreamThroughput, n) {
   (void)n;
@@ -41,13 +71,18 @@ BENCHMARK(StreamThroughput, n) {
 
   std::unique_ptr<Fixture> fixture;
   Fixture::Options opts;
+  auto const stats = std::make_shared<ZeroCopyStats>();
+  std::chrono::microseconds cpuStart;
 
   BENCHMARK_SUSPEND {
     auto responder =
-        std::make_shared<FixedResponder>(std::string(kMessageLen, 'a'));
+        std::make_shared<FixedResponder>(std::string(FLAGS_message_len, 'a'));
 
     opts.serverThreads = FLAGS_server_threads;
+    opts.transport = Fixture::parseTransport(FLAGS_transport);
     opts.clients = FLAGS_clients;
+    opts.zeroCopyThreshold = FLAGS_zerocopy_threshold;
+    opts.serverStats = stats;
     if (FLAGS_override_client_threads > 0) {
       opts.clientThreads = FLAGS_override_client_threads;
     }
@@ -55,11 +90,14 @@ BENCHMARK(StreamThroughput, n) {
     fixture = std::make_unique<Fixture>(opts, std::move(responder));
 
     LOG(INFO) << "Running:";
-    LOG(INFO) << "  Server with " << opts.serverThreads << " threads.";
+    LOG(INFO) << "  Server with " << opts.serverThreads << " threads, over "
+              << FLAGS_transport << ".";
     LOG(INFO) << "  " << opts.clients << " clients across "
               << fixture->workers.size() << " threads.";
     LOG(INFO) << "  Running " << FLAGS_streams << " streams of " << FLAGS_items
-              << " items each.";
+              << " items of " << FLAGS_message_len << " bytes each.";
+
+    cpuStart = cpuTime();
   }
 
   for (size_t i = 0; i < FLAGS_streams; ++i) {
@@ -74,4 +112,13 @@ BENCHMARK(StreamThroughput, n) {
   if (!latch.timed_wait(timeout)) {
     LOG(ERROR) << "Timed out!";
   }
+
+  BENCHMARK_SUSPEND {
+    LOG(INFO) << "  Used " << (cpuTime() - cpuStart).count()
+              << "us of CPU time.";
+    if (FLAGS_zerocopy_threshold > 0) {
+      LOG(INFO) << "  " << stats->requested << " zerocopy writes, "
+                << stats->fallbacks << " copied.";
+    }
+  }
 }
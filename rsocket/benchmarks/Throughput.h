@@ -44,6 +44,32 @@ class FixedResponder : public RSocketResponder {
   std::unique_ptr<folly::IOBuf> message_;
 };
 
+#if FOLLY_HAS_COROUTINES
+/// Coroutine responder that always sends back a fixed message.
+class FixedCoroResponder : public RSocketCoroResponder {
+ public:
+  explicit FixedCoroResponder(const std::string& message)
+      : message_{folly::IOBuf::copyBuffer(message)} {}
+
+  /// Infinitely streams back the message.
+  folly::coro::AsyncGenerator<Payload&&> co_handleRequestStream(
+      Payload,
+      StreamId) override {
+    while (true) {
+      co_yield Payload(message_->clone());
+    }
+  }
+
+  folly::coro::Task<Payload> co_handleRequestResponse(Payload, StreamId)
+      override {
+    co_return Payload(message_->clone());
+  }
+
+ private:
+  std::unique_ptr<folly::IOBuf> message_;
+};
+#endif
+
 /// Subscriber that requests N items and cancels the subscription once all of
 /// them arrive.  Signals a latch when it terminates.
 class BoundedSubscriber : public yarpl::flowable::BaseSubscriber<Payload> {
@@ -20,6 +20,8 @@
 #include <sstream>
 
 #include "rsocket/RSocketParameters.h"
+#include "rsocket/framing/MetadataDictionary.h"
+#include "rsocket/framing/PayloadCompressor.h"
 
 namespace rsocket {
 
@@ -161,6 +163,10 @@ std::ostream& operator<<(std::ostream& os, const Frame_SETUP& frame) {
 void Frame_SETUP::moveToSetupPayload(SetupParameters& setupPayload) {
   setupPayload.metadataMimeType = std::move(metadataMimeType_);
   setupPayload.dataMimeType = std::move(dataMimeType_);
+  setupPayload.compression =
+      PayloadCompressor::takeFromMimeType(setupPayload.dataMimeType);
+  setupPayload.metadataDictionarySize =
+      MetadataDictionary::takeFromMimeType(setupPayload.metadataMimeType);
   setupPayload.payload = std::move(payload_);
   setupPayload.token = std::move(token_);
   setupPayload.resumable = !!(header_.flags & FrameFlags::RESUME_ENABLE);
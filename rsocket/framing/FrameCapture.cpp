@@ -0,0 +1,327 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/framing/FrameCapture.h"
+
+#include <folly/lang/Bits.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/io/Cursor.h>
+#include <glog/logging.h>
+
+#include <fcntl.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+namespace rsocket {
+
+namespace {
+
+/// Time, connection, direction and length.
+constexpr size_t kRecordHeaderLength = 8 + 4 + 1 + 4;
+
+/// Bytes a thread buffers before it wakes the writer up.
+constexpr size_t kFlushThreshold = 1 << 20;
+
+/// Bytes a thread buffers before it drops records, when the writer can't keep
+/// up.
+constexpr size_t kMaxBuffered = 64 << 20;
+
+/// How often the writer writes out whatever the threads buffered.
+constexpr std::chrono::milliseconds kWriteInterval{100};
+
+template <typename T>
+void appendBigEndian(std::string& buffer, T value) {
+  value = folly::Endian::big(value);
+  buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+uint64_t recordTime(const std::string& records, size_t offset) {
+  uint64_t time;
+  std::memcpy(&time, records.data() + offset, sizeof(time));
+  return folly::Endian::big(time);
+}
+
+size_t recordLength(const std::string& records, size_t offset) {
+  uint32_t length;
+  std::memcpy(
+      &length,
+      records.data() + offset + kRecordHeaderLength - sizeof(length),
+      sizeof(length));
+  return kRecordHeaderLength + folly::Endian::big(length);
+}
+
+/// Merges the records buffered by different threads into time order.
+std::string mergeByTime(std::vector<std::string> chunks) {
+  if (chunks.size() == 1) {
+    return std::move(chunks[0]);
+  }
+
+  size_t total = 0;
+  for (const auto& chunk : chunks) {
+    total += chunk.size();
+  }
+  std::string merged;
+  merged.reserve(total);
+
+  std::vector<size_t> offsets(chunks.size(), 0);
+  while (merged.size() < total) {
+    folly::Optional<size_t> next;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+      if (offsets[i] < chunks[i].size() &&
+          (!next ||
+           recordTime(chunks[i], offsets[i]) <
+               recordTime(chunks[*next], offsets[*next]))) {
+        next = i;
+      }
+    }
+    const auto length = recordLength(chunks[*next], offsets[*next]);
+    merged.append(chunks[*next], offsets[*next], length);
+    offsets[*next] += length;
+  }
+  return merged;
+}
+
+/// Records the frames a connection receives before passing them on.
+class CapturingSubscriber : public DuplexConnection::Subscriber {
+ public:
+  CapturingSubscriber(
+      std::shared_ptr<DuplexConnection::Subscriber> inner,
+      std::shared_ptr<FrameCapture> capture,
+      uint32_t connection)
+      : inner_{std::move(inner)},
+        capture_{std::move(capture)},
+        connection_{connection} {}
+
+  void onSubscribe(
+      std::shared_ptr<yarpl::flowable::Subscription> subscription) override {
+    inner_->onSubscribe(std::move(subscription));
+  }
+
+  void onNext(std::unique_ptr<folly::IOBuf> frame) override {
+    capture_->record(connection_, FrameCapture::Direction::RECEIVED, *frame);
+    inner_->onNext(std::move(frame));
+  }
+
+  void onComplete() override {
+    inner_->onComplete();
+  }
+
+  void onError(folly::exception_wrapper ew) override {
+    inner_->onError(std::move(ew));
+  }
+
+ private:
+  const std::shared_ptr<DuplexConnection::Subscriber> inner_;
+  const std::shared_ptr<FrameCapture> capture_;
+  const uint32_t connection_;
+};
+
+} // namespace
+
+constexpr folly::StringPiece FrameCapture::kMagic;
+
+FrameCapture::FrameCapture(const std::string& path)
+    : start_{std::chrono::steady_clock::now()},
+      file_{path, O_WRONLY | O_CREAT | O_TRUNC} {
+  writer_ = std::thread{[this] { writerLoop(); }};
+}
+
+FrameCapture::~FrameCapture() {
+  {
+    std::lock_guard<std::mutex> lock{writerMutex_};
+    stopping_ = true;
+  }
+  writerCv_.notify_one();
+  writer_.join();
+  writeOut();
+}
+
+void FrameCapture::record(
+    uint32_t connection,
+    Direction direction,
+    const folly::IOBuf& frame) {
+  if (failed()) {
+    return;
+  }
+
+  auto& buffer = localBuffer();
+  const auto length = frame.computeChainDataLength();
+  bool wakeWriter;
+  {
+    std::lock_guard<std::mutex> lock{buffer.mutex};
+    if (buffer.records.size() >= kMaxBuffered) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    // Taken under the lock, so that the records of a thread are in order.
+    const auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start_);
+    auto& records = buffer.records;
+    appendBigEndian<uint64_t>(records, time.count());
+    appendBigEndian<uint32_t>(records, connection);
+    appendBigEndian<uint8_t>(records, static_cast<uint8_t>(direction));
+    appendBigEndian<uint32_t>(records, length);
+    for (const auto range : frame) {
+      records.append(reinterpret_cast<const char*>(range.data()), range.size());
+    }
+    wakeWriter = records.size() >= kFlushThreshold;
+  }
+
+  // Notifying without the writer's mutex may miss a wakeup, the writer then
+  // gets to the records after kWriteInterval anyway.
+  if (wakeWriter) {
+    writerCv_.notify_one();
+  }
+}
+
+void FrameCapture::flush() {
+  writeOut();
+}
+
+FrameCapture::ThreadBuffer& FrameCapture::localBuffer() {
+  auto& buffer = *localBuffer_;
+  if (!buffer) {
+    buffer = std::make_shared<ThreadBuffer>();
+    // Kept past the thread's exit, until its records are written out.
+    std::lock_guard<std::mutex> lock{buffersMutex_};
+    buffers_.push_back(buffer);
+  }
+  return *buffer;
+}
+
+void FrameCapture::writerLoop() {
+  std::unique_lock<std::mutex> lock{writerMutex_};
+  while (!stopping_) {
+    writerCv_.wait_for(lock, kWriteInterval);
+    lock.unlock();
+    writeOut();
+    lock.lock();
+  }
+}
+
+void FrameCapture::writeOut() {
+  std::lock_guard<std::mutex> fileLock{fileMutex_};
+
+  std::vector<std::string> chunks;
+  {
+    std::lock_guard<std::mutex> lock{buffersMutex_};
+    for (const auto& buffer : buffers_) {
+      std::string records;
+      {
+        std::lock_guard<std::mutex> bufferLock{buffer->mutex};
+        records.swap(buffer->records);
+      }
+      if (!records.empty()) {
+        chunks.push_back(std::move(records));
+      }
+    }
+  }
+
+  if (const auto dropped = dropped_.exchange(0, std::memory_order_relaxed)) {
+    LOG(WARNING) << "Dropped " << dropped << " captured frames, writing them "
+                 << "out can't keep up";
+  }
+  if (failed() || (chunks.empty() && wroteMagic_)) {
+    return;
+  }
+
+  auto records = mergeByTime(std::move(chunks));
+  if (!wroteMagic_) {
+    records.insert(0, kMagic.data(), kMagic.size());
+    wroteMagic_ = true;
+  }
+  if (folly::writeFull(file_.fd(), records.data(), records.size()) < 0) {
+    const auto error = errno;
+    LOG(ERROR) << "Failed to write captured frames, stopping the capture: "
+               << folly::errnoStr(error);
+    failed_.store(true, std::memory_order_relaxed);
+  }
+}
+
+CapturingDuplexConnection::CapturingDuplexConnection(
+    std::unique_ptr<DuplexConnection> connection,
+    std::shared_ptr<FrameCapture> capture)
+    : inner_{std::move(connection)},
+      capture_{std::move(capture)},
+      connection_{capture_->nextConnection()} {}
+
+void CapturingDuplexConnection::setInput(
+    std::shared_ptr<DuplexConnection::Subscriber> subscriber) {
+  inner_->setInput(std::make_shared<CapturingSubscriber>(
+      std::move(subscriber), capture_, connection_));
+}
+
+void CapturingDuplexConnection::send(std::unique_ptr<folly::IOBuf> frame) {
+  capture_->record(connection_, FrameCapture::Direction::SENT, *frame);
+  inner_->send(std::move(frame));
+}
+
+void CapturingDuplexConnection::setWriteWatermarks(
+    WriteWatermarks watermarks,
+    WritabilityCallback callback) {
+  inner_->setWriteWatermarks(watermarks, std::move(callback));
+}
+
+FrameCaptureReader::FrameCaptureReader(const std::string& path)
+    : file_{path, O_RDONLY} {
+  char magic[FrameCapture::kMagic.size()];
+  if (!read(magic, sizeof(magic)) ||
+      folly::StringPiece{magic, sizeof(magic)} != FrameCapture::kMagic) {
+    throw std::runtime_error{path + " is not a frame capture"};
+  }
+}
+
+folly::Optional<CapturedFrame> FrameCaptureReader::next() {
+  uint8_t header[kRecordHeaderLength];
+  if (!read(header, 1)) {
+    return folly::none;
+  }
+  if (!read(header + 1, sizeof(header) - 1)) {
+    throw std::runtime_error{"Frame capture is cut short"};
+  }
+
+  folly::IOBuf headerBuf{folly::IOBuf::WRAP_BUFFER, header, sizeof(header)};
+  folly::io::Cursor cur{&headerBuf};
+
+  CapturedFrame captured;
+  captured.time = std::chrono::nanoseconds{cur.readBE<uint64_t>()};
+  captured.connection = cur.readBE<uint32_t>();
+  const auto direction = cur.readBE<uint8_t>();
+  if (direction > static_cast<uint8_t>(FrameCapture::Direction::SENT)) {
+    throw std::runtime_error{"Frame capture is corrupt"};
+  }
+  captured.direction = static_cast<FrameCapture::Direction>(direction);
+
+  const auto length = cur.readBE<uint32_t>();
+  captured.frame = folly::IOBuf::create(length);
+  if (!read(captured.frame->writableData(), length)) {
+    throw std::runtime_error{"Frame capture is cut short"};
+  }
+  captured.frame->append(length);
+  return captured;
+}
+
+bool FrameCaptureReader::read(void* data, size_t length) {
+  const auto n = folly::readFull(file_.fd(), data, length);
+  if (n < 0) {
+    throw std::system_error(
+        errno, std::generic_category(), "Failed to read frame capture");
+  }
+  return static_cast<size_t>(n) == length;
+}
+
+} // namespace rsocket
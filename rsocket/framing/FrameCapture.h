@@ -0,0 +1,169 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/File.h>
+#include <folly/Optional.h>
+#include <folly/ThreadLocal.h>
+#include <folly/io/IOBuf.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rsocket/DuplexConnection.h"
+
+namespace rsocket {
+
+/// Records the frames of any number of connections into a binary file, to
+/// replay them later.
+///
+/// The file starts with the 8 bytes "RSCAP001", followed by one record per
+/// frame.  Integers are big endian:
+///
+///   uint64  nanoseconds since the capture was opened
+///   uint32  connection, numbered from 0 in the order they were captured
+///   uint8   0 for a frame the connection received, 1 for one it sent
+///   uint32  length of the frame
+///   bytes   the frame, without the frame length field of the transport
+///
+/// Each thread buffers its records in memory, and a thread of the capture's
+/// own writes them out, so capturing costs a copy of every frame and a lock
+/// that only that thread and the writer take.  Records of one thread, and so
+/// of one connection, are in time order, those of different threads nearly
+/// so.  If writing fails, the error is logged and capturing stops.
+/// Thread-safe.
+class FrameCapture {
+ public:
+  enum class Direction : uint8_t {
+    RECEIVED = 0,
+    SENT = 1,
+  };
+
+  static constexpr folly::StringPiece kMagic{"RSCAP001"};
+
+  /// Truncates or creates the file at `path`.  Throws if it can't be opened.
+  explicit FrameCapture(const std::string& path);
+
+  /// Stops the writer and writes out the records still buffered.
+  ~FrameCapture();
+
+  FrameCapture(const FrameCapture&) = delete;
+  FrameCapture& operator=(const FrameCapture&) = delete;
+
+  /// Number for a new connection to record frames of.
+  uint32_t nextConnection() {
+    return nextConnection_++;
+  }
+
+  /// Buffers the record of a frame, doesn't block on I/O.
+  void record(uint32_t connection, Direction, const folly::IOBuf& frame);
+
+  /// Writes out the records buffered so far.  Blocks on the file I/O, so it's
+  /// not for EventBase threads.
+  void flush();
+
+  /// Whether capturing stopped because writing the file failed.
+  bool failed() const {
+    return failed_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct ThreadBuffer {
+    std::mutex mutex;
+    std::string records;
+  };
+
+  ThreadBuffer& localBuffer();
+  void writerLoop();
+  void writeOut();
+
+  const std::chrono::steady_clock::time_point start_;
+  std::atomic<uint32_t> nextConnection_{0};
+  std::atomic<bool> failed_{false};
+  /// Records dropped because a thread's buffer was full.
+  std::atomic<uint64_t> dropped_{0};
+
+  folly::ThreadLocal<std::shared_ptr<ThreadBuffer>> localBuffer_;
+  std::mutex buffersMutex_;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+
+  std::mutex fileMutex_;
+  folly::File file_;
+  bool wroteMagic_{false};
+
+  std::mutex writerMutex_;
+  std::condition_variable writerCv_;
+  bool stopping_{false};
+  std::thread writer_;
+};
+
+/// Hands every frame a connection sends or receives to a FrameCapture.  Wraps
+/// a connection that already respects frame boundaries.
+class CapturingDuplexConnection : public DuplexConnection {
+ public:
+  CapturingDuplexConnection(
+      std::unique_ptr<DuplexConnection> connection,
+      std::shared_ptr<FrameCapture> capture);
+
+  void setInput(std::shared_ptr<DuplexConnection::Subscriber>) override;
+
+  void send(std::unique_ptr<folly::IOBuf>) override;
+
+  void setWriteWatermarks(WriteWatermarks, WritabilityCallback) override;
+
+  bool isFramed() const override {
+    return inner_->isFramed();
+  }
+
+  DuplexConnection* getConnection() {
+    return inner_.get();
+  }
+
+ private:
+  const std::unique_ptr<DuplexConnection> inner_;
+  const std::shared_ptr<FrameCapture> capture_;
+  const uint32_t connection_;
+};
+
+/// A frame read back from a capture file.
+struct CapturedFrame {
+  std::chrono::nanoseconds time;
+  uint32_t connection;
+  FrameCapture::Direction direction;
+  std::unique_ptr<folly::IOBuf> frame;
+};
+
+/// Reads the frames of a capture file in the order they were recorded.
+class FrameCaptureReader {
+ public:
+  /// Throws if the file can't be opened or isn't a capture.
+  explicit FrameCaptureReader(const std::string& path);
+
+  /// The next frame, or none at the end of the file.  Throws if the file is
+  /// cut short or corrupt.
+  folly::Optional<CapturedFrame> next();
+
+ private:
+  bool read(void* data, size_t length);
+
+  folly::File file_;
+};
+
+} // namespace rsocket
@@ -25,6 +25,10 @@ class FrameProcessor {
 
   virtual void processFrame(std::unique_ptr<folly::IOBuf>) = 0;
   virtual void onTerminal(folly::exception_wrapper) = 0;
+
+  /// Called when the transport's write buffer crosses its watermarks, see
+  /// FrameTransport::setWriteWatermarks().
+  virtual void onWritabilityChanged(bool /* writable */) {}
 };
 
 } // namespace rsocket
@@ -39,10 +39,47 @@ bool& FrameSerializer::preallocateFrameSizeField() {
   return preallocateFrameSizeField_;
 }
 
+void FrameSerializer::setAllocator(std::shared_ptr<BufferAllocator> allocator) {
+  allocator_ = std::move(allocator);
+}
+
+void FrameSerializer::setPayloadCompressor(
+    std::shared_ptr<PayloadCompressor> compressor) {
+  compressor_ = std::move(compressor);
+}
+
+void FrameSerializer::setMetadataDictionary(
+    std::shared_ptr<MetadataDictionary> dictionary) {
+  dictionary_ = std::move(dictionary);
+}
+
+void FrameSerializer::encodePayload(Payload& payload) const {
+  if (compressor_ && payload.data && !payload.data->empty()) {
+    payload.data = compressor_->compress(std::move(payload.data));
+  }
+  if (dictionary_ && payload.metadata && !payload.metadata->empty()) {
+    payload.metadata = dictionary_->encode(std::move(payload.metadata));
+  }
+}
+
+void FrameSerializer::decodePayload(Payload& payload) const {
+  if (compressor_ && payload.data) {
+    payload.data = compressor_->decompress(std::move(payload.data));
+  }
+  if (dictionary_ && payload.metadata && !payload.metadata->empty()) {
+    payload.metadata = dictionary_->decode(std::move(payload.metadata));
+  }
+}
+
+size_t FrameSerializer::frameLengthHeadroom() const {
+  return preallocateFrameSizeField_ ? frameLengthFieldSize() : 0;
+}
+
 folly::IOBufQueue FrameSerializer::createBufferQueue(size_t bufferSize) const {
-  const auto prependSize =
-      preallocateFrameSizeField_ ? frameLengthFieldSize() : 0;
-  auto buf = folly::IOBuf::createCombined(bufferSize + prependSize);
+  const auto prependSize = frameLengthHeadroom();
+  const auto size = bufferSize + prependSize;
+  auto buf = allocator_ ? allocator_->allocate(size)
+                        : folly::IOBuf::createCombined(size);
   buf->advance(prependSize);
   folly::IOBufQueue queue(folly::IOBufQueue::cacheChainLength());
   queue.append(std::move(buf));
@@ -18,7 +18,10 @@
 
 #include <memory>
 
+#include "rsocket/BufferAllocator.h"
 #include "rsocket/framing/Frame.h"
+#include "rsocket/framing/MetadataDictionary.h"
+#include "rsocket/framing/PayloadCompressor.h"
 
 namespace rsocket {
 
@@ -105,11 +108,36 @@ class FrameSerializer {
   virtual size_t frameLengthFieldSize() const = 0;
   bool& preallocateFrameSizeField();
 
+  /// Allocator used for the buffers frames are serialized into.  Null means
+  /// the heap.
+  void setAllocator(std::shared_ptr<BufferAllocator> allocator);
+
+  /// Compressor for the data of request and payload frames, set once the
+  /// connection negotiated compression.  Null means no compression.
+  void setPayloadCompressor(std::shared_ptr<PayloadCompressor> compressor);
+
+  /// Dictionary interning the metadata of request and payload frames, set
+  /// once the connection negotiated interning.  Null means no interning.
+  void setMetadataDictionary(std::shared_ptr<MetadataDictionary> dictionary);
+
  protected:
   folly::IOBufQueue createBufferQueue(size_t bufferSize) const;
 
+  /// Compresses the data and interns the metadata of an outgoing payload, as
+  /// negotiated for the connection.
+  void encodePayload(Payload& payload) const;
+
+  /// Reverts encodePayload().  Throws if the payload is malformed.
+  void decodePayload(Payload& payload) const;
+
+  /// Bytes to leave in front of a serialized frame for its length prefix.
+  size_t frameLengthHeadroom() const;
+
  private:
   bool preallocateFrameSizeField_{false};
+  std::shared_ptr<BufferAllocator> allocator_;
+  std::shared_ptr<PayloadCompressor> compressor_;
+  std::shared_ptr<MetadataDictionary> dictionary_;
 };
 
 } // namespace rsocket
@@ -39,10 +39,9 @@ static FrameType deserializeFrameType(uint16_t frameType) {
   return static_cast<FrameType>(frameType);
 }
 
-static void serializeHeaderInto(
-    folly::io::QueueAppender& appender,
-    const FrameHeader& header) {
-  appender.writeBE<int32_t>(static_cast<int32_t>(header.streamId));
+template <typename Writer>
+static void serializeHeaderInto(Writer& appender, const FrameHeader& header) {
+  appender.writeBE(static_cast<int32_t>(header.streamId));
 
   auto type = static_cast<uint8_t>(header.type); // 6 bit
   auto flags = static_cast<uint16_t>(header.flags); // 10 bit
@@ -62,16 +61,10 @@ static void deserializeHeaderFrom(folly::io::Cursor& cur, FrameHeader& header) {
       static_cast<FrameFlags>(((type & 0x3) << 8) | cur.readBE<uint8_t>());
 }
 
-static void serializeMetadataInto(
-    folly::io::QueueAppender& appender,
-    std::unique_ptr<folly::IOBuf> metadata) {
-  if (metadata == nullptr) {
-    return;
-  }
-
+template <typename Writer>
+static void serializeMetadataLengthInto(Writer& appender, size_t length) {
   // metadata length field not included in the medatadata length
-  uint32_t metadataLength =
-      static_cast<uint32_t>(metadata->computeChainDataLength());
+  uint32_t metadataLength = static_cast<uint32_t>(length);
   CHECK_LT(metadataLength, kMaxMetadataLength)
       << "Metadata is too big to serialize";
 
@@ -79,7 +72,16 @@ static void serializeMetadataInto(
   appender.write(
       static_cast<uint8_t>((metadataLength >> 8) & 0xFF)); // second byte
   appender.write(static_cast<uint8_t>(metadataLength & 0xFF)); // third byte
+}
 
+static void serializeMetadataInto(
+    folly::io::QueueAppender& appender,
+    std::unique_ptr<folly::IOBuf> metadata) {
+  if (metadata == nullptr) {
+    return;
+  }
+
+  serializeMetadataLengthInto(appender, metadata->computeChainDataLength());
   appender.insert(std::move(metadata));
 }
 
@@ -135,23 +137,67 @@ static uint32_t payloadFramingSize(const Payload& payload) {
   return (payload.metadata != nullptr ? kMedatadaLengthSize : 0);
 }
 
-std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOutInternal(
-    Frame_REQUEST_Base&& frame) const {
-  auto queue = createBufferQueue(
-      FrameSerializerV1_0::kFrameHeaderSize + sizeof(uint32_t) +
-      payloadFramingSize(frame.payload_));
+static_assert(
+    Payload::kFrameHeadroom >= FrameSerializerV1_0::kFrameHeaderSize +
+            sizeof(uint32_t) + kMedatadaLengthSize + 3 /* frame length */,
+    "Payload::kFrameHeadroom cannot fit the largest payload frame header");
+
+/// Serializes a frame carrying a payload.  If the first buffer of the payload
+/// is unshared and has enough headroom, e.g. when it was created by
+/// Payload::withFrameHeadroom(), the header is written in place in front of it
+/// rather than into a separately allocated buffer.
+template <typename WriteFields>
+std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializePayloadFrame(
+    const FrameHeader& header,
+    size_t fieldsSize,
+    Payload&& payload,
+    WriteFields writeFields) const {
+  const auto headerSize =
+      kFrameHeaderSize + fieldsSize + payloadFramingSize(payload);
+  const bool hasMetadata = payload.metadata != nullptr;
+  auto& first = hasMetadata ? payload.metadata : payload.data;
+
+  if (first && !first->isSharedOne() &&
+      first->headroom() >= headerSize + frameLengthHeadroom()) {
+    const auto metadataLength =
+        hasMetadata ? payload.metadata->computeChainDataLength() : 0;
+
+    auto frame = std::move(first);
+    frame->prepend(headerSize);
+    folly::io::RWPrivateCursor cur(frame.get());
+    serializeHeaderInto(cur, header);
+    writeFields(cur);
+    if (hasMetadata) {
+      serializeMetadataLengthInto(cur, metadataLength);
+      if (payload.data) {
+        frame->prependChain(std::move(payload.data));
+      }
+    }
+    return frame;
+  }
 
+  auto queue = createBufferQueue(headerSize);
   folly::io::QueueAppender appender(&queue, /* do not grow */ 0);
-  serializeHeaderInto(appender, frame.header_);
-
-  appender.writeBE<int32_t>(static_cast<int32_t>(frame.requestN_));
-  serializePayloadInto(appender, std::move(frame.payload_));
+  serializeHeaderInto(appender, header);
+  writeFields(appender);
+  serializePayloadInto(appender, std::move(payload));
   return queue.move();
 }
 
-static bool deserializeFromInternal(
+std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOutInternal(
+    Frame_REQUEST_Base&& frame) const {
+  const auto requestN = static_cast<int32_t>(frame.requestN_);
+  encodePayload(frame.payload_);
+  return serializePayloadFrame(
+      frame.header_,
+      sizeof(uint32_t),
+      std::move(frame.payload_),
+      [requestN](auto& writer) { writer.writeBE(requestN); });
+}
+
+bool FrameSerializerV1_0::deserializeFromInternal(
     Frame_REQUEST_Base& frame,
-    std::unique_ptr<folly::IOBuf> in) {
+    std::unique_ptr<folly::IOBuf> in) const {
   folly::io::Cursor cur(in.get());
   try {
     deserializeHeaderFrom(cur, frame.header_);
@@ -163,6 +209,7 @@ static bool deserializeFromInternal(
     }
     frame.requestN_ = static_cast<uint32_t>(requestN);
     frame.payload_ = deserializePayloadFrom(cur, frame.header_.flags);
+    decodePayload(frame.payload_);
   } catch (...) {
     return false;
   }
@@ -218,22 +265,16 @@ std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
 
 std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
     Frame_REQUEST_RESPONSE&& frame) const {
-  auto queue =
-      createBufferQueue(kFrameHeaderSize + payloadFramingSize(frame.payload_));
-  folly::io::QueueAppender appender(&queue, /* do not grow */ 0);
-  serializeHeaderInto(appender, frame.header_);
-  serializePayloadInto(appender, std::move(frame.payload_));
-  return queue.move();
+  encodePayload(frame.payload_);
+  return serializePayloadFrame(
+      frame.header_, 0, std::move(frame.payload_), [](auto&) {});
 }
 
 std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
     Frame_REQUEST_FNF&& frame) const {
-  auto queue =
-      createBufferQueue(kFrameHeaderSize + payloadFramingSize(frame.payload_));
-  folly::io::QueueAppender appender(&queue, /* do not grow */ 0);
-  serializeHeaderInto(appender, frame.header_);
-  serializePayloadInto(appender, std::move(frame.payload_));
-  return queue.move();
+  encodePayload(frame.payload_);
+  return serializePayloadFrame(
+      frame.header_, 0, std::move(frame.payload_), [](auto&) {});
 }
 
 std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
@@ -266,23 +307,19 @@ std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
 
 std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
     Frame_PAYLOAD&& frame) const {
-  auto queue =
-      createBufferQueue(kFrameHeaderSize + payloadFramingSize(frame.payload_));
-  folly::io::QueueAppender appender(&queue, /* do not grow */ 0);
-  serializeHeaderInto(appender, frame.header_);
-  serializePayloadInto(appender, std::move(frame.payload_));
-  return queue.move();
+  encodePayload(frame.payload_);
+  return serializePayloadFrame(
+      frame.header_, 0, std::move(frame.payload_), [](auto&) {});
 }
 
 std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
     Frame_ERROR&& frame) const {
-  auto queue = createBufferQueue(
-      kFrameHeaderSize + sizeof(uint32_t) + payloadFramingSize(frame.payload_));
-  folly::io::QueueAppender appender(&queue, /* do not grow */ 0);
-  serializeHeaderInto(appender, frame.header_);
-  appender.writeBE(static_cast<uint32_t>(frame.errorCode_));
-  serializePayloadInto(appender, std::move(frame.payload_));
-  return queue.move();
+  const auto errorCode = static_cast<uint32_t>(frame.errorCode_);
+  return serializePayloadFrame(
+      frame.header_,
+      sizeof(uint32_t),
+      std::move(frame.payload_),
+      [errorCode](auto& writer) { writer.writeBE(errorCode); });
 }
 
 std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
@@ -404,6 +441,7 @@ bool FrameSerializerV1_0::deserializeFrom(
   try {
     deserializeHeaderFrom(cur, frame.header_);
     frame.payload_ = deserializePayloadFrom(cur, frame.header_.flags);
+    decodePayload(frame.payload_);
   } catch (...) {
     return false;
   }
@@ -417,6 +455,7 @@ bool FrameSerializerV1_0::deserializeFrom(
   try {
     deserializeHeaderFrom(cur, frame.header_);
     frame.payload_ = deserializePayloadFrom(cur, frame.header_.flags);
+    decodePayload(frame.payload_);
   } catch (...) {
     return false;
   }
@@ -474,6 +513,7 @@ bool FrameSerializerV1_0::deserializeFrom(
   try {
     deserializeHeaderFrom(cur, frame.header_);
     frame.payload_ = deserializePayloadFrom(cur, frame.header_.flags);
+    decodePayload(frame.payload_);
   } catch (...) {
     return false;
   }
@@ -91,6 +91,16 @@ class FrameSerializerV1_0 : public FrameSerializer {
  private:
   std::unique_ptr<folly::IOBuf> serializeOutInternal(
       Frame_REQUEST_Base&& frame) const;
+  bool deserializeFromInternal(
+      Frame_REQUEST_Base& frame,
+      std::unique_ptr<folly::IOBuf> in) const;
+
+  template <typename WriteFields>
+  std::unique_ptr<folly::IOBuf> serializePayloadFrame(
+      const FrameHeader& header,
+      size_t fieldsSize,
+      Payload&& payload,
+      WriteFields writeFields) const;
 
   size_t frameLengthFieldSize() const override;
 };
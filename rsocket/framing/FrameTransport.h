@@ -29,6 +29,15 @@ class FrameTransport {
   virtual void outputFrameOrDrop(std::unique_ptr<folly::IOBuf>) = 0;
   virtual void close() = 0;
 
+  /// Reports to the FrameProcessor when the bytes buffered for sending cross
+  /// the watermarks.
+  virtual void setWriteWatermarks(WriteWatermarks) = 0;
+
+  /// Bounds how many inbound frames are handed to the FrameProcessor per
+  /// event loop iteration.  Zero means no limit.  Must be called before the
+  /// FrameProcessor is set.
+  virtual void setMaxFramesPerLoop(size_t) = 0;
+
   // Just for observation purposes!
   // TODO(T25011919): remove
   virtual DuplexConnection* getConnection() = 0;
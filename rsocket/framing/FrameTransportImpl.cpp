@@ -16,6 +16,7 @@
 
 #include <folly/ExceptionWrapper.h>
 #include <folly/io/IOBuf.h>
+#include <folly/io/async/EventBaseManager.h>
 #include <glog/logging.h>
 
 #include "rsocket/DuplexConnection.h"
@@ -75,6 +76,47 @@ void FrameTransportImpl::close() {
   }
 }
 
+void FrameTransportImpl::setWriteWatermarks(WriteWatermarks watermarks) {
+  if (!connection_) {
+    return;
+  }
+
+  connection_->setWriteWatermarks(
+      watermarks,
+      [weak = std::weak_ptr<FrameTransportImpl>(shared_from_this())](
+          bool writable) {
+        auto const self = weak.lock();
+        if (!self) {
+          return;
+        }
+        // Copy in case the processor closes the transport.
+        if (auto const processor = self->frameProcessor_) {
+          processor->onWritabilityChanged(writable);
+        }
+      });
+}
+
+void FrameTransportImpl::setMaxFramesPerLoop(size_t maxFrames) {
+  DCHECK(!connectionInputSub_);
+  maxFramesPerLoop_ = maxFrames;
+}
+
+void FrameTransportImpl::requestNextBatch() {
+  auto const evb = folly::EventBaseManager::get()->getExistingEventBase();
+  if (!evb) {
+    connectionInputSub_->request(maxFramesPerLoop_);
+    return;
+  }
+
+  evb->runInLoop(
+      [weak = std::weak_ptr<FrameTransportImpl>(shared_from_this())] {
+        auto const self = weak.lock();
+        if (self && self->connectionInputSub_) {
+          self->connectionInputSub_->request(self->maxFramesPerLoop_);
+        }
+      });
+}
+
 void FrameTransportImpl::onSubscribe(
     std::shared_ptr<Subscription> subscription) {
   if (!connection_) {
@@ -84,7 +126,11 @@ void FrameTransportImpl::onSubscribe(
   CHECK(!connectionInputSub_);
   CHECK(frameProcessor_);
   connectionInputSub_ = std::move(subscription);
-  connectionInputSub_->request(std::numeric_limits<int64_t>::max());
+  framesInBatch_ = 0;
+  connectionInputSub_->request(
+      maxFramesPerLoop_ > 0
+          ? static_cast<int64_t>(maxFramesPerLoop_)
+          : std::numeric_limits<int64_t>::max());
 }
 
 void FrameTransportImpl::onNext(std::unique_ptr<folly::IOBuf> frame) {
@@ -92,6 +138,13 @@ void FrameTransportImpl::onNext(std::unique_ptr<folly::IOBuf> frame) {
   if (auto const processor = frameProcessor_) {
     processor->processFrame(std::move(frame));
   }
+
+  if (maxFramesPerLoop_ > 0 && ++framesInBatch_ == maxFramesPerLoop_) {
+    framesInBatch_ = 0;
+    if (connectionInputSub_) {
+      requestNextBatch();
+    }
+  }
 }
 
 void FrameTransportImpl::terminateProcessor(folly::exception_wrapper ex) {
@@ -43,6 +43,10 @@ class FrameTransportImpl
   /// Cancel the input and close the underlying connection.
   void close() override;
 
+  void setWriteWatermarks(WriteWatermarks) override;
+
+  void setMaxFramesPerLoop(size_t) override;
+
   bool isClosed() const {
     return !connection_;
   }
@@ -67,11 +71,18 @@ class FrameTransportImpl
   /// processor is set, overwriting any previously queued exception.
   void terminateProcessor(folly::exception_wrapper);
 
+  /// Requests the next batch of frames from the connection.  Deferred to the
+  /// next loop iteration when running on an EventBase.
+  void requestNextBatch();
+
   std::shared_ptr<FrameProcessor> frameProcessor_;
   std::shared_ptr<DuplexConnection> connection_;
 
   std::shared_ptr<DuplexConnection::Subscriber> connectionOutput_;
   std::shared_ptr<yarpl::flowable::Subscription> connectionInputSub_;
+
+  size_t maxFramesPerLoop_{0};
+  size_t framesInBatch_{0};
 };
 
 } // namespace rsocket
@@ -62,6 +62,18 @@ folly::StringPiece toString(FrameType type) {
   }
 }
 
+bool isRequestFrame(FrameType type) {
+  switch (type) {
+    case FrameType::REQUEST_RESPONSE:
+    case FrameType::REQUEST_FNF:
+    case FrameType::REQUEST_STREAM:
+    case FrameType::REQUEST_CHANNEL:
+      return true;
+    default:
+      return false;
+  }
+}
+
 std::ostream& operator<<(std::ostream& os, FrameType type) {
   auto const str = toString(type);
   if (str == kUnknown) {
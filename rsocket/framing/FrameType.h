@@ -42,6 +42,9 @@ enum class FrameType : uint8_t {
 
 folly::StringPiece toString(FrameType);
 
+/// Whether frames of the type open a stream.
+bool isRequestFrame(FrameType);
+
 std::ostream& operator<<(std::ostream&, FrameType);
 
 } // namespace rsocket
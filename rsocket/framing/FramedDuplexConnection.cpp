@@ -110,4 +110,12 @@ void FramedDuplexConnection::setInput(
   }
   inputReader_->setInput(std::move(framesSink));
 }
+
+void FramedDuplexConnection::setWriteWatermarks(
+    WriteWatermarks watermarks,
+    WritabilityCallback callback) {
+  if (inner_) {
+    inner_->setWriteWatermarks(watermarks, std::move(callback));
+  }
+}
 } // namespace rsocket
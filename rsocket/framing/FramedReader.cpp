@@ -76,16 +76,35 @@ size_t FramedReader::readFrameLength() const {
 
 void FramedReader::onSubscribe(std::shared_ptr<Subscription> subscription) {
   subscription_ = std::move(subscription);
-  subscription_->request(std::numeric_limits<int64_t>::max());
+  requestUpstream();
 }
 
 void FramedReader::onNext(std::unique_ptr<folly::IOBuf> payload) {
   VLOG(4) << "incoming bytes length=" << payload->length() << '\n'
           << hexDump(payload->clone()->moveToFbString());
+  if (upstreamRequested_ > 0) {
+    --upstreamRequested_;
+  }
   payloadQueue_.append(std::move(payload));
   parseFrames();
 }
 
+void FramedReader::requestUpstream() {
+  if (!subscription_ || upstreamUnbounded_ || !allowance_.canConsume(1)) {
+    return;
+  }
+
+  constexpr auto kUnbounded =
+      static_cast<size_t>(std::numeric_limits<int64_t>::max());
+  if (allowance_.get() >= kUnbounded) {
+    upstreamUnbounded_ = true;
+    subscription_->request(std::numeric_limits<int64_t>::max());
+  } else if (upstreamRequested_ == 0) {
+    upstreamRequested_ = 1;
+    subscription_->request(1);
+  }
+}
+
 void FramedReader::parseFrames() {
   if (dispatchingFrames_) {
     return;
@@ -136,6 +155,9 @@ void FramedReader::parseFrames() {
   }
 
   dispatchingFrames_ = false;
+
+  // Out of complete frames but the subscriber wants more.
+  requestUpstream();
 }
 
 void FramedReader::onComplete() {
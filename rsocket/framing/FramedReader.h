@@ -52,6 +52,10 @@ class FramedReader : public DuplexConnection::Subscriber,
   void parseFrames();
   bool ensureOrAutodetectProtocolVersion();
 
+  /// Asks the connection for more data if the subscriber wants frames that
+  /// the buffered bytes can't provide.
+  void requestUpstream();
+
   size_t readFrameLength() const;
 
   std::shared_ptr<yarpl::flowable::Subscription> subscription_;
@@ -60,6 +64,12 @@ class FramedReader : public DuplexConnection::Subscriber,
   Allowance allowance_;
   bool dispatchingFrames_{false};
 
+  /// Reads requested from the connection and not delivered yet.  Only one is
+  /// outstanding at a time unless the subscriber doesn't use flow control, in
+  /// which case everything is requested at once.
+  size_t upstreamRequested_{0};
+  bool upstreamUnbounded_{false};
+
   folly::IOBufQueue payloadQueue_{folly::IOBufQueue::cacheChainLength()};
   const std::shared_ptr<ProtocolVersion> version_;
 };
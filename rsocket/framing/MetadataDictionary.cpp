@@ -0,0 +1,162 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/framing/MetadataDictionary.h"
+
+#include <folly/Conv.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBufQueue.h>
+
+#include <limits>
+
+#include "rsocket/Payload.h"
+#include "rsocket/framing/MimeTypeParameter.h"
+
+namespace rsocket {
+
+namespace {
+
+constexpr uint8_t kLiteral{0};
+constexpr uint8_t kDefine{1};
+constexpr uint8_t kReference{2};
+
+constexpr size_t kTagSize{1};
+constexpr size_t kIdTagSize{kTagSize + sizeof(uint16_t)};
+
+constexpr folly::StringPiece kMimeParameter{"interning"};
+
+/// Buffer for a tag and an optional ID, with enough headroom for the
+/// serializer to write the frame header in front of it.
+std::unique_ptr<folly::IOBuf> makeTag(
+    uint8_t tag,
+    folly::Optional<uint16_t> id) {
+  auto buf = folly::IOBuf::create(Payload::kFrameHeadroom + kIdTagSize);
+  buf->advance(Payload::kFrameHeadroom);
+  folly::io::Appender appender(buf.get(), 0);
+  appender.write(tag);
+  if (id) {
+    appender.writeBE(*id);
+  }
+  return buf;
+}
+
+std::unique_ptr<folly::IOBuf> trimStart(
+    std::unique_ptr<folly::IOBuf> buf,
+    size_t length) {
+  folly::IOBufQueue queue;
+  queue.append(std::move(buf));
+  queue.trimStart(length);
+  return queue.move();
+}
+
+} // namespace
+
+constexpr size_t MetadataDictionary::kMaxSize;
+constexpr size_t MetadataDictionary::kMinLength;
+constexpr size_t MetadataDictionary::kMaxLength;
+
+MetadataDictionary::MetadataDictionary(
+    size_t size,
+    std::shared_ptr<RSocketStats> stats)
+    : size_{size}, stats_{std::move(stats)}, sent_{size} {
+  CHECK_GT(size_, 0u);
+  CHECK_LE(size_, kMaxSize);
+}
+
+std::string MetadataDictionary::addToMimeType(
+    folly::StringPiece mimeType,
+    size_t size) {
+  return addMimeTypeParameter(
+      mimeType, kMimeParameter, folly::to<std::string>(size));
+}
+
+size_t MetadataDictionary::takeFromMimeType(std::string& mimeType) {
+  const auto size = takeMimeTypeParameter(mimeType, kMimeParameter);
+  if (!size) {
+    return 0;
+  }
+  return folly::tryTo<size_t>(*size).value_or(
+      std::numeric_limits<size_t>::max());
+}
+
+std::unique_ptr<folly::IOBuf> MetadataDictionary::encode(
+    std::unique_ptr<folly::IOBuf> metadata) {
+  const auto length = metadata->computeChainDataLength();
+  if (length < kMinLength || length > kMaxLength) {
+    auto tag = makeTag(kLiteral, folly::none);
+    tag->prependChain(std::move(metadata));
+    return tag;
+  }
+
+  auto key = folly::io::Cursor(metadata.get()).readFixedString(length);
+  const auto it = sent_.find(key);
+  if (it != sent_.end()) {
+    stats_->metadataBytesSaved(length - kIdTagSize);
+    return makeTag(kReference, it->second);
+  }
+
+  uint16_t id;
+  if (sent_.size() < size_) {
+    id = static_cast<uint16_t>(sent_.size());
+  } else {
+    const auto lru = sent_.rbegin();
+    id = lru->second;
+    const auto evicted = lru->first;
+    sent_.erase(evicted);
+  }
+  sent_.set(std::move(key), id);
+
+  auto tag = makeTag(kDefine, id);
+  tag->prependChain(std::move(metadata));
+  return tag;
+}
+
+std::unique_ptr<folly::IOBuf> MetadataDictionary::decode(
+    std::unique_ptr<folly::IOBuf> metadata) {
+  folly::io::Cursor cur(metadata.get());
+  const auto tag = cur.read<uint8_t>();
+  if (tag == kLiteral) {
+    return trimStart(std::move(metadata), kTagSize);
+  }
+  if (tag != kDefine && tag != kReference) {
+    throw std::runtime_error{"Unknown metadata interning tag"};
+  }
+
+  const auto id = cur.readBE<uint16_t>();
+  if (id >= size_) {
+    throw std::runtime_error{"Interned metadata ID is out of range"};
+  }
+
+  if (tag == kReference) {
+    if (id >= received_.size() || !received_[id]) {
+      throw std::runtime_error{"Unknown interned metadata ID"};
+    }
+    return received_[id]->clone();
+  }
+
+  auto defined = trimStart(std::move(metadata), kIdTagSize);
+  const auto length = defined ? defined->computeChainDataLength() : 0;
+  if (length < kMinLength || length > kMaxLength) {
+    throw std::runtime_error{"Interned metadata has an invalid length"};
+  }
+  if (id >= received_.size()) {
+    received_.resize(id + 1);
+  }
+  // Copied, as a clone would keep the whole frame alive.
+  received_[id] = folly::IOBuf::copyBuffer(
+      folly::io::Cursor(defined.get()).readFixedString(length));
+  return defined;
+}
+
+} // namespace rsocket
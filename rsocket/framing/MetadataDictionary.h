@@ -0,0 +1,77 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <folly/io/IOBuf.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rsocket/RSocketStats.h"
+
+namespace rsocket {
+
+/// Interns the metadata of the payloads of a connection that negotiated it in
+/// its SETUP frame, so metadata repeated on every request, e.g. routing or
+/// auth, goes over the wire as a small ID.
+///
+/// Every non-empty metadata is prefixed with a tag.  Metadata is either sent
+/// literally, defined under an ID the peer stores it under, or replaced by the
+/// ID it was defined under before.  Each end assigns IDs to the metadata it
+/// sends and reuses the least recently used ID once all of them are taken.
+/// This relies on the peer decoding frames in the order they were encoded.
+///
+/// Not thread-safe, each connection needs its own instance.
+class MetadataDictionary {
+ public:
+  /// Largest number of IDs a connection can negotiate.
+  static constexpr size_t kMaxSize{1 << 16};
+
+  /// Metadata outside of these bounds is always sent literally.
+  static constexpr size_t kMinLength{16};
+  static constexpr size_t kMaxLength{4096};
+
+  /// Reports the bytes saved by sending IDs to `stats`.
+  MetadataDictionary(size_t size, std::shared_ptr<RSocketStats> stats);
+
+  /// Adds a parameter with the number of IDs to a MIME type, which is how a
+  /// client proposes interning in its SETUP frame.
+  static std::string addToMimeType(folly::StringPiece mimeType, size_t size);
+
+  /// Strips the parameter added by addToMimeType() from a MIME type and
+  /// returns the number of IDs, or zero if there wasn't any.  A malformed
+  /// number comes back as larger than any server accepts.
+  static size_t takeFromMimeType(std::string& mimeType);
+
+  std::unique_ptr<folly::IOBuf> encode(std::unique_ptr<folly::IOBuf> metadata);
+
+  /// Throws if the metadata is malformed or refers to an unknown ID.
+  std::unique_ptr<folly::IOBuf> decode(std::unique_ptr<folly::IOBuf> metadata);
+
+ private:
+  const size_t size_;
+  const std::shared_ptr<RSocketStats> stats_;
+
+  /// IDs of the metadata sent to the peer, most recently used first.
+  folly::EvictingCacheMap<std::string, uint16_t> sent_;
+
+  /// Metadata received from the peer, indexed by ID.
+  std::vector<std::unique_ptr<folly::IOBuf>> received_;
+};
+
+} // namespace rsocket
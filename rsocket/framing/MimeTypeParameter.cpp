@@ -0,0 +1,46 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/framing/MimeTypeParameter.h"
+
+#include <folly/Conv.h>
+
+namespace rsocket {
+
+std::string addMimeTypeParameter(
+    folly::StringPiece mimeType,
+    folly::StringPiece name,
+    folly::StringPiece value) {
+  return folly::to<std::string>(mimeType, "; ", name, "=", value);
+}
+
+folly::Optional<std::string> takeMimeTypeParameter(
+    std::string& mimeType,
+    folly::StringPiece name) {
+  const auto parameter = folly::to<std::string>("; ", name, "=");
+  const auto begin = mimeType.find(parameter);
+  if (begin == std::string::npos) {
+    return folly::none;
+  }
+  const auto valueBegin = begin + parameter.size();
+  auto end = mimeType.find(';', valueBegin);
+  if (end == std::string::npos) {
+    end = mimeType.size();
+  }
+  auto value = mimeType.substr(valueBegin, end - valueBegin);
+  mimeType.erase(begin, end - begin);
+  return value;
+}
+
+} // namespace rsocket
@@ -0,0 +1,37 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+
+#include <string>
+
+namespace rsocket {
+
+/// Appends a "; name=value" parameter to a MIME type.  Extensions negotiated
+/// in the SETUP frame are proposed this way.
+std::string addMimeTypeParameter(
+    folly::StringPiece mimeType,
+    folly::StringPiece name,
+    folly::StringPiece value);
+
+/// Strips a parameter added by addMimeTypeParameter() from a MIME type and
+/// returns its value, or folly::none if the MIME type doesn't have it.
+folly::Optional<std::string> takeMimeTypeParameter(
+    std::string& mimeType,
+    folly::StringPiece name);
+
+} // namespace rsocket
@@ -0,0 +1,148 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/framing/PayloadCompressor.h"
+
+#include <folly/Conv.h>
+#include <folly/Optional.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBufQueue.h>
+
+#include "rsocket/Payload.h"
+#include "rsocket/framing/MimeTypeParameter.h"
+
+namespace rsocket {
+
+namespace {
+
+constexpr uint8_t kUncompressed{0};
+constexpr uint8_t kCompressed{1};
+
+/// A compressed data never inflates to more than a frame can carry.
+constexpr uint32_t kMaxUncompressedLength{0xFFFFFF};
+
+constexpr folly::StringPiece kMimeParameter{"compression"};
+
+folly::Optional<folly::io::CodecType> codecType(folly::StringPiece codec) {
+  if (codec == "zstd") {
+    return folly::io::CodecType::ZSTD;
+  }
+  if (codec == "lz4") {
+    return folly::io::CodecType::LZ4;
+  }
+  return folly::none;
+}
+
+/// Buffer holding a marker and `size - 1` more bytes, with enough headroom for
+/// the serializer to write the frame header in front of it.
+std::unique_ptr<folly::IOBuf> makeHeader(uint8_t marker, size_t size) {
+  auto buf = folly::IOBuf::create(Payload::kFrameHeadroom + size);
+  buf->advance(Payload::kFrameHeadroom);
+  buf->append(size);
+  buf->writableData()[0] = marker;
+  return buf;
+}
+
+} // namespace
+
+bool PayloadCompressor::isSupported(folly::StringPiece codec) {
+  const auto type = codecType(codec);
+  return type && folly::io::hasCodec(*type);
+}
+
+std::unique_ptr<PayloadCompressor> PayloadCompressor::create(
+    folly::StringPiece codec,
+    Options options) {
+  if (!isSupported(codec)) {
+    throw std::invalid_argument{
+        folly::to<std::string>("Unsupported payload compression: ", codec)};
+  }
+  return std::unique_ptr<PayloadCompressor>(new PayloadCompressor(
+      codec.str(),
+      folly::io::getCodec(*codecType(codec), options.level),
+      options));
+}
+
+std::string PayloadCompressor::addToMimeType(
+    folly::StringPiece mimeType,
+    folly::StringPiece codec) {
+  return addMimeTypeParameter(mimeType, kMimeParameter, codec);
+}
+
+std::string PayloadCompressor::takeFromMimeType(std::string& mimeType) {
+  return takeMimeTypeParameter(mimeType, kMimeParameter).value_or("");
+}
+
+PayloadCompressor::PayloadCompressor(
+    std::string codec,
+    std::unique_ptr<folly::io::Codec> impl,
+    Options options)
+    : codec_{std::move(codec)}, impl_{std::move(impl)}, options_{options} {}
+
+std::unique_ptr<folly::IOBuf> PayloadCompressor::compress(
+    std::unique_ptr<folly::IOBuf> data) const {
+  const auto length = data->computeChainDataLength();
+  if (length >= options_.threshold && length <= kMaxUncompressedLength) {
+    auto compressed = impl_->compress(data.get());
+    if (compressed->computeChainDataLength() + sizeof(uint32_t) < length) {
+      auto header = makeHeader(kCompressed, 1 + sizeof(uint32_t));
+      folly::io::RWPrivateCursor cur(header.get());
+      cur.skip(1);
+      cur.writeBE(static_cast<uint32_t>(length));
+      header->prependChain(std::move(compressed));
+      return header;
+    }
+  }
+
+  // Payload::withFrameHeadroom() leaves room for both the marker and the
+  // largest frame header that doesn't go in front of metadata.
+  if (!data->isSharedOne() && data->headroom() > 0) {
+    data->prepend(1);
+    data->writableData()[0] = kUncompressed;
+    return data;
+  }
+  auto header = makeHeader(kUncompressed, 1);
+  header->prependChain(std::move(data));
+  return header;
+}
+
+std::unique_ptr<folly::IOBuf> PayloadCompressor::decompress(
+    std::unique_ptr<folly::IOBuf> data) const {
+  folly::io::Cursor cur(data.get());
+  const auto marker = cur.read<uint8_t>();
+  if (marker == kUncompressed) {
+    folly::IOBufQueue queue;
+    queue.append(std::move(data));
+    queue.trimStart(1);
+    return queue.move();
+  }
+  if (marker != kCompressed) {
+    throw std::runtime_error{"Unknown payload compression marker"};
+  }
+
+  const auto length = cur.readBE<uint32_t>();
+  if (length > kMaxUncompressedLength) {
+    throw std::runtime_error{"Compressed payload is too large"};
+  }
+  folly::IOBufQueue queue;
+  queue.append(std::move(data));
+  queue.trimStart(1 + sizeof(uint32_t));
+  auto compressed = queue.move();
+  if (!compressed) {
+    throw std::runtime_error{"Compressed payload is truncated"};
+  }
+  return impl_->uncompress(compressed.get(), length);
+}
+
+} // namespace rsocket
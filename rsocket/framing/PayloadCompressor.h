@@ -0,0 +1,85 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/io/Compression.h>
+#include <folly/io/IOBuf.h>
+
+#include <memory>
+#include <string>
+
+namespace rsocket {
+
+/// Compresses and decompresses the data of the payloads of a connection that
+/// negotiated compression in its SETUP frame.
+///
+/// Every non-empty data is prefixed with a marker byte saying whether it is
+/// compressed, so that data below the threshold, or data that doesn't shrink,
+/// goes out as is.  Compressed data also carries its uncompressed length.
+/// Metadata is never compressed.
+///
+/// Not thread-safe, each connection needs its own instance.
+class PayloadCompressor {
+ public:
+  struct Options {
+    /// Codec specific compression level.
+    int level{folly::io::COMPRESSION_LEVEL_DEFAULT};
+
+    /// Data shorter than this is sent uncompressed.
+    size_t threshold{256};
+  };
+
+  /// Whether this build supports the codec, "zstd" or "lz4".
+  static bool isSupported(folly::StringPiece codec);
+
+  /// Throws std::invalid_argument if the codec isn't supported.
+  static std::unique_ptr<PayloadCompressor> create(
+      folly::StringPiece codec,
+      Options options);
+
+  /// Adds a parameter naming the codec to a MIME type, which is how a client
+  /// proposes compression in its SETUP frame.
+  static std::string addToMimeType(
+      folly::StringPiece mimeType,
+      folly::StringPiece codec);
+
+  /// Strips the parameter added by addToMimeType() from a MIME type and
+  /// returns the codec it named, or an empty string if there wasn't any.
+  static std::string takeFromMimeType(std::string& mimeType);
+
+  const std::string& codec() const {
+    return codec_;
+  }
+
+  std::unique_ptr<folly::IOBuf> compress(
+      std::unique_ptr<folly::IOBuf> data) const;
+
+  /// Throws if the data is malformed.
+  std::unique_ptr<folly::IOBuf> decompress(
+      std::unique_ptr<folly::IOBuf> data) const;
+
+ private:
+  PayloadCompressor(
+      std::string codec,
+      std::unique_ptr<folly::io::Codec> impl,
+      Options options);
+
+  const std::string codec_;
+  const std::unique_ptr<folly::io::Codec> impl_;
+  const Options options_;
+};
+
+} // namespace rsocket
@@ -40,4 +40,14 @@ void ScheduledFrameProcessor::onTerminal(folly::exception_wrapper ew) {
       });
 }
 
+void ScheduledFrameProcessor::onWritabilityChanged(bool writable) {
+  if (!processor_) {
+    return;
+  }
+
+  evb_->runInEventBaseThread([processor = processor_, writable] {
+    processor->onWritabilityChanged(writable);
+  });
+}
+
 } // namespace rsocket
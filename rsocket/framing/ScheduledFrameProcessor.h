@@ -35,6 +35,7 @@ class ScheduledFrameProcessor : public FrameProcessor {
 
   void processFrame(std::unique_ptr<folly::IOBuf>) override;
   void onTerminal(folly::exception_wrapper) override;
+  void onWritabilityChanged(bool) override;
 
  private:
   folly::EventBase* const evb_;
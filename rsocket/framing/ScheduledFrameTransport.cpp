@@ -50,6 +50,24 @@ void ScheduledFrameTransport::close() {
       [transport = std::move(frameTransport_)]() { transport->close(); });
 }
 
+void ScheduledFrameTransport::setWriteWatermarks(WriteWatermarks watermarks) {
+  CHECK(frameTransport_) << "Inner transport already closed";
+
+  transportEvb_->runInEventBaseThread(
+      [transport = frameTransport_, watermarks]() {
+        transport->setWriteWatermarks(watermarks);
+      });
+}
+
+void ScheduledFrameTransport::setMaxFramesPerLoop(size_t maxFrames) {
+  CHECK(frameTransport_) << "Inner transport already closed";
+
+  transportEvb_->runInEventBaseThread(
+      [transport = frameTransport_, maxFrames]() {
+        transport->setMaxFramesPerLoop(maxFrames);
+      });
+}
+
 bool ScheduledFrameTransport::isConnectionFramed() const {
   CHECK(frameTransport_) << "Inner transport already closed";
   return frameTransport_->isConnectionFramed();
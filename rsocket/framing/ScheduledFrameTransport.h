@@ -43,6 +43,8 @@ class ScheduledFrameTransport : public FrameTransport {
   void setFrameProcessor(std::shared_ptr<FrameProcessor>) override;
   void outputFrameOrDrop(std::unique_ptr<folly::IOBuf>) override;
   void close() override;
+  void setWriteWatermarks(WriteWatermarks) override;
+  void setMaxFramesPerLoop(size_t) override;
   bool isConnectionFramed() const override;
 
  private:
@@ -16,6 +16,7 @@
 
 #include "rsocket/statemachine/RSocketStateMachine.h"
 
+#include <folly/futures/Future.h>
 #include <folly/io/async/EventBase.h>
 
 namespace rsocket {
@@ -105,4 +106,33 @@ size_t ConnectionSet::size() const {
   return machines_.lock()->size();
 }
 
+std::vector<std::string> ConnectionSet::dumpFlightRecorders() const {
+  // Don't hold the lock while waiting on the EventBases, the state machines
+  // remove themselves from the map on them.
+  std::vector<
+      std::pair<std::shared_ptr<RSocketStateMachine>, folly::EventBase*>>
+      machines;
+  {
+    const auto locked = machines_.lock();
+    machines.assign(locked->begin(), locked->end());
+  }
+
+  // Ask all the EventBases at once instead of waiting on each in turn.  Those
+  // of the calling thread's EventBase are dumped inline, it can't get to them
+  // while we wait.
+  std::vector<folly::Future<std::string>> dumps;
+  dumps.reserve(machines.size());
+  for (const auto& kv : machines) {
+    auto machine = kv.first;
+    if (kv.second->isInEventBaseThread()) {
+      dumps.push_back(folly::makeFuture(machine->dumpFlightRecorder()));
+    } else {
+      dumps.push_back(folly::via(kv.second, [machine] {
+        return machine->dumpFlightRecorder();
+      }));
+    }
+  }
+  return folly::collect(dumps.begin(), dumps.end()).get();
+}
+
 } // namespace rsocket
@@ -19,7 +19,9 @@
 
 #include <memory>
 #include <mutex>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "rsocket/statemachine/RSocketStateMachine.h"
 
@@ -44,6 +46,12 @@ class ConnectionSet : public RSocketStateMachine::CloseCallback {
 
   size_t size() const;
 
+  /// Dumps the flight recorder of each state machine on its EventBase, and
+  /// waits for all of them.  The EventBases work on it concurrently, and those
+  /// of the calling thread's EventBase are dumped inline.  Two EventBase
+  /// threads of the set calling it at once still wait on each other.
+  std::vector<std::string> dumpFlightRecorders() const;
+
   void shutdownAndWait();
 
  private:
@@ -0,0 +1,120 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/FileRange.h"
+
+#include <folly/Synchronized.h>
+#include <glog/logging.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <system_error>
+#include <unordered_map>
+
+namespace rsocket {
+
+namespace {
+
+/// Owned by the IOBuf through its free function.
+struct Mapping {
+  folly::File file;
+  void* base;
+  size_t mappedLength;
+};
+
+/// File ranges of the live mappings, by the IOBuf buffer mapping them.
+using Registry = std::unordered_map<const uint8_t*, FileRange>;
+
+folly::Synchronized<Registry>& registry() {
+  static auto* const instance = new folly::Synchronized<Registry>();
+  return *instance;
+}
+
+std::atomic<size_t> liveMappings{0};
+
+void unmap(void* buffer, void* userData) {
+  std::unique_ptr<Mapping> mapping{static_cast<Mapping*>(userData)};
+  registry().wlock()->erase(static_cast<const uint8_t*>(buffer));
+  --liveMappings;
+  if (::munmap(mapping->base, mapping->mappedLength) != 0) {
+    PLOG(ERROR) << "Failed to unmap a file range";
+  }
+}
+
+} // namespace
+
+std::unique_ptr<folly::IOBuf>
+mapFileRange(const folly::File& file, off_t offset, size_t length) {
+  if (length == 0) {
+    return folly::IOBuf::create(0);
+  }
+
+  struct stat st;
+  if (::fstat(file.fd(), &st) != 0) {
+    throw std::system_error(errno, std::generic_category(), "fstat");
+  }
+  auto const fileSize = static_cast<uint64_t>(st.st_size);
+  if (offset < 0 || static_cast<uint64_t>(offset) > fileSize ||
+      length > fileSize - offset) {
+    throw std::out_of_range("File range past the end of the file");
+  }
+
+  static const off_t pageSize = ::sysconf(_SC_PAGESIZE);
+  auto const start = offset - offset % pageSize;
+  auto const delta = static_cast<size_t>(offset - start);
+
+  auto mapping = std::make_unique<Mapping>();
+  mapping->mappedLength = delta + length;
+  mapping->base = ::mmap(
+      nullptr, mapping->mappedLength, PROT_READ, MAP_SHARED, file.fd(), start);
+  if (mapping->base == MAP_FAILED) {
+    throw std::system_error(errno, std::generic_category(), "mmap");
+  }
+  // Keeps the file open for sendfile() even if the caller closes it.
+  mapping->file = file.dup();
+
+  auto const data = static_cast<uint8_t*>(mapping->base) + delta;
+  registry().wlock()->emplace(data, FileRange{mapping->file.fd(), offset});
+  ++liveMappings;
+
+  // The buffer starts at the data, so nothing can prepend into the mapping.
+  auto buf = folly::IOBuf::takeOwnership(
+      data, length, length, &unmap, mapping.release());
+  buf->markExternallySharedOne();
+  return buf;
+}
+
+bool anyFileRanges() {
+  return liveMappings.load(std::memory_order_relaxed) > 0;
+}
+
+folly::Optional<FileRange> findFileRange(const folly::IOBuf& buf) {
+  if (!anyFileRanges()) {
+    return folly::none;
+  }
+
+  auto const locked = registry().rlock();
+  auto const it = locked->find(buf.buffer());
+  if (it == locked->end()) {
+    return folly::none;
+  }
+  auto range = it->second;
+  range.offset += buf.data() - buf.buffer();
+  return range;
+}
+
+} // namespace rsocket
@@ -0,0 +1,54 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/File.h>
+#include <folly/Optional.h>
+#include <folly/io/IOBuf.h>
+
+#include <sys/types.h>
+
+#include <memory>
+
+namespace rsocket {
+
+/// Where the data of a file-backed IOBuf lives in its file.
+struct FileRange {
+  /// Stays open for as long as the IOBuf, or any clone of it, is alive.
+  int fd;
+  off_t offset;
+};
+
+/// Wraps `length` bytes of `file`, starting at `offset`, in an IOBuf that maps
+/// them instead of reading them.  Pages are only read if something actually
+/// looks at the bytes, and transports that know about file ranges can send
+/// them straight from the file instead, see findFileRange().
+///
+/// The IOBuf is marked shared, so nothing writes into it.  The file must not
+/// shrink while the IOBuf is alive.  Throws if the range is past the end of
+/// the file or can't be mapped.
+std::unique_ptr<folly::IOBuf>
+mapFileRange(const folly::File& file, off_t offset, size_t length);
+
+/// Whether any IOBufs created by mapFileRange() are alive.  A cheap check
+/// before looking IOBufs up.
+bool anyFileRanges();
+
+/// The file range that the data of `buf` maps, if `buf` was created by
+/// mapFileRange() or is a clone of part of such an IOBuf.  Only looks at `buf`
+/// itself, not at the rest of its chain.
+folly::Optional<FileRange> findFileRange(const folly::IOBuf& buf);
+
+} // namespace rsocket
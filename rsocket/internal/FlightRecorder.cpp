@@ -0,0 +1,160 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/FlightRecorder.h"
+
+#include <folly/Format.h>
+#include <folly/chrono/Hardware.h>
+#include <folly/io/Cursor.h>
+#include <folly/lang/Bits.h>
+
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+
+namespace rsocket {
+
+namespace {
+
+constexpr folly::StringPiece kUnknown{"UNKNOWN_EVENT"};
+
+/// Stream ID, then 6 bits of frame type and 10 bits of flags.
+constexpr size_t kHeaderLength = 6;
+
+std::string frameTypeName(uint8_t type) {
+  const auto known = type <= static_cast<uint8_t>(FrameType::RESUME_OK) ||
+      type == static_cast<uint8_t>(FrameType::EXT);
+  if (!known) {
+    return folly::sformat("type 0x{:02x}", type);
+  }
+  return toString(static_cast<FrameType>(type)).str();
+}
+
+} // namespace
+
+FlightRecorder::FlightRecorder(Options options)
+    : options_{options},
+      startTime_{std::chrono::steady_clock::now()},
+      startTicks_{folly::hardware_timestamp()} {
+  if (options_.capacity > 0) {
+    const auto capacity = folly::nextPowTwo(options_.capacity);
+    entries_.resize(capacity);
+    mask_ = capacity - 1;
+  }
+}
+
+void FlightRecorder::recordFrame(Kind kind, const folly::IOBuf& frame) {
+  auto& entry = nextEntry();
+  entry.ticks = folly::hardware_timestamp();
+  entry.kind = kind;
+  entry.length = static_cast<uint32_t>(frame.computeChainDataLength());
+
+  uint8_t header[kHeaderLength] = {};
+  if (frame.length() >= kHeaderLength) {
+    std::memcpy(header, frame.data(), kHeaderLength);
+  } else {
+    folly::io::Cursor{&frame}.pullAtMost(header, kHeaderLength);
+  }
+  entry.streamId =
+      folly::Endian::big(folly::loadUnaligned<uint32_t>(header)) & 0x7FFFFFFF;
+  const auto typeAndFlags =
+      folly::Endian::big(folly::loadUnaligned<uint16_t>(header + 4));
+  entry.type = static_cast<uint8_t>(typeAndFlags >> 10);
+  entry.flags = typeAndFlags & 0x3FF;
+}
+
+void FlightRecorder::event(Event event) {
+  if (entries_.empty()) {
+    return;
+  }
+  auto& entry = nextEntry();
+  entry.ticks = folly::hardware_timestamp();
+  entry.kind = Kind::EVENT;
+  entry.streamId = 0;
+  entry.length = 0;
+  entry.flags = static_cast<uint16_t>(event);
+  entry.type = 0;
+}
+
+std::vector<FlightRecorder::Entry> FlightRecorder::entries() const {
+  const auto size = std::min<uint64_t>(next_, entries_.size());
+  std::vector<Entry> entries;
+  entries.reserve(size);
+  for (auto i = next_ - size; i < next_; ++i) {
+    entries.push_back(entries_[i & mask_]);
+  }
+  return entries;
+}
+
+double FlightRecorder::nanosPerTick(uint64_t nowTicks) const {
+  const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - startTime_);
+  if (nowTicks <= startTicks_) {
+    return 0;
+  }
+  return static_cast<double>(elapsed.count()) / (nowTicks - startTicks_);
+}
+
+std::string FlightRecorder::dump() const {
+  const auto nowTicks = folly::hardware_timestamp();
+  const auto perTick = nanosPerTick(nowTicks);
+  const auto entries = this->entries();
+
+  auto out = folly::sformat(
+      "{} frames and events recorded, the last {}:\n", next_, entries.size());
+  for (const auto& entry : entries) {
+    const auto ago = (nowTicks - entry.ticks) * perTick / 1000;
+    if (entry.kind == Kind::EVENT) {
+      out += folly::sformat(
+          "{:>14.1f}us ago  {}\n",
+          ago,
+          toString(static_cast<Event>(entry.flags)));
+      continue;
+    }
+    out += folly::sformat(
+        "{:>14.1f}us ago  {} {:<16} stream {} flags 0x{:03x} length {}\n",
+        ago,
+        entry.kind == Kind::RECEIVED ? "in " : "out",
+        frameTypeName(entry.type),
+        entry.streamId,
+        entry.flags,
+        entry.length);
+  }
+  return out;
+}
+
+folly::StringPiece toString(FlightRecorder::Event event) {
+  switch (event) {
+    case FlightRecorder::Event::CONNECTED:
+      return "CONNECTED";
+    case FlightRecorder::Event::DISCONNECTED:
+      return "DISCONNECTED";
+    case FlightRecorder::Event::RESUMED:
+      return "RESUMED";
+    case FlightRecorder::Event::UNWRITABLE:
+      return "UNWRITABLE";
+    case FlightRecorder::Event::WRITABLE:
+      return "WRITABLE";
+    case FlightRecorder::Event::CLOSED:
+      return "CLOSED";
+    default:
+      return kUnknown;
+  }
+}
+
+std::ostream& operator<<(std::ostream& os, FlightRecorder::Event event) {
+  return os << toString(event);
+}
+
+} // namespace rsocket
@@ -0,0 +1,130 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/io/IOBuf.h>
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "rsocket/framing/FrameType.h"
+#include "rsocket/internal/Common.h"
+
+namespace rsocket {
+
+/// Always-on record of the last frames a connection sent and received, and of
+/// its state transitions, to find out after the fact what happened to a
+/// connection that misbehaved.
+///
+/// Only frame headers are kept, in a fixed-size ring that overwrites the
+/// oldest entries.  Recording a frame reads the CPU's timestamp counter and
+/// copies a few header bytes, so it can stay on in production.  Timestamps are
+/// converted to wall time only when the ring is dumped.
+///
+/// Not thread safe.
+class FlightRecorder {
+ public:
+  struct Options {
+    /// Number of entries kept, rounded up to a power of two.  Each takes 24
+    /// bytes.  Zero turns recording off.
+    size_t capacity{64};
+
+    /// Log the entries at WARNING when the connection closes with an error.
+    bool dumpOnError{false};
+  };
+
+  enum class Event : uint8_t {
+    CONNECTED,
+    DISCONNECTED,
+    RESUMED,
+    UNWRITABLE,
+    WRITABLE,
+    CLOSED,
+  };
+
+  enum class Kind : uint8_t {
+    RECEIVED,
+    SENT,
+    EVENT,
+  };
+
+  struct Entry {
+    /// Value of the timestamp counter.
+    uint64_t ticks;
+    StreamId streamId;
+    /// Length of the frame, without the frame length field.
+    uint32_t length;
+    /// Frame flags, or the Event of an EVENT entry.
+    uint16_t flags;
+    /// Raw frame type, it's recorded before the frame is validated.
+    uint8_t type;
+    Kind kind;
+  };
+
+  FlightRecorder() : FlightRecorder(Options{}) {}
+  explicit FlightRecorder(Options);
+
+  const Options& options() const {
+    return options_;
+  }
+
+  void received(const folly::IOBuf& frame) {
+    if (!entries_.empty()) {
+      recordFrame(Kind::RECEIVED, frame);
+    }
+  }
+
+  void sent(const folly::IOBuf& frame) {
+    if (!entries_.empty()) {
+      recordFrame(Kind::SENT, frame);
+    }
+  }
+
+  void event(Event);
+
+  /// The entries still in the ring, oldest first.
+  std::vector<Entry> entries() const;
+
+  /// One line per entry, oldest first, with its age relative to now.
+  std::string dump() const;
+
+ private:
+  void recordFrame(Kind, const folly::IOBuf&);
+
+  Entry& nextEntry() {
+    return entries_[next_++ & mask_];
+  }
+
+  /// Nanoseconds per tick, measured between the construction and now.
+  double nanosPerTick(uint64_t nowTicks) const;
+
+  Options options_;
+  std::chrono::steady_clock::time_point startTime_;
+  uint64_t startTicks_;
+
+  std::vector<Entry> entries_;
+  size_t mask_{0};
+  /// Number of entries recorded so far.
+  uint64_t next_{0};
+};
+
+folly::StringPiece toString(FlightRecorder::Event);
+
+std::ostream& operator<<(std::ostream&, FlightRecorder::Event);
+
+} // namespace rsocket
@@ -19,12 +19,25 @@ namespace rsocket {
 KeepaliveTimer::KeepaliveTimer(
     std::chrono::milliseconds period,
     folly::EventBase& eventBase)
-    : eventBase_(eventBase),
-      generation_(std::make_shared<uint32_t>(0)),
-      period_(period) {}
+    : eventBase_(eventBase), period_(period) {}
 
 KeepaliveTimer::~KeepaliveTimer() {
-  stop();
+  if (!wheel_) {
+    return;
+  }
+  // The wheel may only be touched from its EventBase's thread.  Off that
+  // thread the timer must have been stopped already, so that its entry can't
+  // call back into it before being removed.
+  if (eventBase_.isInEventBaseThread()) {
+    wheel_->remove(handle_);
+  } else {
+    DCHECK(!connection_) << "KeepaliveTimer destroyed off its EventBase "
+                         << "without being stopped";
+    eventBase_.runInEventBaseThread(
+        [wheel = std::move(wheel_), handle = handle_] {
+          wheel->remove(handle);
+        });
+  }
 }
 
 std::chrono::milliseconds KeepaliveTimer::keepaliveTime() const {
@@ -32,22 +45,18 @@ std::chrono::milliseconds KeepaliveTimer::keepaliveTime() const {
 }
 
 void KeepaliveTimer::schedule() {
-  const auto scheduledGeneration = *generation_;
-  const auto generation = generation_;
-  eventBase_.runAfterDelay(
-      [this,
-       wpConnection = std::weak_ptr<FrameSink>(connection_),
-       generation,
-       scheduledGeneration]() {
-        auto spConnection = wpConnection.lock();
-        if (!spConnection) {
-          return;
-        }
-        if (*generation == scheduledGeneration) {
-          sendKeepalive(*spConnection);
-        }
-      },
-      static_cast<uint32_t>(keepaliveTime().count()));
+  if (!wheel_) {
+    wheel_ = KeepaliveTimerWheel::forEventBase(eventBase_);
+    handle_ = wheel_->add(*this);
+  }
+  wheel_->schedule(handle_, keepaliveTime());
+}
+
+void KeepaliveTimer::expired() {
+  // sendKeepalive() may stop() the timer, keep the connection alive meanwhile.
+  if (auto connection = connection_) {
+    sendKeepalive(*connection);
+  }
 }
 
 void KeepaliveTimer::sendKeepalive(FrameSink& sink) {
@@ -61,21 +70,24 @@ void KeepaliveTimer::sendKeepalive(FrameSink& sink) {
     // stop() being called
     pending_ = true;
     sink.sendKeepalive();
-    schedule();
+    if (connection_) {
+      schedule();
+    }
   }
 }
 
 // must be called from the same thread as start
 void KeepaliveTimer::stop() {
-  *generation_ += 1;
   pending_ = false;
   connection_.reset();
+  if (wheel_) {
+    wheel_->cancel(handle_);
+  }
 }
 
 // must be called from the same thread as stop
 void KeepaliveTimer::start(const std::shared_ptr<FrameSink>& connection) {
   connection_ = connection;
-  *generation_ += 1;
   DCHECK(!pending_);
 
   schedule();
@@ -84,4 +96,13 @@ void KeepaliveTimer::start(const std::shared_ptr<FrameSink>& connection) {
 void KeepaliveTimer::keepaliveReceived() {
   pending_ = false;
 }
+
+void KeepaliveTimer::activity() {
+  if (!connection_) {
+    return;
+  }
+  pending_ = false;
+  // Moving an entry between the wheel's slots is O(1).
+  schedule();
+}
 } // namespace rsocket
@@ -16,6 +16,7 @@
 
 #include <folly/io/async/EventBase.h>
 
+#include "rsocket/internal/KeepaliveTimerWheel.h"
 #include "rsocket/statemachine/RSocketStateMachine.h"
 
 namespace rsocket {
@@ -38,10 +39,22 @@ class KeepaliveTimer {
 
   void keepaliveReceived();
 
+  /// Called for frames received while started.  The peer is evidently alive,
+  /// so the next keepalive is pushed back by a whole period.
+  void activity();
+
  private:
+  friend class KeepaliveTimerWheel;
+
+  /// Called by the wheel once a period has elapsed.
+  void expired();
+
   std::shared_ptr<FrameSink> connection_;
   folly::EventBase& eventBase_;
-  const std::shared_ptr<uint32_t> generation_;
+  /// Deadlines are tracked by the wheel shared by all the connections of
+  /// eventBase_, it is looked up on first use.
+  std::shared_ptr<KeepaliveTimerWheel> wheel_;
+  KeepaliveTimerWheel::Handle handle_{KeepaliveTimerWheel::kInvalidHandle};
   const std::chrono::milliseconds period_;
   std::atomic<bool> pending_{false};
 };
@@ -0,0 +1,188 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/KeepaliveTimerWheel.h"
+
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventBaseLocal.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+
+#include "rsocket/internal/KeepaliveTimer.h"
+
+namespace rsocket {
+
+constexpr KeepaliveTimerWheel::Handle KeepaliveTimerWheel::kInvalidHandle;
+constexpr std::chrono::milliseconds KeepaliveTimerWheel::kDefaultTick;
+constexpr size_t KeepaliveTimerWheel::kDefaultSlots;
+
+KeepaliveTimerWheel::KeepaliveTimerWheel(
+    folly::EventBase& eventBase,
+    std::chrono::milliseconds tick,
+    size_t slots)
+    : tick_{std::max(tick, std::chrono::milliseconds{1})},
+      origin_{Clock::now()},
+      timeout_{folly::AsyncTimeout::make(
+          eventBase,
+          [this]() noexcept { expire(Clock::now()); })},
+      slots_(std::max<size_t>(slots, 1), kInvalidHandle) {}
+
+std::shared_ptr<KeepaliveTimerWheel> KeepaliveTimerWheel::forEventBase(
+    folly::EventBase& evb) {
+  static folly::EventBaseLocal<std::shared_ptr<KeepaliveTimerWheel>> local;
+  return local.getOrCreateFn(
+      evb, [&evb] { return std::make_shared<KeepaliveTimerWheel>(evb); });
+}
+
+KeepaliveTimerWheel::Handle KeepaliveTimerWheel::add(KeepaliveTimer& timer) {
+  Handle handle;
+  if (free_ != kInvalidHandle) {
+    handle = free_;
+    free_ = entries_[handle].next;
+  } else {
+    CHECK_LT(entries_.size(), static_cast<size_t>(kInvalidHandle));
+    handle = static_cast<Handle>(entries_.size());
+    entries_.emplace_back();
+  }
+
+  auto& entry = entries_[handle];
+  entry.timer = &timer;
+  entry.prev = kInvalidHandle;
+  entry.next = kInvalidHandle;
+  entry.state = State::IDLE;
+  return handle;
+}
+
+void KeepaliveTimerWheel::remove(Handle handle) {
+  cancel(handle);
+
+  auto& entry = entries_[handle];
+  entry.timer = nullptr;
+  entry.state = State::FREE;
+  entry.next = free_;
+  free_ = handle;
+}
+
+void KeepaliveTimerWheel::schedule(
+    Handle handle,
+    std::chrono::milliseconds delay) {
+  DCHECK(entries_[handle].state != State::FREE);
+  if (entries_[handle].state == State::SCHEDULED) {
+    unlink(handle);
+  }
+
+  // Rounding up to the next tick never fires early.
+  auto const deadline =
+      std::max(tickOf(Clock::now() + delay) + 1, currentTick_ + 1);
+  link(handle, deadline);
+  arm();
+}
+
+void KeepaliveTimerWheel::cancel(Handle handle) {
+  auto& entry = entries_[handle];
+  DCHECK(entry.state != State::FREE);
+  if (entry.state == State::SCHEDULED) {
+    unlink(handle);
+  }
+  // Also keeps an entry in the middle of a batch from expiring.
+  entry.state = State::IDLE;
+
+  if (scheduled_ == 0) {
+    timeout_->cancelTimeout();
+  }
+}
+
+void KeepaliveTimerWheel::expire(Clock::time_point now) {
+  auto const nowTick = tickOf(now);
+  if (nowTick > currentTick_) {
+    // Walking more than one round would only revisit the same slots.
+    auto const ticks =
+        std::min<uint64_t>(nowTick - currentTick_, slots_.size());
+    for (uint64_t i = 1; i <= ticks; ++i) {
+      auto handle = slots_[(currentTick_ + i) % slots_.size()];
+      while (handle != kInvalidHandle) {
+        auto& entry = entries_[handle];
+        auto const next = entry.next;
+        // Deadlines further than a round away share the slot.
+        if (entry.deadline <= nowTick) {
+          unlink(handle);
+          entry.state = State::EXPIRING;
+          expired_.push_back(handle);
+        }
+        handle = next;
+      }
+    }
+    currentTick_ = nowTick;
+  }
+
+  // The timers may reschedule, cancel or remove any entry, including the ones
+  // that are yet to be expired in this batch.
+  for (auto const handle : expired_) {
+    auto& entry = entries_[handle];
+    if (entry.state == State::EXPIRING) {
+      entry.state = State::IDLE;
+      entry.timer->expired();
+    }
+  }
+  expired_.clear();
+
+  arm();
+}
+
+uint64_t KeepaliveTimerWheel::tickOf(Clock::time_point time) const {
+  if (time <= origin_) {
+    return 0;
+  }
+  return std::chrono::duration_cast<std::chrono::milliseconds>(time - origin_)
+             .count() /
+      tick_.count();
+}
+
+void KeepaliveTimerWheel::link(Handle handle, uint64_t deadline) {
+  auto& head = slots_[deadline % slots_.size()];
+  auto& entry = entries_[handle];
+  entry.deadline = deadline;
+  entry.prev = kInvalidHandle;
+  entry.next = head;
+  entry.state = State::SCHEDULED;
+  if (head != kInvalidHandle) {
+    entries_[head].prev = handle;
+  }
+  head = handle;
+  ++scheduled_;
+}
+
+void KeepaliveTimerWheel::unlink(Handle handle) {
+  auto& entry = entries_[handle];
+  if (entry.prev != kInvalidHandle) {
+    entries_[entry.prev].next = entry.next;
+  } else {
+    slots_[entry.deadline % slots_.size()] = entry.next;
+  }
+  if (entry.next != kInvalidHandle) {
+    entries_[entry.next].prev = entry.prev;
+  }
+  entry.prev = kInvalidHandle;
+  entry.next = kInvalidHandle;
+  --scheduled_;
+}
+
+void KeepaliveTimerWheel::arm() {
+  if (scheduled_ > 0 && !timeout_->isScheduled()) {
+    timeout_->scheduleTimeout(tick_);
+  }
+}
+
+} // namespace rsocket
@@ -0,0 +1,122 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/io/async/AsyncTimeout.h>
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace folly {
+class EventBase;
+}
+
+namespace rsocket {
+
+class KeepaliveTimer;
+
+/// Hashed timing wheel tracking the keepalive deadlines of every connection of
+/// one EventBase.
+///
+/// All deadlines live in a single array of entries threaded into per-slot
+/// lists, so (re)scheduling and cancelling are O(1) and don't allocate once the
+/// array has grown to the number of connections.  A single AsyncTimeout ticks
+/// the wheel while any deadline is pending; each tick expires the whole slot
+/// it lands on in one batch.
+///
+/// Not thread safe: an instance must only be used from its EventBase's thread.
+class KeepaliveTimerWheel {
+ public:
+  using Handle = uint32_t;
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr Handle kInvalidHandle{std::numeric_limits<Handle>::max()};
+  static constexpr std::chrono::milliseconds kDefaultTick{10};
+  static constexpr size_t kDefaultSlots{1024};
+
+  explicit KeepaliveTimerWheel(
+      folly::EventBase& eventBase,
+      std::chrono::milliseconds tick = kDefaultTick,
+      size_t slots = kDefaultSlots);
+
+  KeepaliveTimerWheel(const KeepaliveTimerWheel&) = delete;
+  KeepaliveTimerWheel& operator=(const KeepaliveTimerWheel&) = delete;
+
+  /// Wheel shared by every KeepaliveTimer on the given EventBase.  Must be
+  /// called from the EventBase's thread.
+  static std::shared_ptr<KeepaliveTimerWheel> forEventBase(folly::EventBase&);
+
+  /// Registers a timer with the wheel without scheduling it.  The handle stays
+  /// valid until remove() is called.
+  Handle add(KeepaliveTimer& timer);
+  void remove(Handle);
+
+  /// Schedules, or reschedules, the timer to expire after the delay.  The
+  /// deadline is rounded up to the wheel's tick.
+  void schedule(Handle, std::chrono::milliseconds delay);
+  void cancel(Handle);
+
+  /// Expires every deadline up to `now`.  Called by the wheel's own timeout,
+  /// exposed for tests.
+  void expire(Clock::time_point now);
+
+  /// Number of timers that currently have a deadline.
+  size_t scheduled() const {
+    return scheduled_;
+  }
+
+ private:
+  enum class State : uint8_t {
+    FREE,
+    IDLE,
+    SCHEDULED,
+    EXPIRING,
+  };
+
+  struct Entry {
+    KeepaliveTimer* timer{nullptr};
+    uint64_t deadline{0};
+    Handle prev{kInvalidHandle};
+    Handle next{kInvalidHandle};
+    State state{State::FREE};
+  };
+
+  uint64_t tickOf(Clock::time_point) const;
+  void link(Handle, uint64_t deadline);
+  void unlink(Handle);
+  void arm();
+
+  const std::chrono::milliseconds tick_;
+  const Clock::time_point origin_;
+  const std::unique_ptr<folly::AsyncTimeout> timeout_;
+
+  std::vector<Entry> entries_;
+  /// Heads of the per-slot lists.
+  std::vector<Handle> slots_;
+  /// Head of the list of free entries, linked through Entry::next.
+  Handle free_{kInvalidHandle};
+
+  /// Last tick whose slot has been expired.
+  uint64_t currentTick_{0};
+  size_t scheduled_{0};
+
+  /// Reused between expiries so that a batch doesn't allocate.
+  std::vector<Handle> expired_;
+};
+
+} // namespace rsocket
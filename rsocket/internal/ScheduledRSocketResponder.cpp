@@ -48,10 +48,12 @@ ScheduledRSocketResponder::handleRequestStream(
   auto innerFlowable =
       inner_->handleRequestStream(std::move(request), streamId);
   return yarpl::flowable::internal::flowableFromSubscriber<Payload>(
-      [innerFlowable = std::move(innerFlowable), eventBase = &eventBase_](
+      [innerFlowable = std::move(innerFlowable),
+       eventBase = &eventBase_,
+       streamId](
           std::shared_ptr<yarpl::flowable::Subscriber<Payload>> subscriber) {
         innerFlowable->subscribe(std::make_shared<ScheduledSubscriber<Payload>>(
-            std::move(subscriber), *eventBase));
+            std::move(subscriber), *eventBase, streamId));
       });
 }
 
@@ -72,10 +74,12 @@ ScheduledRSocketResponder::handleRequestChannel(
   auto innerFlowable = inner_->handleRequestChannel(
       std::move(request), std::move(requestStreamFlowable), streamId);
   return yarpl::flowable::internal::flowableFromSubscriber<Payload>(
-      [innerFlowable = std::move(innerFlowable), eventBase = &eventBase_](
+      [innerFlowable = std::move(innerFlowable),
+       eventBase = &eventBase_,
+       streamId](
           std::shared_ptr<yarpl::flowable::Subscriber<Payload>> subscriber) {
         innerFlowable->subscribe(std::make_shared<ScheduledSubscriber<Payload>>(
-            std::move(subscriber), *eventBase));
+            std::move(subscriber), *eventBase, streamId));
       });
 }
 
@@ -15,6 +15,7 @@
 #pragma once
 
 #include "rsocket/internal/ScheduledSubscription.h"
+#include "rsocket/internal/Tracing.h"
 
 #include <folly/io/async/EventBase.h>
 
@@ -28,6 +29,8 @@ namespace rsocket {
 // This class should be used to wrap a Subscriber returned to the application
 // code so that calls to on{Subscribe,Next,Complete,Error} are scheduled on the
 // right EventBase.
+// The stream ID only tags the tracing spans of the time items wait for the
+// EventBase.
 //
 
 template <typename T>
@@ -35,8 +38,9 @@ class ScheduledSubscriber : public yarpl::flowable::Subscriber<T> {
  public:
   ScheduledSubscriber(
       std::shared_ptr<yarpl::flowable::Subscriber<T>> inner,
-      folly::EventBase& eventBase)
-      : inner_(std::move(inner)), eventBase_(eventBase) {}
+      folly::EventBase& eventBase,
+      StreamId streamId = 0)
+      : inner_(std::move(inner)), eventBase_(eventBase), streamId_(streamId) {}
 
   void onSubscribe(
       std::shared_ptr<yarpl::flowable::Subscription> subscription) override {
@@ -76,7 +80,11 @@ class ScheduledSubscriber : public yarpl::flowable::Subscriber<T> {
       inner_->onNext(std::move(value));
     } else {
       eventBase_.runInEventBaseThread(
-          [inner = inner_, value = std::move(value)]() mutable {
+          [inner = inner_,
+           value = std::move(value),
+           queued = QueuedSpan{"ScheduledSubscriber::queue", streamId_}]()
+              mutable {
+            queued.end();
             inner->onNext(std::move(value));
           });
     }
@@ -85,6 +93,7 @@ class ScheduledSubscriber : public yarpl::flowable::Subscriber<T> {
  private:
   const std::shared_ptr<yarpl::flowable::Subscriber<T>> inner_;
   folly::EventBase& eventBase_;
+  const StreamId streamId_;
 };
 
 //
@@ -0,0 +1,84 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/StatsBatch.h"
+
+#include <folly/io/async/EventBaseManager.h>
+#include <folly/lang/Bits.h>
+
+namespace rsocket {
+
+constexpr size_t StatsBatch::kFrameTypes;
+
+StatsBatch::StatsBatch(std::shared_ptr<RSocketStats> stats)
+    : stats_{stats ? std::move(stats) : RSocketStats::noop()},
+      mode_{modeFor(*stats_)} {}
+
+StatsBatch::Mode StatsBatch::modeFor(const RSocketStats& stats) {
+  if (&stats == RSocketStats::noop().get()) {
+    return Mode::NOOP;
+  }
+  return stats.acceptsBatchedCounts() ? Mode::BATCHED : Mode::DIRECT;
+}
+
+StatsBatch::~StatsBatch() {
+  flush();
+}
+
+void StatsBatch::scheduleFlush() {
+  auto const evb = folly::EventBaseManager::get()->getExistingEventBase();
+  if (evb && evb->isInEventBaseThread()) {
+    evb->runInLoop(this);
+  } else {
+    flush();
+  }
+}
+
+void StatsBatch::flush() {
+  cancelLoopCallback();
+
+  flushFrames(framesRead_, false);
+  flushFrames(framesWritten_, true);
+  if (bytesRead_) {
+    stats_->bytesRead(bytesRead_);
+    bytesRead_ = 0;
+  }
+  if (bytesWritten_) {
+    stats_->bytesWritten(bytesWritten_);
+    bytesWritten_ = 0;
+  }
+  if (streamBufferFrames_ || streamBufferBytes_) {
+    stats_->streamBufferChanged(streamBufferFrames_, streamBufferBytes_);
+    streamBufferFrames_ = 0;
+    streamBufferBytes_ = 0;
+  }
+}
+
+void StatsBatch::flushFrames(FrameCounts& frames, bool written) {
+  while (frames.types) {
+    auto const index = folly::findFirstSet(frames.types) - 1;
+    frames.types &= frames.types - 1;
+
+    auto const type = static_cast<FrameType>(index);
+    auto const count = frames.counts[index];
+    frames.counts[index] = 0;
+    if (written) {
+      stats_->framesWritten(type, count);
+    } else {
+      stats_->framesRead(type, count);
+    }
+  }
+}
+
+} // namespace rsocket
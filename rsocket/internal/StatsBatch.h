@@ -0,0 +1,147 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/io/async/EventBase.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+#include "rsocket/RSocketStats.h"
+
+namespace rsocket {
+
+/// The per-frame counts of one connection, kept in plain counters and flushed
+/// to its RSocketStats at the end of the EventBase loop they were counted in,
+/// so counting a frame costs an increment rather than a virtual call.
+///
+/// Stats whose acceptsBatchedCounts() is false are called directly, and the
+/// RSocketStats::noop() stats not at all.  Counts made on a thread without an
+/// EventBase are flushed right away.
+///
+/// Must only be used from a single thread at a time.
+class StatsBatch : private folly::EventBase::LoopCallback {
+ public:
+  explicit StatsBatch(std::shared_ptr<RSocketStats>);
+  ~StatsBatch() override;
+
+  StatsBatch(const StatsBatch&) = delete;
+  StatsBatch& operator=(const StatsBatch&) = delete;
+
+  void frameRead(FrameType type) {
+    if (mode_ == Mode::BATCHED && countFrame(framesRead_, type)) {
+      return;
+    }
+    if (mode_ != Mode::NOOP) {
+      stats_->frameRead(type);
+    }
+  }
+
+  void frameWritten(FrameType type) {
+    if (mode_ == Mode::BATCHED && countFrame(framesWritten_, type)) {
+      return;
+    }
+    if (mode_ != Mode::NOOP) {
+      stats_->frameWritten(type);
+    }
+  }
+
+  void bytesRead(size_t bytes) {
+    if (mode_ == Mode::BATCHED) {
+      bytesRead_ += bytes;
+      schedule();
+    } else if (mode_ == Mode::DIRECT) {
+      stats_->bytesRead(bytes);
+    }
+  }
+
+  void bytesWritten(size_t bytes) {
+    if (mode_ == Mode::BATCHED) {
+      bytesWritten_ += bytes;
+      schedule();
+    } else if (mode_ == Mode::DIRECT) {
+      stats_->bytesWritten(bytes);
+    }
+  }
+
+  void streamBufferChanged(int64_t framesCountDelta, int64_t dataSizeDelta) {
+    if (mode_ == Mode::BATCHED) {
+      streamBufferFrames_ += framesCountDelta;
+      streamBufferBytes_ += dataSizeDelta;
+      schedule();
+    } else if (mode_ == Mode::DIRECT) {
+      stats_->streamBufferChanged(framesCountDelta, dataSizeDelta);
+    }
+  }
+
+  /// Delivers the counts made so far.
+  void flush();
+
+  RSocketStats& stats() const {
+    return *stats_;
+  }
+
+ private:
+  enum class Mode : uint8_t { NOOP, DIRECT, BATCHED };
+
+  static Mode modeFor(const RSocketStats&);
+
+  /// Frame types are six bits wide.
+  static constexpr size_t kFrameTypes = 64;
+
+  struct FrameCounts {
+    std::array<uint32_t, kFrameTypes> counts{};
+    /// Bit per frame type counted since the last flush.
+    uint64_t types{0};
+  };
+
+  /// Returns false for frame types that don't fit, they're delivered directly.
+  bool countFrame(FrameCounts& frames, FrameType type) {
+    auto const index = static_cast<size_t>(type);
+    if (index >= kFrameTypes) {
+      return false;
+    }
+    ++frames.counts[index];
+    frames.types |= uint64_t{1} << index;
+    schedule();
+    return true;
+  }
+
+  void schedule() {
+    if (!isLoopCallbackScheduled()) {
+      scheduleFlush();
+    }
+  }
+
+  void scheduleFlush();
+  void flushFrames(FrameCounts&, bool written);
+
+  void runLoopCallback() noexcept override {
+    flush();
+  }
+
+  const std::shared_ptr<RSocketStats> stats_;
+  const Mode mode_;
+
+  FrameCounts framesRead_;
+  FrameCounts framesWritten_;
+  size_t bytesRead_{0};
+  size_t bytesWritten_{0};
+  int64_t streamBufferFrames_{0};
+  int64_t streamBufferBytes_{0};
+};
+
+} // namespace rsocket
@@ -0,0 +1,91 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/StreamIdAllocator.h"
+
+#include <glog/logging.h>
+
+namespace rsocket {
+
+constexpr StreamId StreamIdAllocator::kLimit;
+constexpr std::chrono::milliseconds StreamIdAllocator::kDefaultQuarantine;
+
+StreamIdAllocator::StreamIdAllocator(
+    StreamId first,
+    StreamId limit,
+    std::chrono::milliseconds quarantine,
+    Clock::time_point (*now)())
+    : first_{first},
+      size_{(limit - first + 1) / 2},
+      quarantine_{quarantine},
+      now_{now} {
+  CHECK_GT(first, 0u);
+  CHECK_GT(limit, first);
+  CHECK_LE(limit, kLimit);
+}
+
+folly::Optional<StreamId> StreamIdAllocator::allocate(
+    folly::FunctionRef<bool(StreamId)> inUse) {
+  for (uint32_t tries = 0; tries < size_; ++tries) {
+    if (next_ == 0 && position_ > 0) {
+      wrapped_ = true;
+    }
+    auto const streamId = first_ + 2 * next_;
+    auto const position = position_++;
+    if (++next_ == size_) {
+      next_ = 0;
+    }
+
+    if (!released_.empty() && released_.begin()->first == position) {
+      auto const releasedAt = released_.begin()->second;
+      released_.erase(released_.begin());
+      if (now_() - releasedAt < quarantine_) {
+        continue;
+      }
+    }
+    if (!inUse(streamId)) {
+      return streamId;
+    }
+  }
+  return folly::none;
+}
+
+void StreamIdAllocator::release(StreamId streamId) {
+  if (!owns(streamId) || streamId < first_) {
+    return;
+  }
+  auto const index = indexOf(streamId);
+  if (index >= size_) {
+    return;
+  }
+  auto const distance = distanceTo(index);
+  if (distance < size_ / 2) {
+    released_[position_ + distance] = now_();
+  }
+}
+
+void StreamIdAllocator::skipPast(StreamId streamId) {
+  if (streamId < first_) {
+    return;
+  }
+  auto index = indexOf(streamId) + 1;
+  if (index >= size_) {
+    index = 0;
+  }
+  position_ += distanceTo(index);
+  next_ = index;
+  released_.erase(released_.begin(), released_.lower_bound(position_));
+}
+
+} // namespace rsocket
@@ -0,0 +1,112 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/Function.h>
+#include <folly/Optional.h>
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <map>
+
+#include "rsocket/internal/Common.h"
+
+namespace rsocket {
+
+/// Hands out the IDs of the streams initiated by one side of a connection.
+///
+/// IDs are handed out in ascending order.  Once they run out the allocator
+/// starts over from the lowest one, which the protocol allows, skipping the
+/// IDs of streams that are still open.  The peer may still send frames for a
+/// stream after it was closed on this side, e.g. after a CANCEL, so the ID of
+/// a closed stream is not reused until `quarantine` passed.
+///
+/// Only streams closed shortly before their IDs come up again need to be
+/// remembered for that, i.e. those that lived for about as long as it takes
+/// to hand out half of the IDs.  The others are reused no sooner than that.
+///
+/// Not thread safe.
+class StreamIdAllocator {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /// Stream IDs are 31-bit, the topmost ones are never handed out.
+  static constexpr StreamId kLimit{std::numeric_limits<int32_t>::max() - 2};
+  static constexpr std::chrono::milliseconds kDefaultQuarantine{30000};
+
+  /// Hands out `first`, `first + 2` and so on, up to but excluding `limit`.
+  explicit StreamIdAllocator(
+      StreamId first,
+      StreamId limit = kLimit,
+      std::chrono::milliseconds quarantine = kDefaultQuarantine,
+      Clock::time_point (*now)() = &Clock::now);
+
+  /// The next ID for which `inUse` returns false and that is not quarantined,
+  /// or none if there is no such ID.
+  folly::Optional<StreamId> allocate(folly::FunctionRef<bool(StreamId)> inUse);
+
+  /// Marks the stream as closed.  Ignores IDs this allocator doesn't hand
+  /// out.
+  void release(StreamId);
+
+  /// Continues with the first ID greater than `streamId`, e.g. the largest one
+  /// used before a cold resumption.
+  void skipPast(StreamId);
+
+  /// Whether the ID has the parity of the IDs this allocator hands out.
+  bool owns(StreamId streamId) const {
+    return streamId % 2 == first_ % 2;
+  }
+
+  /// Whether the allocator started over from the lowest ID at least once.
+  bool wrapped() const {
+    return wrapped_;
+  }
+
+  /// Number of closed streams whose IDs are remembered for the quarantine.
+  size_t quarantined() const {
+    return released_.size();
+  }
+
+ private:
+  uint32_t indexOf(StreamId streamId) const {
+    return (streamId - first_) / 2;
+  }
+
+  /// How many IDs are handed out before the one at `index` comes up.
+  uint32_t distanceTo(uint32_t index) const {
+    return index >= next_ ? index - next_ : size_ - (next_ - index);
+  }
+
+  const StreamId first_;
+  /// Number of IDs handed out before starting over.
+  const uint32_t size_;
+  const std::chrono::milliseconds quarantine_;
+  Clock::time_point (*const now_)();
+
+  /// Index of the next ID to hand out.
+  uint32_t next_{0};
+  /// Number of IDs handed out or skipped so far.
+  uint64_t position_{0};
+  bool wrapped_{false};
+
+  /// When the streams closed shortly before their IDs come up again were
+  /// closed, by the position_ their IDs come up at.  The cursor passes them
+  /// in order, so only the first one needs to be looked at.
+  std::map<uint64_t, Clock::time_point> released_;
+};
+
+} // namespace rsocket
@@ -0,0 +1,238 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/Tracing.h"
+
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/json.h>
+#include <folly/system/ThreadId.h>
+#include <folly/system/ThreadName.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <vector>
+
+namespace rsocket {
+
+std::atomic<bool> Tracer::enabled_{false};
+
+namespace {
+
+struct Span {
+  const char* name;
+  /// Nanoseconds since the clock's epoch.
+  int64_t begin;
+  int64_t duration;
+  StreamId streamId;
+};
+
+/// Spans of one thread.  Only that thread appends to it, exporters read the
+/// spans published by the release store of the size.
+class ThreadBuffer {
+ public:
+  explicit ThreadBuffer(size_t capacity)
+      : spans_{new Span[capacity]},
+        capacity_{capacity},
+        tid_{folly::getOSThreadID()},
+        threadName_{folly::getCurrentThreadName().value_or("")} {}
+
+  void push(const Span& span) {
+    auto const size = size_.load(std::memory_order_relaxed);
+    if (size == capacity_) {
+      return;
+    }
+    spans_[size] = span;
+    size_.store(size + 1, std::memory_order_release);
+  }
+
+  size_t size() const {
+    return size_.load(std::memory_order_acquire);
+  }
+
+  const Span& operator[](size_t i) const {
+    return spans_[i];
+  }
+
+  uint64_t tid() const {
+    return tid_;
+  }
+
+  const std::string& threadName() const {
+    return threadName_;
+  }
+
+ private:
+  const std::unique_ptr<Span[]> spans_;
+  const size_t capacity_;
+  std::atomic<size_t> size_{0};
+  const uint64_t tid_;
+  const std::string threadName_;
+};
+
+struct Session {
+  std::mutex mutex;
+  uint64_t generation{0};
+  size_t spansPerThread{0};
+  Tracer::Clock::time_point start;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+};
+
+Session& session() {
+  // Leaked so that threads outliving static destruction can still record.
+  static auto* session = new Session;
+  return *session;
+}
+
+/// Bumped by each start(), so that threads replace their buffers.
+std::atomic<uint64_t> generation{0};
+
+struct LocalBuffer {
+  uint64_t generation{0};
+  std::shared_ptr<ThreadBuffer> buffer;
+};
+
+thread_local LocalBuffer localBuffer;
+
+ThreadBuffer& currentBuffer() {
+  if (localBuffer.generation != generation.load(std::memory_order_acquire)) {
+    auto& s = session();
+    std::lock_guard<std::mutex> lock{s.mutex};
+    localBuffer.buffer = std::make_shared<ThreadBuffer>(s.spansPerThread);
+    localBuffer.generation = s.generation;
+    s.buffers.push_back(localBuffer.buffer);
+  }
+  return *localBuffer.buffer;
+}
+
+int64_t toNanos(Tracer::Clock::time_point time) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             time.time_since_epoch())
+      .count();
+}
+
+/// Chrome traces count in microseconds, keep the nanoseconds as decimals.
+void appendMicros(std::string& out, int64_t nanos) {
+  if (nanos < 0) {
+    out += '-';
+    nanos = -nanos;
+  }
+  folly::stringAppendf(
+      &out,
+      "%lld.%03lld",
+      static_cast<long long>(nanos / 1000),
+      static_cast<long long>(nanos % 1000));
+}
+
+void appendName(std::string& out, folly::StringPiece name) {
+  folly::json::escapeString(name, out, folly::json::serialization_opts{});
+}
+
+} // namespace
+
+void Tracer::start(size_t spansPerThread) {
+  auto& s = session();
+  std::lock_guard<std::mutex> lock{s.mutex};
+  s.spansPerThread = std::max<size_t>(spansPerThread, 1);
+  s.start = Clock::now();
+  s.buffers.clear();
+  s.generation = generation.load(std::memory_order_relaxed) + 1;
+  generation.store(s.generation, std::memory_order_release);
+  enabled_.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::stop() {
+  enabled_.store(false, std::memory_order_relaxed);
+}
+
+void Tracer::record(
+    const char* name,
+    StreamId streamId,
+    Clock::time_point begin,
+    Clock::time_point end) {
+  if (!enabled()) {
+    return;
+  }
+  currentBuffer().push(
+      Span{name, toNanos(begin), toNanos(end) - toNanos(begin), streamId});
+}
+
+std::string Tracer::exportChromeTrace() {
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+  int64_t start;
+  {
+    auto& s = session();
+    std::lock_guard<std::mutex> lock{s.mutex};
+    buffers = s.buffers;
+    start = toNanos(s.start);
+  }
+
+  auto const pid = static_cast<int>(::getpid());
+  std::string out{"{\"traceEvents\":["};
+  bool first = true;
+  auto const separate = [&] {
+    if (!first) {
+      out += ',';
+    }
+    first = false;
+  };
+
+  for (auto const& buffer : buffers) {
+    if (!buffer->threadName().empty()) {
+      separate();
+      folly::stringAppendf(
+          &out,
+          "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%llu,"
+          "\"args\":{\"name\":",
+          pid,
+          static_cast<unsigned long long>(buffer->tid()));
+      appendName(out, buffer->threadName());
+      out += "}}";
+    }
+
+    auto const size = buffer->size();
+    for (size_t i = 0; i < size; ++i) {
+      auto const& span = (*buffer)[i];
+      separate();
+      out += "{\"name\":";
+      appendName(out, span.name);
+      out += ",\"cat\":\"rsocket\",\"ph\":\"X\",\"ts\":";
+      appendMicros(out, span.begin - start);
+      out += ",\"dur\":";
+      appendMicros(out, span.duration);
+      folly::stringAppendf(
+          &out,
+          ",\"pid\":%d,\"tid\":%llu,\"args\":{\"stream\":%u}}",
+          pid,
+          static_cast<unsigned long long>(buffer->tid()),
+          span.streamId);
+    }
+  }
+
+  out += "],\"displayTimeUnit\":\"ns\"}";
+  return out;
+}
+
+void Tracer::writeChromeTrace(const std::string& path) {
+  if (!folly::writeFile(exportChromeTrace(), path.c_str())) {
+    throw std::system_error(
+        errno, std::generic_category(), "writing trace to " + path);
+  }
+}
+
+} // namespace rsocket
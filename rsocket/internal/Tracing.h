@@ -0,0 +1,141 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/Preprocessor.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include "rsocket/internal/Common.h"
+
+namespace rsocket {
+
+/// Spans of time spent inside the library, tagged with the stream they were
+/// spent on, exported in the Chrome trace event format that chrome://tracing
+/// and Perfetto (ui.perfetto.dev) open.
+///
+/// The library records spans only when it's built with RSOCKET_TRACING (cmake
+/// -DRSOCKET_TRACING=ON), it costs nothing otherwise.  Even then, spans are
+/// recorded only between start() and stop().
+///
+/// Each thread records into a buffer of its own that only it writes to, so
+/// recording takes no lock.  A thread drops its spans once its buffer is full.
+class Tracer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /// Discards the spans recorded so far and starts recording, keeping up to
+  /// `spansPerThread` spans from each thread.  Each takes 32 bytes.
+  static void start(size_t spansPerThread = 1 << 16);
+
+  /// Stops recording.  The spans recorded so far can still be exported.
+  static void stop();
+
+  static bool enabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  /// Records a span on the calling thread.  `name` must outlive the Tracer,
+  /// string literals do.
+  static void record(
+      const char* name,
+      StreamId streamId,
+      Clock::time_point begin,
+      Clock::time_point end);
+
+  /// The spans recorded since the last start() as a Chrome trace JSON object,
+  /// with timestamps relative to the start().  Safe to call while recording.
+  static std::string exportChromeTrace();
+
+  /// Writes exportChromeTrace() to the file at `path`, throws on I/O errors.
+  static void writeChromeTrace(const std::string& path);
+
+ private:
+  static std::atomic<bool> enabled_;
+};
+
+/// Records a span over its own lifetime.  A null name records nothing.
+class TraceSpan {
+ public:
+  TraceSpan(const char* name, StreamId streamId)
+      : name_{name}, streamId_{streamId} {
+    if (name_) {
+      begin_ = Tracer::Clock::now();
+    }
+  }
+
+  ~TraceSpan() {
+    if (name_) {
+      Tracer::record(name_, streamId_, begin_, Tracer::Clock::now());
+    }
+  }
+
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+ private:
+  const char* const name_;
+  const StreamId streamId_;
+  Tracer::Clock::time_point begin_;
+};
+
+/// Records the span a task waits in a queue, from its construction, when the
+/// task is queued, until end() is called when the task runs.
+#ifdef RSOCKET_TRACING
+class QueuedSpan {
+ public:
+  QueuedSpan(const char* name, StreamId streamId)
+      : name_{Tracer::enabled() ? name : nullptr}, streamId_{streamId} {
+    if (name_) {
+      begin_ = Tracer::Clock::now();
+    }
+  }
+
+  void end() const {
+    if (name_) {
+      Tracer::record(name_, streamId_, begin_, Tracer::Clock::now());
+    }
+  }
+
+ private:
+  const char* name_;
+  StreamId streamId_;
+  Tracer::Clock::time_point begin_;
+};
+#else
+class QueuedSpan {
+ public:
+  QueuedSpan(const char*, StreamId) {}
+
+  void end() const {}
+};
+#endif
+
+} // namespace rsocket
+
+/// Records a span over the rest of the enclosing scope.  The stream ID
+/// expression is evaluated only while the Tracer is recording.
+#ifdef RSOCKET_TRACING
+#define RSOCKET_TRACE_SPAN(name, streamId)                                  \
+  ::rsocket::TraceSpan FB_ANONYMOUS_VARIABLE(rsocketTraceSpan) {            \
+    ::rsocket::Tracer::enabled() ? (name) : nullptr,                        \
+        ::rsocket::Tracer::enabled() ? ::rsocket::StreamId(streamId)        \
+                                     : ::rsocket::StreamId(0)               \
+  }
+#else
+#define RSOCKET_TRACE_SPAN(name, streamId) static_cast<void>(0)
+#endif
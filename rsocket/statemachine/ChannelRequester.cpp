@@ -152,4 +152,12 @@ void ChannelRequester::tryCompleteChannel() {
   }
 }
 
+void ChannelRequester::onWritabilityChanged(bool writable) {
+  if (writable) {
+    resumePublisher();
+  } else {
+    pausePublisher();
+  }
+}
+
 } // namespace rsocket
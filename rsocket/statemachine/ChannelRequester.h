@@ -56,6 +56,8 @@ class ChannelRequester : public ConsumerBase,
   void handleError(folly::exception_wrapper) override;
   void handleCancel() override;
 
+  void onWritabilityChanged(bool) override;
+
   void endStream(StreamCompletionSignal) override;
 
  private:
@@ -63,7 +63,10 @@ void ChannelResponder::handlePayload(
     bool flagsComplete,
     bool flagsNext,
     bool flagsFollows) {
-  payloadFragments_.addPayload(std::move(payload), flagsNext, flagsComplete);
+  if (!addFragment(std::move(payload), flagsNext, flagsComplete)) {
+    handleReassemblyError();
+    return;
+  }
 
   if (flagsFollows) {
     // there will be more fragments to come
@@ -119,4 +122,12 @@ void ChannelResponder::tryCompleteChannel() {
   }
 }
 
+void ChannelResponder::onWritabilityChanged(bool writable) {
+  if (writable) {
+    resumePublisher();
+  } else {
+    pausePublisher();
+  }
+}
+
 } // namespace rsocket
@@ -50,6 +50,8 @@ class ChannelResponder : public ConsumerBase,
   void handleError(folly::exception_wrapper) override;
   void handleCancel() override;
 
+  void onWritabilityChanged(bool) override;
+
   void endStream(StreamCompletionSignal) override;
 
  private:
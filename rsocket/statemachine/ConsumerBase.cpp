@@ -18,8 +18,40 @@
 
 #include <glog/logging.h>
 
+#include "yarpl/utils/credits.h"
+
 namespace rsocket {
 
+namespace {
+
+constexpr auto kReassemblyError = "Payload exceeds the maximum reassembly size";
+
+size_t payloadSize(const Payload& payload) {
+  return (payload.data ? payload.data->computeChainDataLength() : 0) +
+      (payload.metadata ? payload.metadata->computeChainDataLength() : 0);
+}
+
+} // namespace
+
+/// Subscription handed out in fragment-streaming mode.  Its credits count
+/// chunks, ConsumerBase::requestChunks() turns them into payload requests.
+class ConsumerBase::ChunkSubscription : public yarpl::flowable::Subscription {
+ public:
+  explicit ChunkSubscription(std::shared_ptr<ConsumerBase> consumer)
+      : consumer_{std::move(consumer)} {}
+
+  void request(int64_t n) override {
+    consumer_->requestChunks(n);
+  }
+
+  void cancel() override {
+    consumer_->cancel();
+  }
+
+ private:
+  const std::shared_ptr<ConsumerBase> consumer_;
+};
+
 void ConsumerBase::subscribe(
     std::shared_ptr<yarpl::flowable::Subscriber<Payload>> subscriber) {
   if (state_ == State::CLOSED) {
@@ -33,10 +65,29 @@ void ConsumerBase::subscribe(
   consumingSubscriber_->onSubscribe(shared_from_this());
 }
 
+void ConsumerBase::subscribe(
+    std::shared_ptr<yarpl::flowable::Subscriber<PayloadChunk>> subscriber) {
+  if (state_ == State::CLOSED) {
+    subscriber->onSubscribe(yarpl::flowable::Subscription::create());
+    subscriber->onComplete();
+    return;
+  }
+
+  DCHECK(!consumingSubscriber_);
+  DCHECK(!chunkSubscriber_);
+  streamingFragments_ = true;
+  chunkSubscriber_ = std::move(subscriber);
+  chunkSubscriber_->onSubscribe(
+      std::make_shared<ChunkSubscription>(shared_from_this()));
+}
+
 void ConsumerBase::cancelConsumer() {
   state_ = State::CLOSED;
   VLOG(5) << "ConsumerBase::cancelConsumer()";
   consumingSubscriber_ = nullptr;
+  chunkSubscriber_ = nullptr;
+  pendingChunks_.clear();
+  pendingChunksSize_ = 0;
 }
 
 void ConsumerBase::addImplicitAllowance(size_t n) {
@@ -53,15 +104,15 @@ void ConsumerBase::generateRequest(size_t n) {
 void ConsumerBase::endStream(StreamCompletionSignal signal) {
   VLOG(5) << "ConsumerBase::endStream(" << signal << ")";
   state_ = State::CLOSED;
-  if (auto subscriber = std::move(consumingSubscriber_)) {
-    if (signal == StreamCompletionSignal::COMPLETE ||
-        signal == StreamCompletionSignal::CANCEL) { // TODO: remove CANCEL
-      VLOG(5) << "Closing ConsumerBase subscriber with calling onComplete";
-      subscriber->onComplete();
-    } else {
-      VLOG(5) << "Closing ConsumerBase subscriber with calling onError";
-      subscriber->onError(StreamInterruptedException(static_cast<int>(signal)));
-    }
+  if (signal == StreamCompletionSignal::COMPLETE ||
+      signal == StreamCompletionSignal::CANCEL) { // TODO: remove CANCEL
+    VLOG(5) << "Closing ConsumerBase subscriber with calling onComplete";
+    terminateSubscriber(folly::exception_wrapper());
+  } else {
+    VLOG(5) << "Closing ConsumerBase subscriber with calling onError";
+    terminateSubscriber(
+        folly::make_exception_wrapper<StreamInterruptedException>(
+            static_cast<int>(signal)));
   }
 }
 
@@ -95,7 +146,15 @@ bool ConsumerBase::processFragmentedPayload(
     bool flagsNext,
     bool flagsComplete,
     bool flagsFollows) {
-  payloadFragments_.addPayload(std::move(payload), flagsNext, flagsComplete);
+  if (streamingFragments_) {
+    return processChunk(
+        std::move(payload), flagsNext, flagsComplete, flagsFollows);
+  }
+
+  if (!addFragment(std::move(payload), flagsNext, flagsComplete)) {
+    handleReassemblyError();
+    return false;
+  }
 
   if (flagsFollows) {
     // there will be more fragments to come
@@ -111,19 +170,118 @@ bool ConsumerBase::processFragmentedPayload(
   return finalFlagsComplete;
 }
 
+bool ConsumerBase::processChunk(
+    Payload&& payload,
+    bool flagsNext,
+    bool flagsComplete,
+    bool flagsFollows) {
+  if (chunkStartsPayload_) {
+    if (!payload && !flagsNext && !flagsFollows) {
+      // COMPLETE without a payload
+      return flagsComplete;
+    }
+    // Flow control still counts whole payloads, charge it on the first
+    // fragment.
+    if (!allowance_.tryConsume(1) || !activeRequests_.tryConsume(1)) {
+      handleFlowControlError();
+      return false;
+    }
+    sendRequests();
+  }
+  chunkStartsPayload_ = !flagsFollows;
+  chunkFlagsComplete_ |= flagsComplete;
+
+  pendingChunksSize_ += payloadSize(payload);
+  pendingChunks_.push_back(PayloadChunk{std::move(payload), !flagsFollows});
+  drainChunks();
+
+  if (pendingChunksSize_ > maxReassemblySize()) {
+    handleReassemblyError();
+    return false;
+  }
+
+  if (flagsFollows) {
+    return false;
+  }
+  auto const complete = chunkFlagsComplete_;
+  chunkFlagsComplete_ = false;
+  return complete;
+}
+
+void ConsumerBase::requestChunks(int64_t n) {
+  if (n <= 0 || !chunkSubscriber_) {
+    return;
+  }
+  chunkCredits_ = yarpl::credits::add(chunkCredits_, n);
+  drainChunks();
+
+  if (consumerClosed() || chunkCredits_ <= 0) {
+    return;
+  }
+
+  // Every payload in flight yields at least one chunk, so only ask for more
+  // payloads than are already on their way.
+  auto const inFlight = std::min<size_t>(
+      allowance_.get(), static_cast<size_t>(yarpl::credits::kNoFlowControl));
+  if (static_cast<size_t>(chunkCredits_) > inFlight) {
+    request(chunkCredits_ - static_cast<int64_t>(inFlight));
+  }
+}
+
+void ConsumerBase::drainChunks() {
+  while (chunkSubscriber_ && chunkCredits_ > 0 && !pendingChunks_.empty()) {
+    auto chunk = std::move(pendingChunks_.front());
+    pendingChunks_.pop_front();
+    pendingChunksSize_ -= payloadSize(chunk.payload);
+    if (chunkCredits_ != yarpl::credits::kNoFlowControl) {
+      --chunkCredits_;
+    }
+    auto subscriber = chunkSubscriber_;
+    subscriber->onNext(std::move(chunk));
+  }
+
+  if (chunksCompleted_ && pendingChunks_.empty()) {
+    chunksCompleted_ = false;
+    if (auto subscriber = std::move(chunkSubscriber_)) {
+      subscriber->onComplete();
+    }
+  }
+}
+
 void ConsumerBase::completeConsumer() {
   state_ = State::CLOSED;
   VLOG(5) << "ConsumerBase::completeConsumer()";
-  if (auto subscriber = std::move(consumingSubscriber_)) {
-    subscriber->onComplete();
+  if (!pendingChunks_.empty()) {
+    // the subscriber gets the held back chunks first
+    chunksCompleted_ = true;
+    return;
   }
+  terminateSubscriber(folly::exception_wrapper());
 }
 
 void ConsumerBase::errorConsumer(folly::exception_wrapper ew) {
   state_ = State::CLOSED;
   VLOG(5) << "ConsumerBase::errorConsumer()";
+  terminateSubscriber(std::move(ew));
+}
+
+void ConsumerBase::terminateSubscriber(folly::exception_wrapper ew) {
+  pendingChunks_.clear();
+  pendingChunksSize_ = 0;
+  chunksCompleted_ = false;
+
   if (auto subscriber = std::move(consumingSubscriber_)) {
-    subscriber->onError(std::move(ew));
+    if (ew) {
+      subscriber->onError(std::move(ew));
+    } else {
+      subscriber->onComplete();
+    }
+  } else if (auto chunkSubscriber = std::move(chunkSubscriber_)) {
+    if (ew) {
+      chunkSubscriber->onError(std::move(ew));
+    } else {
+      chunkSubscriber->onComplete();
+    }
   }
 }
 
@@ -140,12 +298,19 @@ void ConsumerBase::sendRequests() {
 }
 
 void ConsumerBase::handleFlowControlError() {
-  if (auto subscriber = std::move(consumingSubscriber_)) {
-    subscriber->onError(std::runtime_error("Surplus response"));
-  }
+  terminateSubscriber(
+      folly::make_exception_wrapper<std::runtime_error>("Surplus response"));
   writeInvalidError("Flow control error");
   endStream(StreamCompletionSignal::ERROR);
   removeFromWriter();
 }
 
+void ConsumerBase::handleReassemblyError() {
+  terminateSubscriber(
+      folly::make_exception_wrapper<std::runtime_error>(kReassemblyError));
+  writeInvalidError(kReassemblyError);
+  endStream(StreamCompletionSignal::ERROR);
+  removeFromWriter();
+}
+
 } // namespace rsocket
@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <deque>
+
 #include "rsocket/Payload.h"
 #include "rsocket/internal/Allowance.h"
 #include "rsocket/statemachine/StreamStateMachineBase.h"
@@ -31,6 +33,15 @@ class ConsumerBase : public StreamStateMachineBase,
 
   void subscribe(std::shared_ptr<yarpl::flowable::Subscriber<Payload>>);
 
+  /// Subscribes in fragment-streaming mode: fragments are handed out as they
+  /// arrive instead of being reassembled into whole payloads.
+  ///
+  /// The subscriber's credits count chunks.  Payloads are requested from the
+  /// remote end while there are more chunk credits than payloads in flight, as
+  /// every payload yields at least one chunk.  Fragments arriving beyond the
+  /// credits are held back, up to the connection's maximum reassembly size.
+  void subscribe(std::shared_ptr<yarpl::flowable::Subscriber<PayloadChunk>>);
+
   /// Adds implicit allowance.
   ///
   /// This portion of allowance will not be synced to the remote end, but will
@@ -57,7 +68,12 @@ class ConsumerBase : public StreamStateMachineBase,
   void completeConsumer();
   void errorConsumer(folly::exception_wrapper);
 
+  /// Fails the stream after a fragmented payload grew beyond the maximum
+  /// reassembly size.
+  void handleReassemblyError();
+
  private:
+  class ChunkSubscription;
   enum class State : uint8_t {
     RESPONDING,
     CLOSED,
@@ -67,10 +83,38 @@ class ConsumerBase : public StreamStateMachineBase,
 
   void handleFlowControlError();
 
+  /// Delivers onComplete, or onError if the exception_wrapper is set, to the
+  /// attached subscriber and drops any chunks held back for it.
+  void terminateSubscriber(folly::exception_wrapper);
+
+  bool processChunk(Payload&&, bool next, bool complete, bool follows);
+  void requestChunks(int64_t);
+  void drainChunks();
+
   /// A Subscriber that will consume payloads.  This is responsible for
   /// delivering a terminal signal to the Subscriber once the stream ends.
   std::shared_ptr<yarpl::flowable::Subscriber<Payload>> consumingSubscriber_;
 
+  /// Set instead of consumingSubscriber_ in fragment-streaming mode.
+  std::shared_ptr<yarpl::flowable::Subscriber<PayloadChunk>> chunkSubscriber_;
+
+  /// Chunks that arrived while chunkSubscriber_ had no credits.
+  std::deque<PayloadChunk> pendingChunks_;
+  size_t pendingChunksSize_{0};
+  int64_t chunkCredits_{0};
+
+  /// Whether the consumer was subscribed in fragment-streaming mode.
+  bool streamingFragments_{false};
+
+  /// Whether the next chunk starts a new payload.
+  bool chunkStartsPayload_{true};
+
+  /// A fragment of the current payload carried the COMPLETE flag.
+  bool chunkFlagsComplete_{false};
+
+  /// The stream completed while chunks were still pending.
+  bool chunksCompleted_{false};
+
   /// A total, net allowance (requested less delivered) by this consumer.
   Allowance allowance_;
   /// An allowance that have yet to be synced to the other end by sending
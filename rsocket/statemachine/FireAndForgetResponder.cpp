@@ -23,7 +23,11 @@ void FireAndForgetResponder::handlePayload(
     bool /*flagsComplete*/,
     bool /*flagsNext*/,
     bool flagsFollows) {
-  payloadFragments_.addPayloadIgnoreFlags(std::move(payload));
+  if (!addFragment(std::move(payload), false, false)) {
+    // there is nobody to report the error to
+    removeFromWriter();
+    return;
+  }
 
   if (flagsFollows) {
     // there will be more fragments to come
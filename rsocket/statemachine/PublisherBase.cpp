@@ -29,7 +29,7 @@ void PublisherBase::publisherSubscribe(
   }
   DCHECK(!producingSubscription_);
   producingSubscription_ = std::move(subscription);
-  if (initialRequestN_) {
+  if (initialRequestN_ && !paused_) {
     producingSubscription_->request(initialRequestN_.consumeAll());
   }
 }
@@ -50,7 +50,7 @@ void PublisherBase::processRequestN(uint32_t requestN) {
 
   // We might not have the subscription set yet as there can be REQUEST_N frames
   // scheduled on the executor before onSubscribe method.
-  if (producingSubscription_) {
+  if (producingSubscription_ && !paused_) {
     producingSubscription_->request(requestN);
   } else {
     initialRequestN_.add(requestN);
@@ -64,4 +64,16 @@ void PublisherBase::terminatePublisher() {
   }
 }
 
+void PublisherBase::pausePublisher() {
+  paused_ = true;
+}
+
+void PublisherBase::resumePublisher() {
+  paused_ = false;
+  if (state_ == State::CLOSED || !producingSubscription_ || !initialRequestN_) {
+    return;
+  }
+  producingSubscription_->request(initialRequestN_.consumeAll());
+}
+
 } // namespace rsocket
@@ -32,6 +32,11 @@ class PublisherBase {
   bool publisherClosed() const;
   void terminatePublisher();
 
+  /// Stops handing out REQUEST_N credits to the producing subscription.  They
+  /// are accumulated until resumePublisher() is called.
+  void pausePublisher();
+  void resumePublisher();
+
  private:
   enum class State : uint8_t {
     RESPONDING,
@@ -39,8 +44,11 @@ class PublisherBase {
   };
 
   std::shared_ptr<yarpl::flowable::Subscription> producingSubscription_;
+  /// Credits that couldn't be handed to producingSubscription_ yet, because
+  /// it's not set or the publisher is paused.
   Allowance initialRequestN_;
   State state_{State::RESPONDING};
+  bool paused_{false};
 };
 
 } // namespace rsocket
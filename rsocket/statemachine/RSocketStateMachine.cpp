@@ -14,6 +14,7 @@
 
 #include "rsocket/statemachine/RSocketStateMachine.h"
 
+#include <folly/Conv.h>
 #include <folly/ExceptionWrapper.h>
 #include <folly/Format.h>
 #include <folly/Optional.h>
@@ -31,6 +32,7 @@
 #include "rsocket/framing/FrameTransportImpl.h"
 #include "rsocket/internal/ClientResumeStatusCallback.h"
 #include "rsocket/internal/ScheduledSubscriber.h"
+#include "rsocket/internal/Tracing.h"
 #include "rsocket/internal/WarmResumeManager.h"
 #include "rsocket/statemachine/ChannelRequester.h"
 #include "rsocket/statemachine/ChannelResponder.h"
@@ -48,8 +50,23 @@ namespace rsocket {
 
 namespace {
 
+/// Whether a connection closing with `signal` misbehaved, as opposed to it or
+/// its peer hanging up.
+bool isErrorSignal(StreamCompletionSignal signal) {
+  switch (signal) {
+    case StreamCompletionSignal::CANCEL:
+    case StreamCompletionSignal::COMPLETE:
+    case StreamCompletionSignal::CONNECTION_END:
+    case StreamCompletionSignal::SOCKET_CLOSED:
+      return false;
+    default:
+      return true;
+  }
+}
+
+template <typename T>
 void disconnectError(
-    std::shared_ptr<yarpl::flowable::Subscriber<Payload>> subscriber) {
+    std::shared_ptr<yarpl::flowable::Subscriber<T>> subscriber) {
   std::runtime_error exn{"RSocket connection is disconnected or closed"};
   subscriber->onSubscribe(yarpl::flowable::Subscription::create());
   subscriber->onError(std::move(exn));
@@ -93,9 +110,10 @@ RSocketStateMachine::RSocketStateMachine(
     std::shared_ptr<ColdResumeHandler> coldResumeHandler)
     : mode_{mode},
       stats_{stats ? stats : RSocketStats::noop()},
+      statsBatch_{stats_},
       // Streams initiated by a client MUST use odd-numbered and streams
       // initiated by the server MUST use even-numbered stream identifiers
-      nextStreamId_(mode == RSocketMode::CLIENT ? 1 : 2),
+      streamIdAllocator_(mode == RSocketMode::CLIENT ? 1 : 2),
       resumeManager_(std::move(resumeManager)),
       requestResponder_{std::move(requestResponder)},
       keepaliveTimer_{std::move(keepaliveTimer)},
@@ -187,6 +205,22 @@ void RSocketStateMachine::connectClient(
   setProtocolVersionOrThrow(version, transport);
   setResumable(params.resumable);
 
+  // The server rejects the SETUP if it doesn't accept the codec, so frames
+  // can be compressed before it answers.
+  if (!params.compression.empty()) {
+    setPayloadCompressor(PayloadCompressor::create(
+        params.compression, params.compressionOptions));
+    params.dataMimeType = PayloadCompressor::addToMimeType(
+        params.dataMimeType, params.compression);
+  }
+  // A cold resumed client would start over with an empty dictionary while
+  // the server kept its own, so resumable connections don't intern.
+  if (params.metadataDictionarySize > 0 && !params.resumable) {
+    setMetadataDictionarySize(params.metadataDictionarySize);
+    params.metadataMimeType = MetadataDictionary::addToMimeType(
+        params.metadataMimeType, params.metadataDictionarySize);
+  }
+
   Frame_SETUP frame(
       (params.resumable ? FrameFlags::RESUME_ENABLE : FrameFlags::EMPTY_) |
           (params.payload.metadata ? FrameFlags::METADATA : FrameFlags::EMPTY_),
@@ -247,6 +281,10 @@ void RSocketStateMachine::connect(std::shared_ptr<FrameTransport> transport) {
   CHECK(isDisconnected());
   CHECK(transport);
 
+  // Streams paused by the previous transport start over.  Whatever they
+  // publish right away is queued as we're still disconnected.
+  onWritabilityChanged(true);
+
   // Keep a reference to the argument, make sure the instance survives until
   // setFrameProcessor() returns.  There can be terminating signals processed in
   // that call which will nullify frameTransport_.
@@ -256,6 +294,14 @@ void RSocketStateMachine::connect(std::shared_ptr<FrameTransport> transport) {
   frameSerializer_->preallocateFrameSizeField() =
       transport->isConnectionFramed();
 
+  if (writeWatermarks_) {
+    frameTransport_->setWriteWatermarks(*writeWatermarks_);
+  }
+  if (maxFramesPerLoop_ > 0) {
+    frameTransport_->setMaxFramesPerLoop(maxFramesPerLoop_);
+  }
+
+  flightRecorder_.event(FlightRecorder::Event::CONNECTED);
   if (connectionEvents_) {
     connectionEvents_->onConnected();
   }
@@ -283,6 +329,8 @@ void RSocketStateMachine::disconnect(folly::exception_wrapper ex) {
     return;
   }
 
+  flightRecorder_.event(FlightRecorder::Event::DISCONNECTED);
+
   if (connectionEvents_) {
     connectionEvents_->onDisconnected(ex);
   }
@@ -293,6 +341,7 @@ void RSocketStateMachine::disconnect(folly::exception_wrapper ex) {
     connectionEvents_->onStreamsPaused();
   }
 
+  statsBatch_.flush();
   stats_->socketDisconnected();
 }
 
@@ -304,17 +353,29 @@ void RSocketStateMachine::close(
   }
 
   isClosed_ = true;
+  statsBatch_.flush();
   stats_->socketClosed(signal);
 
   VLOG(6) << "close";
 
+  flightRecorder_.event(FlightRecorder::Event::CLOSED);
+  if (flightRecorder_.options().dumpOnError && isErrorSignal(signal)) {
+    LOG(WARNING) << mode_ << " connection closed with " << signal
+                 << ", flight recorder: " << flightRecorder_.dump();
+  }
+
   if (auto resumeCallback = std::move(resumeCallback_)) {
     resumeCallback->onResumeError(
         ConnectionException(ex ? ex.get_exception()->what() : "RS closing"));
   }
 
   closeStreams(signal);
+  // Nothing queued up can be sent anymore.
+  consumePendingOutputFrames();
   closeFrameTransport(ex);
+  // The state machine may be destroyed on another thread, leave nothing
+  // scheduled on the EventBase.
+  statsBatch_.flush();
 
   if (auto connectionEvents = std::move(connectionEvents_)) {
     connectionEvents->onClosed(std::move(ex));
@@ -428,6 +489,22 @@ void RSocketStateMachine::requestStream(
   stateMachine->subscribe(std::move(responseSink));
 }
 
+void RSocketStateMachine::requestChunkedStream(
+    Payload request,
+    std::shared_ptr<yarpl::flowable::Subscriber<PayloadChunk>> responseSink) {
+  if (isDisconnected()) {
+    disconnectError(std::move(responseSink));
+    return;
+  }
+
+  auto const streamId = getNextStreamId();
+  auto stateMachine = std::make_shared<StreamRequester>(
+      shared_from_this(), streamId, std::move(request));
+  const auto result = streams_.emplace(streamId, stateMachine);
+  DCHECK(result.second);
+  stateMachine->subscribe(std::move(responseSink));
+}
+
 std::shared_ptr<yarpl::flowable::Subscriber<Payload>>
 RSocketStateMachine::requestChannel(
     Payload request,
@@ -449,6 +526,9 @@ RSocketStateMachine::requestChannel(
   }
   const auto result = streams_.emplace(streamId, stateMachine);
   DCHECK(result.second);
+  if (!writable_) {
+    stateMachine->onWritabilityChanged(false);
+  }
   stateMachine->subscribe(std::move(responseSink));
   return stateMachine;
 }
@@ -484,6 +564,8 @@ void RSocketStateMachine::processFrame(std::unique_ptr<folly::IOBuf> frame) {
     return;
   }
 
+  flightRecorder_.received(*frame);
+
   if (!ensureOrAutodetectFrameSerializer(*frame)) {
     constexpr auto msg = "Cannot detect protocol version";
     closeWithError(Frame_ERROR::connectionError(msg));
@@ -491,7 +573,7 @@ void RSocketStateMachine::processFrame(std::unique_ptr<folly::IOBuf> frame) {
   }
 
   const auto frameType = frameSerializer_->peekFrameType(*frame);
-  stats_->frameRead(frameType);
+  statsBatch_.frameRead(frameType);
 
   const auto optStreamId = frameSerializer_->peekStreamId(*frame, false);
   if (!optStreamId) {
@@ -500,6 +582,12 @@ void RSocketStateMachine::processFrame(std::unique_ptr<folly::IOBuf> frame) {
     return;
   }
 
+  // Resumable connections keep sending keepalives regardless, they
+  // acknowledge the resume position.
+  if (keepaliveTimer_ && !isResumable_) {
+    keepaliveTimer_->activity();
+  }
+
   const auto frameLength = frame->computeChainDataLength();
   const auto streamId = *optStreamId;
   handleFrame(streamId, frameType, std::move(frame));
@@ -517,6 +605,119 @@ void RSocketStateMachine::onTerminal(folly::exception_wrapper ex) {
   close(std::move(ex), termSignal);
 }
 
+void RSocketStateMachine::onWritabilityChanged(bool writable) {
+  if (transportWritable_ == writable) {
+    return;
+  }
+  VLOG(3) << "Transport became " << (writable ? "writable" : "unwritable");
+  transportWritable_ = writable;
+  updateWritability();
+}
+
+void RSocketStateMachine::onPendingOutputFull(bool full) {
+  VLOG(3) << "Pending output queue became " << (full ? "full" : "drained");
+  updateWritability();
+}
+
+std::unique_ptr<folly::IOBuf> RSocketStateMachine::onPendingOutputOverflow(
+    std::unique_ptr<folly::IOBuf> frame) {
+  stats_->pendingOutputOverflow();
+
+  auto overflow = pendingOutputLimits().overflow;
+  if (overflow == PendingOutputOverflow::SPILL_TO_RESUME_MANAGER &&
+      !isResumable_) {
+    overflow = PendingOutputOverflow::CLOSE_CONNECTION;
+  }
+
+  switch (overflow) {
+    case PendingOutputOverflow::DROP_STREAM: {
+      auto const streamId = frameSerializer_->peekStreamId(*frame, false);
+      CHECK(streamId) << "Error in serialized frame.";
+      if (*streamId == 0) {
+        break;
+      }
+      VLOG(3) << "Pending output queue overflow, dropping stream "
+              << *streamId;
+      auto const peerKnowsStream = !dropPendingOutputFrames(*streamId) &&
+          !isRequestFrame(frameSerializer_->peekFrameType(*frame));
+      auto it = streams_.find(*streamId);
+      if (it == streams_.end()) {
+        return nullptr;
+      }
+      auto stateMachine = std::move(it->second);
+      streams_.erase(it);
+      streamIdAllocator_.release(*streamId);
+      stateMachine->endStream(StreamCompletionSignal::ERROR);
+
+      // Only some stream state machines write a frame when they're ended, so
+      // replace whatever they wrote with a frame that ends the stream on the
+      // peer as well.  It's queued past the limits as we're handling the
+      // overflow.
+      dropPendingOutputFrames(*streamId);
+      if (peerKnowsStream) {
+        writeOverflowTermination(*streamId, *stateMachine);
+      }
+      return nullptr;
+    }
+    case PendingOutputOverflow::SPILL_TO_RESUME_MANAGER:
+      VLOG(3) << "Pending output queue overflow, spilling to ResumeManager";
+      spillPendingOutputFrames();
+      trackSentFrame(*frame, frameSerializer_->peekFrameType(*frame));
+      return nullptr;
+    case PendingOutputOverflow::CLOSE_CONNECTION:
+      break;
+  }
+
+  close(
+      std::runtime_error("Pending output queue overflow"),
+      StreamCompletionSignal::ERROR);
+  return nullptr;
+}
+
+void RSocketStateMachine::writeOverflowTermination(
+    StreamId streamId,
+    StreamStateMachineBase& stateMachine) {
+  constexpr auto msg = "Pending output queue overflow";
+  if (!streamIdAllocator_.owns(streamId)) {
+    writeError(Frame_ERROR::canceled(streamId, msg));
+  } else if (dynamic_cast<ChannelRequester*>(&stateMachine)) {
+    // A CANCEL would leave the peer's side of the channel open.
+    writeError(Frame_ERROR::applicationError(streamId, msg));
+  } else {
+    writeCancel(Frame_CANCEL{streamId});
+  }
+}
+
+void RSocketStateMachine::spillPendingOutputFrames() {
+  // The peer hasn't received any of these yet, so they are retransmitted from
+  // the ResumeManager ahead of whatever is queued later on.
+  auto frames = consumePendingOutputFrames();
+  for (auto& frame : frames) {
+    trackSentFrame(*frame, frameSerializer_->peekFrameType(*frame));
+  }
+}
+
+void RSocketStateMachine::updateWritability() {
+  auto const writable = transportWritable_ && !pendingOutputFull();
+  if (writable_ == writable) {
+    return;
+  }
+  writable_ = writable;
+  flightRecorder_.event(
+      writable ? FlightRecorder::Event::WRITABLE
+               : FlightRecorder::Event::UNWRITABLE);
+
+  // Resuming a publisher may deliver payloads inline, which can close streams.
+  std::vector<std::shared_ptr<StreamStateMachineBase>> streams;
+  streams.reserve(streams_.size());
+  for (const auto& it : streams_) {
+    streams.push_back(it.second);
+  }
+  for (const auto& stream : streams) {
+    stream->onWritabilityChanged(writable);
+  }
+}
+
 void RSocketStateMachine::onKeepAliveFrame(
     ResumePosition resumePosition,
     std::unique_ptr<folly::IOBuf> data,
@@ -541,6 +742,7 @@ void RSocketStateMachine::onKeepAliveFrame(
 
 void RSocketStateMachine::onMetadataPushFrame(
     std::unique_ptr<folly::IOBuf> metadata) {
+  RSOCKET_TRACE_SPAN("RSocketResponder::handleMetadataPush", 0);
   requestResponder_->handleMetadataPush(std::move(metadata));
 }
 
@@ -656,6 +858,7 @@ void RSocketStateMachine::handleFrame(
     StreamId streamId,
     FrameType frameType,
     std::unique_ptr<folly::IOBuf> payload) {
+  RSOCKET_TRACE_SPAN("RSocketStateMachine::handleFrame", streamId);
   switch (frameType) {
     case FrameType::KEEPALIVE: {
       Frame_KEEPALIVE frame;
@@ -872,6 +1075,9 @@ void RSocketStateMachine::onRequestStreamFrame(
       std::make_shared<StreamResponder>(shared_from_this(), streamId, requestN);
   const auto result = streams_.emplace(streamId, stateMachine);
   DCHECK(result.second); // ensured by calling isNewStreamId
+  if (!writable_) {
+    stateMachine->onWritabilityChanged(false);
+  }
   stateMachine->handlePayload(std::move(payload), false, false, flagsFollows);
 }
 
@@ -889,6 +1095,9 @@ void RSocketStateMachine::onRequestChannelFrame(
       shared_from_this(), streamId, requestN);
   const auto result = streams_.emplace(streamId, stateMachine);
   DCHECK(result.second); // ensured by calling isNewStreamId
+  if (!writable_) {
+    stateMachine->onWritabilityChanged(false);
+  }
   stateMachine->handlePayload(
       std::move(payload), flagsComplete, flagsNext, flagsFollows);
 }
@@ -935,6 +1144,7 @@ RSocketStateMachine::onNewStreamReady(
     StreamType streamType,
     Payload payload,
     std::shared_ptr<yarpl::flowable::Subscriber<Payload>> response) {
+  RSOCKET_TRACE_SPAN("RSocketResponder::handleRequest", streamId);
   if (coldResumeHandler_ && streamType != StreamType::FNF) {
     auto streamToken =
         coldResumeHandler_->generateStreamToken(payload, streamId, streamType);
@@ -973,6 +1183,7 @@ void RSocketStateMachine::onNewStreamReady(
     Payload payload,
     std::shared_ptr<yarpl::single::SingleObserver<Payload>> response) {
   CHECK(streamType == StreamType::REQUEST_RESPONSE);
+  RSOCKET_TRACE_SPAN("RSocketResponder::handleRequest", streamId);
 
   if (coldResumeHandler_) {
     auto streamToken =
@@ -1040,6 +1251,7 @@ void RSocketStateMachine::resumeFromPosition(ResumePosition position) {
   DCHECK(!isDisconnected());
   DCHECK(resumeManager_->isPositionAvailable(position));
 
+  flightRecorder_.event(FlightRecorder::Event::RESUMED);
   if (connectionEvents_) {
     connectionEvents_->onStreamsResumed();
   }
@@ -1049,6 +1261,7 @@ void RSocketStateMachine::resumeFromPosition(ResumePosition position) {
   for (auto& frame : frames) {
     outputFrameOrEnqueue(std::move(frame));
   }
+  onPendingOutputDrained();
 
   if (!isDisconnected() && keepaliveTimer_) {
     keepaliveTimer_->start(shared_from_this());
@@ -1075,18 +1288,25 @@ void RSocketStateMachine::metadataPush(std::unique_ptr<folly::IOBuf> metadata) {
 void RSocketStateMachine::outputFrame(std::unique_ptr<folly::IOBuf> frame) {
   DCHECK(!isDisconnected());
 
+  flightRecorder_.sent(*frame);
   const auto frameType = frameSerializer_->peekFrameType(*frame);
-  stats_->frameWritten(frameType);
+  statsBatch_.frameWritten(frameType);
 
   if (isResumable_) {
-    auto streamIdPtr = frameSerializer_->peekStreamId(*frame, false);
-    CHECK(streamIdPtr) << "Error in serialized frame.";
-    resumeManager_->trackSentFrame(
-        *frame, frameType, *streamIdPtr, getConsumerAllowance(*streamIdPtr));
+    trackSentFrame(*frame, frameType);
   }
   frameTransport_->outputFrameOrDrop(std::move(frame));
 }
 
+void RSocketStateMachine::trackSentFrame(
+    const folly::IOBuf& frame,
+    FrameType frameType) {
+  auto streamIdPtr = frameSerializer_->peekStreamId(frame, false);
+  CHECK(streamIdPtr) << "Error in serialized frame.";
+  resumeManager_->trackSentFrame(
+      frame, frameType, *streamIdPtr, getConsumerAllowance(*streamIdPtr));
+}
+
 uint32_t RSocketStateMachine::getKeepaliveTime() const {
   return keepaliveTimer_
       ? static_cast<uint32_t>(keepaliveTimer_->keepaliveTime().count())
@@ -1119,6 +1339,7 @@ void RSocketStateMachine::writeNewStream(
 
 void RSocketStateMachine::onStreamClosed(StreamId streamId) {
   streams_.erase(streamId);
+  streamIdAllocator_.release(streamId);
   resumeManager_->onStreamClosed(streamId);
 }
 
@@ -1145,6 +1366,9 @@ bool RSocketStateMachine::ensureOrAutodetectFrameSerializer(
   frameSerializer_ = std::move(serializer);
   frameSerializer_->preallocateFrameSizeField() =
       frameTransport_ && frameTransport_->isConnectionFramed();
+  frameSerializer_->setAllocator(bufferAllocator_);
+  frameSerializer_->setPayloadCompressor(payloadCompressor_);
+  frameSerializer_->setMetadataDictionary(metadataDictionary_);
 
   return true;
 }
@@ -1163,6 +1387,55 @@ DuplexConnection* RSocketStateMachine::getConnection() {
   return frameTransport_ ? frameTransport_->getConnection() : nullptr;
 }
 
+void RSocketStateMachine::setBufferAllocator(
+    std::shared_ptr<BufferAllocator> allocator) {
+  bufferAllocator_ = std::move(allocator);
+  if (frameSerializer_) {
+    frameSerializer_->setAllocator(bufferAllocator_);
+  }
+}
+
+void RSocketStateMachine::setPayloadCompressor(
+    std::shared_ptr<PayloadCompressor> compressor) {
+  payloadCompressor_ = std::move(compressor);
+  if (frameSerializer_) {
+    frameSerializer_->setPayloadCompressor(payloadCompressor_);
+  }
+}
+
+void RSocketStateMachine::setMetadataDictionarySize(size_t size) {
+  metadataDictionary_ = std::make_shared<MetadataDictionary>(size, stats_);
+  if (frameSerializer_) {
+    frameSerializer_->setMetadataDictionary(metadataDictionary_);
+  }
+}
+
+void RSocketStateMachine::setMaxReassemblySize(size_t size) {
+  maxReassemblySize_ = size;
+}
+
+void RSocketStateMachine::setWriteWatermarks(WriteWatermarks watermarks) {
+  writeWatermarks_ = watermarks;
+  if (frameTransport_) {
+    frameTransport_->setWriteWatermarks(watermarks);
+  }
+}
+
+void RSocketStateMachine::setMaxFramesPerLoop(size_t maxFrames) {
+  maxFramesPerLoop_ = maxFrames;
+}
+
+void RSocketStateMachine::setFlightRecorder(FlightRecorder::Options options) {
+  flightRecorder_ = FlightRecorder{options};
+}
+
+std::string RSocketStateMachine::dumpFlightRecorder() const {
+  return folly::to<std::string>(
+      mode_ == RSocketMode::SERVER ? "Server" : "Client",
+      " connection, ",
+      flightRecorder_.dump());
+}
+
 void RSocketStateMachine::setProtocolVersionOrThrow(
     ProtocolVersion version,
     const std::shared_ptr<FrameTransport>& transport) {
@@ -1188,41 +1461,43 @@ void RSocketStateMachine::setProtocolVersionOrThrow(
     frameSerializer_ = std::move(frameSerializer);
     frameSerializer_->preallocateFrameSizeField() =
         frameTransport_ && frameTransport_->isConnectionFramed();
+    frameSerializer_->setAllocator(bufferAllocator_);
+    frameSerializer_->setPayloadCompressor(payloadCompressor_);
+    frameSerializer_->setMetadataDictionary(metadataDictionary_);
   }
 
   transportGuard.dismiss();
 }
 
 StreamId RSocketStateMachine::getNextStreamId() {
-  constexpr auto limit =
-      static_cast<uint32_t>(std::numeric_limits<int32_t>::max() - 2);
-
-  auto const streamId = nextStreamId_;
-  if (streamId >= limit) {
+  auto const streamId = streamIdAllocator_.allocate(
+      [this](StreamId id) { return streams_.count(id) > 0; });
+  if (!streamId) {
     throw std::runtime_error{"Ran out of stream IDs"};
   }
-
-  CHECK_EQ(0, streams_.count(streamId))
-      << "Next stream ID already exists in the streams map";
-
-  nextStreamId_ += 2;
-  return streamId;
+  return *streamId;
 }
 
 void RSocketStateMachine::setNextStreamId(StreamId streamId) {
-  nextStreamId_ = streamId + 2;
+  streamIdAllocator_.skipPast(streamId);
 }
 
 bool RSocketStateMachine::registerNewPeerStreamId(StreamId streamId) {
   DCHECK_NE(0, streamId);
-  if (nextStreamId_ % 2 == streamId % 2) {
+  if (streamIdAllocator_.owns(streamId)) {
     // if this is an unknown stream to the socket and this socket is
     // generating such stream ids, it is an incoming frame on the stream which
     // no longer exist
     return false;
   }
-  if (streamId <= lastPeerStreamId_) {
-    // receiving frame for a stream which no longer exists
+  if (streamId <= lastPeerStreamId_ &&
+      lastPeerStreamId_ - streamId < StreamIdAllocator::kLimit / 2) {
+    // receiving frame for a stream which no longer exists.  A much lower ID
+    // means the peer ran out of them and started over.
+    return false;
+  }
+  if (streams_.count(streamId)) {
+    // the peer reused the ID of a stream that is still open
     return false;
   }
   lastPeerStreamId_ = streamId;
@@ -17,6 +17,8 @@
 #include <deque>
 #include <memory>
 
+#include <folly/Optional.h>
+
 #include "rsocket/ColdResumeHandler.h"
 #include "rsocket/DuplexConnection.h"
 #include "rsocket/Payload.h"
@@ -25,7 +27,10 @@
 #include "rsocket/framing/FrameProcessor.h"
 #include "rsocket/framing/FrameSerializer.h"
 #include "rsocket/internal/Common.h"
+#include "rsocket/internal/FlightRecorder.h"
 #include "rsocket/internal/KeepaliveTimer.h"
+#include "rsocket/internal/StatsBatch.h"
+#include "rsocket/internal/StreamIdAllocator.h"
 #include "rsocket/statemachine/StreamFragmentAccumulator.h"
 #include "rsocket/statemachine/StreamStateMachineBase.h"
 #include "rsocket/statemachine/StreamsWriter.h"
@@ -134,6 +139,12 @@ class RSocketStateMachine final
       Payload request,
       std::shared_ptr<yarpl::flowable::Subscriber<Payload>> responseSink);
 
+  /// Like requestStream(), but delivers fragments of the response payloads as
+  /// they arrive, see ConsumerBase::subscribe().
+  void requestChunkedStream(
+      Payload request,
+      std::shared_ptr<yarpl::flowable::Subscriber<PayloadChunk>> responseSink);
+
   std::shared_ptr<yarpl::flowable::Subscriber<Payload>> requestChannel(
       Payload request,
       bool hasInitialRequest,
@@ -165,6 +176,41 @@ class RSocketStateMachine final
 
   DuplexConnection* getConnection();
 
+  /// Allocator used for the buffers of outgoing frames.  Must be called on the
+  /// state machine's EventBase.
+  void setBufferAllocator(std::shared_ptr<BufferAllocator>);
+
+  /// Compressor for the data of the connection's request and payload frames,
+  /// once compression was negotiated at SETUP.  Must be called on the state
+  /// machine's EventBase.
+  void setPayloadCompressor(std::shared_ptr<PayloadCompressor>);
+
+  /// Intern the metadata of the connection's request and payload frames under
+  /// this many IDs per direction, once interning was negotiated at SETUP.
+  /// Must be called on the state machine's EventBase.
+  void setMetadataDictionarySize(size_t);
+
+  /// Limit on the size of payloads reassembled from fragments.  Streams
+  /// receiving a larger payload fail with an INVALID error.
+  void setMaxReassemblySize(size_t);
+
+  /// Pause the publishing streams while more than the high watermark worth of
+  /// bytes is buffered in the transport, until it drains to the low one.
+  void setWriteWatermarks(WriteWatermarks);
+
+  /// Process at most this many inbound frames per event loop iteration, so a
+  /// flooding peer can't starve the other connections on the EventBase.
+  /// Zero means no limit.  Applies to transports connected after the call.
+  void setMaxFramesPerLoop(size_t);
+
+  /// Replace the flight recorder of the connection, which starts over empty.
+  /// Must be called on the state machine's EventBase.
+  void setFlightRecorder(FlightRecorder::Options);
+
+  /// The frames and state transitions the flight recorder holds.  Must be
+  /// called on the state machine's EventBase.
+  std::string dumpFlightRecorder() const;
+
   // Has active requests?
   bool hasStreams() const;
 
@@ -239,14 +285,18 @@ class RSocketStateMachine final
   // Should buffer the frame if the state machine is disconnected or in the
   // process of resuming.
   bool shouldQueue() override;
-  RSocketStats& stats() override {
-    return *stats_;
+  StatsBatch& stats() override {
+    return statsBatch_;
   }
 
   FrameSerializer& serializer() override {
     return *frameSerializer_;
   }
 
+  size_t maxReassemblySize() const override {
+    return maxReassemblySize_;
+  }
+
   template <typename TFrame>
   bool deserializeFrameOrError(
       TFrame& frame,
@@ -261,6 +311,18 @@ class RSocketStateMachine final
   // FrameProcessor.
   void processFrame(std::unique_ptr<folly::IOBuf>) override;
   void onTerminal(folly::exception_wrapper) override;
+  void onWritabilityChanged(bool) override;
+
+  void onPendingOutputFull(bool) override;
+  std::unique_ptr<folly::IOBuf> onPendingOutputOverflow(
+      std::unique_ptr<folly::IOBuf>) override;
+  /// Lets the peer know a stream was dropped on overflow.
+  void writeOverflowTermination(StreamId, StreamStateMachineBase&);
+  void spillPendingOutputFrames();
+
+  /// Pauses or resumes the streams when either the transport or the pending
+  /// output queue changed whether it keeps up.
+  void updateWritability();
 
   void handleFrame(StreamId, FrameType, std::unique_ptr<folly::IOBuf>);
 
@@ -271,6 +333,7 @@ class RSocketStateMachine final
 
   void resumeFromPosition(ResumePosition);
   void outputFrame(std::unique_ptr<folly::IOBuf>) override;
+  void trackSentFrame(const folly::IOBuf&, FrameType);
 
   void writeNewStream(
       StreamId streamId,
@@ -320,11 +383,13 @@ class RSocketStateMachine final
   bool coldResumeInProgress_{false};
 
   std::shared_ptr<RSocketStats> stats_;
+  /// The per-frame counts, delivered to stats_ once per EventBase loop.
+  StatsBatch statsBatch_;
 
   /// Map of all individual stream state machines.
   std::unordered_map<StreamId, std::shared_ptr<StreamStateMachineBase>>
       streams_;
-  StreamId nextStreamId_;
+  StreamIdAllocator streamIdAllocator_;
   StreamId lastPeerStreamId_{0};
 
   // Manages all state needed for warm/cold resumption.
@@ -333,6 +398,19 @@ class RSocketStateMachine final
   const std::shared_ptr<RSocketResponderCore> requestResponder_;
   std::shared_ptr<FrameTransport> frameTransport_;
   std::unique_ptr<FrameSerializer> frameSerializer_;
+  std::shared_ptr<BufferAllocator> bufferAllocator_;
+  std::shared_ptr<PayloadCompressor> payloadCompressor_;
+  std::shared_ptr<MetadataDictionary> metadataDictionary_;
+  size_t maxReassemblySize_{std::numeric_limits<size_t>::max()};
+  folly::Optional<WriteWatermarks> writeWatermarks_;
+  size_t maxFramesPerLoop_{0};
+  /// Whether the transport keeps up with the frames written to it.
+  bool transportWritable_{true};
+  /// Whether the streams may publish, i.e. neither the transport nor the
+  /// pending output queue is full.
+  bool writable_{true};
+
+  FlightRecorder flightRecorder_;
 
   const std::unique_ptr<KeepaliveTimer> keepaliveTimer_;
 
@@ -103,7 +103,15 @@ void RequestResponseRequester::handlePayload(
   // if we fail here, we broke some internal invariant of the class
   CHECK(state_ == State::REQUESTED);
 
-  payloadFragments_.addPayload(std::move(payload), flagsNext, false);
+  if (!addFragment(std::move(payload), flagsNext, false)) {
+    constexpr auto msg = "Response exceeds the maximum reassembly size";
+    state_ = State::CLOSED;
+    consumingSubscriber_->onError(std::runtime_error(msg));
+    consumingSubscriber_ = nullptr;
+    writeInvalidError(msg);
+    removeFromWriter();
+    return;
+  }
 
   if (flagsFollows) {
     // there will be more fragments to come
@@ -90,7 +90,12 @@ void RequestResponseResponder::handlePayload(
     bool /*flagsComplete*/,
     bool /*flagsNext*/,
     bool flagsFollows) {
-  payloadFragments_.addPayloadIgnoreFlags(std::move(payload));
+  if (!addFragment(std::move(payload), false, false)) {
+    state_ = State::CLOSED;
+    writeInvalidError("Request exceeds the maximum reassembly size");
+    removeFromWriter();
+    return;
+  }
 
   if (flagsFollows) {
     // there will be more fragments to come
@@ -21,6 +21,7 @@ StreamFragmentAccumulator::StreamFragmentAccumulator()
 
 void StreamFragmentAccumulator::addPayloadIgnoreFlags(Payload p) {
   if (p.metadata) {
+    size_ += p.metadata->computeChainDataLength();
     if (!fragments.metadata) {
       fragments.metadata = std::move(p.metadata);
     } else {
@@ -29,6 +30,7 @@ void StreamFragmentAccumulator::addPayloadIgnoreFlags(Payload p) {
   }
 
   if (p.data) {
+    size_ += p.data->computeChainDataLength();
     if (!fragments.data) {
       fragments.data = std::move(p.data);
     } else {
@@ -49,6 +51,7 @@ void StreamFragmentAccumulator::addPayload(
 Payload StreamFragmentAccumulator::consumePayloadIgnoreFlags() {
   flagsComplete = false;
   flagsNext = false;
+  size_ = 0;
   return std::move(fragments);
 }
 
@@ -58,6 +61,7 @@ StreamFragmentAccumulator::consumePayloadAndFlags() {
       std::move(fragments), bool(flagsNext), bool(flagsComplete));
   flagsComplete = false;
   flagsNext = false;
+  size_ = 0;
   return ret;
 }
 
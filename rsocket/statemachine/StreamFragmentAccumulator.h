@@ -32,10 +32,16 @@ class StreamFragmentAccumulator {
     return fragments.data || fragments.metadata;
   }
 
+  /// Number of bytes accumulated so far.
+  size_t size() const {
+    return size_;
+  }
+
  private:
   bool flagsComplete : 1;
   bool flagsNext : 1;
   Payload fragments;
+  size_t size_{0};
 };
 
 } /* namespace rsocket */
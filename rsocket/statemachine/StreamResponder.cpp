@@ -63,7 +63,12 @@ void StreamResponder::handlePayload(
     bool /*flagsComplete*/,
     bool /*flagsNext*/,
     bool flagsFollows) {
-  payloadFragments_.addPayloadIgnoreFlags(std::move(payload));
+  if (!addFragment(std::move(payload), false, false)) {
+    terminatePublisher();
+    writeInvalidError("Request exceeds the maximum reassembly size");
+    removeFromWriter();
+    return;
+  }
 
   if (flagsFollows) {
     // there will be more fragments to come
@@ -99,4 +104,12 @@ void StreamResponder::endStream(StreamCompletionSignal signal) {
   removeFromWriter();
 }
 
+void StreamResponder::onWritabilityChanged(bool writable) {
+  if (writable) {
+    resumePublisher();
+  } else {
+    pausePublisher();
+  }
+}
+
 } // namespace rsocket
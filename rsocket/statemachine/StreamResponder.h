@@ -47,6 +47,8 @@ class StreamResponder : public StreamStateMachineBase,
   void handleError(folly::exception_wrapper) override;
   void handleCancel() override;
 
+  void onWritabilityChanged(bool) override;
+
   void endStream(StreamCompletionSignal) override;
 
  private:
@@ -76,6 +76,24 @@ void StreamStateMachineBase::writeInvalidError(folly::StringPiece msg) {
   writer_->writeError(Frame_ERROR::invalid(streamId_, msg));
 }
 
+bool StreamStateMachineBase::addFragment(
+    Payload&& payload,
+    bool next,
+    bool complete) {
+  payloadFragments_.addPayload(std::move(payload), next, complete);
+  if (payloadFragments_.size() <= maxReassemblySize()) {
+    return true;
+  }
+  VLOG(3) << "Fragmented payload on stream " << streamId_ << " exceeds "
+          << maxReassemblySize() << " bytes";
+  payloadFragments_.consumePayloadIgnoreFlags();
+  return false;
+}
+
+size_t StreamStateMachineBase::maxReassemblySize() const {
+  return writer_->maxReassemblySize();
+}
+
 void StreamStateMachineBase::removeFromWriter() {
   writer_->onStreamClosed(streamId_);
   // TODO: set writer_ to nullptr
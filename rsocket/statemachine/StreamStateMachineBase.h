@@ -54,6 +54,11 @@ class StreamStateMachineBase {
 
   virtual size_t getConsumerAllowance() const;
 
+  /// Indicates that the connection stopped, or resumed, keeping up with the
+  /// frames written to it.  Publishers stop pulling from their Flowables in
+  /// the meantime.
+  virtual void onWritabilityChanged(bool /* writable */) {}
+
   /// Indicates a terminal signal from the connection.
   ///
   /// This signal corresponds to Subscriber::{onComplete,onError} and
@@ -82,6 +87,13 @@ class StreamStateMachineBase {
 
   void removeFromWriter();
 
+  /// Adds a fragment to payloadFragments_.  Returns false, after dropping the
+  /// fragments, if the reassembled payload would exceed the connection's
+  /// maximum reassembly size.  The caller is then expected to fail the stream.
+  bool addFragment(Payload&& payload, bool next, bool complete);
+
+  size_t maxReassemblySize() const;
+
   std::shared_ptr<yarpl::flowable::Subscriber<Payload>> onNewStreamReady(
       StreamType streamType,
       Payload payload,
@@ -14,8 +14,11 @@
 
 #include "rsocket/statemachine/StreamsWriter.h"
 
-#include "rsocket/RSocketStats.h"
+#include <folly/ScopeGuard.h>
+
 #include "rsocket/framing/FrameSerializer.h"
+#include "rsocket/internal/StatsBatch.h"
+#include "rsocket/internal/Tracing.h"
 
 namespace rsocket {
 
@@ -35,14 +38,73 @@ void StreamsWriterImpl::sendPendingFrames() {
   for (auto& frame : frames) {
     outputFrameOrEnqueue(std::move(frame));
   }
+  onPendingOutputDrained();
+}
+
+void StreamsWriterImpl::setPendingOutputLimits(PendingOutputLimits limits) {
+  pendingOutputLimits_ = limits;
 }
 
 void StreamsWriterImpl::enqueuePendingOutputFrame(
     std::unique_ptr<folly::IOBuf> frame) {
-  auto const length = frame->computeChainDataLength();
+  auto length = frame->computeChainDataLength();
+  if (!handlingPendingOutputOverflow_ &&
+      (pendingOutputFrames_.size() >= pendingOutputLimits_.maxFrames ||
+       pendingSize_ + length > pendingOutputLimits_.maxBytes)) {
+    handlingPendingOutputOverflow_ = true;
+    SCOPE_EXIT {
+      handlingPendingOutputOverflow_ = false;
+    };
+    frame = onPendingOutputOverflow(std::move(frame));
+    if (!frame) {
+      return;
+    }
+    length = frame->computeChainDataLength();
+  }
+
   stats().streamBufferChanged(1, static_cast<int64_t>(length));
   pendingSize_ += length;
   pendingOutputFrames_.push_back(std::move(frame));
+
+  if (!pendingOutputFull_ && pendingOutputAtPauseThreshold()) {
+    pendingOutputFull_ = true;
+    onPendingOutputFull(true);
+  }
+}
+
+bool StreamsWriterImpl::dropPendingOutputFrames(StreamId streamId) {
+  int64_t numFrames = 0;
+  int64_t numBytes = 0;
+  bool droppedRequest = false;
+  auto it = pendingOutputFrames_.begin();
+  while (it != pendingOutputFrames_.end()) {
+    auto const frameStreamId = serializer().peekStreamId(**it, false);
+    if (!frameStreamId || *frameStreamId != streamId) {
+      ++it;
+      continue;
+    }
+    ++numFrames;
+    numBytes += (*it)->computeChainDataLength();
+    droppedRequest |= isRequestFrame(serializer().peekFrameType(**it));
+    it = pendingOutputFrames_.erase(it);
+  }
+  if (numFrames > 0) {
+    stats().streamBufferChanged(-numFrames, -numBytes);
+    pendingSize_ -= numBytes;
+  }
+  return droppedRequest;
+}
+
+void StreamsWriterImpl::onPendingOutputDrained() {
+  if (pendingOutputFull_ && !pendingOutputAtPauseThreshold()) {
+    pendingOutputFull_ = false;
+    onPendingOutputFull(false);
+  }
+}
+
+bool StreamsWriterImpl::pendingOutputAtPauseThreshold() const {
+  return pendingOutputFrames_.size() >= pendingOutputLimits_.maxFrames / 2 ||
+      pendingSize_ >= pendingOutputLimits_.maxBytes / 2;
 }
 
 std::deque<std::unique_ptr<folly::IOBuf>>
@@ -60,6 +122,7 @@ void StreamsWriterImpl::writeNewStream(
     StreamType streamType,
     uint32_t initialRequestN,
     Payload payload) {
+  RSOCKET_TRACE_SPAN("StreamsWriter::writeNewStream", streamId);
   // for simplicity, require that sent buffers don't consist of chains
   writeFragmented(
       [&](Payload p, FrameFlags flags) {
@@ -91,10 +154,12 @@ void StreamsWriterImpl::writeNewStream(
 }
 
 void StreamsWriterImpl::writeRequestN(Frame_REQUEST_N&& frame) {
+  RSOCKET_TRACE_SPAN("StreamsWriter::writeRequestN", frame.header_.streamId);
   outputFrameOrEnqueue(serializer().serializeOut(std::move(frame)));
 }
 
 void StreamsWriterImpl::writeCancel(Frame_CANCEL&& frame) {
+  RSOCKET_TRACE_SPAN("StreamsWriter::writeCancel", frame.header_.streamId);
   outputFrameOrEnqueue(serializer().serializeOut(std::move(frame)));
 }
 
@@ -102,6 +167,7 @@ void StreamsWriterImpl::writePayload(Frame_PAYLOAD&& f) {
   Frame_PAYLOAD frame = std::move(f);
   auto const streamId = frame.header_.streamId;
   auto const initialFlags = frame.header_.flags;
+  RSOCKET_TRACE_SPAN("StreamsWriter::writePayload", streamId);
 
   writeFragmented(
       [this, streamId](Payload p, FrameFlags flags) {
@@ -114,6 +180,7 @@ void StreamsWriterImpl::writePayload(Frame_PAYLOAD&& f) {
 }
 
 void StreamsWriterImpl::writeError(Frame_ERROR&& frame) {
+  RSOCKET_TRACE_SPAN("StreamsWriter::writeError", frame.header_.streamId);
   // TODO: implement fragmentation for writeError as well
   outputFrameOrEnqueue(serializer().serializeOut(std::move(frame)));
 }
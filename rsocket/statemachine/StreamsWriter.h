@@ -15,6 +15,7 @@
 #pragma once
 
 #include <deque>
+#include <limits>
 
 #include <yarpl/Flowable.h>
 #include <yarpl/Single.h>
@@ -25,8 +26,31 @@
 
 namespace rsocket {
 
-class RSocketStats;
 class FrameSerializer;
+class StatsBatch;
+
+/// What happens to a frame that doesn't fit into the pending output queue.
+enum class PendingOutputOverflow : uint8_t {
+  /// Close the connection, failing all of its streams.
+  CLOSE_CONNECTION,
+  /// Fail the stream the frame belongs to and drop its queued frames.  Falls
+  /// back to closing the connection for frames of stream 0.
+  DROP_STREAM,
+  /// Hand the queued frames over to the ResumeManager, which retransmits them
+  /// when the connection resumes.  Falls back to closing the connection if it
+  /// isn't resumable.
+  SPILL_TO_RESUME_MANAGER,
+};
+
+/// Limits on the frames queued up while the connection can't send them,
+/// e.g. while a resumable connection is disconnected.  Producers are paused
+/// once the queue holds half of either limit, the other half is left for the
+/// frames they already had credits for.
+struct PendingOutputLimits {
+  size_t maxFrames{std::numeric_limits<size_t>::max()};
+  size_t maxBytes{std::numeric_limits<size_t>::max()};
+  PendingOutputOverflow overflow{PendingOutputOverflow::CLOSE_CONNECTION};
+};
 
 /// The interface for writing stream related frames on the wire.
 class StreamsWriter {
@@ -47,6 +71,12 @@ class StreamsWriter {
 
   virtual void onStreamClosed(StreamId) = 0;
 
+  /// Upper bound on the size of a payload reassembled from fragments, and on
+  /// the fragments a stream in fragment-streaming mode may hold back.
+  virtual size_t maxReassemblySize() const {
+    return std::numeric_limits<size_t>::max();
+  }
+
   virtual std::shared_ptr<yarpl::flowable::Subscriber<Payload>>
   onNewStreamReady(
       StreamId streamId,
@@ -76,11 +106,13 @@ class StreamsWriterImpl : public StreamsWriter {
   // TODO: writeFragmentedError
   void writeError(Frame_ERROR&&) override;
 
+  void setPendingOutputLimits(PendingOutputLimits);
+
  protected:
   // note: onStreamClosed() method is also still pure
   virtual void outputFrame(std::unique_ptr<folly::IOBuf>) = 0;
   virtual FrameSerializer& serializer() = 0;
-  virtual RSocketStats& stats() = 0;
+  virtual StatsBatch& stats() = 0;
   virtual bool shouldQueue() = 0;
 
   template <typename WriteInitialFrame>
@@ -96,12 +128,48 @@ class StreamsWriterImpl : public StreamsWriter {
   void enqueuePendingOutputFrame(std::unique_ptr<folly::IOBuf> frame);
   std::deque<std::unique_ptr<folly::IOBuf>> consumePendingOutputFrames();
 
+  /// Drops the queued frames of the stream.  Returns whether the request that
+  /// opened the stream was among them, the peer doesn't know the stream then.
+  bool dropPendingOutputFrames(StreamId);
+
+  /// Resumes the producers if the pending output queue drained below the
+  /// point they were paused at.  Called once the frames consumed from the
+  /// queue have been written, so the producers don't overtake them.
+  void onPendingOutputDrained();
+
+  const PendingOutputLimits& pendingOutputLimits() const {
+    return pendingOutputLimits_;
+  }
+  bool pendingOutputFull() const {
+    return pendingOutputFull_;
+  }
+
+  /// Indicates that the pending output queue filled up, or drained again.
+  /// Producers are expected to pause in the meantime.
+  virtual void onPendingOutputFull(bool /* full */) {}
+
+  /// Called with a frame that doesn't fit into the pending output queue.  The
+  /// returned frame, if any, is queued regardless of the limits.
+  virtual std::unique_ptr<folly::IOBuf> onPendingOutputOverflow(
+      std::unique_ptr<folly::IOBuf> frame) {
+    return frame;
+  }
+
  private:
+  bool pendingOutputAtPauseThreshold() const;
+
   /// A queue of frames that are slated to be sent out.
   std::deque<std::unique_ptr<folly::IOBuf>> pendingOutputFrames_;
 
   /// The byte size of all pending output frames.
   size_t pendingSize_{0};
+
+  PendingOutputLimits pendingOutputLimits_;
+  /// Whether the producers are paused because of the pending output queue.
+  bool pendingOutputFull_{false};
+  /// Set while onPendingOutputOverflow() runs.  Frames written in the
+  /// meantime, e.g. errors of the dropped streams, bypass the limits.
+  bool handlingPendingOutputOverflow_{false};
 };
 
 } // namespace rsocket
@@ -0,0 +1,160 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/io/IOBuf.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "rsocket/BufferAllocator.h"
+#include "rsocket/Payload.h"
+#include "rsocket/framing/Frame.h"
+#include "rsocket/framing/FrameSerializer.h"
+
+using namespace ::rsocket;
+
+namespace {
+
+class CountingBufferAllocator : public BufferAllocator {
+ public:
+  std::unique_ptr<folly::IOBuf> allocate(size_t size) override {
+    ++allocations;
+    requested += size;
+    return BufferAllocator::heap()->allocate(size);
+  }
+
+  size_t allocations{0};
+  size_t requested{0};
+};
+
+} // namespace
+
+TEST(BufferAllocatorTest, SlabCarvesSmallBuffers) {
+  SlabBufferAllocator allocator{4096, 256};
+
+  std::vector<std::unique_ptr<folly::IOBuf>> bufs;
+  for (size_t i = 0; i < 10; ++i) {
+    auto buf = allocator.allocate(32);
+    ASSERT_FALSE(buf->isShared());
+    ASSERT_GE(buf->tailroom(), 32u);
+    ASSERT_EQ(buf->length(), 0u);
+    std::memset(buf->writableTail(), static_cast<int>('a' + i), 32);
+    buf->append(32);
+    bufs.push_back(std::move(buf));
+  }
+
+  EXPECT_EQ(allocator.slabAllocations(), 10u);
+  EXPECT_EQ(allocator.heapAllocations(), 0u);
+  EXPECT_EQ(allocator.slabs(), 1u);
+
+  // neighbouring buffers don't overlap
+  for (size_t i = 0; i < bufs.size(); ++i) {
+    EXPECT_EQ(
+        bufs[i]->moveToFbString().toStdString(),
+        std::string(32, static_cast<char>('a' + i)));
+  }
+}
+
+TEST(BufferAllocatorTest, SlabRollsOver) {
+  SlabBufferAllocator allocator{1024, 256};
+
+  std::vector<std::unique_ptr<folly::IOBuf>> bufs;
+  for (size_t i = 0; i < 10; ++i) {
+    bufs.push_back(allocator.allocate(256));
+  }
+
+  EXPECT_EQ(allocator.slabAllocations(), 10u);
+  EXPECT_EQ(allocator.slabs(), 3u);
+}
+
+TEST(BufferAllocatorTest, LargeBuffersFallBackToHeap) {
+  SlabBufferAllocator allocator{1024, 256};
+
+  auto buf = allocator.allocate(257);
+  EXPECT_GE(buf->tailroom(), 257u);
+  EXPECT_EQ(allocator.slabAllocations(), 0u);
+  EXPECT_EQ(allocator.heapAllocations(), 1u);
+  EXPECT_EQ(allocator.slabs(), 0u);
+}
+
+TEST(BufferAllocatorTest, BuffersOutliveAllocator) {
+  std::unique_ptr<folly::IOBuf> buf;
+  {
+    SlabBufferAllocator allocator;
+    buf = allocator.allocate(5);
+  }
+  std::memcpy(buf->writableTail(), "hello", 5);
+  buf->append(5);
+  EXPECT_EQ(buf->moveToFbString(), "hello");
+}
+
+TEST(BufferAllocatorTest, Payload) {
+  CountingBufferAllocator allocator;
+
+  Payload p("data", "metadata", allocator);
+  EXPECT_EQ(allocator.allocations, 2u);
+  EXPECT_EQ(p.cloneDataToString(), "data");
+  EXPECT_EQ(p.cloneMetadataToString(), "metadata");
+
+  // empty metadata is not allocated
+  Payload nometa("data", "", allocator);
+  EXPECT_EQ(allocator.allocations, 3u);
+  EXPECT_EQ(nometa.metadata, nullptr);
+}
+
+TEST(BufferAllocatorTest, FrameSerializer) {
+  auto allocator = std::make_shared<CountingBufferAllocator>();
+  auto serializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  serializer->setAllocator(allocator);
+
+  auto buf = serializer->serializeOut(Frame_REQUEST_N(42, 24));
+  EXPECT_EQ(allocator->allocations, 1u);
+  EXPECT_EQ(allocator->requested, buf->computeChainDataLength());
+
+  Frame_REQUEST_N frame;
+  ASSERT_TRUE(serializer->deserializeFrom(frame, std::move(buf)));
+  EXPECT_EQ(frame.header_.streamId, 42u);
+  EXPECT_EQ(frame.requestN_, 24u);
+
+  // headroom for the frame length is part of the same allocation
+  serializer->preallocateFrameSizeField() = true;
+  buf = serializer->serializeOut(
+      Frame_PAYLOAD(42, FrameFlags::NEXT, Payload("hello")));
+  EXPECT_EQ(allocator->allocations, 2u);
+  EXPECT_EQ(buf->headroom(), serializer->frameLengthFieldSize());
+}
+
+TEST(BufferAllocatorTest, FrameSerializerSlab) {
+  auto allocator = std::make_shared<SlabBufferAllocator>();
+  auto serializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  serializer->setAllocator(allocator);
+
+  std::vector<std::unique_ptr<folly::IOBuf>> bufs;
+  for (uint32_t i = 1; i <= 100; ++i) {
+    bufs.push_back(serializer->serializeOut(Frame_REQUEST_N(i, i)));
+  }
+  EXPECT_EQ(allocator->slabAllocations(), 100u);
+  EXPECT_EQ(allocator->slabs(), 1u);
+
+  for (uint32_t i = 1; i <= 100; ++i) {
+    Frame_REQUEST_N frame;
+    ASSERT_TRUE(serializer->deserializeFrom(frame, std::move(bufs[i - 1])));
+    EXPECT_EQ(frame.header_.streamId, i);
+    EXPECT_EQ(frame.requestN_, i);
+  }
+}
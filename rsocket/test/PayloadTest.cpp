@@ -12,17 +12,42 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <folly/File.h>
+#include <folly/FileUtil.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
+#include <folly/io/IOBufQueue.h>
 
 #include <gtest/gtest.h>
 
 #include "rsocket/Payload.h"
 #include "rsocket/framing/Frame.h"
 #include "rsocket/framing/FrameSerializer_v1_0.h"
+#include "rsocket/internal/FileRange.h"
 
 using namespace ::rsocket;
 
+namespace {
+
+/// A few pages of text, so that ranges don't start on page boundaries.
+std::string fileContents() {
+  std::string contents;
+  for (size_t i = 0; i < 3 * 4096 + 100; ++i) {
+    contents.push_back('a' + i % 26);
+  }
+  return contents;
+}
+
+folly::File fileWith(const std::string& contents) {
+  auto file = folly::File::temporary();
+  auto const written =
+      folly::writeFull(file.fd(), contents.data(), contents.size());
+  CHECK_EQ(static_cast<size_t>(written), contents.size());
+  return file;
+}
+
+} // namespace
+
 TEST(PayloadTest, EmptyMetadata) {
   Payload p("some error message");
   EXPECT_NE(p.data, nullptr);
@@ -80,3 +105,83 @@ TEST(PayloadTest, Clone) {
   EXPECT_EQ(clone.data, nullptr);
   EXPECT_EQ(clone.metadata, nullptr);
 }
+
+TEST(PayloadTest, WithFrameHeadroom) {
+  auto p = Payload::withFrameHeadroom("data");
+  ASSERT_NE(p.data, nullptr);
+  EXPECT_EQ(p.metadata, nullptr);
+  EXPECT_GE(p.data->headroom(), Payload::kFrameHeadroom);
+  EXPECT_EQ(p.cloneDataToString(), "data");
+
+  // headroom goes in front of the metadata, as it is serialized first
+  auto pm = Payload::withFrameHeadroom("data", "metadata");
+  ASSERT_NE(pm.metadata, nullptr);
+  EXPECT_GE(pm.metadata->headroom(), Payload::kFrameHeadroom);
+  EXPECT_EQ(pm.data->headroom(), 0u);
+  EXPECT_EQ(pm.cloneDataToString(), "data");
+  EXPECT_EQ(pm.cloneMetadataToString(), "metadata");
+}
+
+TEST(PayloadTest, FromFile) {
+  auto const contents = fileContents();
+  auto file = fileWith(contents);
+
+  auto p = Payload::fromFile(file, 5000, 6000, folly::IOBuf::copyBuffer("m"));
+  ASSERT_NE(p.data, nullptr);
+  EXPECT_TRUE(p.data->isSharedOne());
+  EXPECT_EQ(p.data->headroom(), 0u);
+  EXPECT_EQ(p.cloneMetadataToString(), "m");
+
+  auto const range = findFileRange(*p.data);
+  ASSERT_TRUE(range);
+  EXPECT_EQ(range->offset, 5000);
+
+  // The payload keeps the file open on its own.
+  file.close();
+  EXPECT_EQ(p.cloneDataToString(), contents.substr(5000, 6000));
+
+  EXPECT_FALSE(findFileRange(*folly::IOBuf::copyBuffer("not a file")));
+}
+
+TEST(PayloadTest, FromFileOutOfRange) {
+  auto const contents = fileContents();
+  auto file = fileWith(contents);
+
+  EXPECT_THROW(
+      Payload::fromFile(file, 10, contents.size()), std::out_of_range);
+  EXPECT_NO_THROW(Payload::fromFile(file, 10, contents.size() - 10));
+}
+
+TEST(PayloadTest, FromFileSplitsWithoutReading) {
+  auto const contents = fileContents();
+  auto p = Payload::fromFile(fileWith(contents), 100, 8000);
+
+  // Like fragmentation does.
+  folly::IOBufQueue queue{folly::IOBufQueue::cacheChainLength()};
+  queue.append(std::move(p.data));
+  auto first = queue.splitAtMost(3000);
+  auto second = queue.move();
+
+  auto const firstRange = findFileRange(*first);
+  auto const secondRange = findFileRange(*second);
+  ASSERT_TRUE(firstRange);
+  ASSERT_TRUE(secondRange);
+  EXPECT_EQ(firstRange->offset, 100);
+  EXPECT_EQ(secondRange->offset, 3100);
+  EXPECT_EQ(second->computeChainDataLength(), 5000u);
+}
+
+TEST(PayloadTest, FromFileSerializesOnlyTheHeader) {
+  auto const contents = fileContents();
+  auto p = Payload::fromFile(fileWith(contents), 0, 4096);
+
+  FrameSerializerV1_0 serializer;
+  auto frame = serializer.serializeOut(
+      Frame_PAYLOAD(1, FrameFlags::NEXT | FrameFlags::COMPLETE, std::move(p)));
+
+  // The data is chained after a separate header, still mapping the file.
+  ASSERT_GT(frame->countChainElements(), 1u);
+  auto const data = frame->prev();
+  EXPECT_TRUE(findFileRange(*data));
+  EXPECT_EQ(data->length(), 4096u);
+}
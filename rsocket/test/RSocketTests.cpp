@@ -134,7 +134,8 @@ std::unique_ptr<RSocketClient> makeWarmResumableClient(
     folly::EventBase* eventBase,
     uint16_t port,
     std::shared_ptr<RSocketConnectionEvents> connectionEvents,
-    folly::EventBase* stateMachineEvb) {
+    folly::EventBase* stateMachineEvb,
+    std::shared_ptr<RSocketStats> stats) {
   CHECK(eventBase);
   SetupParameters setupParameters;
   setupParameters.resumable = true;
@@ -143,7 +144,7 @@ std::unique_ptr<RSocketClient> makeWarmResumableClient(
              std::move(setupParameters),
              std::make_shared<RSocketResponder>(),
              kDefaultKeepaliveInterval,
-             RSocketStats::noop(),
+             std::move(stats),
              std::move(connectionEvents),
              std::make_shared<WarmResumeManager>(RSocketStats::noop()),
              std::shared_ptr<ColdResumeHandler>(),
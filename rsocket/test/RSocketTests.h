@@ -73,7 +73,8 @@ std::unique_ptr<RSocketClient> makeWarmResumableClient(
     folly::EventBase* eventBase,
     uint16_t port,
     std::shared_ptr<RSocketConnectionEvents> connectionEvents = nullptr,
-    folly::EventBase* stateMachineEvb = nullptr);
+    folly::EventBase* stateMachineEvb = nullptr,
+    std::shared_ptr<RSocketStats> stats = RSocketStats::noop());
 
 std::unique_ptr<RSocketClient> makeColdResumableClient(
     folly::EventBase* eventBase,
@@ -12,9 +12,11 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <folly/Portability.h>
 #include <folly/io/async/ScopedEventBaseThread.h>
 #include <folly/synchronization/Baton.h>
 #include <gtest/gtest.h>
+#include <atomic>
 #include <thread>
 
 #include "RSocketTests.h"
@@ -22,6 +24,10 @@
 #include "yarpl/Single.h"
 #include "yarpl/single/SingleTestObserver.h"
 
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/BlockingWait.h>
+#endif
+
 using namespace yarpl::single;
 using namespace rsocket;
 using namespace rsocket::tests;
@@ -125,6 +131,134 @@ TEST(RequestResponseTest, Hello) {
   to->assertOnSuccessValue({"Hello, Jane Doe!", ":)"});
 }
 
+TEST(RequestResponseTest, CompressedHello) {
+  if (!PayloadCompressor::isSupported("zstd")) {
+    return;
+  }
+
+  folly::ScopedEventBaseThread worker;
+  auto server = makeServer(std::make_shared<GenericRequestResponseHandler>(
+      [](StringPair const& request) {
+        return payload_response(
+            "Hello, " + request.first + " " + request.second + "!", ":)");
+      }));
+  server->setPayloadCompression(PayloadCompressor::Options{});
+
+  SetupParameters setupParameters;
+  setupParameters.compression = "zstd";
+  auto client = RSocket::createConnectedClient(
+                    getConnFactory(worker.getEventBase(),
+                                   *server->listeningPort()),
+                    std::move(setupParameters))
+                    .get();
+  auto requester = client->getRequester();
+
+  // Long enough to be compressed both ways.
+  const std::string name(4096, 'J');
+  auto to = SingleTestObserver<StringPair>::create();
+  requester->requestResponse(Payload(name, "Doe"))
+      ->map(payload_to_stringpair)
+      ->subscribe(to);
+  to->awaitTerminalEvent();
+  to->assertOnSuccessValue({"Hello, " + name + " Doe!", ":)"});
+}
+
+TEST(RequestResponseTest, CompressionRejected) {
+  if (!PayloadCompressor::isSupported("zstd")) {
+    return;
+  }
+
+  folly::ScopedEventBaseThread worker;
+  auto server = makeServer(std::make_shared<GenericRequestResponseHandler>(
+      [](StringPair const&) { return payload_response("unused", ""); }));
+
+  SetupParameters setupParameters;
+  setupParameters.compression = "zstd";
+  auto client = RSocket::createConnectedClient(
+                    getConnFactory(worker.getEventBase(),
+                                   *server->listeningPort()),
+                    std::move(setupParameters))
+                    .get();
+  auto requester = client->getRequester();
+
+  auto to = SingleTestObserver<StringPair>::create();
+  requester->requestResponse(Payload(std::string(4096, 'J'), "Doe"))
+      ->map(payload_to_stringpair)
+      ->subscribe(to);
+  to->awaitTerminalEvent();
+  EXPECT_TRUE(to->getException());
+}
+
+namespace {
+class MetadataStats : public RSocketStats {
+ public:
+  void metadataBytesSaved(size_t bytes) override {
+    saved += bytes;
+  }
+
+  std::atomic<size_t> saved{0};
+};
+} // namespace
+
+TEST(RequestResponseTest, InternedMetadata) {
+  folly::ScopedEventBaseThread worker;
+  auto server = makeServer(std::make_shared<GenericRequestResponseHandler>(
+      [](StringPair const& request) {
+        return payload_response(
+            "Hello, " + request.first + "!", request.second);
+      }));
+  server->setMaxMetadataDictionarySize(16);
+
+  SetupParameters setupParameters;
+  setupParameters.metadataDictionarySize = 16;
+  auto stats = std::make_shared<MetadataStats>();
+  auto client = RSocket::createConnectedClient(
+                    getConnFactory(worker.getEventBase(),
+                                   *server->listeningPort()),
+                    std::move(setupParameters),
+                    std::make_shared<RSocketResponder>(),
+                    kDefaultKeepaliveInterval,
+                    stats)
+                    .get();
+  auto requester = client->getRequester();
+
+  const std::string route = "route=/hello;auth=Bearer 0123456789abcdef";
+  for (int i = 0; i < 3; ++i) {
+    auto to = SingleTestObserver<StringPair>::create();
+    requester->requestResponse(Payload("Jane", route))
+        ->map(payload_to_stringpair)
+        ->subscribe(to);
+    to->awaitTerminalEvent();
+    to->assertOnSuccessValue({"Hello, Jane!", route});
+  }
+
+  // The first request defined the metadata, the other two referred to it.
+  EXPECT_EQ(2 * (route.size() - 3), stats->saved.load());
+}
+
+TEST(RequestResponseTest, MetadataDictionaryRejected) {
+  folly::ScopedEventBaseThread worker;
+  auto server = makeServer(std::make_shared<GenericRequestResponseHandler>(
+      [](StringPair const&) { return payload_response("unused", ""); }));
+  server->setMaxMetadataDictionarySize(16);
+
+  SetupParameters setupParameters;
+  setupParameters.metadataDictionarySize = 32;
+  auto client = RSocket::createConnectedClient(
+                    getConnFactory(worker.getEventBase(),
+                                   *server->listeningPort()),
+                    std::move(setupParameters))
+                    .get();
+
+  auto to = SingleTestObserver<StringPair>::create();
+  client->getRequester()
+      ->requestResponse(Payload("Jane", "route=/hello;auth=Bearer 01234567"))
+      ->map(payload_to_stringpair)
+      ->subscribe(to);
+  to->awaitTerminalEvent();
+  EXPECT_TRUE(to->getException());
+}
+
 TEST(RequestResponseTest, FailureInResponse) {
   folly::ScopedEventBaseThread worker;
   auto server = makeServer(std::make_shared<GenericRequestResponseHandler>(
@@ -303,3 +437,58 @@ TEST(RequestResponseTest, MultiSubscribe) {
   to->awaitTerminalEvent();
   to->assertOnSuccessValue({"Hello, Jane Doe!", ":)"});
 }
+
+#if FOLLY_HAS_COROUTINES
+namespace {
+class CoroHelloResponder : public RSocketCoroResponder {
+ public:
+  folly::coro::Task<Payload> co_handleRequestResponse(
+      Payload request,
+      StreamId) override {
+    auto name = request.moveDataToString();
+    if (name.empty()) {
+      throw std::runtime_error("no name");
+    }
+    co_return Payload("Hello, " + name + "!");
+  }
+};
+} // namespace
+
+TEST(RequestResponseTest, CoroHello) {
+  folly::ScopedEventBaseThread worker;
+  auto server = makeServer(std::make_shared<CoroHelloResponder>());
+  auto client = makeClient(worker.getEventBase(), *server->listeningPort());
+  auto requester = client->getRequester();
+
+  auto response =
+      folly::coro::blockingWait(requester->co_requestResponse(Payload("Jane")));
+  EXPECT_EQ("Hello, Jane!", response.moveDataToString());
+}
+
+TEST(RequestResponseTest, CoroHandleError) {
+  folly::ScopedEventBaseThread worker;
+  auto server = makeServer(std::make_shared<CoroHelloResponder>());
+  auto client = makeClient(worker.getEventBase(), *server->listeningPort());
+  auto requester = client->getRequester();
+
+  EXPECT_THROW(
+      folly::coro::blockingWait(requester->co_requestResponse(Payload(""))),
+      std::exception);
+}
+
+TEST(RequestResponseTest, CoroRequesterRxResponder) {
+  folly::ScopedEventBaseThread worker;
+  auto server = makeServer(std::make_shared<GenericRequestResponseHandler>(
+      [](StringPair const& request) {
+        return payload_response(
+            "Hello, " + request.first + " " + request.second + "!", ":)");
+      }));
+  auto client = makeClient(worker.getEventBase(), *server->listeningPort());
+  auto requester = client->getRequester();
+
+  auto response = folly::coro::blockingWait(
+      requester->co_requestResponse(Payload("Jane", "Doe")));
+  EXPECT_EQ("Hello, Jane Doe!", response.moveDataToString());
+  EXPECT_EQ(":)", response.moveMetadataToString());
+}
+#endif
@@ -12,14 +12,22 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <folly/Portability.h>
 #include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/synchronization/Baton.h>
 #include <gtest/gtest.h>
+#include <atomic>
 #include <thread>
 
 #include "RSocketTests.h"
 #include "yarpl/Flowable.h"
 #include "yarpl/flowable/TestSubscriber.h"
 
+#if FOLLY_HAS_COROUTINES
+#include <folly/Conv.h>
+#include <folly/experimental/coro/BlockingWait.h>
+#endif
+
 using namespace yarpl::flowable;
 using namespace rsocket;
 using namespace rsocket::tests;
@@ -355,3 +363,133 @@ TEST(RequestStreamTest, MultiSubscribe) {
   ts->assertValueAt(0, "Hello Bob 1!");
   ts->assertValueAt(9, "Hello Bob 10!");
 }
+
+namespace {
+/// Streams of payloads of a fixed size, counting the bytes it produced.
+class CountingStreamHandler : public rsocket::RSocketResponder {
+ public:
+  CountingStreamHandler(int64_t items, size_t size)
+      : items_{items}, data_(size, 'a') {}
+
+  std::shared_ptr<Flowable<Payload>> handleRequestStream(
+      Payload,
+      StreamId) override {
+    return Flowable<>::range(0, items_)->map([this](int64_t) {
+      produced += data_.size();
+      return Payload(data_);
+    });
+  }
+
+  std::atomic<size_t> produced{0};
+
+ private:
+  const int64_t items_;
+  const std::string data_;
+};
+} // namespace
+
+TEST(RequestStreamTest, SlowReaderBoundsServerBuffering) {
+  constexpr size_t kItemSize = 64 * 1024;
+  constexpr int64_t kItems = 16;
+  constexpr size_t kStreams = 128;
+  // The loopback socket buffers take a few megabytes before anything is
+  // buffered by the server itself.
+  constexpr size_t kMaxBuffered = 32 * 1024 * 1024;
+
+  auto handler = std::make_shared<CountingStreamHandler>(kItems, kItemSize);
+  auto server = makeServer(handler);
+  server->setWriteWatermarks({256 * 1024, 1024 * 1024});
+
+  folly::ScopedEventBaseThread worker;
+  auto client = makeClient(worker.getEventBase(), *server->listeningPort());
+  auto requester = client->getRequester();
+
+  std::vector<std::shared_ptr<TestSubscriber<size_t>>> subscribers;
+  for (size_t i = 0; i < kStreams; ++i) {
+    subscribers.push_back(TestSubscriber<size_t>::create(kItems));
+    requester->requestStream(Payload("slow"))
+        ->map([](Payload p) { return p.data->computeChainDataLength(); })
+        ->subscribe(subscribers.back());
+  }
+
+  // Once the client sent its requests, it stops reading altogether.
+  folly::Baton<> unblock;
+  worker.getEventBase()->runInEventBaseThread([&] { unblock.wait(); });
+
+  size_t produced;
+  auto const deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  do {
+    produced = handler->produced;
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  } while (handler->produced != produced &&
+           std::chrono::steady_clock::now() < deadline);
+
+  // Everything the server produced is still buffered between the two.  The
+  // credits of streams opened after the connection became unwritable are held
+  // back.
+  EXPECT_LE(produced, kMaxBuffered);
+  EXPECT_LT(produced, kStreams * kItems * kItemSize);
+
+  unblock.post();
+  for (const auto& subscriber : subscribers) {
+    subscriber->awaitTerminalEvent(std::chrono::seconds{10});
+    subscriber->assertSuccess();
+    subscriber->assertValueCount(kItems);
+  }
+}
+
+#if FOLLY_HAS_COROUTINES
+namespace {
+class CoroHelloStreamResponder : public RSocketCoroResponder {
+ public:
+  folly::coro::AsyncGenerator<Payload&&> co_handleRequestStream(
+      Payload request,
+      StreamId) override {
+    auto name = request.moveDataToString();
+    for (int i = 1; i <= 10; ++i) {
+      co_yield Payload(folly::to<std::string>("Hello ", name, " ", i, "!"));
+    }
+  }
+};
+} // namespace
+
+TEST(RequestStreamTest, CoroHello) {
+  folly::ScopedEventBaseThread worker;
+  auto server = makeServer(std::make_shared<CoroHelloStreamResponder>());
+  auto client = makeClient(worker.getEventBase(), *server->listeningPort());
+  auto requester = client->getRequester();
+
+  auto values = folly::coro::blockingWait(
+      [&]() -> folly::coro::Task<std::vector<std::string>> {
+        std::vector<std::string> result;
+        // a small prefetch exercises the credit replenishing
+        auto stream = requester->co_requestStream(Payload("Bob"), 3);
+        while (auto item = co_await stream.next()) {
+          result.push_back(item->moveDataToString());
+        }
+        co_return result;
+      }());
+
+  ASSERT_EQ(10u, values.size());
+  EXPECT_EQ("Hello Bob 1!", values.front());
+  EXPECT_EQ("Hello Bob 10!", values.back());
+}
+
+TEST(RequestStreamTest, CoroRxResponderEarlyStop) {
+  folly::ScopedEventBaseThread worker;
+  auto server = makeServer(std::make_shared<TestHandlerSync>());
+  auto client = makeClient(worker.getEventBase(), *server->listeningPort());
+  auto requester = client->getRequester();
+
+  auto first = folly::coro::blockingWait(
+      [&]() -> folly::coro::Task<std::string> {
+        // destroying the generator cancels the stream
+        auto stream = requester->co_requestStream(Payload("Bob"));
+        auto item = co_await stream.next();
+        co_return item->moveDataToString();
+      }());
+
+  EXPECT_EQ("Hello Bob 1!", first);
+}
+#endif
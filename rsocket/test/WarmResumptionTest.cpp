@@ -28,6 +28,26 @@ using namespace rsocket::tests;
 using namespace rsocket::tests::client_server;
 using namespace yarpl::flowable;
 
+namespace {
+
+class PendingOutputStats : public RSocketStats {
+ public:
+  void streamBufferChanged(int64_t framesCountDelta, int64_t) override {
+    pendingFrames_ += framesCountDelta;
+    maxPendingFrames_ = std::max(maxPendingFrames_, pendingFrames_);
+  }
+
+  void pendingOutputOverflow() override {
+    ++overflows_;
+  }
+
+  int64_t pendingFrames_{0};
+  int64_t maxPendingFrames_{0};
+  size_t overflows_{0};
+};
+
+} // namespace
+
 TEST(WarmResumptionTest, SuccessfulResumption) {
   folly::ScopedEventBaseThread worker;
   auto server = makeResumableServer(std::make_shared<HelloServiceHandler>());
@@ -171,3 +191,51 @@ TEST(WarmResumptionTest, DifferentEvb) {
   ts->assertSuccess();
   ts->assertValueCount(10);
 }
+
+// Verify the frames queued up while disconnected stay within their limits, and
+// the streams unaffected by the overflow resume
+TEST(WarmResumptionTest, PendingOutputLimits) {
+  folly::ScopedEventBaseThread worker;
+  auto stats = std::make_shared<PendingOutputStats>();
+  auto server = makeResumableServer(std::make_shared<HelloServiceHandler>());
+  auto client = makeWarmResumableClient(
+      worker.getEventBase(),
+      *server->listeningPort(),
+      nullptr, // connectionEvents
+      nullptr, // stateMachineEvb
+      stats);
+
+  constexpr size_t kMaxFrames = 16;
+  PendingOutputLimits limits;
+  limits.maxFrames = kMaxFrames;
+  limits.overflow = PendingOutputOverflow::DROP_STREAM;
+  client->setPendingOutputLimits(limits);
+
+  auto ts = TestSubscriber<std::string>::create(7 /* initialRequestN */);
+  client->getRequester()
+      ->requestStream(Payload("Bob"))
+      ->map([](auto p) { return p.moveDataToString(); })
+      ->subscribe(ts);
+  // Wait for a few frames before disconnecting.
+  while (ts->getValueCount() < 3) {
+    std::this_thread::yield();
+  }
+  client->disconnect(std::runtime_error("Test triggered disconnect")).get();
+
+  constexpr size_t kRequests = 1000;
+  for (size_t i = 0; i < kRequests; ++i) {
+    client->getRequester()->fireAndForget(Payload("Alice"))->subscribe([] {});
+  }
+  worker.getEventBase()->runInEventBaseThreadAndWait([] {});
+  EXPECT_EQ(static_cast<int64_t>(kMaxFrames), stats->maxPendingFrames_);
+  EXPECT_GE(stats->overflows_, kRequests - kMaxFrames);
+
+  EXPECT_NO_THROW(client->resume().get());
+  worker.getEventBase()->runInEventBaseThreadAndWait([] {});
+  EXPECT_EQ(0, stats->pendingFrames_);
+
+  ts->request(3);
+  ts->awaitTerminalEvent();
+  ts->assertSuccess();
+  ts->assertValueCount(10);
+}
@@ -0,0 +1,125 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/benchmarks/HdrHistogram.h"
+
+#include <gtest/gtest.h>
+
+using namespace rsocket;
+
+namespace {
+
+/// Same range the latency benchmarks use.
+constexpr uint64_t kOneMinuteNs = 60'000'000'000;
+
+/// Percentiles are reported as the highest value in the bucket, so they can
+/// be above the exact answer by up to the three significant digits.
+void expectWithinPrecision(uint64_t expected, uint64_t actual) {
+  EXPECT_GE(actual, expected);
+  EXPECT_LE(actual, expected + expected / 1000);
+}
+
+} // namespace
+
+TEST(HdrHistogramTest, Empty) {
+  HdrHistogram histogram{kOneMinuteNs};
+  EXPECT_EQ(0, histogram.count());
+  EXPECT_EQ(0, histogram.min());
+  EXPECT_EQ(0, histogram.max());
+  EXPECT_EQ(0, histogram.valueAtPercentile(50));
+}
+
+TEST(HdrHistogramTest, BucketBoundaries) {
+  HdrHistogram histogram{kOneMinuteNs};
+
+  // With three digits, values below 2048 get a slot each, the next power of
+  // two range has slots two wide, the one after four wide.
+  histogram.record(2047);
+  histogram.record(2048);
+  histogram.record(2050);
+  histogram.record(4096);
+  histogram.record(10000);
+
+  EXPECT_EQ(2047, histogram.valueAtPercentile(10));
+  EXPECT_EQ(2049, histogram.valueAtPercentile(30));
+  EXPECT_EQ(2051, histogram.valueAtPercentile(50));
+  EXPECT_EQ(4099, histogram.valueAtPercentile(70));
+
+  // Never reported above the largest value recorded.
+  EXPECT_EQ(10000, histogram.valueAtPercentile(100));
+  EXPECT_EQ(2047, histogram.min());
+  EXPECT_EQ(10000, histogram.max());
+}
+
+TEST(HdrHistogramTest, UniformPercentiles) {
+  HdrHistogram histogram{kOneMinuteNs};
+  for (uint64_t i = 1; i <= 100000; ++i) {
+    histogram.record(i);
+  }
+
+  EXPECT_EQ(100000, histogram.count());
+  expectWithinPrecision(50000, histogram.valueAtPercentile(50));
+  expectWithinPrecision(99000, histogram.valueAtPercentile(99));
+  expectWithinPrecision(99900, histogram.valueAtPercentile(99.9));
+  EXPECT_EQ(100000, histogram.valueAtPercentile(100));
+}
+
+TEST(HdrHistogramTest, TailPercentiles) {
+  HdrHistogram histogram{kOneMinuteNs};
+  for (int i = 0; i < 990; ++i) {
+    histogram.record(1000);
+  }
+  for (int i = 0; i < 10; ++i) {
+    histogram.record(5'000'000);
+  }
+
+  // Only the last percent is slow.
+  EXPECT_EQ(1000, histogram.valueAtPercentile(50));
+  EXPECT_EQ(1000, histogram.valueAtPercentile(99));
+  EXPECT_EQ(5'000'000, histogram.valueAtPercentile(99.9));
+}
+
+TEST(HdrHistogramTest, ClampsAboveHighest) {
+  HdrHistogram histogram{kOneMinuteNs};
+  histogram.record(kOneMinuteNs + 1);
+  histogram.record(UINT64_MAX);
+
+  EXPECT_EQ(2, histogram.count());
+  EXPECT_EQ(kOneMinuteNs, histogram.min());
+  EXPECT_EQ(kOneMinuteNs, histogram.max());
+  EXPECT_EQ(kOneMinuteNs, histogram.valueAtPercentile(99.9));
+}
+
+TEST(HdrHistogramTest, Merge) {
+  HdrHistogram low{kOneMinuteNs};
+  HdrHistogram high{kOneMinuteNs};
+  for (uint64_t i = 1; i <= 1000; ++i) {
+    low.record(i);
+    high.record(i + 1000);
+  }
+
+  HdrHistogram merged{kOneMinuteNs};
+  merged.merge(low);
+  merged.merge(high);
+
+  EXPECT_EQ(2000, merged.count());
+  EXPECT_EQ(1, merged.min());
+  EXPECT_EQ(2000, merged.max());
+  EXPECT_EQ(1000, merged.valueAtPercentile(50));
+  EXPECT_EQ(1990, merged.valueAtPercentile(99.5));
+
+  // Merging doesn't touch the source.
+  EXPECT_EQ(1000, low.count());
+  EXPECT_EQ(1000, low.max());
+}
@@ -0,0 +1,165 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/Conv.h>
+#include <folly/Format.h>
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <thread>
+#include <vector>
+
+#include "rsocket/framing/FrameCapture.h"
+#include "rsocket/test/test_utils/MockDuplexConnection.h"
+
+using namespace rsocket;
+using namespace testing;
+using namespace yarpl::mocks;
+
+namespace {
+
+std::string capturePath() {
+  static int counter{0};
+  return folly::sformat(
+      "/tmp/rsocket-capture-test-{}-{}.bin", getpid(), ++counter);
+}
+
+std::string toString(const CapturedFrame& captured) {
+  return captured.frame->clone()->moveToFbString().toStdString();
+}
+
+} // namespace
+
+TEST(FrameCapture, RoundTrip) {
+  const auto path = capturePath();
+  auto capture = std::make_shared<FrameCapture>(path);
+
+  std::shared_ptr<DuplexConnection::Subscriber> input;
+  auto inner = std::make_unique<StrictMock<MockDuplexConnection>>();
+  EXPECT_CALL(*inner, setInput_(_)).WillOnce(SaveArg<0>(&input));
+  EXPECT_CALL(*inner, send_(_)).WillOnce(Invoke([](auto& buf) {
+    EXPECT_EQ("sent", buf->moveToFbString().toStdString());
+  }));
+
+  auto connection =
+      std::make_unique<CapturingDuplexConnection>(std::move(inner), capture);
+  auto other = std::make_unique<CapturingDuplexConnection>(
+      std::make_unique<NiceMock<MockDuplexConnection>>(), capture);
+
+  auto subscriber = std::make_shared<
+      StrictMock<MockSubscriber<std::unique_ptr<folly::IOBuf>>>>();
+  EXPECT_CALL(*subscriber, onSubscribe_(_));
+  EXPECT_CALL(*subscriber, onNext_(_));
+  EXPECT_CALL(*subscriber, onComplete_());
+
+  connection->setInput(subscriber);
+  ASSERT_TRUE(input);
+  input->onSubscribe(yarpl::flowable::Subscription::create());
+
+  // A chained frame is recorded contiguously.
+  auto received = folly::IOBuf::copyBuffer("rece");
+  received->prependChain(folly::IOBuf::copyBuffer("ived"));
+  input->onNext(std::move(received));
+
+  connection->send(folly::IOBuf::copyBuffer("sent"));
+  other->send(folly::IOBuf::copyBuffer("other"));
+
+  input->onComplete();
+  connection.reset();
+  other.reset();
+  capture.reset();
+
+  FrameCaptureReader reader{path};
+
+  auto first = reader.next();
+  ASSERT_TRUE(first);
+  EXPECT_EQ(0u, first->connection);
+  EXPECT_EQ(FrameCapture::Direction::RECEIVED, first->direction);
+  EXPECT_EQ("received", toString(*first));
+
+  auto second = reader.next();
+  ASSERT_TRUE(second);
+  EXPECT_EQ(0u, second->connection);
+  EXPECT_EQ(FrameCapture::Direction::SENT, second->direction);
+  EXPECT_EQ("sent", toString(*second));
+  EXPECT_LE(first->time, second->time);
+
+  auto third = reader.next();
+  ASSERT_TRUE(third);
+  EXPECT_EQ(1u, third->connection);
+  EXPECT_EQ("other", toString(*third));
+
+  EXPECT_FALSE(reader.next());
+
+  unlink(path.c_str());
+}
+
+TEST(FrameCapture, RecordsFromManyThreads) {
+  const auto path = capturePath();
+  auto capture = std::make_shared<FrameCapture>(path);
+
+  constexpr uint32_t kThreads = 4;
+  constexpr int kFrames = 1000;
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < kThreads; ++i) {
+    threads.emplace_back([&] {
+      CapturingDuplexConnection connection{
+          std::make_unique<NiceMock<MockDuplexConnection>>(), capture};
+      for (int j = 0; j < kFrames; ++j) {
+        connection.send(folly::IOBuf::copyBuffer(folly::to<std::string>(j)));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  capture.reset();
+
+  // The frames of each connection are in order.
+  FrameCaptureReader reader{path};
+  std::vector<int> nextFrame(kThreads, 0);
+  while (auto captured = reader.next()) {
+    ASSERT_LT(captured->connection, kThreads);
+    EXPECT_EQ(
+        folly::to<std::string>(nextFrame[captured->connection]++),
+        toString(*captured));
+  }
+  EXPECT_EQ(std::vector<int>(kThreads, kFrames), nextFrame);
+
+  unlink(path.c_str());
+}
+
+TEST(FrameCapture, StopsWhenWritingFails) {
+  auto capture = std::make_shared<FrameCapture>("/dev/full");
+  CapturingDuplexConnection connection{
+      std::make_unique<NiceMock<MockDuplexConnection>>(), capture};
+
+  // Neither recording nor writing out throws.
+  connection.send(folly::IOBuf::copyBuffer("lost"));
+  capture->flush();
+  EXPECT_TRUE(capture->failed());
+  connection.send(folly::IOBuf::copyBuffer("ignored"));
+}
+
+TEST(FrameCapture, RejectsOtherFiles) {
+  const auto path = capturePath();
+  {
+    folly::File file{path, O_WRONLY | O_CREAT | O_TRUNC};
+    ASSERT_EQ(5, write(file.fd(), "hello", 5));
+  }
+  EXPECT_THROW(FrameCaptureReader{path}, std::runtime_error);
+  unlink(path.c_str());
+}
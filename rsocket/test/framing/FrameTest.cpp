@@ -302,3 +302,70 @@ TEST(FrameTest, Frame_PreallocatedFrameLengthField) {
 
   EXPECT_LT(0, serializedFrame->headroom());
 }
+
+TEST(FrameTest, Frame_HeaderWrittenIntoPayloadHeadroom) {
+  uint32_t streamId = 42;
+  FrameFlags flags = FrameFlags::COMPLETE | FrameFlags::NEXT;
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  frameSerializer->preallocateFrameSizeField() = true;
+
+  auto frame =
+      Frame_PAYLOAD(streamId, flags, Payload::withFrameHeadroom("424242"));
+  auto serializedFrame = frameSerializer->serializeOut(std::move(frame));
+
+  EXPECT_FALSE(serializedFrame->isChained());
+  EXPECT_LE(3u, serializedFrame->headroom());
+
+  Frame_PAYLOAD newFrame;
+  ASSERT_TRUE(frameSerializer->deserializeFrom(
+      newFrame, std::move(serializedFrame)));
+  expectHeader(FrameType::PAYLOAD, flags, streamId, newFrame);
+  EXPECT_EQ(newFrame.payload_.moveDataToString(), "424242");
+}
+
+TEST(FrameTest, Frame_HeaderWrittenIntoMetadataHeadroom) {
+  uint32_t streamId = 42;
+  uint32_t requestN = 3;
+  FrameFlags flags = FrameFlags::METADATA;
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+
+  auto frame = Frame_REQUEST_STREAM(
+      streamId,
+      flags,
+      requestN,
+      Payload::withFrameHeadroom("424242", "i'm so meta"));
+  auto serializedFrame = frameSerializer->serializeOut(std::move(frame));
+
+  // header and metadata in the first buffer, data in the second one
+  EXPECT_EQ(2u, serializedFrame->countChainElements());
+
+  Frame_REQUEST_STREAM newFrame;
+  ASSERT_TRUE(frameSerializer->deserializeFrom(
+      newFrame, std::move(serializedFrame)));
+  expectHeader(FrameType::REQUEST_STREAM, flags, streamId, newFrame);
+  EXPECT_EQ(requestN, newFrame.requestN_);
+  EXPECT_EQ(newFrame.payload_.moveMetadataToString(), "i'm so meta");
+  EXPECT_EQ(newFrame.payload_.moveDataToString(), "424242");
+}
+
+TEST(FrameTest, Frame_SharedPayloadHeadroomNotWritten) {
+  uint32_t streamId = 42;
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+
+  auto payload = Payload::withFrameHeadroom("424242");
+  auto clone = payload.clone();
+  auto frame = Frame_ERROR::applicationError(streamId, std::move(payload));
+  auto serializedFrame = frameSerializer->serializeOut(std::move(frame));
+
+  EXPECT_TRUE(serializedFrame->isChained());
+  EXPECT_EQ(clone.moveDataToString(), "424242");
+
+  Frame_ERROR newFrame;
+  ASSERT_TRUE(frameSerializer->deserializeFrom(
+      newFrame, std::move(serializedFrame)));
+  EXPECT_EQ(ErrorCode::APPLICATION_ERROR, newFrame.errorCode_);
+  EXPECT_EQ(newFrame.payload_.moveDataToString(), "424242");
+}
@@ -111,3 +111,37 @@ TEST(FramedReader, SubscriberErrorAfterError) {
   reader->error("Oops");
   reader->onError(std::runtime_error{"Not oops"});
 }
+
+TEST(FramedReader, RequestsUpstreamOnlyWhenFramesAreWanted) {
+  auto version = std::make_shared<ProtocolVersion>(ProtocolVersion::Latest);
+  auto reader = std::make_shared<FramedReader>(version);
+
+  auto subscription = std::make_shared<StrictMock<MockSubscription>>();
+  reader->onSubscribe(subscription);
+
+  auto subscriber = std::make_shared<
+      NiceMock<MockSubscriber<std::unique_ptr<folly::IOBuf>>>>(1);
+  EXPECT_CALL(*subscription, request_(1));
+  reader->setInput(subscriber);
+  Mock::VerifyAndClearExpectations(subscription.get());
+
+  // Two minimal frames in a single read.
+  const char frames[] = "\x00\x00\x06"
+                        "ABCDEF"
+                        "\x00\x00\x06"
+                        "GHIJKL";
+  EXPECT_CALL(*subscriber, onNext_(_)).Times(1);
+  reader->onNext(folly::IOBuf::copyBuffer(frames, sizeof(frames) - 1));
+  Mock::VerifyAndClearExpectations(subscriber.get());
+
+  // The second frame is already buffered, nothing is read for it.
+  EXPECT_CALL(*subscriber, onNext_(_)).Times(1);
+  subscriber->subscription()->request(1);
+  Mock::VerifyAndClearExpectations(subscriber.get());
+
+  EXPECT_CALL(*subscription, request_(1));
+  subscriber->subscription()->request(1);
+  Mock::VerifyAndClearExpectations(subscription.get());
+
+  reader->onComplete();
+}
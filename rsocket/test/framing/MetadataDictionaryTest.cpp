@@ -0,0 +1,157 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/io/IOBuf.h>
+#include <gmock/gmock.h>
+
+#include "rsocket/framing/FrameSerializer.h"
+#include "rsocket/framing/MetadataDictionary.h"
+#include "rsocket/test/test_utils/MockStats.h"
+
+using namespace rsocket;
+using namespace testing;
+
+namespace {
+
+const std::string kRoute = "route=/users/profile;auth=Bearer abcdef0123456789";
+
+std::string roundTrip(
+    MetadataDictionary& sender,
+    MetadataDictionary& receiver,
+    const std::string& metadata,
+    size_t* wireLength = nullptr) {
+  auto encoded = sender.encode(folly::IOBuf::copyBuffer(metadata));
+  if (wireLength) {
+    *wireLength = encoded->computeChainDataLength();
+  }
+  return receiver.decode(std::move(encoded))->moveToFbString().toStdString();
+}
+
+} // namespace
+
+TEST(MetadataDictionaryTest, RepeatedMetadataIsSentAsAnId) {
+  auto stats = std::make_shared<StrictMock<MockStats>>();
+  MetadataDictionary sender(16, stats);
+  MetadataDictionary receiver(16, RSocketStats::noop());
+
+  size_t wireLength;
+  EXPECT_EQ(kRoute, roundTrip(sender, receiver, kRoute, &wireLength));
+  EXPECT_EQ(kRoute.size() + 3, wireLength);
+
+  EXPECT_CALL(*stats, metadataBytesSaved(kRoute.size() - 3)).Times(2);
+  EXPECT_EQ(kRoute, roundTrip(sender, receiver, kRoute, &wireLength));
+  EXPECT_EQ(3u, wireLength);
+  EXPECT_EQ(kRoute, roundTrip(sender, receiver, kRoute, &wireLength));
+  EXPECT_EQ(3u, wireLength);
+}
+
+TEST(MetadataDictionaryTest, ShortAndLongMetadataIsSentLiterally) {
+  auto stats = std::make_shared<StrictMock<MockStats>>();
+  MetadataDictionary sender(16, stats);
+  MetadataDictionary receiver(16, RSocketStats::noop());
+
+  const std::string shortMetadata = "short";
+  const std::string longMetadata(MetadataDictionary::kMaxLength + 1, 'm');
+  for (int i = 0; i < 2; ++i) {
+    size_t wireLength;
+    EXPECT_EQ(
+        shortMetadata,
+        roundTrip(sender, receiver, shortMetadata, &wireLength));
+    EXPECT_EQ(shortMetadata.size() + 1, wireLength);
+    EXPECT_EQ(
+        longMetadata, roundTrip(sender, receiver, longMetadata, &wireLength));
+    EXPECT_EQ(longMetadata.size() + 1, wireLength);
+  }
+}
+
+TEST(MetadataDictionaryTest, LeastRecentlyUsedIdIsReused) {
+  MetadataDictionary sender(2, RSocketStats::noop());
+  MetadataDictionary receiver(2, RSocketStats::noop());
+
+  const auto a = kRoute + "a";
+  const auto b = kRoute + "b";
+  const auto c = kRoute + "c";
+
+  size_t wireLength;
+  roundTrip(sender, receiver, a);
+  roundTrip(sender, receiver, b);
+  EXPECT_EQ(a, roundTrip(sender, receiver, a, &wireLength));
+  EXPECT_EQ(3u, wireLength);
+
+  // Takes over the ID of b, which was used less recently than a.
+  EXPECT_EQ(c, roundTrip(sender, receiver, c, &wireLength));
+  EXPECT_EQ(c.size() + 3, wireLength);
+  EXPECT_EQ(c, roundTrip(sender, receiver, c, &wireLength));
+  EXPECT_EQ(3u, wireLength);
+  EXPECT_EQ(a, roundTrip(sender, receiver, a, &wireLength));
+  EXPECT_EQ(3u, wireLength);
+  EXPECT_EQ(b, roundTrip(sender, receiver, b, &wireLength));
+  EXPECT_EQ(b.size() + 3, wireLength);
+}
+
+TEST(MetadataDictionaryTest, MalformedMetadata) {
+  MetadataDictionary receiver(16, RSocketStats::noop());
+  // unknown tag
+  EXPECT_ANY_THROW(receiver.decode(folly::IOBuf::copyBuffer("\x07")));
+  // reference to an ID that wasn't defined
+  EXPECT_ANY_THROW(receiver.decode(
+      folly::IOBuf::copyBuffer(std::string("\x02\x00\x01", 3))));
+  // ID out of range
+  EXPECT_ANY_THROW(receiver.decode(
+      folly::IOBuf::copyBuffer(std::string("\x02\x00\x10", 3))));
+  // definition that is too short to have been interned
+  EXPECT_ANY_THROW(receiver.decode(
+      folly::IOBuf::copyBuffer(std::string("\x01\x00\x00short", 8))));
+}
+
+TEST(MetadataDictionaryTest, MimeType) {
+  auto mimeType = MetadataDictionary::addToMimeType("text/plain", 64);
+  EXPECT_EQ("text/plain; interning=64", mimeType);
+  EXPECT_EQ(64u, MetadataDictionary::takeFromMimeType(mimeType));
+  EXPECT_EQ("text/plain", mimeType);
+
+  EXPECT_EQ(0u, MetadataDictionary::takeFromMimeType(mimeType));
+
+  mimeType = "text/plain; interning=lots";
+  EXPECT_GT(
+      MetadataDictionary::takeFromMimeType(mimeType),
+      MetadataDictionary::kMaxSize);
+}
+
+TEST(MetadataDictionaryTest, SerializerInternsMetadataOnly) {
+  auto sender = FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  sender->setMetadataDictionary(
+      std::make_shared<MetadataDictionary>(16, RSocketStats::noop()));
+  auto receiver =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  receiver->setMetadataDictionary(
+      std::make_shared<MetadataDictionary>(16, RSocketStats::noop()));
+
+  size_t firstLength = 0;
+  for (int i = 0; i < 2; ++i) {
+    auto serialized = sender->serializeOut(Frame_REQUEST_RESPONSE(
+        1 + 2 * i, FrameFlags::EMPTY_, Payload("data", kRoute)));
+    const auto length = serialized->computeChainDataLength();
+    if (i == 0) {
+      firstLength = length;
+    } else {
+      EXPECT_EQ(firstLength - kRoute.size(), length);
+    }
+
+    Frame_REQUEST_RESPONSE frame;
+    ASSERT_TRUE(receiver->deserializeFrom(frame, std::move(serialized)));
+    EXPECT_EQ("data", frame.payload_.cloneDataToString());
+    EXPECT_EQ(kRoute, frame.payload_.cloneMetadataToString());
+  }
+}
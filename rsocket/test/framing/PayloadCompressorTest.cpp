@@ -0,0 +1,153 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/io/IOBuf.h>
+#include <gtest/gtest.h>
+
+#include "rsocket/framing/FrameSerializer.h"
+#include "rsocket/framing/PayloadCompressor.h"
+
+using namespace rsocket;
+
+namespace {
+
+std::vector<std::string> supportedCodecs() {
+  std::vector<std::string> codecs;
+  for (auto codec : {"zstd", "lz4"}) {
+    if (PayloadCompressor::isSupported(codec)) {
+      codecs.emplace_back(codec);
+    }
+  }
+  return codecs;
+}
+
+std::string compressible(size_t length) {
+  std::string str;
+  for (size_t i = 0; str.size() < length; ++i) {
+    str += "{\"id\":" + std::to_string(i % 100) + ",\"name\":\"rsocket\"}";
+  }
+  str.resize(length);
+  return str;
+}
+
+} // namespace
+
+TEST(PayloadCompressorTest, UnknownCodec) {
+  EXPECT_FALSE(PayloadCompressor::isSupported("gzip"));
+  EXPECT_THROW(
+      PayloadCompressor::create("gzip", PayloadCompressor::Options{}),
+      std::invalid_argument);
+}
+
+TEST(PayloadCompressorTest, RoundTrip) {
+  for (const auto& codec : supportedCodecs()) {
+    auto compressor =
+        PayloadCompressor::create(codec, PayloadCompressor::Options{});
+    auto const data = compressible(16 * 1024);
+
+    auto compressed = compressor->compress(folly::IOBuf::copyBuffer(data));
+    EXPECT_LT(compressed->computeChainDataLength(), data.size() / 2) << codec;
+
+    auto decompressed = compressor->decompress(std::move(compressed));
+    EXPECT_EQ(data, decompressed->moveToFbString().toStdString()) << codec;
+  }
+}
+
+TEST(PayloadCompressorTest, ShortDataIsSentAsIs) {
+  for (const auto& codec : supportedCodecs()) {
+    PayloadCompressor::Options options;
+    options.threshold = 1024;
+    auto compressor = PayloadCompressor::create(codec, options);
+    auto const data = compressible(1000);
+
+    auto compressed = compressor->compress(folly::IOBuf::copyBuffer(data));
+    EXPECT_EQ(data.size() + 1, compressed->computeChainDataLength()) << codec;
+
+    auto decompressed = compressor->decompress(std::move(compressed));
+    EXPECT_EQ(data, decompressed->moveToFbString().toStdString()) << codec;
+  }
+}
+
+TEST(PayloadCompressorTest, IncompressibleDataIsSentAsIs) {
+  for (const auto& codec : supportedCodecs()) {
+    PayloadCompressor::Options options;
+    options.threshold = 0;
+    auto compressor = PayloadCompressor::create(codec, options);
+
+    auto compressed = compressor->compress(folly::IOBuf::copyBuffer("abc"));
+    EXPECT_EQ(4u, compressed->computeChainDataLength()) << codec;
+    EXPECT_EQ(
+        "abc",
+        compressor->decompress(std::move(compressed))
+            ->moveToFbString()
+            .toStdString())
+        << codec;
+  }
+}
+
+TEST(PayloadCompressorTest, MalformedData) {
+  for (const auto& codec : supportedCodecs()) {
+    auto compressor =
+        PayloadCompressor::create(codec, PayloadCompressor::Options{});
+    EXPECT_ANY_THROW(compressor->decompress(folly::IOBuf::copyBuffer("\x07")));
+    EXPECT_ANY_THROW(
+        compressor->decompress(folly::IOBuf::copyBuffer("\x01\xff\xff")));
+    EXPECT_ANY_THROW(compressor->decompress(
+        folly::IOBuf::copyBuffer(std::string("\x01\x00\x00\x10\x00", 5))));
+  }
+}
+
+TEST(PayloadCompressorTest, MimeType) {
+  auto mimeType =
+      PayloadCompressor::addToMimeType("application/json", "zstd");
+  EXPECT_EQ("application/json; compression=zstd", mimeType);
+  EXPECT_EQ("zstd", PayloadCompressor::takeFromMimeType(mimeType));
+  EXPECT_EQ("application/json", mimeType);
+
+  mimeType = "text/plain; compression=lz4; charset=utf-8";
+  EXPECT_EQ("lz4", PayloadCompressor::takeFromMimeType(mimeType));
+  EXPECT_EQ("text/plain; charset=utf-8", mimeType);
+
+  mimeType = "text/plain";
+  EXPECT_EQ("", PayloadCompressor::takeFromMimeType(mimeType));
+  EXPECT_EQ("text/plain", mimeType);
+}
+
+TEST(PayloadCompressorTest, SerializerCompressesDataOnly) {
+  for (const auto& codec : supportedCodecs()) {
+    auto serializer =
+        FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+    serializer->setPayloadCompressor(
+        PayloadCompressor::create(codec, PayloadCompressor::Options{}));
+
+    auto const data = compressible(16 * 1024);
+    auto const metadata = compressible(1024);
+    auto serialized = serializer->serializeOut(Frame_PAYLOAD(
+        3, FrameFlags::NEXT, Payload(data, metadata)));
+    EXPECT_LT(serialized->computeChainDataLength(), data.size()) << codec;
+
+    Frame_PAYLOAD frame;
+    ASSERT_TRUE(serializer->deserializeFrom(frame, std::move(serialized)));
+    EXPECT_EQ(data, frame.payload_.cloneDataToString()) << codec;
+    EXPECT_EQ(metadata, frame.payload_.cloneMetadataToString()) << codec;
+
+    // A peer that didn't negotiate compression sees the marker.
+    auto plain =
+        FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+    serialized = serializer->serializeOut(
+        Frame_PAYLOAD(3, FrameFlags::NEXT, Payload("abc")));
+    ASSERT_TRUE(plain->deserializeFrom(frame, std::move(serialized)));
+    EXPECT_EQ(std::string("\0abc", 4), frame.payload_.cloneDataToString());
+  }
+}
@@ -15,6 +15,7 @@
 #include <gtest/gtest.h>
 
 #include <folly/io/async/EventBase.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
 
 #include "rsocket/RSocketConnectionEvents.h"
 #include "rsocket/RSocketResponder.h"
@@ -63,3 +64,23 @@ TEST(ConnectionSet, CloseViaSetDtor) {
   set.insert(machine, &evb);
   machine->registerCloseCallback(&set);
 }
+
+TEST(ConnectionSet, DumpFlightRecordersFromEventBase) {
+  folly::ScopedEventBaseThread worker1;
+  folly::ScopedEventBaseThread worker2;
+  auto machine1 = makeStateMachine(worker1.getEventBase());
+  auto machine2 = makeStateMachine(worker2.getEventBase());
+
+  ConnectionSet set;
+  set.insert(machine1, worker1.getEventBase());
+  machine1->registerCloseCallback(&set);
+  set.insert(machine2, worker2.getEventBase());
+  machine2->registerCloseCallback(&set);
+
+  // The calling thread's state machine is dumped inline, the other one on its
+  // EventBase.
+  std::vector<std::string> dumps;
+  worker1.getEventBase()->runInEventBaseThreadAndWait(
+      [&] { dumps = set.dumpFlightRecorders(); });
+  EXPECT_EQ(2u, dumps.size());
+}
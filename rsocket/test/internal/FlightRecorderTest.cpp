@@ -0,0 +1,121 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "rsocket/framing/Frame.h"
+#include "rsocket/framing/FrameSerializer.h"
+#include "rsocket/internal/FlightRecorder.h"
+
+using namespace rsocket;
+
+namespace {
+
+std::unique_ptr<FrameSerializer> makeSerializer() {
+  return FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+}
+
+} // namespace
+
+TEST(FlightRecorderTest, RecordsFrameHeaders) {
+  auto const serializer = makeSerializer();
+  FlightRecorder recorder;
+
+  auto request = serializer->serializeOut(Frame_REQUEST_STREAM(
+      3, FrameFlags::EMPTY_, 10, Payload("hello", "meta")));
+  auto response = serializer->serializeOut(Frame_PAYLOAD(
+      3, FrameFlags::NEXT | FrameFlags::COMPLETE, Payload("world")));
+
+  recorder.event(FlightRecorder::Event::CONNECTED);
+  recorder.sent(*request);
+  recorder.received(*response);
+  recorder.event(FlightRecorder::Event::CLOSED);
+
+  auto const entries = recorder.entries();
+  ASSERT_EQ(4u, entries.size());
+
+  EXPECT_EQ(FlightRecorder::Kind::EVENT, entries[0].kind);
+  EXPECT_EQ(
+      static_cast<uint16_t>(FlightRecorder::Event::CONNECTED),
+      entries[0].flags);
+
+  EXPECT_EQ(FlightRecorder::Kind::SENT, entries[1].kind);
+  EXPECT_EQ(static_cast<uint8_t>(FrameType::REQUEST_STREAM), entries[1].type);
+  EXPECT_EQ(3u, entries[1].streamId);
+  EXPECT_EQ(raw(FrameFlags::METADATA), entries[1].flags);
+  EXPECT_EQ(request->computeChainDataLength(), entries[1].length);
+
+  EXPECT_EQ(FlightRecorder::Kind::RECEIVED, entries[2].kind);
+  EXPECT_EQ(static_cast<uint8_t>(FrameType::PAYLOAD), entries[2].type);
+  EXPECT_EQ(3u, entries[2].streamId);
+  EXPECT_EQ(raw(FrameFlags::NEXT | FrameFlags::COMPLETE), entries[2].flags);
+
+  EXPECT_EQ(FlightRecorder::Kind::EVENT, entries[3].kind);
+  EXPECT_LE(entries[0].ticks, entries[3].ticks);
+
+  auto const dump = recorder.dump();
+  EXPECT_NE(std::string::npos, dump.find("4 frames and events recorded"));
+  EXPECT_NE(std::string::npos, dump.find("REQUEST_STREAM"));
+  EXPECT_NE(std::string::npos, dump.find("CLOSED"));
+}
+
+TEST(FlightRecorderTest, HeaderSplitAcrossBuffers) {
+  auto const serializer = makeSerializer();
+  FlightRecorder recorder;
+
+  auto frame = serializer->serializeOut(Frame_CANCEL(5));
+  frame->coalesce();
+  auto split = folly::IOBuf::copyBuffer(frame->data(), 3);
+  split->prependChain(
+      folly::IOBuf::copyBuffer(frame->data() + 3, frame->length() - 3));
+
+  recorder.received(*split);
+
+  auto const entries = recorder.entries();
+  ASSERT_EQ(1u, entries.size());
+  EXPECT_EQ(static_cast<uint8_t>(FrameType::CANCEL), entries[0].type);
+  EXPECT_EQ(5u, entries[0].streamId);
+  EXPECT_EQ(frame->length(), entries[0].length);
+}
+
+TEST(FlightRecorderTest, OverwritesOldestEntries) {
+  auto const serializer = makeSerializer();
+  FlightRecorder::Options options;
+  options.capacity = 3;
+  FlightRecorder recorder{options};
+
+  for (StreamId streamId = 1; streamId <= 10; ++streamId) {
+    recorder.sent(*serializer->serializeOut(Frame_REQUEST_N(streamId, 1)));
+  }
+
+  // The capacity is rounded up to a power of two.
+  auto const entries = recorder.entries();
+  ASSERT_EQ(4u, entries.size());
+  for (size_t i = 0; i < entries.size(); ++i) {
+    EXPECT_EQ(7 + i, entries[i].streamId);
+  }
+  EXPECT_NE(
+      std::string::npos, recorder.dump().find("10 frames and events recorded"));
+}
+
+TEST(FlightRecorderTest, Disabled) {
+  FlightRecorder::Options options;
+  options.capacity = 0;
+  FlightRecorder recorder{options};
+
+  recorder.sent(*makeSerializer()->serializeOut(Frame_CANCEL(1)));
+  recorder.event(FlightRecorder::Event::CLOSED);
+
+  EXPECT_TRUE(recorder.entries().empty());
+}
@@ -17,6 +17,7 @@
 #include <folly/io/async/ScopedEventBaseThread.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <thread>
 
 #include "rsocket/framing/Frame.h"
 #include "rsocket/framing/FramedDuplexConnection.h"
@@ -83,3 +84,82 @@ TEST(FollyKeepaliveTimerTest, NoResponse) {
 
   timer.stop();
 }
+
+TEST(FollyKeepaliveTimerTest, StoppedWhileSendingKeepalive) {
+  auto connection = std::make_shared<StrictMock<MockConnectionAutomaton>>();
+
+  folly::EventBase eventBase;
+  auto const wheel = KeepaliveTimerWheel::forEventBase(eventBase);
+  auto const now = KeepaliveTimerWheel::Clock::now();
+
+  KeepaliveTimer timer(std::chrono::milliseconds(100), eventBase);
+  timer.start(connection);
+
+  // E.g. the connection closes because sending the keepalive failed.
+  EXPECT_CALL(*connection, sendKeepalive_(_)).WillOnce(Invoke([&](auto&) {
+    timer.stop();
+  }));
+  wheel->expire(now + std::chrono::milliseconds(200));
+  Mock::VerifyAndClearExpectations(connection.get());
+
+  // The stopped timer isn't scheduled again, so it never fires.
+  EXPECT_EQ(0u, wheel->scheduled());
+  wheel->expire(now + std::chrono::milliseconds(400));
+}
+
+TEST(FollyKeepaliveTimerTest, ActivityPushesKeepaliveBack) {
+  auto connection = std::make_shared<StrictMock<MockConnectionAutomaton>>();
+
+  folly::EventBase eventBase;
+  auto const wheel = KeepaliveTimerWheel::forEventBase(eventBase);
+  auto const now = KeepaliveTimerWheel::Clock::now();
+
+  KeepaliveTimer timer(std::chrono::milliseconds(100), eventBase);
+  timer.start(connection);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+  timer.activity();
+
+  // The keepalive would have been due by now without the activity.
+  wheel->expire(now + std::chrono::milliseconds(130));
+  EXPECT_EQ(1u, wheel->scheduled());
+
+  EXPECT_CALL(*connection, sendKeepalive_(_));
+  wheel->expire(now + std::chrono::milliseconds(300));
+  Mock::VerifyAndClearExpectations(connection.get());
+
+  timer.stop();
+}
+
+TEST(FollyKeepaliveTimerTest, SharedWheel) {
+  auto connection1 = std::make_shared<StrictMock<MockConnectionAutomaton>>();
+  auto connection2 = std::make_shared<StrictMock<MockConnectionAutomaton>>();
+
+  folly::EventBase eventBase;
+  auto const wheel = KeepaliveTimerWheel::forEventBase(eventBase);
+  auto const now = KeepaliveTimerWheel::Clock::now();
+
+  KeepaliveTimer timer1(std::chrono::milliseconds(100), eventBase);
+  KeepaliveTimer timer2(std::chrono::milliseconds(100), eventBase);
+  timer1.start(connection1);
+  timer2.start(connection2);
+  EXPECT_EQ(2u, wheel->scheduled());
+
+  // Not due yet.
+  wheel->expire(now + std::chrono::milliseconds(50));
+  EXPECT_EQ(2u, wheel->scheduled());
+
+  EXPECT_CALL(*connection1, sendKeepalive_(_));
+  EXPECT_CALL(*connection2, sendKeepalive_(_));
+  wheel->expire(now + std::chrono::milliseconds(200));
+  Mock::VerifyAndClearExpectations(connection1.get());
+  Mock::VerifyAndClearExpectations(connection2.get());
+  EXPECT_EQ(2u, wheel->scheduled());
+
+  // A stopped timer doesn't fire anymore, the other one gets no response.
+  timer2.stop();
+  EXPECT_EQ(1u, wheel->scheduled());
+  EXPECT_CALL(*connection1, disconnectOrCloseWithError_(_));
+  wheel->expire(now + std::chrono::milliseconds(400));
+  EXPECT_EQ(0u, wheel->scheduled());
+}
@@ -0,0 +1,140 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventBaseManager.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "rsocket/internal/StatsBatch.h"
+
+using namespace rsocket;
+
+namespace {
+
+/// Records every call it gets.
+class RecordingStats : public RSocketStats {
+ public:
+  explicit RecordingStats(bool batched) : batched_{batched} {}
+
+  bool acceptsBatchedCounts() const override {
+    return batched_;
+  }
+
+  void frameRead(FrameType type) override {
+    readFrames.emplace_back(type, 1);
+  }
+
+  void framesRead(FrameType type, size_t count) override {
+    readFrames.emplace_back(type, count);
+  }
+
+  void bytesRead(size_t bytes) override {
+    readBytes.push_back(bytes);
+  }
+
+  void streamBufferChanged(int64_t frames, int64_t bytes) override {
+    streamBufferDeltas.emplace_back(frames, bytes);
+  }
+
+  std::vector<std::pair<FrameType, size_t>> readFrames;
+  std::vector<size_t> readBytes;
+  std::vector<std::pair<int64_t, int64_t>> streamBufferDeltas;
+
+ private:
+  const bool batched_;
+};
+
+using FrameCounts = std::vector<std::pair<FrameType, size_t>>;
+
+} // namespace
+
+TEST(StatsBatchTest, FlushesAtTheEndOfTheLoop) {
+  auto const stats = std::make_shared<RecordingStats>(true);
+  StatsBatch batch{stats};
+
+  folly::EventBase evb;
+  folly::EventBaseManager::get()->setEventBase(&evb, false);
+
+  evb.runInLoop([&] {
+    batch.frameRead(FrameType::PAYLOAD);
+    batch.frameRead(FrameType::REQUEST_N);
+    batch.frameRead(FrameType::PAYLOAD);
+    batch.bytesRead(10);
+    batch.bytesRead(5);
+    batch.streamBufferChanged(2, 100);
+    batch.streamBufferChanged(-1, -40);
+
+    EXPECT_TRUE(stats->readFrames.empty());
+    EXPECT_TRUE(stats->readBytes.empty());
+  });
+  evb.loop();
+
+  EXPECT_EQ(
+      stats->readFrames,
+      FrameCounts({{FrameType::REQUEST_N, 1}, {FrameType::PAYLOAD, 2}}));
+  EXPECT_EQ(stats->readBytes, std::vector<size_t>({15}));
+  EXPECT_EQ(
+      stats->streamBufferDeltas,
+      (std::vector<std::pair<int64_t, int64_t>>{{1, 60}}));
+
+  folly::EventBaseManager::get()->clearEventBase();
+}
+
+TEST(StatsBatchTest, FlushDeliversPendingCounts) {
+  auto const stats = std::make_shared<RecordingStats>(true);
+  StatsBatch batch{stats};
+
+  folly::EventBase evb;
+  folly::EventBaseManager::get()->setEventBase(&evb, false);
+
+  evb.runInLoop([&] {
+    batch.frameRead(FrameType::PAYLOAD);
+    batch.flush();
+    EXPECT_EQ(stats->readFrames, FrameCounts({{FrameType::PAYLOAD, 1}}));
+  });
+  evb.loop();
+
+  // Nothing is delivered twice.
+  EXPECT_EQ(stats->readFrames.size(), 1ULL);
+
+  folly::EventBaseManager::get()->clearEventBase();
+}
+
+TEST(StatsBatchTest, CallsUnbatchedStatsDirectly) {
+  auto const stats = std::make_shared<RecordingStats>(false);
+  StatsBatch batch{stats};
+
+  batch.frameRead(FrameType::PAYLOAD);
+  batch.frameRead(FrameType::PAYLOAD);
+  batch.bytesRead(10);
+
+  EXPECT_EQ(
+      stats->readFrames,
+      FrameCounts({{FrameType::PAYLOAD, 1}, {FrameType::PAYLOAD, 1}}));
+  EXPECT_EQ(stats->readBytes, std::vector<size_t>({10}));
+}
+
+TEST(StatsBatchTest, FlushesRightAwayWithoutEventBase) {
+  auto const stats = std::make_shared<RecordingStats>(true);
+
+  std::thread{[&] {
+    StatsBatch batch{stats};
+    batch.frameRead(FrameType::CANCEL);
+    EXPECT_EQ(stats->readFrames, FrameCounts({{FrameType::CANCEL, 1}}));
+  }}.join();
+}
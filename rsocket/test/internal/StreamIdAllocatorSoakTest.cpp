@@ -0,0 +1,102 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/StreamIdAllocator.h"
+
+#include <folly/portability/GFlags.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+
+DEFINE_bool(
+    full_soak,
+    false,
+    "go through the whole stream ID space instead of a 512th of it");
+
+using namespace rsocket;
+
+namespace {
+
+StreamIdAllocator::Clock::time_point fakeTime;
+
+StreamIdAllocator::Clock::time_point fakeNow() {
+  return fakeTime;
+}
+
+} // namespace
+
+// Hands out IDs for a little more than two rounds through the whole ID space,
+// about 2.2 billion of them, at a pace of 100k streams per second.  A couple of
+// streams stay open all the time, and others live for almost a whole round, so
+// they are closed just before their IDs come up again.
+//
+// That takes a while, so by default the ID space is shrunk 512 times, and the
+// pace slowed down as much so that a round takes as long.  Run with
+// --full_soak for the real thing.
+TEST(StreamIdAllocatorSoakTest, TwoRounds) {
+  fakeTime = {};
+  constexpr std::chrono::seconds kQuarantine{30};
+  constexpr StreamId kShrink = 512;
+  auto const limit = FLAGS_full_soak ? StreamIdAllocator::kLimit
+                                     : StreamIdAllocator::kLimit / kShrink;
+  auto const pace =
+      std::chrono::microseconds{10} * (StreamIdAllocator::kLimit / limit);
+  StreamIdAllocator allocator{1, limit, kQuarantine, &fakeNow};
+
+  const uint64_t ids = limit / 2;
+  const uint64_t allocations = ids * 2 + ids / 16;
+  constexpr size_t kLongLived = 4;
+  const uint64_t replaceEvery = (ids - 1000) / kLongLived;
+
+  std::array<StreamId, 2> forever{};
+  std::array<StreamId, kLongLived> longLived{};
+  std::array<std::pair<StreamId, StreamIdAllocator::Clock::time_point>,
+             kLongLived>
+      closed{};
+
+  auto const inUse = [&](StreamId id) {
+    return std::find(forever.begin(), forever.end(), id) != forever.end() ||
+        std::find(longLived.begin(), longLived.end(), id) != longLived.end();
+  };
+
+  uint64_t violations = 0;
+  for (uint64_t i = 0; i < allocations; ++i) {
+    fakeTime += pace;
+    auto const id = allocator.allocate(inUse);
+    ASSERT_TRUE(id);
+    for (const auto& entry : closed) {
+      if (entry.first == *id && fakeTime - entry.second < kQuarantine) {
+        ++violations;
+      }
+    }
+
+    if (i < forever.size()) {
+      forever[i] = *id;
+    } else if (i % replaceEvery == 0) {
+      auto const slot = (i / replaceEvery) % kLongLived;
+      if (longLived[slot]) {
+        allocator.release(longLived[slot]);
+        closed[slot] = {longLived[slot], fakeTime};
+      }
+      longLived[slot] = *id;
+    } else {
+      allocator.release(*id);
+    }
+  }
+
+  EXPECT_EQ(0u, violations);
+  EXPECT_TRUE(allocator.wrapped());
+  EXPECT_LE(allocator.quarantined(), kLongLived);
+}
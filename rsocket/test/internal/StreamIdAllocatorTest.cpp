@@ -0,0 +1,104 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/StreamIdAllocator.h"
+
+#include <gtest/gtest.h>
+
+using namespace rsocket;
+
+namespace {
+
+StreamIdAllocator::Clock::time_point fakeTime;
+
+StreamIdAllocator::Clock::time_point fakeNow() {
+  return fakeTime;
+}
+
+bool noneInUse(StreamId) {
+  return false;
+}
+
+} // namespace
+
+TEST(StreamIdAllocatorTest, StartsOverWhenRunningOut) {
+  StreamIdAllocator allocator{1, 9};
+
+  for (StreamId expected : {1, 3, 5, 7}) {
+    EXPECT_EQ(expected, allocator.allocate(noneInUse));
+  }
+  EXPECT_FALSE(allocator.wrapped());
+
+  EXPECT_EQ(1u, allocator.allocate(noneInUse));
+  EXPECT_TRUE(allocator.wrapped());
+}
+
+TEST(StreamIdAllocatorTest, SkipsIdsInUse) {
+  StreamIdAllocator allocator{2, 10};
+
+  for (int i = 0; i < 4; ++i) {
+    allocator.allocate(noneInUse);
+  }
+  auto const inUse = [](StreamId id) { return id == 2 || id == 6; };
+  EXPECT_EQ(4u, allocator.allocate(inUse));
+  EXPECT_EQ(8u, allocator.allocate(inUse));
+  EXPECT_EQ(4u, allocator.allocate(inUse));
+}
+
+TEST(StreamIdAllocatorTest, RunsOutWhenAllInUse) {
+  StreamIdAllocator allocator{1, 9};
+
+  EXPECT_FALSE(allocator.allocate([](StreamId) { return true; }));
+  EXPECT_EQ(1u, allocator.allocate(noneInUse));
+}
+
+TEST(StreamIdAllocatorTest, QuarantinesClosedIds) {
+  fakeTime = {};
+  StreamIdAllocator allocator{1, 11, std::chrono::seconds{1}, &fakeNow};
+
+  for (StreamId expected : {1, 3, 5, 7}) {
+    EXPECT_EQ(expected, allocator.allocate(noneInUse));
+  }
+
+  // Comes up again only after most of the other IDs.
+  allocator.release(7);
+  EXPECT_EQ(0u, allocator.quarantined());
+
+  // Comes up again next but one.
+  allocator.release(1);
+  EXPECT_EQ(1u, allocator.quarantined());
+
+  EXPECT_EQ(9u, allocator.allocate(noneInUse));
+  EXPECT_EQ(3u, allocator.allocate(noneInUse));
+  EXPECT_EQ(0u, allocator.quarantined());
+
+  // Once the quarantine passed the ID is reused.
+  allocator.release(5);
+  fakeTime += std::chrono::seconds{1};
+  EXPECT_EQ(5u, allocator.allocate(noneInUse));
+}
+
+TEST(StreamIdAllocatorTest, SkipPast) {
+  StreamIdAllocator allocator{2, 20};
+
+  allocator.skipPast(0);
+  EXPECT_EQ(2u, allocator.allocate(noneInUse));
+
+  allocator.skipPast(7);
+  EXPECT_EQ(8u, allocator.allocate(noneInUse));
+
+  allocator.skipPast(18);
+  EXPECT_EQ(2u, allocator.allocate(noneInUse));
+  EXPECT_TRUE(allocator.wrapped());
+}
@@ -0,0 +1,131 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/json.h>
+#include <gtest/gtest.h>
+
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "rsocket/internal/Tracing.h"
+
+using namespace rsocket;
+
+namespace {
+
+/// The complete ("X") events of an exported trace.
+std::vector<folly::dynamic> exportSpans() {
+  auto const trace = folly::parseJson(Tracer::exportChromeTrace());
+  std::vector<folly::dynamic> spans;
+  for (auto const& event : trace["traceEvents"]) {
+    if (event["ph"] == "X") {
+      spans.push_back(event);
+    }
+  }
+  return spans;
+}
+
+} // namespace
+
+TEST(TracingTest, ExportsChromeTrace) {
+  Tracer::start();
+  auto const begin = Tracer::Clock::now();
+  Tracer::record(
+      "handleFrame", 7, begin, begin + std::chrono::microseconds{1500});
+  {
+    TraceSpan span{"write", 9};
+  }
+  Tracer::stop();
+
+  auto const spans = exportSpans();
+  ASSERT_EQ(spans.size(), 2ULL);
+
+  EXPECT_EQ(spans[0]["name"], "handleFrame");
+  EXPECT_EQ(spans[0]["cat"], "rsocket");
+  EXPECT_EQ(spans[0]["args"]["stream"], 7);
+  EXPECT_DOUBLE_EQ(spans[0]["dur"].asDouble(), 1500.0);
+  EXPECT_GE(spans[0]["ts"].asDouble(), 0.0);
+
+  EXPECT_EQ(spans[1]["name"], "write");
+  EXPECT_EQ(spans[1]["args"]["stream"], 9);
+  EXPECT_EQ(spans[1]["tid"], spans[0]["tid"]);
+}
+
+TEST(TracingTest, RecordsNothingWhenStopped) {
+  Tracer::start();
+  Tracer::stop();
+
+  TraceSpan span{"ignored", 1};
+  auto const now = Tracer::Clock::now();
+  Tracer::record("ignored", 1, now, now);
+
+  EXPECT_TRUE(exportSpans().empty());
+}
+
+TEST(TracingTest, StartDiscardsPreviousSpans) {
+  Tracer::start();
+  auto const now = Tracer::Clock::now();
+  Tracer::record("first", 1, now, now);
+  Tracer::start();
+  Tracer::record("second", 3, now, now);
+  Tracer::stop();
+
+  auto const spans = exportSpans();
+  ASSERT_EQ(spans.size(), 1ULL);
+  EXPECT_EQ(spans[0]["name"], "second");
+}
+
+TEST(TracingTest, DropsSpansPastCapacity) {
+  Tracer::start(4);
+  auto const now = Tracer::Clock::now();
+  for (int i = 0; i < 10; ++i) {
+    Tracer::record("span", i, now, now);
+  }
+  Tracer::stop();
+
+  auto const spans = exportSpans();
+  ASSERT_EQ(spans.size(), 4ULL);
+  EXPECT_EQ(spans.back()["args"]["stream"], 3);
+}
+
+TEST(TracingTest, KeepsThreadsApart) {
+  constexpr size_t kThreads = 4;
+  constexpr size_t kSpans = 1000;
+
+  Tracer::start(kSpans);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kThreads; ++i) {
+    threads.emplace_back([] {
+      for (size_t j = 0; j < kSpans; ++j) {
+        TraceSpan span{"span", static_cast<StreamId>(j)};
+      }
+    });
+  }
+  // Exporting while the threads record is allowed.
+  Tracer::exportChromeTrace();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  Tracer::stop();
+
+  auto const spans = exportSpans();
+  EXPECT_EQ(spans.size(), kThreads * kSpans);
+
+  std::set<int64_t> tids;
+  for (auto const& span : spans) {
+    tids.insert(span["tid"].asInt());
+  }
+  EXPECT_EQ(tids.size(), kThreads);
+}
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "rsocket/statemachine/RSocketStateMachine.h"
+#include <folly/Conv.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <yarpl/single/SingleSubscriptions.h>
@@ -23,6 +24,7 @@
 #include "rsocket/framing/FrameSerializer_v1_0.h"
 #include "rsocket/framing/FrameTransportImpl.h"
 #include "rsocket/internal/Common.h"
+#include "rsocket/internal/WarmResumeManager.h"
 #include "rsocket/statemachine/ChannelRequester.h"
 #include "rsocket/statemachine/ChannelResponder.h"
 #include "rsocket/statemachine/RequestResponseResponder.h"
@@ -68,6 +70,35 @@ class ResponderMock : public RSocketResponder {
   }
 };
 
+/// Answers stream requests with the items the test hands to `subscriber`.
+class PublishingResponder : public RSocketResponder {
+ public:
+  std::shared_ptr<yarpl::flowable::Flowable<Payload>> handleRequestStream(
+      Payload,
+      StreamId) override {
+    return yarpl::flowable::internal::flowableFromSubscriber<Payload>(
+        [this](std::shared_ptr<yarpl::flowable::Subscriber<Payload>> s) {
+          subscriber = s;
+          s->onSubscribe(subscription);
+        });
+  }
+
+  const std::shared_ptr<NiceMock<MockSubscription>> subscription{
+      std::make_shared<NiceMock<MockSubscription>>()};
+  std::shared_ptr<yarpl::flowable::Subscriber<Payload>> subscriber;
+};
+
+/// A connection that appends the frames sent over it to `frames`.
+std::unique_ptr<MockDuplexConnection> recordingConnection(
+    std::vector<std::unique_ptr<folly::IOBuf>>& frames) {
+  auto connection = std::make_unique<NiceMock<MockDuplexConnection>>();
+  ON_CALL(*connection, send_(_))
+      .WillByDefault(Invoke([&frames](std::unique_ptr<folly::IOBuf>& frame) {
+        frames.push_back(std::move(frame));
+      }));
+  return connection;
+}
+
 struct ConnectionEventsMock : public RSocketConnectionEvents {
   MOCK_METHOD1(onDisconnected, void(const folly::exception_wrapper&));
   MOCK_METHOD0(onStreamsPaused, void());
@@ -105,7 +136,9 @@ class RSocketStateMachineTest : public Test {
       std::unique_ptr<MockDuplexConnection> connection,
       std::shared_ptr<RSocketResponder> responder,
       folly::Optional<ResumeIdentificationToken> resumeToken = folly::none,
-      std::shared_ptr<RSocketConnectionEvents> connectionEvents = nullptr) {
+      std::shared_ptr<RSocketConnectionEvents> connectionEvents = nullptr,
+      std::shared_ptr<ResumeManager> resumeManager =
+          ResumeManager::makeEmpty()) {
     auto transport =
         std::make_shared<FrameTransportImpl>(std::move(connection));
 
@@ -115,7 +148,7 @@ class RSocketStateMachineTest : public Test {
         RSocketMode::SERVER,
         nullptr,
         std::move(connectionEvents),
-        ResumeManager::makeEmpty(),
+        std::move(resumeManager),
         nullptr);
 
     if (resumeToken) {
@@ -137,6 +170,12 @@ class RSocketStateMachineTest : public Test {
     return stateMachine.streams_;
   }
 
+  bool registerNewPeerStreamId(
+      RSocketStateMachine& stateMachine,
+      StreamId streamId) {
+    return stateMachine.registerNewPeerStreamId(streamId);
+  }
+
   void setupRequestStream(
       RSocketStateMachine& stateMachine,
       StreamId streamId,
@@ -427,4 +466,156 @@ TEST_F(RSocketStateMachineTest, ResumeWithCurrentConnection) {
   stateMachine->close({}, StreamCompletionSignal::CONNECTION_END);
 }
 
+TEST_F(RSocketStateMachineTest, PendingOutputOverflowDropsStream) {
+  auto const resumeToken = ResumeIdentificationToken::generateNew();
+  auto const responder = std::make_shared<PublishingResponder>();
+  std::vector<std::unique_ptr<folly::IOBuf>> sent;
+  auto stateMachine =
+      createServer(recordingConnection(sent), responder, resumeToken);
+
+  PendingOutputLimits limits;
+  limits.maxFrames = 4;
+  limits.overflow = PendingOutputOverflow::DROP_STREAM;
+  stateMachine->setPendingOutputLimits(limits);
+
+  setupRequestStream(*stateMachine, 1, 100, Payload{});
+  ASSERT_TRUE(responder->subscriber);
+  stateMachine->disconnect(std::runtime_error("Test triggered disconnect"));
+
+  // The fifth item overflows the queue.
+  EXPECT_CALL(*responder->subscription, cancel_());
+  for (int i = 0; i < 5; ++i) {
+    responder->subscriber->onNext(Payload("item"));
+  }
+  Mock::VerifyAndClearExpectations(responder->subscription.get());
+  EXPECT_TRUE(getStreams(*stateMachine).empty());
+
+  sent.clear();
+  stateMachine->resumeServer(
+      std::make_shared<FrameTransportImpl>(recordingConnection(sent)),
+      ResumeParameters(resumeToken, 0, 0, ProtocolVersion::Latest));
+
+  // The peer gets none of the queued items, and learns the stream is gone.
+  FrameSerializerV1_0 serializer;
+  ASSERT_EQ(2, sent.size());
+  EXPECT_EQ(FrameType::RESUME_OK, serializer.peekFrameType(*sent[0]));
+  Frame_ERROR error;
+  ASSERT_TRUE(serializer.deserializeFrom(error, std::move(sent[1])));
+  EXPECT_EQ(1, error.header_.streamId);
+  EXPECT_EQ(ErrorCode::CANCELED, error.errorCode_);
+
+  stateMachine->close({}, StreamCompletionSignal::CONNECTION_END);
+}
+
+TEST_F(RSocketStateMachineTest, PendingOutputOverflowSpillsToResumeManager) {
+  auto const resumeToken = ResumeIdentificationToken::generateNew();
+  auto const responder = std::make_shared<PublishingResponder>();
+  auto const resumeManager =
+      std::make_shared<WarmResumeManager>(RSocketStats::noop());
+  std::vector<std::unique_ptr<folly::IOBuf>> sent;
+  auto stateMachine = createServer(
+      recordingConnection(sent),
+      responder,
+      resumeToken,
+      nullptr,
+      resumeManager);
+
+  PendingOutputLimits limits;
+  limits.maxFrames = 4;
+  limits.overflow = PendingOutputOverflow::SPILL_TO_RESUME_MANAGER;
+  stateMachine->setPendingOutputLimits(limits);
+
+  setupRequestStream(*stateMachine, 1, 100, Payload{});
+  ASSERT_TRUE(responder->subscriber);
+
+  // The peer got the first items before the connection dropped.
+  constexpr int kSentItems = 2;
+  constexpr int kItems = 13;
+  for (int i = 0; i < kSentItems; ++i) {
+    responder->subscriber->onNext(Payload(folly::to<std::string>(i)));
+  }
+  auto const peerPosition = resumeManager->lastSentPosition();
+  stateMachine->disconnect(std::runtime_error("Test triggered disconnect"));
+
+  // Overflows twice, leaving the last item queued.
+  EXPECT_CALL(*responder->subscription, cancel_()).Times(0);
+  for (int i = kSentItems; i < kItems; ++i) {
+    responder->subscriber->onNext(Payload(folly::to<std::string>(i)));
+  }
+  Mock::VerifyAndClearExpectations(responder->subscription.get());
+  EXPECT_EQ(1, getStreams(*stateMachine).size());
+
+  sent.clear();
+  stateMachine->resumeServer(
+      std::make_shared<FrameTransportImpl>(recordingConnection(sent)),
+      ResumeParameters(resumeToken, peerPosition, 0, ProtocolVersion::Latest));
+
+  // The peer gets every item it missed, in order.
+  FrameSerializerV1_0 serializer;
+  ASSERT_EQ(1 + kItems - kSentItems, sent.size());
+  EXPECT_EQ(FrameType::RESUME_OK, serializer.peekFrameType(*sent[0]));
+  for (int i = kSentItems; i < kItems; ++i) {
+    Frame_PAYLOAD payload;
+    ASSERT_TRUE(serializer.deserializeFrom(
+        payload, std::move(sent[1 + i - kSentItems])));
+    EXPECT_EQ(1, payload.header_.streamId);
+    EXPECT_EQ(folly::to<std::string>(i), payload.payload_.moveDataToString());
+  }
+
+  stateMachine->close({}, StreamCompletionSignal::CONNECTION_END);
+}
+
 } // namespace rsocket
+
+TEST_F(RSocketStateMachineTest, PeerStreamIdWrapsAround) {
+  auto stateMachine = createServer(
+      std::make_unique<NiceMock<MockDuplexConnection>>(),
+      std::make_shared<RSocketResponder>());
+
+  EXPECT_TRUE(registerNewPeerStreamId(*stateMachine, 5));
+  EXPECT_TRUE(
+      registerNewPeerStreamId(*stateMachine, StreamIdAllocator::kLimit));
+
+  // The peer ran out of IDs and started over from the bottom.
+  EXPECT_TRUE(registerNewPeerStreamId(*stateMachine, 1));
+  EXPECT_TRUE(registerNewPeerStreamId(*stateMachine, 3));
+
+  stateMachine->close({}, StreamCompletionSignal::CONNECTION_END);
+}
+
+TEST_F(RSocketStateMachineTest, LatePeerStreamIdRejected) {
+  auto stateMachine = createServer(
+      std::make_unique<NiceMock<MockDuplexConnection>>(),
+      std::make_shared<RSocketResponder>());
+
+  EXPECT_TRUE(registerNewPeerStreamId(*stateMachine, 7));
+
+  // Anything at or just below the last ID is for a stream that is gone.
+  EXPECT_FALSE(registerNewPeerStreamId(*stateMachine, 5));
+  EXPECT_FALSE(registerNewPeerStreamId(*stateMachine, 7));
+
+  // The server allocates the even IDs itself.
+  EXPECT_FALSE(registerNewPeerStreamId(*stateMachine, 8));
+
+  EXPECT_TRUE(registerNewPeerStreamId(*stateMachine, 9));
+
+  stateMachine->close({}, StreamCompletionSignal::CONNECTION_END);
+}
+
+TEST_F(RSocketStateMachineTest, OpenPeerStreamIdRejected) {
+  auto const responder = std::make_shared<PublishingResponder>();
+  auto stateMachine = createServer(
+      std::make_unique<NiceMock<MockDuplexConnection>>(), responder);
+
+  setupRequestStream(*stateMachine, 1, 100, Payload{});
+  ASSERT_EQ(1, getStreams(*stateMachine).count(1));
+
+  EXPECT_TRUE(
+      registerNewPeerStreamId(*stateMachine, StreamIdAllocator::kLimit));
+
+  // After wrapping around the peer must skip the IDs still in use.
+  EXPECT_FALSE(registerNewPeerStreamId(*stateMachine, 1));
+  EXPECT_TRUE(registerNewPeerStreamId(*stateMachine, 3));
+
+  stateMachine->close({}, StreamCompletionSignal::CONNECTION_END);
+}
@@ -152,3 +152,25 @@ TEST(StreamResponder, EndStream) {
   responder->endStream(StreamCompletionSignal::SOCKET_CLOSED);
   ASSERT_TRUE(responder->publisherClosed());
 }
+
+TEST(StreamResponder, PausedWhileUnwritable) {
+  auto writer = std::make_shared<StrictMock<MockStreamsWriter>>();
+  auto responder = std::make_shared<StreamResponder>(writer, 1u, 2);
+
+  EXPECT_CALL(*writer, onStreamClosed(1u));
+
+  auto subscription = std::make_shared<StrictMock<MockSubscription>>();
+
+  // Credits are held back while the connection is unwritable.
+  responder->onWritabilityChanged(false);
+  responder->onSubscribe(subscription);
+  responder->handleRequestN(3);
+  Mock::VerifyAndClearExpectations(subscription.get());
+
+  EXPECT_CALL(*subscription, request_(5));
+  EXPECT_CALL(*subscription, cancel_());
+  responder->onWritabilityChanged(true);
+
+  responder->handleCancel();
+  ASSERT_TRUE(responder->publisherClosed());
+}
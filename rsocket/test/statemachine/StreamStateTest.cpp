@@ -18,6 +18,7 @@
 #include "rsocket/internal/Common.h"
 #include "rsocket/statemachine/ChannelRequester.h"
 #include "rsocket/statemachine/ChannelResponder.h"
+#include "rsocket/statemachine/StreamRequester.h"
 #include "rsocket/statemachine/StreamStateMachineBase.h"
 #include "rsocket/test/test_utils/MockStreamsWriter.h"
 
@@ -330,3 +331,61 @@ TEST(StreamState, ChannelResponderHandleCancel) {
   auto consumerSubscription = mockSubscriber->subscription();
   consumerSubscription->cancel();
 }
+
+TEST(StreamState, StreamRequesterChunks) {
+  auto writer = std::make_shared<StrictMock<MockStreamsWriter>>();
+  auto requester =
+      std::make_shared<StreamRequester>(writer, 1u, Payload("request"));
+
+  EXPECT_CALL(*writer, writeNewStream_(1u, StreamType::STREAM, 2u, _));
+  EXPECT_CALL(*writer, onStreamClosed(1u));
+
+  std::vector<std::pair<std::string, bool>> chunks;
+  auto mockSubscriber =
+      std::make_shared<StrictMock<MockSubscriber<PayloadChunk>>>(2);
+  EXPECT_CALL(*mockSubscriber, onSubscribe_(_));
+  EXPECT_CALL(*mockSubscriber, onNext_(_))
+      .Times(3)
+      .WillRepeatedly(Invoke([&](const PayloadChunk& chunk) {
+        chunks.emplace_back(chunk.payload.cloneDataToString(), chunk.last);
+      }));
+  EXPECT_CALL(*mockSubscriber, onComplete_());
+  requester->subscribe(mockSubscriber);
+
+  requester->handlePayload(Payload("ab"), false, true, true);
+  requester->handlePayload(Payload("cd"), false, true, false);
+  // Out of chunk credits, the next fragment is held back.
+  requester->handlePayload(Payload("ef"), true, true, false);
+  EXPECT_EQ(2u, chunks.size());
+
+  // One payload is still in flight, so no further REQUEST_N is needed.
+  mockSubscriber->subscription()->request(1);
+
+  const std::vector<std::pair<std::string, bool>> expected{
+      {"ab", false}, {"cd", true}, {"ef", true}};
+  EXPECT_EQ(expected, chunks);
+}
+
+TEST(StreamState, StreamRequesterReassemblyLimit) {
+  auto writer = std::make_shared<StrictMock<MockStreamsWriter>>();
+  writer->maxReassemblySize_ = 4;
+  auto requester =
+      std::make_shared<StreamRequester>(writer, 1u, Payload("request"));
+
+  EXPECT_CALL(*writer, writeNewStream_(1u, StreamType::STREAM, _, _));
+  EXPECT_CALL(*writer, writeError_(_));
+  EXPECT_CALL(*writer, onStreamClosed(1u));
+
+  auto mockSubscriber =
+      std::make_shared<StrictMock<MockSubscriber<Payload>>>(1);
+  EXPECT_CALL(*mockSubscriber, onSubscribe_(_));
+  EXPECT_CALL(*mockSubscriber, onNext_(_)).Times(0);
+  EXPECT_CALL(*mockSubscriber, onError_(_));
+  requester->subscribe(mockSubscriber);
+
+  requester->handlePayload(Payload("abc"), false, true, true);
+  ASSERT_FALSE(requester->consumerClosed());
+
+  requester->handlePayload(Payload("de"), false, true, true);
+  ASSERT_TRUE(requester->consumerClosed());
+}
@@ -84,3 +84,55 @@ TEST(StreamsWriterTest, FlushQueuedFrames) {
   // it will not send the pending frames twice
   impl.sendPendingFrames();
 }
+
+TEST(StreamsWriterTest, PauseWhilePendingOutputFills) {
+  auto writer = std::make_shared<StrictMock<MockStreamsWriterImpl>>();
+  writer->shouldQueue_ = true;
+
+  PendingOutputLimits limits;
+  limits.maxFrames = 4;
+  writer->setPendingOutputLimits(limits);
+
+  EXPECT_CALL(*writer, shouldQueue()).Times(AtLeast(1));
+  EXPECT_CALL(*writer, outputFrame_(_)).Times(0);
+  EXPECT_CALL(*writer, onPendingOutputFull(true));
+
+  // Producers are paused at half of the limit.
+  for (StreamId id = 1; id <= 3; id += 2) {
+    writer->writeCancel(Frame_CANCEL{id});
+  }
+  Mock::VerifyAndClearExpectations(writer.get());
+
+  // Frames that were already on their way fill the rest of the queue.
+  EXPECT_CALL(*writer, shouldQueue()).Times(AtLeast(1));
+  EXPECT_CALL(*writer, onPendingOutputOverflow_(_));
+  for (StreamId id = 5; id <= 9; id += 2) {
+    writer->writeCancel(Frame_CANCEL{id});
+  }
+  Mock::VerifyAndClearExpectations(writer.get());
+
+  // Producers are resumed only after the queued frames were written.
+  writer->shouldQueue_ = false;
+  Sequence seq;
+  EXPECT_CALL(*writer, shouldQueue()).Times(4);
+  EXPECT_CALL(*writer, outputFrame_(_)).Times(4).InSequence(seq);
+  EXPECT_CALL(*writer, onPendingOutputFull(false)).InSequence(seq);
+  writer->sendPendingFrames();
+}
+
+TEST(StreamsWriterTest, DropPendingOutputFrames) {
+  auto writer = std::make_shared<StrictMock<MockStreamsWriterImpl>>();
+  writer->shouldQueue_ = true;
+
+  EXPECT_CALL(*writer, shouldQueue()).Times(3);
+  writer->writeCancel(Frame_CANCEL{1});
+  writer->writeCancel(Frame_CANCEL{3});
+  writer->writeCancel(Frame_CANCEL{1});
+
+  writer->dropPendingOutputFrames(1);
+
+  writer->shouldQueue_ = false;
+  EXPECT_CALL(*writer, shouldQueue());
+  EXPECT_CALL(*writer, outputFrame_(_));
+  writer->sendPendingFrames();
+}
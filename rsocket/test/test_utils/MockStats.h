@@ -39,9 +39,13 @@ class MockStats : public RSocketStats {
 
   MOCK_METHOD1(bytesWritten, void(size_t));
   MOCK_METHOD1(bytesRead, void(size_t));
+  MOCK_METHOD1(zeroCopyRequested, void(size_t));
+  MOCK_METHOD1(zeroCopyFallback, void(size_t));
+  MOCK_METHOD1(metadataBytesSaved, void(size_t));
   MOCK_METHOD1(frameWritten, void(FrameType));
   MOCK_METHOD1(frameRead, void(FrameType));
   MOCK_METHOD2(resumeBufferChanged, void(int, int));
   MOCK_METHOD2(streamBufferChanged, void(int64_t, int64_t));
+  MOCK_METHOD0(pendingOutputOverflow, void());
 };
 } // namespace rsocket
@@ -18,6 +18,7 @@
 
 #include "rsocket/RSocketStats.h"
 #include "rsocket/framing/FrameSerializer_v1_0.h"
+#include "rsocket/internal/StatsBatch.h"
 #include "rsocket/statemachine/StreamsWriter.h"
 
 namespace rsocket {
@@ -27,6 +28,8 @@ class MockStreamsWriterImpl : public StreamsWriterImpl {
   MOCK_METHOD1(onStreamClosed, void(StreamId));
   MOCK_METHOD1(outputFrame_, void(folly::IOBuf*));
   MOCK_METHOD0(shouldQueue, bool());
+  MOCK_METHOD1(onPendingOutputFull, void(bool));
+  MOCK_METHOD1(onPendingOutputOverflow_, void(folly::IOBuf*));
 
   MockStreamsWriterImpl() {
     using namespace testing;
@@ -39,12 +42,18 @@ class MockStreamsWriterImpl : public StreamsWriterImpl {
     outputFrame_(buf.get());
   }
 
+  std::unique_ptr<folly::IOBuf> onPendingOutputOverflow(
+      std::unique_ptr<folly::IOBuf> buf) override {
+    onPendingOutputOverflow_(buf.get());
+    return nullptr;
+  }
+
   FrameSerializer& serializer() override {
     return frameSerializer;
   }
 
-  RSocketStats& stats() override {
-    return *stats_;
+  StatsBatch& stats() override {
+    return statsBatch_;
   }
 
   std::shared_ptr<yarpl::flowable::Subscriber<Payload>> onNewStreamReady(
@@ -65,10 +74,12 @@ class MockStreamsWriterImpl : public StreamsWriterImpl {
     // ignoring...
   }
 
+  using StreamsWriterImpl::dropPendingOutputFrames;
   using StreamsWriterImpl::sendPendingFrames;
 
   bool shouldQueue_{false};
   std::shared_ptr<RSocketStats> stats_ = RSocketStats::noop();
+  StatsBatch statsBatch_{stats_};
   FrameSerializerV1_0 frameSerializer;
 };
 
@@ -144,6 +155,12 @@ class MockStreamsWriter : public StreamsWriter {
     // ignoring...
   }
 
+  size_t maxReassemblySize() const override {
+    return maxReassemblySize_;
+  }
+
+  size_t maxReassemblySize_{std::numeric_limits<size_t>::max()};
+
  protected:
   MockStreamsWriterImpl impl_;
   bool delegateToImpl_{false};
@@ -0,0 +1,239 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/Format.h>
+#include <folly/futures/Future.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+
+#include "rsocket/test/transport/DuplexConnectionTest.h"
+#include "rsocket/transports/shm/ShmConnectionAcceptor.h"
+#include "rsocket/transports/shm/ShmConnectionFactory.h"
+#include "rsocket/transports/shm/ShmRing.h"
+
+namespace rsocket {
+namespace tests {
+
+using namespace folly;
+using namespace rsocket;
+
+namespace {
+
+std::string socketPath() {
+  static int counter{0};
+  return folly::sformat(
+      "/tmp/rsocket-shm-test-{}-{}.sock", getpid(), ++counter);
+}
+
+/// Memory for a single ring, aligned like a mapping.
+class RingMemory {
+ public:
+  explicit RingMemory(size_t capacity)
+      : memory_(static_cast<uint8_t*>(
+            ::aligned_alloc(64, ShmRing::regionSize(capacity)))),
+        ring_(memory_.get(), capacity),
+        capacity_(capacity) {
+    ring_.initialize();
+  }
+
+  ShmRing& ring() {
+    return ring_;
+  }
+
+  /// The records, past the header.
+  uint8_t* data() {
+    return memory_.get() + ShmRing::regionSize(capacity_) - capacity_;
+  }
+
+ private:
+  struct Free {
+    void operator()(uint8_t* memory) const {
+      ::free(memory);
+    }
+  };
+
+  std::unique_ptr<uint8_t, Free> memory_;
+  ShmRing ring_;
+  const size_t capacity_;
+};
+
+std::string readString(ShmRing& ring) {
+  auto record = ring.read();
+  return record ? record->moveToFbString().toStdString() : "<empty>";
+}
+
+/**
+ * Synchronously create a server and a client.
+ */
+std::pair<
+    std::unique_ptr<ConnectionAcceptor>,
+    std::unique_ptr<ConnectionFactory>>
+makeShmClientServer(
+    std::unique_ptr<DuplexConnection>& serverConnection,
+    EventBase** serverEvb,
+    std::unique_ptr<DuplexConnection>& clientConnection,
+    EventBase* clientEvb) {
+  Promise<Unit> serverPromise;
+
+  ShmConnectionAcceptor::Options options;
+  options.path = socketPath();
+  options.threads = 1;
+  options.backlog = 0;
+  options.ringSize = 1 << 16;
+
+  auto const path = options.path;
+  auto server = std::make_unique<ShmConnectionAcceptor>(std::move(options));
+  server->start(
+      [&serverPromise, &serverConnection, &serverEvb](
+          std::unique_ptr<DuplexConnection> connection, EventBase& eventBase) {
+        serverConnection = std::move(connection);
+        *serverEvb = &eventBase;
+        serverPromise.setValue();
+      });
+
+  auto client = std::make_unique<ShmConnectionFactory>(*clientEvb, path);
+  client->connect(ProtocolVersion::Latest, ResumeStatus::NEW_SESSION)
+      .thenValue([&clientConnection](
+                     ConnectionFactory::ConnectedDuplexConnection connection) {
+        clientConnection = std::move(connection.connection);
+      })
+      .wait();
+
+  serverPromise.getSemiFuture().wait();
+  return std::make_pair(std::move(server), std::move(client));
+}
+
+} // namespace
+
+TEST(ShmRing, RecordsWrapAround) {
+  RingMemory memory{64};
+  auto& ring = memory.ring();
+
+  // Records of 4 + 10 bytes don't divide the capacity, so they end up split
+  // across the end of the ring.
+  for (int i = 0; i < 20; ++i) {
+    auto const record = folly::sformat("record-{:03d}", i);
+    ASSERT_TRUE(ring.tryWrite(*folly::IOBuf::copyBuffer(record)));
+    EXPECT_EQ(record, readString(ring));
+  }
+  EXPECT_EQ("<empty>", readString(ring));
+}
+
+TEST(ShmRing, WritesChains) {
+  RingMemory memory{64};
+  auto& ring = memory.ring();
+
+  auto chain = folly::IOBuf::copyBuffer("hello ");
+  chain->prependChain(folly::IOBuf::copyBuffer("world"));
+  ASSERT_TRUE(ring.tryWrite(*chain));
+  EXPECT_EQ("hello world", readString(ring));
+}
+
+TEST(ShmRing, FullRingParksWriter) {
+  RingMemory memory{64};
+  auto& ring = memory.ring();
+
+  auto const record = folly::IOBuf::copyBuffer(std::string(20, 'a'));
+  ASSERT_TRUE(ring.tryWrite(*record));
+  ASSERT_TRUE(ring.tryWrite(*record));
+  EXPECT_FALSE(ring.tryWrite(*record));
+
+  EXPECT_TRUE(ring.parkWriter(ShmRing::kRecordHeaderSize + 20));
+
+  EXPECT_EQ(std::string(20, 'a'), readString(ring));
+  EXPECT_TRUE(ring.takeWriterParked());
+  EXPECT_FALSE(ring.parkWriter(ShmRing::kRecordHeaderSize + 20));
+  EXPECT_TRUE(ring.tryWrite(*record));
+}
+
+TEST(ShmRing, ReaderParksOnlyWhenEmpty) {
+  RingMemory memory{64};
+  auto& ring = memory.ring();
+
+  EXPECT_FALSE(ring.takeReaderParked());
+  EXPECT_TRUE(ring.parkReader());
+
+  ASSERT_TRUE(ring.tryWrite(*folly::IOBuf::copyBuffer("x")));
+  EXPECT_TRUE(ring.takeReaderParked());
+  EXPECT_FALSE(ring.takeReaderParked());
+
+  EXPECT_FALSE(ring.parkReader());
+  EXPECT_EQ("x", readString(ring));
+}
+
+TEST(ShmRing, CloseKeepsWrittenRecords) {
+  RingMemory memory{64};
+  auto& ring = memory.ring();
+
+  ASSERT_TRUE(ring.tryWrite(*folly::IOBuf::copyBuffer("last")));
+  ring.closeWriter();
+
+  EXPECT_TRUE(ring.writerClosed());
+  EXPECT_EQ("last", readString(ring));
+  EXPECT_EQ("<empty>", readString(ring));
+}
+
+TEST(ShmRing, RejectsCorruptLengths) {
+  RingMemory memory{64};
+  auto& ring = memory.ring();
+
+  // Longer than the ring.
+  ASSERT_TRUE(ring.tryWrite(*folly::IOBuf::copyBuffer("hello")));
+  uint32_t length = 1000;
+  std::memcpy(memory.data(), &length, sizeof(length));
+  EXPECT_THROW(ring.read(), std::runtime_error);
+
+  // Longer than what was written.
+  length = 20;
+  std::memcpy(memory.data(), &length, sizeof(length));
+  EXPECT_THROW(ring.read(), std::runtime_error);
+
+  length = 5;
+  std::memcpy(memory.data(), &length, sizeof(length));
+  EXPECT_EQ("hello", readString(ring));
+}
+
+TEST(ShmDuplexConnection, MultipleSetInputGetOutputCalls) {
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  auto keepAlive = makeShmClientServer(
+      serverConnection, &serverEvb, clientConnection, worker.getEventBase());
+  makeMultipleSetInputGetOutputCalls(
+      std::move(serverConnection),
+      serverEvb,
+      std::move(clientConnection),
+      worker.getEventBase());
+}
+
+TEST(ShmDuplexConnection, InputAndOutputIsUntied) {
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  auto keepAlive = makeShmClientServer(
+      serverConnection, &serverEvb, clientConnection, worker.getEventBase());
+  verifyInputAndOutputIsUntied(
+      std::move(serverConnection),
+      serverEvb,
+      std::move(clientConnection),
+      worker.getEventBase());
+}
+
+} // namespace tests
+} // namespace rsocket
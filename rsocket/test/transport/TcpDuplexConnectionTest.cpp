@@ -12,15 +12,25 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
 #include <folly/futures/Future.h>
+#include <folly/io/IOBufQueue.h>
 #include <folly/io/async/AsyncTransport.h>
 #include <folly/io/async/ScopedEventBaseThread.h>
 #include <folly/io/async/ssl/SSLErrors.h>
+#include <folly/synchronization/Baton.h>
 #include <gtest/gtest.h>
 
+#include <thread>
+
+#include "rsocket/internal/FileRange.h"
+#include "rsocket/test/test_utils/MockStats.h"
 #include "rsocket/test/transport/DuplexConnectionTest.h"
 #include "rsocket/transports/tcp/TcpConnectionAcceptor.h"
 #include "rsocket/transports/tcp/TcpConnectionFactory.h"
+#include "yarpl/test_utils/Mocks.h"
 
 namespace rsocket {
 namespace tests {
@@ -38,13 +48,17 @@ makeSingleClientServer(
     std::unique_ptr<DuplexConnection>& serverConnection,
     EventBase** serverEvb,
     std::unique_ptr<DuplexConnection>& clientConnection,
-    EventBase* clientEvb) {
+    EventBase* clientEvb,
+    size_t serverZeroCopyThreshold = 0,
+    std::shared_ptr<RSocketStats> serverStats = RSocketStats::noop()) {
   Promise<Unit> serverPromise;
 
   TcpConnectionAcceptor::Options options;
   options.address = folly::SocketAddress{"::", 0};
   options.threads = 1;
   options.backlog = 0;
+  options.zeroCopyThreshold = serverZeroCopyThreshold;
+  options.stats = std::move(serverStats);
 
   auto server = std::make_unique<TcpConnectionAcceptor>(std::move(options));
   server->start(
@@ -109,5 +123,283 @@ TEST(TcpDuplexConnection, ConnectionAndSubscribersAreUntied) {
       worker.getEventBase());
 }
 
+TEST(TcpDuplexConnection, SlowReaderMakesConnectionUnwritable) {
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  auto keepAlive = makeSingleClientServer(
+      serverConnection, &serverEvb, clientConnection, worker.getEventBase());
+
+  constexpr size_t kFrameSize = 64 * 1024;
+  constexpr WriteWatermarks kWatermarks{256 * 1024, 1024 * 1024};
+  // Way more than the socket buffers of the loopback connection can hold.
+  constexpr size_t kMaxFrames = 4096;
+
+  bool writable = true;
+  folly::Baton<> drained;
+  size_t sent = 0;
+
+  // The client doesn't read anything yet.  Write like a publisher would, for
+  // as long as the connection stays writable.
+  serverEvb->runInEventBaseThreadAndWait([&] {
+    serverConnection->setWriteWatermarks(kWatermarks, [&](bool isWritable) {
+      writable = isWritable;
+      if (writable) {
+        drained.post();
+      }
+    });
+    while (writable && sent < kMaxFrames) {
+      auto frame = folly::IOBuf::create(kFrameSize);
+      frame->append(kFrameSize);
+      serverConnection->send(std::move(frame));
+      ++sent;
+    }
+  });
+  EXPECT_LT(sent, kMaxFrames);
+
+  // Once the client catches up, the connection becomes writable again.
+  using Reader = yarpl::mocks::MockSubscriber<std::unique_ptr<folly::IOBuf>>;
+  auto clientSubscriber = std::make_shared<::testing::NiceMock<Reader>>();
+  worker.getEventBase()->runInEventBaseThreadAndWait(
+      [&] { clientConnection->setInput(clientSubscriber); });
+  EXPECT_TRUE(drained.try_wait_for(std::chrono::seconds(5)));
+
+  // Cleanup
+  worker.getEventBase()->runInEventBaseThreadAndWait(
+      [subscriber = std::move(clientSubscriber),
+       connection = std::move(clientConnection)] {
+        subscriber->subscription()->cancel();
+      });
+  serverEvb->runInEventBaseThreadAndWait(
+      [connection = std::move(serverConnection)] {});
+}
+
+TEST(TcpDuplexConnection, ReadingPausesWithoutCredits) {
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  auto keepAlive = makeSingleClientServer(
+      serverConnection, &serverEvb, clientConnection, worker.getEventBase());
+
+  constexpr size_t kFrameSize = 64 * 1024;
+  constexpr WriteWatermarks kWatermarks{256 * 1024, 1024 * 1024};
+  constexpr size_t kMaxFrames = 4096;
+
+  // The server asks for a single read and then stops reading.
+  using Reader = yarpl::mocks::MockSubscriber<std::unique_ptr<folly::IOBuf>>;
+  auto serverSubscriber = std::make_shared<::testing::NiceMock<Reader>>(1);
+  size_t bytesRead = 0;
+  folly::Baton<> firstRead;
+  EXPECT_CALL(*serverSubscriber, onNext_(::testing::_))
+      .WillOnce(
+          ::testing::Invoke([&](const std::unique_ptr<folly::IOBuf>& buf) {
+            bytesRead += buf->computeChainDataLength();
+            firstRead.post();
+          }));
+  serverEvb->runInEventBaseThreadAndWait(
+      [&] { serverConnection->setInput(serverSubscriber); });
+
+  bool writable = true;
+  folly::Baton<> drained;
+  size_t sent = 0;
+
+  // A flooding client fills the socket buffers instead of the server's memory,
+  // and is told to stop sending.
+  worker.getEventBase()->runInEventBaseThreadAndWait([&] {
+    clientConnection->setWriteWatermarks(kWatermarks, [&](bool isWritable) {
+      writable = isWritable;
+      if (writable) {
+        drained.post();
+      }
+    });
+    while (writable && sent < kMaxFrames) {
+      auto frame = folly::IOBuf::create(kFrameSize);
+      frame->append(kFrameSize);
+      clientConnection->send(std::move(frame));
+      ++sent;
+    }
+  });
+  EXPECT_LT(sent, kMaxFrames);
+
+  // Give the server's EventBase time to read more than it asked for, were it
+  // to keep reading, and drain it.
+  ASSERT_TRUE(firstRead.try_wait_for(std::chrono::seconds(5)));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  serverEvb->runInEventBaseThreadAndWait([] {});
+  ::testing::Mock::VerifyAndClearExpectations(serverSubscriber.get());
+
+  // With credits, the server reads everything the client sent.
+  folly::Baton<> readAll;
+  EXPECT_CALL(*serverSubscriber, onNext_(::testing::_))
+      .WillRepeatedly(
+          ::testing::Invoke([&](const std::unique_ptr<folly::IOBuf>& buf) {
+            bytesRead += buf->computeChainDataLength();
+            if (bytesRead == sent * kFrameSize) {
+              readAll.post();
+            }
+          }));
+  serverEvb->runInEventBaseThreadAndWait([&] {
+    serverSubscriber->subscription()->request(
+        std::numeric_limits<int64_t>::max());
+  });
+  EXPECT_TRUE(drained.try_wait_for(std::chrono::seconds(5)));
+  EXPECT_TRUE(readAll.try_wait_for(std::chrono::seconds(5)));
+
+  // Cleanup
+  serverEvb->runInEventBaseThreadAndWait(
+      [subscriber = std::move(serverSubscriber),
+       connection = std::move(serverConnection)] {
+        subscriber->subscription()->cancel();
+      });
+  worker.getEventBase()->runInEventBaseThreadAndWait(
+      [connection = std::move(clientConnection)] {});
+}
+
+TEST(TcpDuplexConnection, ZeroCopyLargeFramesArriveIntact) {
+  using ::testing::_;
+
+  constexpr size_t kThreshold = 64 * 1024;
+  constexpr size_t kLargeFrame = 1024 * 1024;
+  constexpr size_t kSmallFrame = 1024;
+
+  // Whether the kernel lets us use zerocopy depends on the host, but every
+  // large frame is counted one way or the other.
+  std::atomic<size_t> zeroCopyWrites{0};
+  auto stats = std::make_shared<::testing::NiceMock<MockStats>>();
+  EXPECT_CALL(*stats, zeroCopyRequested(kLargeFrame))
+      .WillRepeatedly(::testing::Invoke([&](size_t) { ++zeroCopyWrites; }));
+  EXPECT_CALL(*stats, zeroCopyFallback(kLargeFrame))
+      .WillRepeatedly(::testing::Invoke([&](size_t) { ++zeroCopyWrites; }));
+  EXPECT_CALL(*stats, zeroCopyRequested(kSmallFrame)).Times(0);
+  EXPECT_CALL(*stats, zeroCopyFallback(kSmallFrame)).Times(0);
+
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  auto keepAlive = makeSingleClientServer(
+      serverConnection,
+      &serverEvb,
+      clientConnection,
+      worker.getEventBase(),
+      kThreshold,
+      stats);
+
+  std::vector<std::string> frames;
+  for (size_t i = 0; i < 4; ++i) {
+    auto const size = i % 2 ? kSmallFrame : kLargeFrame;
+    frames.emplace_back(size, static_cast<char>('a' + i));
+  }
+  auto const expected = folly::join("", frames);
+
+  folly::IOBufQueue received{folly::IOBufQueue::cacheChainLength()};
+  folly::Baton<> done;
+
+  using Reader = yarpl::mocks::MockSubscriber<std::unique_ptr<folly::IOBuf>>;
+  auto clientSubscriber = std::make_shared<::testing::NiceMock<Reader>>();
+  EXPECT_CALL(*clientSubscriber, onNext_(_))
+      .WillRepeatedly(
+          ::testing::Invoke([&](const std::unique_ptr<folly::IOBuf>& buf) {
+            received.append(buf->clone());
+            if (received.chainLength() == expected.size()) {
+              done.post();
+            }
+          }));
+  worker.getEventBase()->runInEventBaseThreadAndWait(
+      [&] { clientConnection->setInput(clientSubscriber); });
+
+  // The connection lets go of each frame right away, the socket has to keep
+  // the buffers of zerocopy writes alive until the kernel is done with them.
+  serverEvb->runInEventBaseThreadAndWait([&] {
+    for (auto const& frame : frames) {
+      serverConnection->send(folly::IOBuf::copyBuffer(frame));
+    }
+  });
+
+  ASSERT_TRUE(done.try_wait_for(std::chrono::seconds(5)));
+  EXPECT_EQ(expected, received.move()->moveToFbString().toStdString());
+  EXPECT_EQ(2u, zeroCopyWrites);
+
+  // Cleanup
+  worker.getEventBase()->runInEventBaseThreadAndWait(
+      [subscriber = std::move(clientSubscriber),
+       connection = std::move(clientConnection)] {
+        subscriber->subscription()->cancel();
+      });
+  serverEvb->runInEventBaseThreadAndWait(
+      [connection = std::move(serverConnection)] {});
+}
+
+TEST(TcpDuplexConnection, FileRangesAreSentInOrder) {
+  constexpr size_t kFileSize = 256 * 1024;
+
+  std::string contents;
+  for (size_t i = 0; i < kFileSize; ++i) {
+    contents.push_back('a' + i % 26);
+  }
+  auto file = folly::File::temporary();
+  ASSERT_EQ(
+      static_cast<ssize_t>(kFileSize),
+      folly::writeFull(file.fd(), contents.data(), contents.size()));
+
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  auto keepAlive = makeSingleClientServer(
+      serverConnection, &serverEvb, clientConnection, worker.getEventBase());
+
+  // Memory buffers around file ranges, and frames behind them, must not
+  // overtake the file data.
+  auto const range = [&](off_t offset, size_t length) {
+    auto buf = mapFileRange(file, offset, length);
+    EXPECT_TRUE(findFileRange(*buf));
+    return buf;
+  };
+  std::vector<std::unique_ptr<folly::IOBuf>> frames;
+  frames.push_back(folly::IOBuf::copyBuffer("header"));
+  frames.back()->prependChain(range(10, 100 * 1024));
+  frames.back()->prependChain(folly::IOBuf::copyBuffer("trailer"));
+  frames.push_back(folly::IOBuf::copyBuffer("next frame"));
+  frames.push_back(range(0, kFileSize));
+
+  std::string expected;
+  for (auto const& frame : frames) {
+    expected += frame->cloneAsValue().moveToFbString().toStdString();
+  }
+
+  folly::IOBufQueue received{folly::IOBufQueue::cacheChainLength()};
+  folly::Baton<> done;
+
+  using Reader = yarpl::mocks::MockSubscriber<std::unique_ptr<folly::IOBuf>>;
+  auto clientSubscriber = std::make_shared<::testing::NiceMock<Reader>>();
+  EXPECT_CALL(*clientSubscriber, onNext_(::testing::_))
+      .WillRepeatedly(
+          ::testing::Invoke([&](const std::unique_ptr<folly::IOBuf>& buf) {
+            received.append(buf->clone());
+            if (received.chainLength() == expected.size()) {
+              done.post();
+            }
+          }));
+  worker.getEventBase()->runInEventBaseThreadAndWait(
+      [&] { clientConnection->setInput(clientSubscriber); });
+
+  serverEvb->runInEventBaseThreadAndWait([&] {
+    for (auto& frame : frames) {
+      serverConnection->send(std::move(frame));
+    }
+  });
+
+  ASSERT_TRUE(done.try_wait_for(std::chrono::seconds(5)));
+  EXPECT_EQ(expected, received.move()->moveToFbString().toStdString());
+
+  // Cleanup
+  worker.getEventBase()->runInEventBaseThreadAndWait(
+      [subscriber = std::move(clientSubscriber),
+       connection = std::move(clientConnection)] {
+        subscriber->subscription()->cancel();
+      });
+  serverEvb->runInEventBaseThreadAndWait(
+      [connection = std::move(serverConnection)] {});
+}
+
 } // namespace tests
 } // namespace rsocket
@@ -0,0 +1,183 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/Format.h>
+#include <folly/futures/Future.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <gtest/gtest.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <system_error>
+
+#include "rsocket/test/transport/DuplexConnectionTest.h"
+#include "rsocket/transports/uds/UdsConnectionAcceptor.h"
+#include "rsocket/transports/uds/UdsConnectionFactory.h"
+
+namespace rsocket {
+namespace tests {
+
+using namespace folly;
+using namespace rsocket;
+
+namespace {
+
+std::string socketPath() {
+  static int counter{0};
+  return folly::sformat(
+      "/tmp/rsocket-uds-test-{}-{}.sock", getpid(), ++counter);
+}
+
+/**
+ * Synchronously create a server and a client.
+ */
+std::pair<
+    std::unique_ptr<ConnectionAcceptor>,
+    std::unique_ptr<ConnectionFactory>>
+makeUdsClientServer(
+    std::unique_ptr<DuplexConnection>& serverConnection,
+    EventBase** serverEvb,
+    std::unique_ptr<DuplexConnection>& clientConnection,
+    EventBase* clientEvb) {
+  Promise<Unit> serverPromise;
+
+  UdsConnectionAcceptor::Options options;
+  options.path = socketPath();
+  options.threads = 1;
+  options.backlog = 0;
+
+  auto const path = options.path;
+  auto server = std::make_unique<UdsConnectionAcceptor>(std::move(options));
+  server->start(
+      [&serverPromise, &serverConnection, &serverEvb](
+          std::unique_ptr<DuplexConnection> connection, EventBase& eventBase) {
+        serverConnection = std::move(connection);
+        *serverEvb = &eventBase;
+        serverPromise.setValue();
+      });
+
+  auto client = std::make_unique<UdsConnectionFactory>(*clientEvb, path);
+  client->connect(ProtocolVersion::Latest, ResumeStatus::NEW_SESSION)
+      .thenValue([&clientConnection](
+                     ConnectionFactory::ConnectedDuplexConnection connection) {
+        clientConnection = std::move(connection.connection);
+      })
+      .wait();
+
+  serverPromise.getSemiFuture().wait();
+  return std::make_pair(std::move(server), std::move(client));
+}
+
+} // namespace
+
+TEST(UdsDuplexConnection, MultipleSetInputGetOutputCalls) {
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  auto keepAlive = makeUdsClientServer(
+      serverConnection, &serverEvb, clientConnection, worker.getEventBase());
+  makeMultipleSetInputGetOutputCalls(
+      std::move(serverConnection),
+      serverEvb,
+      std::move(clientConnection),
+      worker.getEventBase());
+}
+
+TEST(UdsDuplexConnection, InputAndOutputIsUntied) {
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  auto keepAlive = makeUdsClientServer(
+      serverConnection, &serverEvb, clientConnection, worker.getEventBase());
+  verifyInputAndOutputIsUntied(
+      std::move(serverConnection),
+      serverEvb,
+      std::move(clientConnection),
+      worker.getEventBase());
+}
+
+TEST(UdsDuplexConnection, StopRemovesSocketFile) {
+  UdsConnectionAcceptor::Options options;
+  options.path = socketPath();
+  options.threads = 1;
+
+  auto const path = options.path;
+  UdsConnectionAcceptor acceptor{std::move(options)};
+  acceptor.start([](std::unique_ptr<DuplexConnection>, EventBase&) {});
+  EXPECT_EQ(0, ::access(path.c_str(), F_OK));
+  EXPECT_FALSE(acceptor.listeningPort());
+
+  acceptor.stop();
+  EXPECT_NE(0, ::access(path.c_str(), F_OK));
+}
+
+TEST(UdsDuplexConnection, LivePathIsNotReplaced) {
+  UdsConnectionAcceptor::Options options;
+  options.path = socketPath();
+  options.threads = 1;
+
+  auto const path = options.path;
+  UdsConnectionAcceptor first{options};
+  first.start([](std::unique_ptr<DuplexConnection>, EventBase&) {});
+
+  UdsConnectionAcceptor second{options};
+  try {
+    second.start([](std::unique_ptr<DuplexConnection>, EventBase&) {});
+    ADD_FAILURE() << "Started a second acceptor on " << path;
+  } catch (const std::system_error& ex) {
+    EXPECT_EQ(EADDRINUSE, ex.code().value());
+  }
+
+  // The failed acceptor leaves the first one's socket alone.
+  second.stop();
+  EXPECT_EQ(0, ::access(path.c_str(), F_OK));
+
+  auto const fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_GE(fd, 0);
+  sockaddr_storage addr;
+  auto const addrLen =
+      folly::SocketAddress::makeFromPath(path).getAddress(&addr);
+  EXPECT_EQ(0, ::connect(fd, reinterpret_cast<sockaddr*>(&addr), addrLen));
+  ::close(fd);
+
+  first.stop();
+}
+
+TEST(UdsDuplexConnection, StaleSocketIsReplaced) {
+  UdsConnectionAcceptor::Options options;
+  options.path = socketPath();
+  options.threads = 1;
+  auto const path = options.path;
+
+  // A socket file nothing listens on.
+  {
+    auto const fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(fd, 0);
+    sockaddr_storage addr;
+    auto const addrLen =
+        folly::SocketAddress::makeFromPath(path).getAddress(&addr);
+    ASSERT_EQ(0, ::bind(fd, reinterpret_cast<sockaddr*>(&addr), addrLen));
+    ::close(fd);
+  }
+  ASSERT_EQ(0, ::access(path.c_str(), F_OK));
+
+  UdsConnectionAcceptor acceptor{std::move(options)};
+  EXPECT_NO_THROW(
+      acceptor.start([](std::unique_ptr<DuplexConnection>, EventBase&) {}));
+  acceptor.stop();
+}
+
+} // namespace tests
+} // namespace rsocket
@@ -0,0 +1,136 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/io_uring/IoUringConnectionAcceptor.h"
+
+#include <folly/Format.h>
+#include <folly/futures/Future.h>
+#include <folly/io/async/EventBaseManager.h>
+
+#include "rsocket/transports/io_uring/IoUringContext.h"
+#include "rsocket/transports/io_uring/IoUringDuplexConnection.h"
+
+namespace rsocket {
+
+class IoUringConnectionAcceptor::SocketCallback
+    : public folly::AsyncServerSocket::AcceptCallback {
+ public:
+  SocketCallback(
+      OnDuplexConnectionAccept& onAccept,
+      std::shared_ptr<RSocketStats> stats)
+      : thread_{folly::sformat("rsuring-acceptor")},
+        onAccept_{onAccept},
+        stats_{std::move(stats)} {
+    // Set up the worker's io_uring now so that failing to do so surfaces from
+    // start().
+    folly::via(eventBase(), [this] {
+      IoUringContext::forEventBase(*eventBase());
+    }).get();
+  }
+
+  void connectionAccepted(
+      folly::NetworkSocket fdNetworkSocket,
+      const folly::SocketAddress& address) noexcept override {
+    VLOG(2) << "Accepting io_uring connection from " << address << " on FD "
+            << fdNetworkSocket.toFd();
+
+    auto connection = std::make_unique<IoUringDuplexConnection>(
+        fdNetworkSocket, *eventBase(), stats_);
+    onAccept_(std::move(connection), *eventBase());
+  }
+
+  void acceptError(folly::exception_wrapper ex) noexcept override {
+    VLOG(2) << "io_uring acceptor error: " << ex;
+  }
+
+  folly::EventBase* eventBase() const {
+    return thread_.getEventBase();
+  }
+
+ private:
+  /// The thread running this callback.
+  folly::ScopedEventBaseThread thread_;
+
+  /// Reference to the ConnectionAcceptor's callback.
+  OnDuplexConnectionAccept& onAccept_;
+
+  const std::shared_ptr<RSocketStats> stats_;
+};
+
+IoUringConnectionAcceptor::IoUringConnectionAcceptor(Options options)
+    : options_(std::move(options)) {}
+
+IoUringConnectionAcceptor::~IoUringConnectionAcceptor() {
+  if (serverThread_) {
+    stop();
+    serverThread_.reset();
+  }
+}
+
+void IoUringConnectionAcceptor::start(OnDuplexConnectionAccept onAccept) {
+  if (onAccept_ != nullptr) {
+    throw std::runtime_error(
+        "IoUringConnectionAcceptor::start() already called");
+  }
+
+  onAccept_ = std::move(onAccept);
+  serverThread_ =
+      std::make_unique<folly::ScopedEventBaseThread>("rsuring-listener");
+
+  callbacks_.reserve(options_.threads);
+  for (size_t i = 0; i < options_.threads; ++i) {
+    callbacks_.push_back(
+        std::make_unique<SocketCallback>(onAccept_, options_.stats));
+  }
+
+  VLOG(1) << "Starting io_uring listener on port "
+          << options_.address.getPort() << " with " << options_.threads
+          << " request threads";
+
+  serverSocket_.reset(
+      new folly::AsyncServerSocket(serverThread_->getEventBase()));
+
+  // The AsyncServerSocket needs to be accessed from the listener thread only.
+  // This will propagate out any exceptions the listener throws.
+  folly::via(serverThread_->getEventBase(), [this] {
+    serverSocket_->bind(options_.address);
+
+    for (auto const& callback : callbacks_) {
+      serverSocket_->addAcceptCallback(callback.get(), callback->eventBase());
+    }
+
+    serverSocket_->listen(options_.backlog);
+    serverSocket_->startAccepting();
+
+    for (const auto& i : serverSocket_->getAddresses()) {
+      VLOG(1) << "Listening on " << i.describe();
+    }
+  }).get();
+}
+
+void IoUringConnectionAcceptor::stop() {
+  VLOG(1) << "Shutting down io_uring listener";
+
+  serverThread_->getEventBase()->runInEventBaseThreadAndWait(
+      [serverSocket = std::move(serverSocket_)]() {});
+}
+
+folly::Optional<uint16_t> IoUringConnectionAcceptor::listeningPort() const {
+  if (!serverSocket_) {
+    return folly::none;
+  }
+  return serverSocket_->getAddress().getPort();
+}
+
+} // namespace rsocket
@@ -0,0 +1,97 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/io_uring/IoUringConnectionFactory.h"
+
+#include <folly/io/async/AsyncSocket.h>
+#include <folly/io/async/EventBaseManager.h>
+#include <glog/logging.h>
+
+#include "rsocket/transports/io_uring/IoUringContext.h"
+#include "rsocket/transports/io_uring/IoUringDuplexConnection.h"
+
+namespace rsocket {
+
+namespace {
+
+class ConnectCallback : public folly::AsyncSocket::ConnectCallback {
+ public:
+  ConnectCallback(
+      folly::EventBase& evb,
+      folly::SocketAddress address,
+      folly::Promise<ConnectionFactory::ConnectedDuplexConnection>
+          connectPromise)
+      : evb_(evb),
+        address_(std::move(address)),
+        connectPromise_(std::move(connectPromise)),
+        socket_(new folly::AsyncSocket(&evb_)) {
+    VLOG(3) << "Attempting connection to " << address_;
+    socket_->connect(this, address_);
+  }
+
+  void connectSuccess() noexcept override {
+    std::unique_ptr<ConnectCallback> deleter(this);
+    VLOG(4) << "connectSuccess() on " << address_;
+
+    // From here on the socket is driven by io_uring.
+    auto const fd = socket_->detachNetworkSocket();
+    auto connection = std::make_unique<IoUringDuplexConnection>(
+        fd, evb_, RSocketStats::noop());
+    connectPromise_.setValue(ConnectionFactory::ConnectedDuplexConnection{
+        std::move(connection), evb_});
+  }
+
+  void connectErr(const folly::AsyncSocketException& ex) noexcept override {
+    std::unique_ptr<ConnectCallback> deleter(this);
+    VLOG(4) << "connectErr(" << ex.what() << ") on " << address_;
+    connectPromise_.setException(ex);
+  }
+
+ private:
+  folly::EventBase& evb_;
+  const folly::SocketAddress address_;
+  folly::Promise<ConnectionFactory::ConnectedDuplexConnection> connectPromise_;
+  folly::AsyncSocket::UniquePtr socket_;
+};
+
+} // namespace
+
+IoUringConnectionFactory::IoUringConnectionFactory(
+    folly::EventBase& eventBase,
+    folly::SocketAddress address)
+    : eventBase_(&eventBase), address_(std::move(address)) {}
+
+IoUringConnectionFactory::~IoUringConnectionFactory() = default;
+
+folly::Future<ConnectionFactory::ConnectedDuplexConnection>
+IoUringConnectionFactory::connect(ProtocolVersion, ResumeStatus /* unused */) {
+  folly::Promise<ConnectionFactory::ConnectedDuplexConnection> connectPromise;
+  auto connectFuture = connectPromise.getFuture();
+
+  eventBase_->runInEventBaseThread(
+      [this, promise = std::move(connectPromise)]() mutable {
+        try {
+          // Fail the connection attempt if io_uring can't be set up.
+          IoUringContext::forEventBase(*eventBase_);
+        } catch (const std::exception& ex) {
+          promise.setException(
+              folly::exception_wrapper{std::current_exception(), ex});
+          return;
+        }
+        new ConnectCallback(*eventBase_, address_, std::move(promise));
+      });
+  return connectFuture;
+}
+
+} // namespace rsocket
@@ -0,0 +1,49 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/SocketAddress.h>
+
+#include "rsocket/ConnectionFactory.h"
+#include "rsocket/DuplexConnection.h"
+
+namespace rsocket {
+
+/**
+ * io_uring implementation of ConnectionFactory for use with
+ * RSocket::createClient().
+ *
+ * The TCP connection is established with an AsyncSocket, its file descriptor
+ * is then handed to an IoUringDuplexConnection.
+ */
+class IoUringConnectionFactory : public ConnectionFactory {
+ public:
+  IoUringConnectionFactory(
+      folly::EventBase& eventBase,
+      folly::SocketAddress address);
+  virtual ~IoUringConnectionFactory();
+
+  /**
+   * Connect to server defined in constructor.
+   */
+  folly::Future<ConnectedDuplexConnection> connect(
+      ProtocolVersion,
+      ResumeStatus resume) override;
+
+ private:
+  folly::EventBase* eventBase_;
+  const folly::SocketAddress address_;
+};
+} // namespace rsocket
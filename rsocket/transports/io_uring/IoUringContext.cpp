@@ -0,0 +1,173 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/io_uring/IoUringContext.h"
+
+#include <folly/String.h>
+#include <folly/io/async/EventBaseLocal.h>
+#include <glog/logging.h>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <system_error>
+
+namespace rsocket {
+
+namespace {
+
+[[noreturn]] void throwErrno(int error, const char* what) {
+  throw std::system_error(error, std::generic_category(), what);
+}
+
+} // namespace
+
+IoUringContext::IoUringContext(folly::EventBase& eventBase, Options options)
+    : eventBase_(eventBase), options_(std::move(options)) {
+  CHECK_GT(options_.receiveBuffers, 0u);
+  CHECK_EQ(options_.receiveBuffers & (options_.receiveBuffers - 1), 0u)
+      << "The number of receive buffers must be a power of two";
+
+  if (auto const ret = io_uring_queue_init(options_.entries, &ring_, 0)) {
+    throwErrno(-ret, "io_uring_queue_init");
+  }
+
+  eventFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (eventFd_ < 0) {
+    auto const error = errno;
+    io_uring_queue_exit(&ring_);
+    throwErrno(error, "eventfd");
+  }
+  if (auto const ret = io_uring_register_eventfd(&ring_, eventFd_)) {
+    ::close(eventFd_);
+    io_uring_queue_exit(&ring_);
+    throwErrno(-ret, "io_uring_register_eventfd");
+  }
+
+  int ret = 0;
+  bufferRing_ = io_uring_setup_buf_ring(
+      &ring_, options_.receiveBuffers, kBufferGroup, 0, &ret);
+  if (!bufferRing_) {
+    ::close(eventFd_);
+    io_uring_queue_exit(&ring_);
+    throwErrno(-ret, "io_uring_setup_buf_ring");
+  }
+
+  buffers_.reset(
+      new uint8_t[options_.receiveBuffers * options_.receiveBufferSize]);
+  auto const mask = io_uring_buf_ring_mask(options_.receiveBuffers);
+  for (unsigned i = 0; i < options_.receiveBuffers; ++i) {
+    io_uring_buf_ring_add(
+        bufferRing_,
+        buffers_.get() + i * options_.receiveBufferSize,
+        options_.receiveBufferSize,
+        i,
+        mask,
+        i);
+  }
+  io_uring_buf_ring_advance(bufferRing_, options_.receiveBuffers);
+
+  initHandler(&eventBase_, folly::NetworkSocket::fromFd(eventFd_));
+  registerInternalHandler(
+      folly::EventHandler::READ | folly::EventHandler::PERSIST);
+}
+
+IoUringContext::~IoUringContext() {
+  unregisterHandler();
+  cancelLoopCallback();
+  io_uring_free_buf_ring(
+      &ring_, bufferRing_, options_.receiveBuffers, kBufferGroup);
+  io_uring_queue_exit(&ring_);
+  ::close(eventFd_);
+}
+
+std::shared_ptr<IoUringContext> IoUringContext::forEventBase(
+    folly::EventBase& evb) {
+  static folly::EventBaseLocal<std::shared_ptr<IoUringContext>> local;
+  return local.getOrCreateFn(
+      evb, [&evb] { return std::make_shared<IoUringContext>(evb, Options{}); });
+}
+
+io_uring_sqe* IoUringContext::getSqe(Operation* op) {
+  DCHECK(eventBase_.isInEventBaseThread());
+
+  auto sqe = io_uring_get_sqe(&ring_);
+  if (!sqe) {
+    // The submission queue is full, hand it to the kernel now.
+    submit();
+    sqe = io_uring_get_sqe(&ring_);
+    CHECK(sqe);
+  }
+  io_uring_sqe_set_data(sqe, op);
+
+  if (!isLoopCallbackScheduled()) {
+    eventBase_.runInLoop(this, true /* thisIteration */);
+  }
+  return sqe;
+}
+
+std::unique_ptr<folly::IOBuf> IoUringContext::takeBuffer(
+    const io_uring_cqe& cqe) {
+  CHECK(cqe.flags & IORING_CQE_F_BUFFER);
+  CHECK_GT(cqe.res, 0);
+
+  auto const id = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+  DCHECK_LT(id, options_.receiveBuffers);
+  auto const data = buffers_.get() + id * options_.receiveBufferSize;
+  auto buf = folly::IOBuf::copyBuffer(data, static_cast<size_t>(cqe.res));
+
+  io_uring_buf_ring_add(
+      bufferRing_,
+      data,
+      options_.receiveBufferSize,
+      id,
+      io_uring_buf_ring_mask(options_.receiveBuffers),
+      0);
+  io_uring_buf_ring_advance(bufferRing_, 1);
+  return buf;
+}
+
+void IoUringContext::handlerReady(uint16_t) noexcept {
+  uint64_t count;
+  while (::read(eventFd_, &count, sizeof(count)) > 0) {
+  }
+  reap();
+}
+
+void IoUringContext::runLoopCallback() noexcept {
+  submit();
+}
+
+void IoUringContext::submit() {
+  auto const ret = io_uring_submit(&ring_);
+  if (ret < 0) {
+    LOG(ERROR) << "io_uring_submit failed: " << folly::errnoStr(-ret);
+  }
+}
+
+void IoUringContext::reap() {
+  io_uring_cqe* cqe;
+  while (io_uring_peek_cqe(&ring_, &cqe) == 0) {
+    // Copy it out, completions can prepare and submit new requests.
+    auto const completion = *cqe;
+    io_uring_cqe_seen(&ring_, cqe);
+
+    if (auto const op =
+            static_cast<Operation*>(io_uring_cqe_get_data(&completion))) {
+      op->onCompletion(completion);
+    }
+  }
+}
+
+} // namespace rsocket
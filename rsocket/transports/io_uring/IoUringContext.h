@@ -0,0 +1,107 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventHandler.h>
+
+#include <liburing.h>
+
+#include <memory>
+
+namespace rsocket {
+
+/// One io_uring instance per EventBase, shared by every io_uring connection
+/// running on it.
+///
+/// Submission entries prepared during a loop iteration are submitted together
+/// with a single io_uring_submit() at the end of the iteration.  Completions
+/// are signalled through an eventfd watched by the EventBase and dispatched to
+/// the Operation stored in the entry's user data.
+///
+/// Multishot receives pick their buffers from a ring of fixed-size buffers
+/// registered with the kernel, see takeBuffer().
+///
+/// Not thread safe: an instance must only be used from its EventBase's thread.
+class IoUringContext : private folly::EventHandler,
+                       private folly::EventBase::LoopCallback {
+ public:
+  struct Options {
+    /// Number of submission queue entries.
+    unsigned entries{1024};
+
+    /// Number and size of the buffers multishot receives read into.
+    unsigned receiveBuffers{256};
+    size_t receiveBufferSize{16 * 1024};
+  };
+
+  /// In-flight request.  Must stay alive until its last completion.
+  class Operation {
+   public:
+    virtual ~Operation() = default;
+    virtual void onCompletion(const io_uring_cqe&) = 0;
+  };
+
+  IoUringContext(folly::EventBase&, Options);
+  ~IoUringContext() override;
+
+  IoUringContext(const IoUringContext&) = delete;
+  IoUringContext& operator=(const IoUringContext&) = delete;
+
+  /// Context shared by every connection on the given EventBase.  Must be called
+  /// from the EventBase's thread.  Throws if io_uring isn't available.
+  static std::shared_ptr<IoUringContext> forEventBase(folly::EventBase&);
+
+  /// Returns a submission entry whose completions go to `op`, or to nobody if
+  /// `op` is null.  The entry is submitted at the end of the loop iteration.
+  io_uring_sqe* getSqe(Operation* op);
+
+  /// Buffer group to select receive buffers from.
+  unsigned bufferGroup() const {
+    return kBufferGroup;
+  }
+
+  /// Copies out the data a receive completion landed in the buffer ring and
+  /// gives the buffer back to the kernel.
+  std::unique_ptr<folly::IOBuf> takeBuffer(const io_uring_cqe&);
+
+  folly::EventBase& eventBase() const {
+    return eventBase_;
+  }
+
+ private:
+  static constexpr unsigned kBufferGroup{0};
+
+  // EventHandler, called when the eventfd signals completions.
+  void handlerReady(uint16_t events) noexcept override;
+
+  // LoopCallback, submits the entries prepared during the iteration.
+  void runLoopCallback() noexcept override;
+
+  void submit();
+  void reap();
+
+  folly::EventBase& eventBase_;
+  const Options options_;
+
+  io_uring ring_;
+  int eventFd_{-1};
+
+  io_uring_buf_ring* bufferRing_{nullptr};
+  std::unique_ptr<uint8_t[]> buffers_;
+};
+
+} // namespace rsocket
@@ -0,0 +1,445 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/io_uring/IoUringDuplexConnection.h"
+
+#include <folly/ExceptionWrapper.h>
+#include <folly/FBVector.h>
+#include <folly/io/IOBufQueue.h>
+#include <glog/logging.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <deque>
+#include <system_error>
+
+#include "rsocket/internal/Allowance.h"
+#include "rsocket/transports/io_uring/IoUringContext.h"
+#include "yarpl/flowable/Subscription.h"
+
+namespace rsocket {
+
+using namespace yarpl::flowable;
+
+namespace {
+
+/// Most buffers written by a single sendmsg, the rest goes out once it
+/// completes.
+constexpr size_t kMaxIovecs = 64;
+
+folly::exception_wrapper makeError(int error, const char* what) {
+  return folly::make_exception_wrapper<std::system_error>(
+      error, std::generic_category(), what);
+}
+
+} // namespace
+
+class IoUringSocket : private folly::EventBase::LoopCallback {
+  friend void intrusive_ptr_add_ref(IoUringSocket* x);
+  friend void intrusive_ptr_release(IoUringSocket* x);
+
+ public:
+  IoUringSocket(
+      folly::NetworkSocket socket,
+      folly::EventBase& eventBase,
+      std::shared_ptr<RSocketStats> stats)
+      : fd_(socket.toFd()),
+        context_(IoUringContext::forEventBase(eventBase)),
+        stats_(std::move(stats)) {}
+
+  ~IoUringSocket() override {
+    CHECK(isClosed());
+    DCHECK(!inputSubscriber_);
+    DCHECK(!recvArmed_);
+    DCHECK(!sendInFlight_);
+    cancelLoopCallback();
+    ::close(fd_);
+  }
+
+  void setInput(std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber) {
+    if (inputSubscriber && isClosed()) {
+      inputSubscriber->onComplete();
+      return;
+    }
+
+    if (!inputSubscriber) {
+      inputSubscriber_ = nullptr;
+      readAllowance_.consumeAll();
+      return;
+    }
+
+    CHECK(!inputSubscriber_);
+    inputSubscriber_ = std::move(inputSubscriber);
+    deliverReads();
+    armRecv();
+  }
+
+  /// Allows `n` more reads to be delivered to the input subscriber.  The
+  /// receive is cancelled while there are none left.
+  void requestReads(int64_t n) {
+    if (n <= 0) {
+      return;
+    }
+    readAllowance_.add(n);
+    deliverReads();
+    armRecv();
+  }
+
+  void send(std::unique_ptr<folly::IOBuf> element) {
+    if (isClosed()) {
+      return;
+    }
+
+    auto const size = element->computeChainDataLength();
+    if (stats_) {
+      stats_->bytesWritten(size);
+    }
+    bufferedBytes_ += size;
+    writeQueue_.append(std::move(element));
+
+    if (writable_ && bufferedBytes_ > watermarks_.high) {
+      setWritable(false);
+    }
+
+    // Everything sent until the end of the loop iteration is written at once.
+    if (!sendInFlight_ && !isLoopCallbackScheduled()) {
+      context_->eventBase().runInLoop(this);
+    }
+  }
+
+  void setWriteWatermarks(
+      WriteWatermarks watermarks,
+      DuplexConnection::WritabilityCallback callback) {
+    watermarks_ = watermarks;
+    writabilityCallback_ = std::move(callback);
+    if (bufferedBytes_ > watermarks_.high) {
+      setWritable(false);
+    }
+  }
+
+  /// Stops reading.  The socket is shut down once the queued frames are
+  /// written.
+  void close() {
+    if (isClosed()) {
+      return;
+    }
+    closed_ = true;
+    writabilityCallback_ = nullptr;
+    pendingReads_.clear();
+    cancelRecv();
+    // A pending write keeps the socket alive until everything is written.
+    flush();
+    if (!sendInFlight_) {
+      shutdown();
+    }
+    if (auto subscriber = std::move(inputSubscriber_)) {
+      subscriber->onComplete();
+    }
+  }
+
+  void closeErr(folly::exception_wrapper ew) {
+    if (isClosed()) {
+      return;
+    }
+    closed_ = true;
+    writabilityCallback_ = nullptr;
+    pendingReads_.clear();
+    writeQueue_.move();
+    cancelRecv();
+    shutdown();
+    if (auto subscriber = std::move(inputSubscriber_)) {
+      subscriber->onError(std::move(ew));
+    }
+  }
+
+ private:
+  /// Routes the completions of one kind of request back to the socket.
+  class Op : public IoUringContext::Operation {
+   public:
+    using Handler = void (IoUringSocket::*)(const io_uring_cqe&);
+
+    Op(IoUringSocket& socket, Handler handler)
+        : socket_(socket), handler_(handler) {}
+
+    void onCompletion(const io_uring_cqe& cqe) override {
+      (socket_.*handler_)(cqe);
+    }
+
+   private:
+    IoUringSocket& socket_;
+    const Handler handler_;
+  };
+
+  bool isClosed() const {
+    return closed_;
+  }
+
+  void shutdown() {
+    ::shutdown(fd_, SHUT_RDWR);
+  }
+
+  void setWritable(bool writable) {
+    writable_ = writable;
+    if (auto callback = writabilityCallback_) {
+      callback(writable);
+    }
+  }
+
+  void armRecv() {
+    if (isClosed() || recvArmed_ || !inputSubscriber_ ||
+        !readAllowance_.canConsume(1)) {
+      return;
+    }
+
+    auto const sqe = context_->getSqe(&recvOp_);
+    io_uring_prep_recv_multishot(sqe, fd_, nullptr, 0, 0);
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = context_->bufferGroup();
+
+    recvArmed_ = true;
+    recvCancelled_ = false;
+    // The receive holds a reference until its final completion.
+    intrusive_ptr_add_ref(this);
+  }
+
+  void cancelRecv() {
+    if (!recvArmed_ || recvCancelled_) {
+      return;
+    }
+    recvCancelled_ = true;
+    io_uring_prep_cancel(context_->getSqe(nullptr), &recvOp_, 0);
+  }
+
+  void recvCompleted(const io_uring_cqe& cqe) {
+    boost::intrusive_ptr<IoUringSocket> self{this};
+
+    auto const more = cqe.flags & IORING_CQE_F_MORE;
+    if (!more) {
+      recvArmed_ = false;
+      intrusive_ptr_release(this);
+    }
+
+    if (cqe.res > 0) {
+      // Always take the buffer so it goes back to the ring.
+      auto buf = context_->takeBuffer(cqe);
+      if (stats_) {
+        stats_->bytesRead(buf->length());
+      }
+      if (isClosed()) {
+        return;
+      }
+      pendingReads_.push_back(std::move(buf));
+      deliverReads();
+    } else if (cqe.res == 0) {
+      close();
+      return;
+    } else if (cqe.res != -ENOBUFS && cqe.res != -ECANCELED) {
+      closeErr(makeError(-cqe.res, "recv"));
+      return;
+    }
+
+    if (!readAllowance_.canConsume(1)) {
+      cancelRecv();
+    } else if (!more) {
+      armRecv();
+    }
+  }
+
+  void deliverReads() {
+    if (deliveringReads_) {
+      return;
+    }
+    deliveringReads_ = true;
+    while (inputSubscriber_ && !pendingReads_.empty() &&
+           readAllowance_.tryConsume(1)) {
+      auto buf = std::move(pendingReads_.front());
+      pendingReads_.pop_front();
+      inputSubscriber_->onNext(std::move(buf));
+    }
+    deliveringReads_ = false;
+  }
+
+  // LoopCallback, writes out the frames queued during the iteration.
+  void runLoopCallback() noexcept override {
+    flush();
+  }
+
+  void flush() {
+    if (sendInFlight_ || writeQueue_.empty()) {
+      return;
+    }
+
+    inFlight_ = writeQueue_.move();
+    iovecs_.clear();
+    inFlight_->appendToIov(&iovecs_);
+    if (iovecs_.size() > kMaxIovecs) {
+      iovecs_.resize(kMaxIovecs);
+    }
+
+    msg_ = {};
+    msg_.msg_iov = iovecs_.data();
+    msg_.msg_iovlen = iovecs_.size();
+
+    io_uring_prep_sendmsg(context_->getSqe(&sendOp_), fd_, &msg_, MSG_NOSIGNAL);
+    sendInFlight_ = true;
+    intrusive_ptr_add_ref(this);
+  }
+
+  void sendCompleted(const io_uring_cqe& cqe) {
+    // Adopt the reference taken by flush().
+    boost::intrusive_ptr<IoUringSocket> self{this, false};
+    sendInFlight_ = false;
+
+    if (cqe.res < 0) {
+      inFlight_.reset();
+      bufferedBytes_ = 0;
+      closeErr(makeError(-cqe.res, "sendmsg"));
+      return;
+    }
+
+    // Requeue whatever didn't make it in front of the newer frames.
+    folly::IOBufQueue rest{folly::IOBufQueue::cacheChainLength()};
+    rest.append(std::move(inFlight_));
+    rest.trimStart(static_cast<size_t>(cqe.res));
+    bufferedBytes_ -= cqe.res;
+    if (!rest.empty()) {
+      auto remaining = rest.move();
+      if (!writeQueue_.empty()) {
+        remaining->prependChain(writeQueue_.move());
+      }
+      writeQueue_.append(std::move(remaining));
+    }
+
+    if (!writable_ && bufferedBytes_ <= watermarks_.low && !isClosed()) {
+      setWritable(true);
+    }
+
+    if (!writeQueue_.empty()) {
+      flush();
+    } else if (isClosed()) {
+      shutdown();
+    }
+  }
+
+  const int fd_;
+  const std::shared_ptr<IoUringContext> context_;
+  const std::shared_ptr<RSocketStats> stats_;
+
+  std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber_;
+  /// Reads the input subscriber has requested.
+  Allowance readAllowance_;
+  /// Received buffers waiting for credits.
+  std::deque<std::unique_ptr<folly::IOBuf>> pendingReads_;
+  bool deliveringReads_{false};
+
+  Op recvOp_{*this, &IoUringSocket::recvCompleted};
+  bool recvArmed_{false};
+  bool recvCancelled_{false};
+
+  Op sendOp_{*this, &IoUringSocket::sendCompleted};
+  folly::IOBufQueue writeQueue_{folly::IOBufQueue::cacheChainLength()};
+  std::unique_ptr<folly::IOBuf> inFlight_;
+  folly::fbvector<iovec> iovecs_;
+  msghdr msg_{};
+  bool sendInFlight_{false};
+
+  /// Bytes queued or being written.
+  size_t bufferedBytes_{0};
+  WriteWatermarks watermarks_;
+  DuplexConnection::WritabilityCallback writabilityCallback_;
+  bool writable_{true};
+
+  bool closed_{false};
+  int refCount_{0};
+};
+
+void intrusive_ptr_add_ref(IoUringSocket* x);
+void intrusive_ptr_release(IoUringSocket* x);
+
+void intrusive_ptr_add_ref(IoUringSocket* x) {
+  ++x->refCount_;
+}
+
+void intrusive_ptr_release(IoUringSocket* x) {
+  if (--x->refCount_ == 0)
+    delete x;
+}
+
+namespace {
+
+class IoUringInputSubscription : public Subscription {
+ public:
+  explicit IoUringInputSubscription(boost::intrusive_ptr<IoUringSocket> socket)
+      : socket_(std::move(socket)) {
+    CHECK(socket_);
+  }
+
+  void request(int64_t n) noexcept override {
+    if (socket_) {
+      socket_->requestReads(n);
+    }
+  }
+
+  void cancel() noexcept override {
+    socket_->setInput(nullptr);
+    socket_ = nullptr;
+  }
+
+ private:
+  boost::intrusive_ptr<IoUringSocket> socket_;
+};
+
+} // namespace
+
+IoUringDuplexConnection::IoUringDuplexConnection(
+    folly::NetworkSocket socket,
+    folly::EventBase& eventBase,
+    std::shared_ptr<RSocketStats> stats)
+    : socket_(new IoUringSocket(socket, eventBase, stats)),
+      stats_(std::move(stats)) {
+  if (stats_) {
+    stats_->duplexConnectionCreated("io_uring", this);
+  }
+}
+
+IoUringDuplexConnection::~IoUringDuplexConnection() {
+  if (stats_) {
+    stats_->duplexConnectionClosed("io_uring", this);
+  }
+  socket_->close();
+}
+
+void IoUringDuplexConnection::send(std::unique_ptr<folly::IOBuf> buf) {
+  if (socket_) {
+    socket_->send(std::move(buf));
+  }
+}
+
+void IoUringDuplexConnection::setWriteWatermarks(
+    WriteWatermarks watermarks,
+    WritabilityCallback callback) {
+  if (socket_) {
+    socket_->setWriteWatermarks(watermarks, std::move(callback));
+  }
+}
+
+void IoUringDuplexConnection::setInput(
+    std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber) {
+  inputSubscriber->onSubscribe(
+      std::make_shared<IoUringInputSubscription>(socket_));
+  socket_->setInput(std::move(inputSubscriber));
+}
+
+} // namespace rsocket
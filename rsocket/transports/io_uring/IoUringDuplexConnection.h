@@ -0,0 +1,57 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+#include <folly/net/NetworkSocket.h>
+
+#include "rsocket/DuplexConnection.h"
+#include "rsocket/RSocketStats.h"
+
+namespace folly {
+class EventBase;
+}
+
+namespace rsocket {
+
+class IoUringSocket;
+
+/// DuplexConnection over a connected TCP socket, driven by the io_uring
+/// instance of the EventBase instead of epoll.
+///
+/// Reads use a multishot receive that stays armed for as long as the input has
+/// credits.  Frames sent during a loop iteration are written with a single
+/// sendmsg.  Must be used from the EventBase's thread only.
+class IoUringDuplexConnection : public DuplexConnection {
+ public:
+  /// Takes ownership of the socket.
+  IoUringDuplexConnection(
+      folly::NetworkSocket socket,
+      folly::EventBase& eventBase,
+      std::shared_ptr<RSocketStats> stats = RSocketStats::noop());
+  ~IoUringDuplexConnection();
+
+  void send(std::unique_ptr<folly::IOBuf>) override;
+
+  void setInput(std::shared_ptr<DuplexConnection::Subscriber>) override;
+
+  void setWriteWatermarks(WriteWatermarks, WritabilityCallback) override;
+
+ private:
+  boost::intrusive_ptr<IoUringSocket> socket_;
+  std::shared_ptr<RSocketStats> stats_;
+};
+
+} // namespace rsocket
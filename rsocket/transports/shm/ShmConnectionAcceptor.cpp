@@ -0,0 +1,143 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/shm/ShmConnectionAcceptor.h"
+
+#include <folly/Format.h>
+#include <folly/futures/Future.h>
+
+#include <unistd.h>
+
+#include "rsocket/transports/shm/ShmDuplexConnection.h"
+#include "rsocket/transports/shm/ShmRing.h"
+
+namespace rsocket {
+
+class ShmConnectionAcceptor::SocketCallback
+    : public folly::AsyncServerSocket::AcceptCallback {
+ public:
+  SocketCallback(
+      OnDuplexConnectionAccept& onAccept,
+      size_t ringSize,
+      std::shared_ptr<RSocketStats> stats)
+      : thread_{folly::sformat("rsshm-acceptor")},
+        onAccept_{onAccept},
+        ringSize_{ringSize},
+        stats_{std::move(stats)} {}
+
+  void connectionAccepted(
+      folly::NetworkSocket fdNetworkSocket,
+      const folly::SocketAddress&) noexcept override {
+    VLOG(2) << "Accepting shared memory connection on FD "
+            << fdNetworkSocket.toFd();
+
+    folly::File control{fdNetworkSocket.toFd(), true};
+    std::unique_ptr<ShmDuplexConnection> connection;
+    try {
+      connection = ShmDuplexConnection::accept(
+          *eventBase(), std::move(control), ringSize_, stats_);
+    } catch (const std::exception& exn) {
+      LOG(ERROR) << "Shared memory handshake failed: " << exn.what();
+      return;
+    }
+    onAccept_(std::move(connection), *eventBase());
+  }
+
+  void acceptError(folly::exception_wrapper ex) noexcept override {
+    VLOG(2) << "Shared memory listener error: " << ex;
+  }
+
+  folly::EventBase* eventBase() const {
+    return thread_.getEventBase();
+  }
+
+ private:
+  /// The thread running this callback.
+  folly::ScopedEventBaseThread thread_;
+
+  /// Reference to the ConnectionAcceptor's callback.
+  OnDuplexConnectionAccept& onAccept_;
+
+  const size_t ringSize_;
+  const std::shared_ptr<RSocketStats> stats_;
+};
+
+ShmConnectionAcceptor::ShmConnectionAcceptor(Options options)
+    : options_(std::move(options)) {}
+
+ShmConnectionAcceptor::~ShmConnectionAcceptor() {
+  if (serverThread_) {
+    stop();
+    serverThread_.reset();
+  }
+}
+
+void ShmConnectionAcceptor::start(OnDuplexConnectionAccept onAccept) {
+  if (onAccept_ != nullptr) {
+    throw std::runtime_error("ShmConnectionAcceptor::start() already called");
+  }
+  if (options_.path.empty()) {
+    throw std::invalid_argument("ShmConnectionAcceptor needs a socket path");
+  }
+  if (options_.ringSize <= ShmRing::kRecordHeaderSize ||
+      (options_.ringSize & (options_.ringSize - 1)) != 0) {
+    throw std::invalid_argument(
+        "ShmConnectionAcceptor needs a power of two ring size");
+  }
+
+  onAccept_ = std::move(onAccept);
+  serverThread_ =
+      std::make_unique<folly::ScopedEventBaseThread>("rsshm-listener");
+
+  callbacks_.reserve(options_.threads);
+  for (size_t i = 0; i < options_.threads; ++i) {
+    callbacks_.push_back(
+        std::make_unique<SocketCallback>(
+            onAccept_, options_.ringSize, options_.stats));
+  }
+
+  VLOG(1) << "Starting shared memory listener on " << options_.path << " with "
+          << options_.threads << " request threads";
+
+  serverSocket_.reset(
+      new folly::AsyncServerSocket(serverThread_->getEventBase()));
+
+  // The AsyncServerSocket needs to be accessed from the listener thread only.
+  // This will propagate out any exceptions the listener throws.
+  folly::via(serverThread_->getEventBase(), [this] {
+    ::unlink(options_.path.c_str());
+    serverSocket_->bind(folly::SocketAddress::makeFromPath(options_.path));
+
+    for (auto const& callback : callbacks_) {
+      serverSocket_->addAcceptCallback(callback.get(), callback->eventBase());
+    }
+
+    serverSocket_->listen(options_.backlog);
+    serverSocket_->startAccepting();
+  }).get();
+}
+
+void ShmConnectionAcceptor::stop() {
+  VLOG(1) << "Shutting down shared memory listener";
+
+  serverThread_->getEventBase()->runInEventBaseThreadAndWait(
+      [serverSocket = std::move(serverSocket_)]() {});
+  ::unlink(options_.path.c_str());
+}
+
+folly::Optional<uint16_t> ShmConnectionAcceptor::listeningPort() const {
+  return folly::none;
+}
+
+} // namespace rsocket
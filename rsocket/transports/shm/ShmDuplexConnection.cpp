@@ -0,0 +1,592 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/shm/ShmDuplexConnection.h"
+
+#include <folly/ExceptionWrapper.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventHandler.h>
+#include <glog/logging.h>
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <system_error>
+
+#include "rsocket/internal/Allowance.h"
+#include "rsocket/transports/shm/ShmRing.h"
+#include "yarpl/flowable/Subscription.h"
+
+namespace rsocket {
+
+using namespace yarpl::flowable;
+
+namespace {
+
+constexpr uint32_t kHandshakeMagic{0x52534d31}; // "RSM1"
+
+/// Sent by the server along with the memfd, the client's doorbell and the
+/// server's doorbell.
+struct HandshakeMessage {
+  uint32_t magic;
+  uint32_t reserved;
+  uint64_t ringSize;
+};
+
+constexpr size_t kHandshakeFds{3};
+
+[[noreturn]] void throwErrno(const char* what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+folly::File makeEventFd() {
+  auto const fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (fd < 0) {
+    throwErrno("eventfd");
+  }
+  return folly::File{fd, true};
+}
+
+void* mapRings(int fd, size_t ringSize) {
+  auto const memory = ::mmap(
+      nullptr,
+      ShmDuplexConnection::mappingSize(ringSize),
+      PROT_READ | PROT_WRITE,
+      MAP_SHARED,
+      fd,
+      0);
+  if (memory == MAP_FAILED) {
+    throwErrno("mmap");
+  }
+  return memory;
+}
+
+} // namespace
+
+class ShmEndpoint : public std::enable_shared_from_this<ShmEndpoint> {
+ public:
+  ShmEndpoint(
+      folly::EventBase& eventBase,
+      void* memory,
+      size_t ringSize,
+      ShmDuplexConnection::Role role,
+      folly::File doorbell,
+      folly::File peerDoorbell,
+      folly::File control,
+      std::shared_ptr<RSocketStats> stats)
+      : memory_(memory),
+        ringSize_(ringSize),
+        tx_(ringAt(role == ShmDuplexConnection::Role::Client ? 0 : 1)),
+        rx_(ringAt(role == ShmDuplexConnection::Role::Client ? 1 : 0)),
+        doorbell_(std::move(doorbell)),
+        peerDoorbell_(std::move(peerDoorbell)),
+        control_(std::move(control)),
+        stats_(std::move(stats)),
+        doorbellHandler_(
+            eventBase,
+            doorbell_.fd(),
+            *this,
+            &ShmEndpoint::onDoorbell),
+        controlHandler_(
+            eventBase,
+            control_.fd(),
+            *this,
+            &ShmEndpoint::onControl) {}
+
+  ~ShmEndpoint() {
+    DCHECK(closed_);
+    ::munmap(memory_, ShmDuplexConnection::mappingSize(ringSize_));
+  }
+
+  void setInput(std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber) {
+    if (inputSubscriber && closed_) {
+      inputSubscriber->onComplete();
+      return;
+    }
+
+    if (!inputSubscriber) {
+      inputSubscriber_ = nullptr;
+      readAllowance_.consumeAll();
+      return;
+    }
+
+    CHECK(!inputSubscriber_);
+    inputSubscriber_ = std::move(inputSubscriber);
+    readFrames();
+  }
+
+  void requestReads(int64_t n) {
+    if (n <= 0) {
+      return;
+    }
+    readAllowance_.add(n);
+    readFrames();
+  }
+
+  void send(std::unique_ptr<folly::IOBuf> frame) {
+    if (closed_) {
+      return;
+    }
+
+    auto const size = frame->computeChainDataLength();
+    if (stats_) {
+      stats_->bytesWritten(size);
+    }
+    if (size > tx_.maxRecordSize()) {
+      closeErr(std::runtime_error{"Frame doesn't fit in the shared ring"});
+      return;
+    }
+
+    if (pendingWrites_.empty() && tx_.tryWrite(*frame)) {
+      if (tx_.takeReaderParked()) {
+        ringPeer();
+      }
+      return;
+    }
+
+    pendingBytes_ += size;
+    pendingWrites_.push_back(std::move(frame));
+    if (writable_ && pendingBytes_ > watermarks_.high) {
+      setWritable(false);
+    }
+    flushWrites();
+  }
+
+  void setWriteWatermarks(
+      WriteWatermarks watermarks,
+      DuplexConnection::WritabilityCallback callback) {
+    watermarks_ = watermarks;
+    writabilityCallback_ = std::move(callback);
+    if (pendingBytes_ > watermarks_.high) {
+      setWritable(false);
+    }
+  }
+
+  /// Frames still waiting for space in the ring are dropped.
+  void close() {
+    if (closeEndpoint()) {
+      if (auto subscriber = std::move(inputSubscriber_)) {
+        subscriber->onComplete();
+      }
+    }
+  }
+
+  void closeErr(folly::exception_wrapper ew) {
+    if (closeEndpoint()) {
+      if (auto subscriber = std::move(inputSubscriber_)) {
+        subscriber->onError(std::move(ew));
+      }
+    }
+  }
+
+ private:
+  /// Calls back into the endpoint when a descriptor becomes readable.
+  class Handler : public folly::EventHandler {
+   public:
+    using Callback = void (ShmEndpoint::*)();
+
+    Handler(
+        folly::EventBase& eventBase,
+        int fd,
+        ShmEndpoint& endpoint,
+        Callback callback)
+        : folly::EventHandler(&eventBase, folly::NetworkSocket::fromFd(fd)),
+          endpoint_(endpoint),
+          callback_(callback) {
+      registerHandler(folly::EventHandler::READ | folly::EventHandler::PERSIST);
+    }
+
+    void handlerReady(uint16_t) noexcept override {
+      (endpoint_.*callback_)();
+    }
+
+   private:
+    ShmEndpoint& endpoint_;
+    const Callback callback_;
+  };
+
+  ShmRing ringAt(size_t index) const {
+    return ShmRing{static_cast<uint8_t*>(memory_) +
+                       index * ShmRing::regionSize(ringSize_),
+                   ringSize_};
+  }
+
+  /// Returns false if the endpoint was closed already.
+  bool closeEndpoint() {
+    if (closed_) {
+      return false;
+    }
+    closed_ = true;
+    writabilityCallback_ = nullptr;
+    pendingWrites_.clear();
+    pendingBytes_ = 0;
+
+    tx_.closeWriter();
+    ringPeer();
+
+    doorbellHandler_.unregisterHandler();
+    controlHandler_.unregisterHandler();
+    ::shutdown(control_.fd(), SHUT_RDWR);
+    return true;
+  }
+
+  void ringPeer() {
+    uint64_t const one = 1;
+    auto const written = ::write(peerDoorbell_.fd(), &one, sizeof(one));
+    DCHECK(written == sizeof(one) || errno == EAGAIN);
+  }
+
+  void setWritable(bool writable) {
+    writable_ = writable;
+    if (auto callback = writabilityCallback_) {
+      callback(writable);
+    }
+  }
+
+  void onDoorbell() {
+    auto const self = shared_from_this();
+
+    uint64_t count;
+    while (::read(doorbell_.fd(), &count, sizeof(count)) > 0) {
+    }
+
+    flushWrites();
+    readFrames();
+  }
+
+  void onControl() {
+    auto const self = shared_from_this();
+
+    // Nothing is sent after the handshake, this is the peer going away.
+    char byte;
+    auto const received = ::recv(control_.fd(), &byte, sizeof(byte), 0);
+    if (received == 0) {
+      close();
+    } else if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+      closeErr(std::system_error{errno, std::generic_category(), "recv"});
+    }
+  }
+
+  void flushWrites() {
+    bool wrote = false;
+    while (!closed_ && !pendingWrites_.empty()) {
+      auto const& frame = *pendingWrites_.front();
+      auto const size = frame.computeChainDataLength();
+      if (tx_.tryWrite(frame)) {
+        wrote = true;
+        pendingBytes_ -= size;
+        pendingWrites_.pop_front();
+        continue;
+      }
+      // The doorbell rings once the reader made enough space.
+      if (tx_.parkWriter(ShmRing::kRecordHeaderSize + size)) {
+        break;
+      }
+    }
+
+    if (wrote && tx_.takeReaderParked()) {
+      ringPeer();
+    }
+    if (!writable_ && pendingBytes_ <= watermarks_.low && !closed_) {
+      setWritable(true);
+    }
+  }
+
+  void readFrames() {
+    if (readingFrames_) {
+      return;
+    }
+    readingFrames_ = true;
+
+    bool consumed = false;
+    bool drained = false;
+    while (!closed_ && inputSubscriber_ && readAllowance_.canConsume(1)) {
+      // Records written before the ring was closed are visible after this.
+      auto const writerClosed = rx_.writerClosed();
+      std::unique_ptr<folly::IOBuf> frame;
+      try {
+        frame = rx_.read();
+      } catch (const std::exception& ex) {
+        closeErr(folly::exception_wrapper{std::current_exception(), ex});
+        break;
+      }
+      if (!frame) {
+        if (writerClosed) {
+          drained = true;
+          break;
+        }
+        if (rx_.parkReader()) {
+          break;
+        }
+        continue;
+      }
+
+      consumed = true;
+      readAllowance_.tryConsume(1);
+      if (stats_) {
+        stats_->bytesRead(frame->length());
+      }
+      inputSubscriber_->onNext(std::move(frame));
+    }
+
+    readingFrames_ = false;
+
+    if (consumed && !closed_ && rx_.takeWriterParked()) {
+      ringPeer();
+    }
+    if (drained) {
+      close();
+    }
+  }
+
+  void* const memory_;
+  const size_t ringSize_;
+  ShmRing tx_;
+  ShmRing rx_;
+
+  folly::File doorbell_;
+  folly::File peerDoorbell_;
+  folly::File control_;
+  const std::shared_ptr<RSocketStats> stats_;
+
+  std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber_;
+  /// Frames the input subscriber has requested.
+  Allowance readAllowance_;
+  bool readingFrames_{false};
+
+  /// Frames waiting for space in the ring.
+  std::deque<std::unique_ptr<folly::IOBuf>> pendingWrites_;
+  size_t pendingBytes_{0};
+  WriteWatermarks watermarks_;
+  DuplexConnection::WritabilityCallback writabilityCallback_;
+  bool writable_{true};
+
+  bool closed_{false};
+
+  Handler doorbellHandler_;
+  Handler controlHandler_;
+};
+
+namespace {
+
+class ShmInputSubscription : public Subscription {
+ public:
+  explicit ShmInputSubscription(std::shared_ptr<ShmEndpoint> endpoint)
+      : endpoint_(std::move(endpoint)) {
+    CHECK(endpoint_);
+  }
+
+  void request(int64_t n) noexcept override {
+    if (endpoint_) {
+      endpoint_->requestReads(n);
+    }
+  }
+
+  void cancel() noexcept override {
+    endpoint_->setInput(nullptr);
+    endpoint_ = nullptr;
+  }
+
+ private:
+  std::shared_ptr<ShmEndpoint> endpoint_;
+};
+
+} // namespace
+
+std::unique_ptr<ShmDuplexConnection> ShmDuplexConnection::accept(
+    folly::EventBase& eventBase,
+    folly::File control,
+    size_t ringSize,
+    std::shared_ptr<RSocketStats> stats) {
+  auto const memfd = ::memfd_create("rsocket-shm", MFD_CLOEXEC);
+  if (memfd < 0) {
+    throwErrno("memfd_create");
+  }
+  folly::File memoryFile{memfd, true};
+  if (::ftruncate(memoryFile.fd(), mappingSize(ringSize)) != 0) {
+    throwErrno("ftruncate");
+  }
+
+  auto const memory = mapRings(memoryFile.fd(), ringSize);
+  for (size_t i = 0; i < 2; ++i) {
+    ShmRing{static_cast<uint8_t*>(memory) + i * ShmRing::regionSize(ringSize),
+            ringSize}
+        .initialize();
+  }
+
+  std::unique_ptr<ShmDuplexConnection> connection;
+  try {
+    auto clientDoorbell = makeEventFd();
+    auto serverDoorbell = makeEventFd();
+
+    HandshakeMessage message{kHandshakeMagic, 0, ringSize};
+    iovec iov{&message, sizeof(message)};
+
+    int fds[kHandshakeFds] = {
+        memoryFile.fd(), clientDoorbell.fd(), serverDoorbell.fd()};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))] = {};
+
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    auto const cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    std::memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    if (::sendmsg(control.fd(), &msg, MSG_NOSIGNAL) !=
+        static_cast<ssize_t>(sizeof(message))) {
+      throwErrno("sendmsg");
+    }
+
+    connection = std::make_unique<ShmDuplexConnection>(
+        eventBase,
+        memory,
+        ringSize,
+        Role::Server,
+        std::move(serverDoorbell),
+        std::move(clientDoorbell),
+        std::move(control),
+        std::move(stats));
+  } catch (...) {
+    ::munmap(memory, mappingSize(ringSize));
+    throw;
+  }
+  return connection;
+}
+
+std::unique_ptr<ShmDuplexConnection> ShmDuplexConnection::receive(
+    folly::EventBase& eventBase,
+    folly::File& control,
+    std::shared_ptr<RSocketStats> stats) {
+  HandshakeMessage message{};
+  iovec iov{&message, sizeof(message)};
+
+  int fds[kHandshakeFds];
+  alignas(cmsghdr) char buffer[CMSG_SPACE(sizeof(fds))] = {};
+
+  msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = buffer;
+  msg.msg_controllen = sizeof(buffer);
+
+  auto const received = ::recvmsg(control.fd(), &msg, MSG_CMSG_CLOEXEC);
+  if (received < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      return nullptr;
+    }
+    throwErrno("recvmsg");
+  }
+
+  auto const cmsg = CMSG_FIRSTHDR(&msg);
+  if (!cmsg || cmsg->cmsg_level != SOL_SOCKET ||
+      cmsg->cmsg_type != SCM_RIGHTS ||
+      cmsg->cmsg_len != CMSG_LEN(sizeof(fds))) {
+    throw std::runtime_error{"Shared memory handshake without descriptors"};
+  }
+  std::memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+  folly::File memoryFile{fds[0], true};
+  folly::File doorbell{fds[1], true};
+  folly::File peerDoorbell{fds[2], true};
+
+  if (received != static_cast<ssize_t>(sizeof(message)) ||
+      message.magic != kHandshakeMagic) {
+    throw std::runtime_error{"Invalid shared memory handshake"};
+  }
+
+  auto const ringSize = static_cast<size_t>(message.ringSize);
+  if (ringSize <= ShmRing::kRecordHeaderSize ||
+      (ringSize & (ringSize - 1)) != 0) {
+    throw std::runtime_error{"Invalid shared memory ring size"};
+  }
+  auto const memory = mapRings(memoryFile.fd(), ringSize);
+  try {
+    return std::make_unique<ShmDuplexConnection>(
+        eventBase,
+        memory,
+        ringSize,
+        Role::Client,
+        std::move(doorbell),
+        std::move(peerDoorbell),
+        std::move(control),
+        std::move(stats));
+  } catch (...) {
+    ::munmap(memory, mappingSize(ringSize));
+    throw;
+  }
+}
+
+size_t ShmDuplexConnection::mappingSize(size_t ringSize) {
+  return 2 * ShmRing::regionSize(ringSize);
+}
+
+ShmDuplexConnection::ShmDuplexConnection(
+    folly::EventBase& eventBase,
+    void* memory,
+    size_t ringSize,
+    Role role,
+    folly::File doorbell,
+    folly::File peerDoorbell,
+    folly::File control,
+    std::shared_ptr<RSocketStats> stats)
+    : endpoint_(std::make_shared<ShmEndpoint>(
+          eventBase,
+          memory,
+          ringSize,
+          role,
+          std::move(doorbell),
+          std::move(peerDoorbell),
+          std::move(control),
+          stats)),
+      stats_(std::move(stats)) {
+  if (stats_) {
+    stats_->duplexConnectionCreated("shm", this);
+  }
+}
+
+ShmDuplexConnection::~ShmDuplexConnection() {
+  if (stats_) {
+    stats_->duplexConnectionClosed("shm", this);
+  }
+  endpoint_->close();
+}
+
+void ShmDuplexConnection::send(std::unique_ptr<folly::IOBuf> buf) {
+  endpoint_->send(std::move(buf));
+}
+
+void ShmDuplexConnection::setWriteWatermarks(
+    WriteWatermarks watermarks,
+    WritabilityCallback callback) {
+  endpoint_->setWriteWatermarks(watermarks, std::move(callback));
+}
+
+void ShmDuplexConnection::setInput(
+    std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber) {
+  inputSubscriber->onSubscribe(
+      std::make_shared<ShmInputSubscription>(endpoint_));
+  endpoint_->setInput(std::move(inputSubscriber));
+}
+
+} // namespace rsocket
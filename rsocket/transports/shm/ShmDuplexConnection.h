@@ -0,0 +1,95 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/File.h>
+
+#include "rsocket/DuplexConnection.h"
+#include "rsocket/RSocketStats.h"
+
+namespace folly {
+class EventBase;
+}
+
+namespace rsocket {
+
+class ShmEndpoint;
+
+/// DuplexConnection between two processes on the same host, over a pair of
+/// ShmRings in a shared memfd mapping.
+///
+/// Each side owns an eventfd doorbell that the other side rings only when it
+/// finds the first side parked, waiting for records or for space.  The Unix
+/// domain socket used for the handshake stays open to notice when the peer
+/// goes away.
+///
+/// Frames are copied straight from the outgoing IOBuf chains into the ring,
+/// and from the ring into a single buffer per incoming frame.  A frame must fit
+/// in the ring.  Must be used from the EventBase's thread only.
+class ShmDuplexConnection : public DuplexConnection {
+ public:
+  enum class Role { Client, Server };
+
+  /// Default capacity of each of the two rings.
+  static constexpr size_t kDefaultRingSize{1 << 20};
+
+  /// Server side of the handshake.  Creates the shared memory and the
+  /// doorbells, and passes them to the client over the connected Unix domain
+  /// socket.
+  static std::unique_ptr<ShmDuplexConnection> accept(
+      folly::EventBase&,
+      folly::File control,
+      size_t ringSize,
+      std::shared_ptr<RSocketStats> stats = RSocketStats::noop());
+
+  /// Client side of the handshake, when `control` is readable.  Returns null
+  /// if the server's message hasn't arrived yet.  Throws if the handshake
+  /// failed.
+  static std::unique_ptr<ShmDuplexConnection> receive(
+      folly::EventBase&,
+      folly::File& control,
+      std::shared_ptr<RSocketStats> stats = RSocketStats::noop());
+
+  /// Takes over the mapping of both rings, which starts at `memory`.
+  ShmDuplexConnection(
+      folly::EventBase&,
+      void* memory,
+      size_t ringSize,
+      Role,
+      folly::File doorbell,
+      folly::File peerDoorbell,
+      folly::File control,
+      std::shared_ptr<RSocketStats> stats);
+  ~ShmDuplexConnection();
+
+  /// Bytes mapped for the two rings of the given size.
+  static size_t mappingSize(size_t ringSize);
+
+  void send(std::unique_ptr<folly::IOBuf>) override;
+
+  void setInput(std::shared_ptr<DuplexConnection::Subscriber>) override;
+
+  void setWriteWatermarks(WriteWatermarks, WritabilityCallback) override;
+
+  bool isFramed() const override {
+    return true;
+  }
+
+ private:
+  std::shared_ptr<ShmEndpoint> endpoint_;
+  std::shared_ptr<RSocketStats> stats_;
+};
+
+} // namespace rsocket
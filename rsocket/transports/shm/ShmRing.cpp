@@ -0,0 +1,175 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/shm/ShmRing.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+namespace rsocket {
+
+/// Shared header.  The indices grow forever and are taken modulo the
+/// capacity, they can't realistically wrap around 64 bits.  Each of them is on
+/// its own cache line so the two sides don't contend.
+struct ShmRing::Header {
+  /// Written by the writer.
+  alignas(64) std::atomic<uint64_t> head;
+  /// Written by the reader.
+  alignas(64) std::atomic<uint64_t> tail;
+
+  alignas(64) std::atomic<uint32_t> readerParked;
+  std::atomic<uint32_t> writerParked;
+  std::atomic<uint32_t> closed;
+};
+
+static_assert(
+    ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+    "Atomics in shared memory must be lock free");
+
+ShmRing::ShmRing(void* memory, size_t capacity)
+    : header_(static_cast<Header*>(memory)),
+      data_(static_cast<uint8_t*>(memory) + sizeof(Header)),
+      capacity_(capacity) {
+  CHECK_GT(capacity_, kRecordHeaderSize);
+  CHECK_EQ(capacity_ & (capacity_ - 1), 0u)
+      << "The ring capacity must be a power of two";
+}
+
+size_t ShmRing::regionSize(size_t capacity) {
+  return sizeof(Header) + capacity;
+}
+
+void ShmRing::initialize() {
+  new (header_) Header();
+  header_->head.store(0);
+  header_->tail.store(0);
+  header_->readerParked.store(0);
+  header_->writerParked.store(0);
+  header_->closed.store(0);
+}
+
+size_t ShmRing::used() const {
+  return header_->head.load(std::memory_order_acquire) -
+      header_->tail.load(std::memory_order_acquire);
+}
+
+void ShmRing::copyIn(uint64_t position, const void* data, size_t length) {
+  auto const offset = position & (capacity_ - 1);
+  auto const first = std::min(length, capacity_ - offset);
+  std::memcpy(data_ + offset, data, first);
+  std::memcpy(data_, static_cast<const uint8_t*>(data) + first, length - first);
+}
+
+void ShmRing::copyOut(uint64_t position, void* data, size_t length) const {
+  auto const offset = position & (capacity_ - 1);
+  auto const first = std::min(length, capacity_ - offset);
+  std::memcpy(data, data_ + offset, first);
+  std::memcpy(static_cast<uint8_t*>(data) + first, data_, length - first);
+}
+
+bool ShmRing::tryWrite(const folly::IOBuf& record) {
+  auto const length = record.computeChainDataLength();
+  DCHECK_LE(length, maxRecordSize());
+
+  auto const needed = kRecordHeaderSize + length;
+  auto const head = header_->head.load(std::memory_order_relaxed);
+  auto const tail = header_->tail.load(std::memory_order_acquire);
+  if (capacity_ - (head - tail) < needed) {
+    return false;
+  }
+
+  auto const length32 = static_cast<uint32_t>(length);
+  copyIn(head, &length32, kRecordHeaderSize);
+  auto position = head + kRecordHeaderSize;
+  for (auto const range : record) {
+    copyIn(position, range.data(), range.size());
+    position += range.size();
+  }
+
+  header_->head.store(head + needed, std::memory_order_release);
+  return true;
+}
+
+bool ShmRing::parkWriter(size_t needed) {
+  header_->writerParked.store(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (capacity_ - used() >= needed) {
+    header_->writerParked.store(0, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+bool ShmRing::takeReaderParked() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  return header_->readerParked.load(std::memory_order_relaxed) &&
+      header_->readerParked.exchange(0);
+}
+
+void ShmRing::closeWriter() {
+  header_->closed.store(1, std::memory_order_release);
+}
+
+std::unique_ptr<folly::IOBuf> ShmRing::read() {
+  auto const tail = header_->tail.load(std::memory_order_relaxed);
+  auto const head = header_->head.load(std::memory_order_acquire);
+  if (head == tail) {
+    return nullptr;
+  }
+
+  // The memory is shared with another process, don't trust what it wrote.
+  auto const used = head - tail;
+  if (used < kRecordHeaderSize || used > capacity_) {
+    throw std::runtime_error{"Shared ring indices are corrupt"};
+  }
+  uint32_t length;
+  copyOut(tail, &length, kRecordHeaderSize);
+  if (length > maxRecordSize() || kRecordHeaderSize + length > used) {
+    throw std::runtime_error{"Shared ring record length is corrupt"};
+  }
+
+  auto record = folly::IOBuf::create(length);
+  copyOut(tail + kRecordHeaderSize, record->writableData(), length);
+  record->append(length);
+
+  header_->tail.store(
+      tail + kRecordHeaderSize + length, std::memory_order_release);
+  return record;
+}
+
+bool ShmRing::parkReader() {
+  header_->readerParked.store(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (used() > 0) {
+    header_->readerParked.store(0, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+bool ShmRing::takeWriterParked() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  return header_->writerParked.load(std::memory_order_relaxed) &&
+      header_->writerParked.exchange(0);
+}
+
+bool ShmRing::writerClosed() const {
+  return header_->closed.load(std::memory_order_acquire);
+}
+
+} // namespace rsocket
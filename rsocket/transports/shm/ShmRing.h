@@ -0,0 +1,109 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/io/IOBuf.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace rsocket {
+
+/// Single-producer single-consumer ring of length-prefixed records, laid out
+/// in memory shared between two processes.
+///
+/// The writer and the reader each own one index and only read the other's.
+/// Either side can "park" when it can't make progress, by raising a flag in the
+/// shared header; the other side then rings a doorbell the next time it makes
+/// progress for it.  Doorbells are only rung for parked peers, so a busy pair
+/// doesn't make any syscalls.
+///
+/// A ShmRing is only a view over memory mapped elsewhere, see regionSize().
+class ShmRing {
+ public:
+  /// Space a record takes in front of its data.
+  static constexpr size_t kRecordHeaderSize{sizeof(uint32_t)};
+
+  /// Views the ring whose header starts at `memory`.  The capacity must be a
+  /// power of two and the same on both sides.
+  ShmRing(void* memory, size_t capacity);
+
+  /// Bytes to map for a ring of the given capacity, header included.
+  static size_t regionSize(size_t capacity);
+
+  /// Resets the header.  Only called by the side creating the memory, before
+  /// the peer maps it.
+  void initialize();
+
+  size_t capacity() const {
+    return capacity_;
+  }
+
+  /// Largest record data that fits in the ring.
+  size_t maxRecordSize() const {
+    return capacity_ - kRecordHeaderSize;
+  }
+
+  // Writer side.
+
+  /// Copies the whole chain into the ring as one record.  Returns false,
+  /// without writing anything, if there isn't enough space right now.
+  bool tryWrite(const folly::IOBuf& record);
+
+  /// Marks the writer as waiting for `needed` bytes of space.  Returns false,
+  /// without parking, if they're available already.
+  bool parkWriter(size_t needed);
+
+  /// Whether the reader was parked, in which case it must be woken up.  Clears
+  /// the flag.
+  bool takeReaderParked();
+
+  /// Tells the reader no more records will follow.
+  void closeWriter();
+
+  // Reader side.
+
+  /// Copies the next record out of the ring, or returns null if it's empty.
+  /// Throws if the indices or the record length the peer wrote are out of
+  /// bounds.
+  std::unique_ptr<folly::IOBuf> read();
+
+  /// Marks the reader as waiting for records.  Returns false, without parking,
+  /// if a record is available already.
+  bool parkReader();
+
+  /// Whether the writer was parked, in which case it must be woken up.  Clears
+  /// the flag.
+  bool takeWriterParked();
+
+  /// Whether the writer closed the ring.  Records written before closing are
+  /// visible to read() once this returned true.
+  bool writerClosed() const;
+
+ private:
+  struct Header;
+
+  size_t used() const;
+  void copyIn(uint64_t position, const void* data, size_t length);
+  void copyOut(uint64_t position, void* data, size_t length) const;
+
+  Header* const header_;
+  uint8_t* const data_;
+  const size_t capacity_;
+};
+
+} // namespace rsocket
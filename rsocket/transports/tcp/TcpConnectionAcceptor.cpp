@@ -26,8 +26,14 @@ namespace rsocket {
 class TcpConnectionAcceptor::SocketCallback
     : public folly::AsyncServerSocket::AcceptCallback {
  public:
-  explicit SocketCallback(OnDuplexConnectionAccept& onAccept)
-      : thread_{folly::sformat("rstcp-acceptor")}, onAccept_{onAccept} {}
+  SocketCallback(
+      OnDuplexConnectionAccept& onAccept,
+      size_t zeroCopyThreshold,
+      std::shared_ptr<RSocketStats> stats)
+      : thread_{folly::sformat("rstcp-acceptor")},
+        onAccept_{onAccept},
+        zeroCopyThreshold_{zeroCopyThreshold},
+        stats_{std::move(stats)} {}
 
   void connectionAccepted(
       folly::NetworkSocket fdNetworkSocket,
@@ -39,7 +45,9 @@ class TcpConnectionAcceptor::SocketCallback
     folly::AsyncTransportWrapper::UniquePtr socket(
         new folly::AsyncSocket(eventBase(), folly::NetworkSocket::fromFd(fd)));
 
-    auto connection = std::make_unique<TcpDuplexConnection>(std::move(socket));
+    auto connection =
+        std::make_unique<TcpDuplexConnection>(std::move(socket), stats_);
+    connection->setZeroCopyThreshold(zeroCopyThreshold_);
     onAccept_(std::move(connection), *eventBase());
   }
 
@@ -57,6 +65,9 @@ class TcpConnectionAcceptor::SocketCallback
 
   /// Reference to the ConnectionAcceptor's callback.
   OnDuplexConnectionAccept& onAccept_;
+
+  const size_t zeroCopyThreshold_;
+  const std::shared_ptr<RSocketStats> stats_;
 };
 
 TcpConnectionAcceptor::TcpConnectionAcceptor(Options options)
@@ -80,7 +91,8 @@ void TcpConnectionAcceptor::start(OnDuplexConnectionAccept onAccept) {
 
   callbacks_.reserve(options_.threads);
   for (size_t i = 0; i < options_.threads; ++i) {
-    callbacks_.push_back(std::make_unique<SocketCallback>(onAccept_));
+    callbacks_.push_back(std::make_unique<SocketCallback>(
+        onAccept_, options_.zeroCopyThreshold, options_.stats));
   }
 
   VLOG(1) << "Starting TCP listener on port " << options_.address.getPort()
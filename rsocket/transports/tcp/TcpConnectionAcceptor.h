@@ -18,6 +18,7 @@
 #include <folly/io/async/ScopedEventBaseThread.h>
 
 #include "rsocket/ConnectionAcceptor.h"
+#include "rsocket/RSocketStats.h"
 
 namespace rsocket {
 
@@ -37,6 +38,13 @@ class TcpConnectionAcceptor : public ConnectionAcceptor {
 
     /// Number of connections to buffer before accept handlers process them.
     int backlog{10};
+
+    /// Frames of at least this many bytes are written with MSG_ZEROCOPY, see
+    /// TcpDuplexConnection::setZeroCopyThreshold().  Zero disables it.
+    size_t zeroCopyThreshold{0};
+
+    /// Stats of the accepted connections.
+    std::shared_ptr<RSocketStats> stats{RSocketStats::noop()};
   };
 
   explicit TcpConnectionAcceptor(Options);
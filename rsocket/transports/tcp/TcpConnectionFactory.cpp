@@ -31,9 +31,12 @@ class ConnectCallback : public folly::AsyncSocket::ConnectCallback {
   ConnectCallback(
       folly::SocketAddress address,
       const std::shared_ptr<folly::SSLContext>& sslContext,
+      size_t zeroCopyThreshold,
       folly::Promise<ConnectionFactory::ConnectedDuplexConnection>
           connectPromise)
-      : address_(address), connectPromise_(std::move(connectPromise)) {
+      : address_(address),
+        zeroCopyThreshold_(zeroCopyThreshold),
+        connectPromise_(std::move(connectPromise)) {
     VLOG(2) << "Constructing ConnectCallback";
 
     // Set up by ScopedEventBaseThread.
@@ -68,8 +71,9 @@ class ConnectCallback : public folly::AsyncSocket::ConnectCallback {
     std::unique_ptr<ConnectCallback> deleter(this);
     VLOG(4) << "connectSuccess() on " << address_;
 
-    auto connection = TcpConnectionFactory::createDuplexConnectionFromSocket(
+    auto connection = std::make_unique<TcpDuplexConnection>(
         std::move(socket_), RSocketStats::noop());
+    connection->setZeroCopyThreshold(zeroCopyThreshold_);
     auto evb = folly::EventBaseManager::get()->getExistingEventBase();
     CHECK(evb);
     connectPromise_.setValue(ConnectionFactory::ConnectedDuplexConnection{
@@ -84,6 +88,7 @@ class ConnectCallback : public folly::AsyncSocket::ConnectCallback {
 
  private:
   const folly::SocketAddress address_;
+  const size_t zeroCopyThreshold_;
   folly::AsyncSocket::UniquePtr socket_;
   folly::Promise<ConnectionFactory::ConnectedDuplexConnection> connectPromise_;
 };
@@ -107,11 +112,16 @@ TcpConnectionFactory::connect(ProtocolVersion, ResumeStatus /* unused */) {
 
   eventBase_->runInEventBaseThread(
       [this, promise = std::move(connectPromise)]() mutable {
-        new ConnectCallback(address_, sslContext_, std::move(promise));
+        new ConnectCallback(
+            address_, sslContext_, zeroCopyThreshold_, std::move(promise));
       });
   return connectFuture;
 }
 
+void TcpConnectionFactory::setZeroCopyThreshold(size_t threshold) {
+  zeroCopyThreshold_ = threshold;
+}
+
 std::unique_ptr<DuplexConnection>
 TcpConnectionFactory::createDuplexConnectionFromSocket(
     folly::AsyncTransportWrapper::UniquePtr socket,
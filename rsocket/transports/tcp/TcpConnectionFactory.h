@@ -51,6 +51,13 @@ class TcpConnectionFactory : public ConnectionFactory {
       ProtocolVersion,
       ResumeStatus resume) override;
 
+  /**
+   * Write frames of at least `threshold` bytes with MSG_ZEROCOPY on the
+   * connections created from now on, see
+   * TcpDuplexConnection::setZeroCopyThreshold().
+   */
+  void setZeroCopyThreshold(size_t threshold);
+
   static std::unique_ptr<DuplexConnection> createDuplexConnectionFromSocket(
       folly::AsyncTransportWrapper::UniquePtr socket,
       std::shared_ptr<RSocketStats> stats = std::shared_ptr<RSocketStats>());
@@ -59,5 +66,6 @@ class TcpConnectionFactory : public ConnectionFactory {
   folly::EventBase* eventBase_;
   const folly::SocketAddress address_;
   std::shared_ptr<folly::SSLContext> sslContext_;
+  size_t zeroCopyThreshold_{0};
 };
 } // namespace rsocket
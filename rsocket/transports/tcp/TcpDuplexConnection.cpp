@@ -16,14 +16,44 @@
 
 #include <folly/ExceptionWrapper.h>
 #include <folly/io/IOBufQueue.h>
+#include <folly/io/async/EventHandler.h>
 
+#include <sys/sendfile.h>
+
+#include <deque>
+#include <system_error>
+
+#include "rsocket/framing/FrameSerializer.h"
+#include "rsocket/internal/Allowance.h"
 #include "rsocket/internal/Common.h"
+#include "rsocket/internal/FileRange.h"
+#include "rsocket/internal/StatsBatch.h"
+#include "rsocket/internal/Tracing.h"
 #include "yarpl/flowable/Subscription.h"
 
 namespace rsocket {
 
 using namespace yarpl::flowable;
 
+namespace {
+
+/// File-backed buffers shorter than this are written from their mapping like
+/// any other buffer, a separate sendfile() call isn't worth it.
+constexpr size_t kMinSendfileLength{16 * 1024};
+
+/// Writes that don't use zerocopy after the kernel copied a zerocopy write.
+constexpr size_t kZeroCopyReenableThreshold{64};
+
+#ifdef RSOCKET_TRACING
+/// Stream of a frame that still has its frame length field, for tracing.
+StreamId traceStreamId(const folly::IOBuf& frame) {
+  return FrameSerializer::peekStreamId(ProtocolVersion::Latest, frame, true)
+      .value_or(0);
+}
+#endif
+
+} // namespace
+
 class TcpReaderWriter : public folly::AsyncTransportWrapper::WriteCallback,
                         public folly::AsyncTransportWrapper::ReadCallback {
   friend void intrusive_ptr_add_ref(TcpReaderWriter* x);
@@ -33,7 +63,9 @@ class TcpReaderWriter : public folly::AsyncTransportWrapper::WriteCallback,
   explicit TcpReaderWriter(
       folly::AsyncTransportWrapper::UniquePtr&& socket,
       std::shared_ptr<RSocketStats> stats)
-      : socket_(std::move(socket)), stats_(std::move(stats)) {}
+      : socket_(std::move(socket)),
+        stats_(std::move(stats)),
+        statsBatch_(stats_) {}
 
   ~TcpReaderWriter() override {
     CHECK(isClosed());
@@ -52,35 +84,80 @@ class TcpReaderWriter : public folly::AsyncTransportWrapper::WriteCallback,
 
     if (!inputSubscriber) {
       inputSubscriber_ = nullptr;
+      readAllowance_.consumeAll();
       return;
     }
 
     CHECK(!inputSubscriber_);
     inputSubscriber_ = std::move(inputSubscriber);
+    resumeReading();
+  }
 
-    if (!socket_->getReadCallback()) {
-      // The AsyncSocket will hold a reference to this instance until it calls
-      // readEOF or readErr.
-      intrusive_ptr_add_ref(this);
-      socket_->setReadCB(this);
+  /// Allows `n` more reads to be delivered to the input subscriber.  Reading
+  /// from the socket is paused while there are none left.
+  void requestReads(int64_t n) {
+    if (n <= 0) {
+      return;
     }
+    readAllowance_.add(n);
+    resumeReading();
   }
 
   void send(std::unique_ptr<folly::IOBuf> element) {
+    RSOCKET_TRACE_SPAN("TcpDuplexConnection::send", traceStreamId(*element));
     if (isClosed()) {
       return;
     }
 
-    if (stats_) {
-      stats_->bytesWritten(element->computeChainDataLength());
+    auto const size = element->computeChainDataLength();
+    statsBatch_.bytesWritten(size);
+    bufferedBytes_ += size;
+
+    if (pendingWrites_.empty() && !hasFileRange(*element)) {
+      writeChain(std::move(element));
+    } else {
+      queueWrites(std::move(element));
+      flushWrites();
+    }
+
+    // The write may have completed, or failed, synchronously.
+    if (writable_ && bufferedBytes_ > watermarks_.high && !isClosed()) {
+      setWritable(false);
     }
-    // now AsyncSocket will hold a reference to this instance as a writer until
-    // they call writeComplete or writeErr
-    intrusive_ptr_add_ref(this);
-    socket_->writeChain(this, std::move(element));
   }
 
+  void setWriteWatermarks(
+      WriteWatermarks watermarks,
+      DuplexConnection::WritabilityCallback callback) {
+    watermarks_ = watermarks;
+    writabilityCallback_ = std::move(callback);
+    if (bufferedBytes_ > watermarks_.high) {
+      setWritable(false);
+    }
+  }
+
+  void setZeroCopyThreshold(size_t threshold) {
+    zeroCopyThreshold_ = threshold;
+    if (isClosed() || threshold == 0 ||
+        !socket_->getSecurityProtocol().empty()) {
+      return;
+    }
+    auto const socket = socket_->getUnderlyingTransport<folly::AsyncSocket>();
+    if (!socket || !socket->setZeroCopy(true)) {
+      VLOG(2) << "SO_ZEROCOPY isn't available, large frames will be copied";
+      return;
+    }
+    // Copying is cheaper than pinning pages the kernel ends up copying
+    // anyway, so back off for a while whenever it does.
+    socket->setZeroCopyReenableThreshold(kZeroCopyReenableThreshold);
+  }
+
+  /// Writes still queued behind a file range are dropped.
   void close() {
+    writabilityCallback_ = nullptr;
+    stopWaitingForWritable();
+    pendingWrites_.clear();
+    statsBatch_.flush();
     if (auto socket = std::move(socket_)) {
       socket->close();
     }
@@ -90,6 +167,10 @@ class TcpReaderWriter : public folly::AsyncTransportWrapper::WriteCallback,
   }
 
   void closeErr(folly::exception_wrapper ew) {
+    writabilityCallback_ = nullptr;
+    stopWaitingForWritable();
+    pendingWrites_.clear();
+    statsBatch_.flush();
     if (auto socket = std::move(socket_)) {
       socket->close();
     }
@@ -103,12 +184,261 @@ class TcpReaderWriter : public folly::AsyncTransportWrapper::WriteCallback,
     return !socket_;
   }
 
+  void resumeReading() {
+    if (isClosed() || !inputSubscriber_ || !readAllowance_.canConsume(1) ||
+        socket_->getReadCallback()) {
+      return;
+    }
+    // The AsyncSocket will hold a reference to this instance until it calls
+    // readEOF or readErr, or reading is paused.
+    intrusive_ptr_add_ref(this);
+    socket_->setReadCB(this);
+  }
+
+  void pauseReading() {
+    if (isClosed() || socket_->getReadCallback() != this) {
+      return;
+    }
+    socket_->setReadCB(nullptr);
+    intrusive_ptr_release(this);
+  }
+
+  /// A write waiting for an earlier file range to be sent.
+  struct PendingWrite {
+    /// A chain of memory buffers, or the single buffer mapping `file`.
+    std::unique_ptr<folly::IOBuf> buf;
+    folly::Optional<FileRange> file;
+  };
+
+  /// Calls back into the TcpReaderWriter once the socket becomes writable
+  /// while a file range is being sent.
+  class WritableHandler : public folly::EventHandler {
+   public:
+    WritableHandler(folly::EventBase* evb, int fd, TcpReaderWriter& writer)
+        : folly::EventHandler(evb, folly::NetworkSocket::fromFd(fd)),
+          writer_(writer) {}
+
+    void handlerReady(uint16_t) noexcept override {
+      boost::intrusive_ptr<TcpReaderWriter> self{&writer_, false};
+      writer_.flushWrites();
+    }
+
+   private:
+    TcpReaderWriter& writer_;
+  };
+
+  /// The socket sendfile() can write to, if any.  TLS sockets need the bytes.
+  folly::AsyncSocket* sendfileSocket() {
+    if (isClosed() || !socket_->getSecurityProtocol().empty()) {
+      return nullptr;
+    }
+    return socket_->getUnderlyingTransport<folly::AsyncSocket>();
+  }
+
+  bool isFileRange(const folly::IOBuf& buf) {
+    return buf.length() >= kMinSendfileLength && findFileRange(buf);
+  }
+
+  bool hasFileRange(const folly::IOBuf& chain) {
+    if (!anyFileRanges() || !sendfileSocket()) {
+      return false;
+    }
+    auto current = &chain;
+    do {
+      if (isFileRange(*current)) {
+        return true;
+      }
+      current = current->next();
+    } while (current != &chain);
+    return false;
+  }
+
+  /// Splits the chain into runs of memory buffers and file ranges.
+  void queueWrites(std::unique_ptr<folly::IOBuf> chain) {
+    std::unique_ptr<folly::IOBuf> memory;
+    bool const sendfile = sendfileSocket() != nullptr;
+    while (chain) {
+      auto rest = chain->pop();
+      auto file = sendfile && chain->length() >= kMinSendfileLength
+          ? findFileRange(*chain)
+          : folly::none;
+      if (file) {
+        if (memory) {
+          pendingWrites_.push_back({std::move(memory), folly::none});
+        }
+        pendingWrites_.push_back({std::move(chain), file});
+      } else if (memory) {
+        memory->prependChain(std::move(chain));
+      } else {
+        memory = std::move(chain);
+      }
+      chain = std::move(rest);
+    }
+    if (memory) {
+      pendingWrites_.push_back({std::move(memory), folly::none});
+    }
+  }
+
+  /// Writes the queued writes in order.  File ranges are sent with sendfile(),
+  /// which bypasses the AsyncSocket, so they wait for it to finish the writes
+  /// before them.  Everything after a file range waits for it in turn.
+  void flushWrites() {
+    if (flushingWrites_) {
+      return;
+    }
+    flushingWrites_ = true;
+
+    while (!pendingWrites_.empty() && !isClosed()) {
+      auto& write = pendingWrites_.front();
+      if (!write.file) {
+        auto buf = std::move(write.buf);
+        pendingWrites_.pop_front();
+        writeChain(std::move(buf));
+        continue;
+      }
+      if (!writeSizes_.empty() || !sendFile(write)) {
+        break;
+      }
+      pendingWrites_.pop_front();
+    }
+
+    flushingWrites_ = false;
+    if (!writable_ && bufferedBytes_ <= watermarks_.low && !isClosed()) {
+      setWritable(true);
+    }
+  }
+
+  /// Returns whether the whole range was sent.
+  bool sendFile(PendingWrite& write) {
+    auto const fd = sendfileSocket()->getNetworkSocket().toFd();
+    while (write.buf->length() > 0) {
+      auto offset = write.file->offset;
+      auto const sent =
+          ::sendfile(fd, write.file->fd, &offset, write.buf->length());
+      if (sent > 0) {
+        write.file->offset = offset;
+        write.buf->trimStart(sent);
+        bufferedBytes_ -= sent;
+        continue;
+      }
+      if (sent < 0 && errno == EINTR) {
+        continue;
+      }
+      if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        waitForWritable(fd);
+        return false;
+      }
+
+      // Sending nothing means the file got shorter than the frame says.
+      auto const error = sent < 0 ? errno : EIO;
+      closeErr(folly::make_exception_wrapper<std::system_error>(
+          error, std::generic_category(), "sendfile"));
+      return false;
+    }
+    return true;
+  }
+
+  void waitForWritable(int fd) {
+    if (!writableHandler_) {
+      writableHandler_ = std::make_unique<WritableHandler>(
+          socket_->getEventBase(), fd, *this);
+    }
+    if (!writableHandler_->isHandlerRegistered()) {
+      // The handler holds a reference until it fires.
+      intrusive_ptr_add_ref(this);
+      writableHandler_->registerHandler(folly::EventHandler::WRITE);
+    }
+  }
+
+  void stopWaitingForWritable() {
+    if (writableHandler_ && writableHandler_->isHandlerRegistered()) {
+      writableHandler_->unregisterHandler();
+      intrusive_ptr_release(this);
+    }
+  }
+
+  /// Hands a chain of memory buffers to the AsyncSocket.
+  void writeChain(std::unique_ptr<folly::IOBuf> chain) {
+    auto const size = chain->computeChainDataLength();
+    writeSizes_.push_back(size);
+#ifdef RSOCKET_TRACING
+    writeTraces_.push_back(
+        Tracer::enabled()
+            ? WriteTrace{Tracer::Clock::now(), traceStreamId(*chain)}
+            : WriteTrace{});
+#endif
+
+    auto const flags = zeroCopyThreshold_ && size >= zeroCopyThreshold_
+        ? zeroCopyFlags(size)
+        : folly::WriteFlags::NONE;
+
+    // now AsyncSocket will hold a reference to this instance as a writer until
+    // they call writeComplete or writeErr
+    intrusive_ptr_add_ref(this);
+    socket_->writeChain(this, std::move(chain), flags);
+  }
+
+  /// The AsyncSocket holds on to the buffers of a zerocopy write until the
+  /// kernel reports it complete.  Once the kernel reports having copied one
+  /// anyway, as it does on loopback, the socket turns zerocopy off for the
+  /// next kZeroCopyReenableThreshold writes, and the frames are counted as
+  /// fallbacks.
+  folly::WriteFlags zeroCopyFlags(size_t size) {
+    auto const socket = socket_->getUnderlyingTransport<folly::AsyncSocket>();
+    if (socket && socket->getZeroCopy()) {
+      if (stats_) {
+        stats_->zeroCopyRequested(size);
+      }
+      return folly::WriteFlags::WRITE_MSG_ZEROCOPY;
+    }
+    if (stats_) {
+      stats_->zeroCopyFallback(size);
+    }
+    return folly::WriteFlags::NONE;
+  }
+
+  void setWritable(bool writable) {
+    writable_ = writable;
+    if (auto callback = writabilityCallback_) {
+      callback(writable);
+    }
+  }
+
+  /// Writes complete in the order they were issued.
+  void writeDone() {
+    DCHECK(!writeSizes_.empty());
+    bufferedBytes_ -= writeSizes_.front();
+    writeSizes_.pop_front();
+#ifdef RSOCKET_TRACING
+    // The span from handing the write to the socket until it's written.
+    auto const& trace = writeTraces_.front();
+    if (trace.begin != Tracer::Clock::time_point{}) {
+      Tracer::record(
+          "TcpDuplexConnection::write",
+          trace.streamId,
+          trace.begin,
+          Tracer::Clock::now());
+    }
+    writeTraces_.pop_front();
+#endif
+  }
+
   void writeSuccess() noexcept override {
+    RSOCKET_TRACE_SPAN(
+        "TcpDuplexConnection::writeSuccess", writeTraces_.front().streamId);
+    writeDone();
+    if (!pendingWrites_.empty()) {
+      flushWrites();
+    } else if (
+        !writable_ && bufferedBytes_ <= watermarks_.low && !isClosed()) {
+      setWritable(true);
+    }
     intrusive_ptr_release(this);
   }
 
   void writeErr(size_t, const folly::AsyncSocketException& exn) noexcept
       override {
+    writeDone();
     closeErr(folly::exception_wrapper{folly::copy(exn)});
     intrusive_ptr_release(this);
   }
@@ -119,9 +449,7 @@ class TcpReaderWriter : public folly::AsyncTransportWrapper::WriteCallback,
 
   void readDataAvailable(size_t len) noexcept override {
     readBuffer_.postallocate(len);
-    if (stats_) {
-      stats_->bytesRead(len);
-    }
+    statsBatch_.bytesRead(len);
 
     if (inputSubscriber_) {
       readBufferAvailable(readBuffer_.split(len));
@@ -145,15 +473,54 @@ class TcpReaderWriter : public folly::AsyncTransportWrapper::WriteCallback,
   void readBufferAvailable(
       std::unique_ptr<folly::IOBuf> readBuf) noexcept override {
     CHECK(inputSubscriber_);
+    // Pausing drops the AsyncSocket's reference.
+    boost::intrusive_ptr<TcpReaderWriter> self{this};
+
+    readAllowance_.tryConsume(1);
     inputSubscriber_->onNext(std::move(readBuf));
+
+    // Only pause if the subscriber didn't request more from within onNext.
+    if (!readAllowance_.canConsume(1)) {
+      pauseReading();
+    }
   }
 
   folly::IOBufQueue readBuffer_{folly::IOBufQueue::cacheChainLength()};
   folly::AsyncTransportWrapper::UniquePtr socket_;
   const std::shared_ptr<RSocketStats> stats_;
+  /// Byte counts, delivered to stats_ once per EventBase loop.
+  StatsBatch statsBatch_;
 
   std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber_;
+  /// Reads the input subscriber has requested.
+  Allowance readAllowance_;
   int refCount_{0};
+
+  /// Bytes handed to the socket that it hasn't finished writing yet, and the
+  /// size of each outstanding write.
+  size_t bufferedBytes_{0};
+  std::deque<size_t> writeSizes_;
+#ifdef RSOCKET_TRACING
+  /// When each outstanding write was issued, and the stream of its first
+  /// frame.  Writes issued while the Tracer was stopped aren't traced.
+  struct WriteTrace {
+    Tracer::Clock::time_point begin;
+    StreamId streamId{0};
+  };
+  std::deque<WriteTrace> writeTraces_;
+#endif
+
+  WriteWatermarks watermarks_;
+  DuplexConnection::WritabilityCallback writabilityCallback_;
+  bool writable_{true};
+
+  /// Smallest frame written with MSG_ZEROCOPY, zero if disabled.
+  size_t zeroCopyThreshold_{0};
+
+  /// Writes queued behind a file range, see flushWrites().
+  std::deque<PendingWrite> pendingWrites_;
+  bool flushingWrites_{false};
+  std::unique_ptr<WritableHandler> writableHandler_;
 };
 
 void intrusive_ptr_add_ref(TcpReaderWriter* x);
@@ -179,9 +546,9 @@ class TcpInputSubscription : public Subscription {
   }
 
   void request(int64_t n) noexcept override {
-    DCHECK(tcpReaderWriter_);
-    DCHECK_EQ(n, std::numeric_limits<int64_t>::max())
-        << "TcpDuplexConnection doesnt support proper flow control";
+    if (tcpReaderWriter_) {
+      tcpReaderWriter_->requestReads(n);
+    }
   }
 
   void cancel() noexcept override {
@@ -222,6 +589,20 @@ void TcpDuplexConnection::send(std::unique_ptr<folly::IOBuf> buf) {
   }
 }
 
+void TcpDuplexConnection::setWriteWatermarks(
+    WriteWatermarks watermarks,
+    WritabilityCallback callback) {
+  if (tcpReaderWriter_) {
+    tcpReaderWriter_->setWriteWatermarks(watermarks, std::move(callback));
+  }
+}
+
+void TcpDuplexConnection::setZeroCopyThreshold(size_t threshold) {
+  if (tcpReaderWriter_) {
+    tcpReaderWriter_->setZeroCopyThreshold(threshold);
+  }
+}
+
 void TcpDuplexConnection::setInput(
     std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber) {
   // we don't care if the subscriber will call request synchronously
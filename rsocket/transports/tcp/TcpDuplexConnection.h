@@ -37,6 +37,18 @@ class TcpDuplexConnection : public DuplexConnection {
 
   void setInput(std::shared_ptr<DuplexConnection::Subscriber>) override;
 
+  void setWriteWatermarks(WriteWatermarks, WritabilityCallback) override;
+
+  /// Writes frames of at least `threshold` bytes with MSG_ZEROCOPY, so the
+  /// kernel sends straight from their buffers instead of copying them.  Zero
+  /// disables it, which is the default.
+  ///
+  /// Only worth it for large frames: the pages are pinned and the completion
+  /// is reported on the socket's error queue, which costs more than copying a
+  /// few kilobytes.  Has no effect on TLS sockets, or if the kernel doesn't
+  /// support SO_ZEROCOPY.
+  void setZeroCopyThreshold(size_t threshold);
+
   // Only to be used for observation purposes.
   folly::AsyncTransportWrapper* getTransport();
 
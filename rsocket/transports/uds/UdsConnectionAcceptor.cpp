@@ -0,0 +1,181 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/uds/UdsConnectionAcceptor.h"
+
+#include <folly/Format.h>
+#include <folly/futures/Future.h>
+#include <folly/io/async/AsyncSocket.h>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <system_error>
+
+#include "rsocket/transports/tcp/TcpDuplexConnection.h"
+
+namespace rsocket {
+
+namespace {
+
+/// Removes a socket file left behind at `path` by a listener that's gone.
+/// Throws if anything else is there, including a live listener.
+void removeStaleSocket(const std::string& path) {
+  struct stat st;
+  if (::lstat(path.c_str(), &st) != 0) {
+    if (errno == ENOENT) {
+      return;
+    }
+    throw std::system_error(errno, std::generic_category(), "lstat " + path);
+  }
+  if (!S_ISSOCK(st.st_mode)) {
+    throw std::system_error(
+        EADDRINUSE, std::generic_category(), path + " isn't a socket");
+  }
+
+  // Nobody listens on a stale socket, so connecting to it is refused.  Don't
+  // block on a live listener with a full backlog.
+  auto const fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  if (fd < 0) {
+    throw std::system_error(errno, std::generic_category(), "socket");
+  }
+  sockaddr_storage addr;
+  auto const addrLen =
+      folly::SocketAddress::makeFromPath(path).getAddress(&addr);
+  auto const connected =
+      ::connect(fd, reinterpret_cast<sockaddr*>(&addr), addrLen) == 0;
+  auto const error = errno;
+  ::close(fd);
+  if (connected || error != ECONNREFUSED) {
+    throw std::system_error(
+        EADDRINUSE, std::generic_category(), path + " is in use");
+  }
+
+  VLOG(1) << "Removing stale socket " << path;
+  ::unlink(path.c_str());
+}
+
+} // namespace
+
+class UdsConnectionAcceptor::SocketCallback
+    : public folly::AsyncServerSocket::AcceptCallback {
+ public:
+  SocketCallback(
+      OnDuplexConnectionAccept& onAccept,
+      std::shared_ptr<RSocketStats> stats)
+      : thread_{folly::sformat("rsuds-acceptor")},
+        onAccept_{onAccept},
+        stats_{std::move(stats)} {}
+
+  void connectionAccepted(
+      folly::NetworkSocket fdNetworkSocket,
+      const folly::SocketAddress&) noexcept override {
+    VLOG(2) << "Accepting UDS connection on FD " << fdNetworkSocket.toFd();
+
+    folly::AsyncTransportWrapper::UniquePtr socket(
+        new folly::AsyncSocket(eventBase(), fdNetworkSocket));
+
+    // TcpDuplexConnection only relies on the AsyncSocket, which doesn't care
+    // about the address family.
+    auto connection =
+        std::make_unique<TcpDuplexConnection>(std::move(socket), stats_);
+    onAccept_(std::move(connection), *eventBase());
+  }
+
+  void acceptError(folly::exception_wrapper ex) noexcept override {
+    VLOG(2) << "UDS error: " << ex;
+  }
+
+  folly::EventBase* eventBase() const {
+    return thread_.getEventBase();
+  }
+
+ private:
+  /// The thread running this callback.
+  folly::ScopedEventBaseThread thread_;
+
+  /// Reference to the ConnectionAcceptor's callback.
+  OnDuplexConnectionAccept& onAccept_;
+
+  const std::shared_ptr<RSocketStats> stats_;
+};
+
+UdsConnectionAcceptor::UdsConnectionAcceptor(Options options)
+    : options_(std::move(options)) {}
+
+UdsConnectionAcceptor::~UdsConnectionAcceptor() {
+  if (serverThread_) {
+    stop();
+    serverThread_.reset();
+  }
+}
+
+void UdsConnectionAcceptor::start(OnDuplexConnectionAccept onAccept) {
+  if (onAccept_ != nullptr) {
+    throw std::runtime_error("UdsConnectionAcceptor::start() already called");
+  }
+  if (options_.path.empty()) {
+    throw std::invalid_argument("UdsConnectionAcceptor needs a socket path");
+  }
+
+  onAccept_ = std::move(onAccept);
+  serverThread_ =
+      std::make_unique<folly::ScopedEventBaseThread>("rsuds-listener");
+
+  callbacks_.reserve(options_.threads);
+  for (size_t i = 0; i < options_.threads; ++i) {
+    callbacks_.push_back(
+        std::make_unique<SocketCallback>(onAccept_, options_.stats));
+  }
+
+  VLOG(1) << "Starting UDS listener on " << options_.path << " with "
+          << options_.threads << " request threads";
+
+  serverSocket_.reset(
+      new folly::AsyncServerSocket(serverThread_->getEventBase()));
+
+  // The AsyncServerSocket needs to be accessed from the listener thread only.
+  // This will propagate out any exceptions the listener throws.
+  folly::via(serverThread_->getEventBase(), [this] {
+    removeStaleSocket(options_.path);
+    serverSocket_->bind(folly::SocketAddress::makeFromPath(options_.path));
+    bound_ = true;
+
+    for (auto const& callback : callbacks_) {
+      serverSocket_->addAcceptCallback(callback.get(), callback->eventBase());
+    }
+
+    serverSocket_->listen(options_.backlog);
+    serverSocket_->startAccepting();
+  }).get();
+}
+
+void UdsConnectionAcceptor::stop() {
+  VLOG(1) << "Shutting down UDS listener";
+
+  serverThread_->getEventBase()->runInEventBaseThreadAndWait(
+      [serverSocket = std::move(serverSocket_)]() {});
+  if (bound_) {
+    ::unlink(options_.path.c_str());
+    bound_ = false;
+  }
+}
+
+folly::Optional<uint16_t> UdsConnectionAcceptor::listeningPort() const {
+  return folly::none;
+}
+
+} // namespace rsocket
@@ -0,0 +1,93 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/io/async/AsyncServerSocket.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+
+#include "rsocket/ConnectionAcceptor.h"
+#include "rsocket/RSocketStats.h"
+
+namespace rsocket {
+
+/**
+ * Unix domain socket implementation of ConnectionAcceptor for use with
+ * RSocket::createServer, for peers on the same host.
+ *
+ * Construction of this does nothing.  The `start` method kicks off work.
+ */
+class UdsConnectionAcceptor : public ConnectionAcceptor {
+ public:
+  struct Options {
+    /// Filesystem path of the socket.  A stale socket file left behind at the
+    /// path is replaced, start() fails with EADDRINUSE if anything else is
+    /// there, including a socket something still listens on.
+    std::string path;
+
+    /// Number of worker threads processing requests.
+    size_t threads{2};
+
+    /// Number of connections to buffer before accept handlers process them.
+    int backlog{10};
+
+    /// Stats of the accepted connections.
+    std::shared_ptr<RSocketStats> stats{RSocketStats::noop()};
+  };
+
+  explicit UdsConnectionAcceptor(Options);
+  ~UdsConnectionAcceptor();
+
+  // ConnectionAcceptor overrides.
+
+  /**
+   * Bind an AsyncServerSocket to the path and start accepting connections.
+   */
+  void start(OnDuplexConnectionAccept) override;
+
+  /**
+   * Shutdown the AsyncServerSocket and associated listener thread, and remove
+   * the socket file.
+   */
+  void stop() override;
+
+  /**
+   * Unix domain sockets don't have a port.
+   */
+  folly::Optional<uint16_t> listeningPort() const override;
+
+ private:
+  class SocketCallback;
+
+  /// Options this acceptor has been configured with.
+  const Options options_;
+
+  /// The thread driving the AsyncServerSocket.
+  std::unique_ptr<folly::ScopedEventBaseThread> serverThread_;
+
+  /// Function to run when a connection is accepted.
+  OnDuplexConnectionAccept onAccept_;
+
+  /// The callbacks handling accepted connections.  Each has its own worker
+  /// thread.
+  std::vector<std::unique_ptr<SocketCallback>> callbacks_;
+
+  /// The socket listening for new connections.
+  folly::AsyncServerSocket::UniquePtr serverSocket_;
+
+  /// Whether the socket file at the path is ours to remove.
+  bool bound_{false};
+};
+
+} // namespace rsocket
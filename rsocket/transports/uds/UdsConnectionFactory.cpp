@@ -0,0 +1,91 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/uds/UdsConnectionFactory.h"
+
+#include <folly/io/async/AsyncSocket.h>
+#include <glog/logging.h>
+
+#include "rsocket/transports/tcp/TcpDuplexConnection.h"
+
+namespace rsocket {
+
+namespace {
+
+class ConnectCallback : public folly::AsyncSocket::ConnectCallback {
+ public:
+  ConnectCallback(
+      folly::EventBase& evb,
+      folly::SocketAddress address,
+      std::shared_ptr<RSocketStats> stats,
+      folly::Promise<ConnectionFactory::ConnectedDuplexConnection>
+          connectPromise)
+      : evb_(evb),
+        address_(std::move(address)),
+        stats_(std::move(stats)),
+        connectPromise_(std::move(connectPromise)),
+        socket_(new folly::AsyncSocket(&evb_)) {
+    VLOG(3) << "Attempting connection to " << address_.describe();
+    socket_->connect(this, address_);
+  }
+
+  void connectSuccess() noexcept override {
+    std::unique_ptr<ConnectCallback> deleter(this);
+    VLOG(4) << "connectSuccess() on " << address_.describe();
+
+    auto connection = std::make_unique<TcpDuplexConnection>(
+        std::move(socket_), std::move(stats_));
+    connectPromise_.setValue(ConnectionFactory::ConnectedDuplexConnection{
+        std::move(connection), evb_});
+  }
+
+  void connectErr(const folly::AsyncSocketException& ex) noexcept override {
+    std::unique_ptr<ConnectCallback> deleter(this);
+    VLOG(4) << "connectErr(" << ex.what() << ") on " << address_.describe();
+    connectPromise_.setException(ex);
+  }
+
+ private:
+  folly::EventBase& evb_;
+  const folly::SocketAddress address_;
+  std::shared_ptr<RSocketStats> stats_;
+  folly::Promise<ConnectionFactory::ConnectedDuplexConnection> connectPromise_;
+  folly::AsyncSocket::UniquePtr socket_;
+};
+
+} // namespace
+
+UdsConnectionFactory::UdsConnectionFactory(
+    folly::EventBase& eventBase,
+    std::string path,
+    std::shared_ptr<RSocketStats> stats)
+    : eventBase_(&eventBase),
+      address_(folly::SocketAddress::makeFromPath(path)),
+      stats_(std::move(stats)) {}
+
+UdsConnectionFactory::~UdsConnectionFactory() = default;
+
+folly::Future<ConnectionFactory::ConnectedDuplexConnection>
+UdsConnectionFactory::connect(ProtocolVersion, ResumeStatus /* unused */) {
+  folly::Promise<ConnectionFactory::ConnectedDuplexConnection> connectPromise;
+  auto connectFuture = connectPromise.getFuture();
+
+  eventBase_->runInEventBaseThread(
+      [this, promise = std::move(connectPromise)]() mutable {
+        new ConnectCallback(*eventBase_, address_, stats_, std::move(promise));
+      });
+  return connectFuture;
+}
+
+} // namespace rsocket
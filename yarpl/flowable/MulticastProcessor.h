@@ -0,0 +1,468 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/ProducerConsumerQueue.h>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "yarpl/Common.h"
+#include "yarpl/flowable/Flowable.h"
+#include "yarpl/utils/credits.h"
+
+namespace yarpl {
+namespace flowable {
+
+namespace details {
+
+template <typename T>
+struct CopyMulticastValue {
+  T operator()(const T& value) const {
+    return value;
+  }
+};
+
+} // namespace details
+
+// Processor that multicasts the items of a single upstream to many
+// Subscribers while honouring the flow control of each of them.
+//
+// Every Subscriber gets its own bounded ring buffer of `bufferSize` items.
+// Upstream credits are only requested as fast as those buffers can absorb
+// them: at the pace of the slowest Subscriber by default or, when `quorum` is
+// non-zero, at the pace of the quorum-th fastest Subscriber.  In the latter
+// case Subscribers which fall behind the quorum overflow their buffer and are
+// terminated with MissingBackpressureException.
+//
+// The list of Subscribers is an immutable snapshot which is replaced
+// (copy-on-write) by subscribe() and cancel(), so onNext() iterates it without
+// taking any lock.  Values are duplicated for each Subscriber with `Copy`,
+// which makes it possible to multicast move-only types (e.g. by cloning their
+// buffers).  Items which arrive while there are no Subscribers are dropped.
+//
+// Unlike PublishProcessor, this processor follows the regular Subscriber
+// contract and can be subscribed to a single upstream only.
+template <typename T, typename Copy = details::CopyMulticastValue<T>>
+class MulticastProcessor : public Flowable<T>, public Subscriber<T> {
+  class MulticastSubscription;
+  using SubscriptionsVector =
+      std::vector<std::shared_ptr<MulticastSubscription>>;
+
+ public:
+  static constexpr size_t kDefaultBufferSize = 128;
+
+  static std::shared_ptr<MulticastProcessor> create(
+      size_t bufferSize = kDefaultBufferSize,
+      size_t quorum = 0,
+      Copy copy = Copy()) {
+    return std::shared_ptr<MulticastProcessor>(
+        new MulticastProcessor(bufferSize, quorum, std::move(copy)));
+  }
+
+  ~MulticastProcessor() {
+    auto subscriptions = std::atomic_load(&subscriptions_);
+    for (const auto& subscription : *subscriptions) {
+      subscription->terminate(
+          std::runtime_error("MulticastProcessor shutdown"));
+    }
+  }
+
+  size_t subscriberCount() const {
+    return std::atomic_load(&subscriptions_)->size();
+  }
+
+  void subscribe(std::shared_ptr<Subscriber<T>> subscriber) override {
+    auto subscription = std::make_shared<MulticastSubscription>(
+        subscriber, this->ref_from_this(this), bufferSize_);
+    // onSubscribe has to happen before the subscription is visible to onNext,
+    // the Subscriber may request (or cancel) right away
+    subscriber->onSubscribe(subscription);
+
+    folly::exception_wrapper error;
+    {
+      std::lock_guard<std::mutex> lock(writeMutex_);
+      if (done_) {
+        error = error_;
+      } else {
+        if (subscription->isCancelled()) {
+          return;
+        }
+        auto oldSubscriptions = std::atomic_load(&subscriptions_);
+        auto newSubscriptions = std::make_shared<SubscriptionsVector>();
+        newSubscriptions->reserve(oldSubscriptions->size() + 1);
+        newSubscriptions->insert(
+            newSubscriptions->end(),
+            oldSubscriptions->cbegin(),
+            oldSubscriptions->cend());
+        newSubscriptions->push_back(subscription);
+        std::atomic_store(
+            &subscriptions_,
+            std::shared_ptr<const SubscriptionsVector>(
+                std::move(newSubscriptions)));
+        subscription.reset();
+      }
+    }
+
+    if (subscription) {
+      // the processor is already terminated
+      subscription->terminate(std::move(error));
+      return;
+    }
+
+    requestUpstream();
+  }
+
+  void onSubscribe(std::shared_ptr<Subscription> subscription) override {
+    {
+      std::lock_guard<std::mutex> lock(requestMutex_);
+      if (!upstream_ && !upstreamTerminated_) {
+        upstream_ = std::move(subscription);
+      }
+    }
+
+    if (subscription) {
+      // only a single upstream is supported
+      subscription->cancel();
+      return;
+    }
+
+    requestUpstream();
+  }
+
+  void onNext(T value) override {
+    auto subscriptions = std::atomic_load(&subscriptions_);
+    const auto size = subscriptions->size();
+
+    std::vector<MulticastSubscription*> overflown;
+    for (size_t i = 0; i < size; ++i) {
+      auto& subscription = (*subscriptions)[i];
+      bool pushed = (i + 1 == size) ? subscription->push(std::move(value))
+                                    : subscription->push(copy_(value));
+      if (!pushed) {
+        overflown.push_back(subscription.get());
+      }
+    }
+
+    // all buffers have to see the item before we give the credit back,
+    // otherwise requestUpstream() could over-request
+    outstanding_.fetch_sub(1);
+
+    for (const auto& subscription : *subscriptions) {
+      subscription->drain(true);
+    }
+
+    for (auto subscription : overflown) {
+      subscription->terminate(MissingBackpressureException());
+      removeSubscription(subscription);
+    }
+
+    if (outstanding_.load() <= replenishThreshold_) {
+      requestUpstream();
+    }
+  }
+
+  void onComplete() override {
+    terminate(folly::exception_wrapper());
+  }
+
+  void onError(folly::exception_wrapper ex) override {
+    terminate(std::move(ex));
+  }
+
+ private:
+  MulticastProcessor(size_t bufferSize, size_t quorum, Copy copy)
+      : bufferSize_(std::max<size_t>(bufferSize, 1)),
+        replenishThreshold_(static_cast<int64_t>(bufferSize_ / 2)),
+        quorum_(quorum),
+        copy_(std::move(copy)),
+        subscriptions_(std::make_shared<const SubscriptionsVector>()) {}
+
+  void terminate(folly::exception_wrapper ex) {
+    std::shared_ptr<const SubscriptionsVector> subscriptions;
+    {
+      std::lock_guard<std::mutex> lock(writeMutex_);
+      if (done_) {
+        return;
+      }
+      done_ = true;
+      error_ = ex;
+      subscriptions = std::atomic_load(&subscriptions_);
+      std::atomic_store(
+          &subscriptions_, std::make_shared<const SubscriptionsVector>());
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(requestMutex_);
+      upstreamTerminated_ = true;
+      upstream_.reset();
+    }
+
+    for (const auto& subscription : *subscriptions) {
+      subscription->terminate(ex);
+    }
+  }
+
+  void removeSubscription(MulticastSubscription* subscription) {
+    {
+      std::lock_guard<std::mutex> lock(writeMutex_);
+      auto oldSubscriptions = std::atomic_load(&subscriptions_);
+
+      auto removingItem = std::find_if(
+          oldSubscriptions->cbegin(),
+          oldSubscriptions->cend(),
+          [&](const auto& ptr) { return ptr.get() == subscription; });
+
+      if (removingItem == oldSubscriptions->cend()) {
+        // not found anymore
+        return;
+      }
+
+      auto newSubscriptions = std::make_shared<SubscriptionsVector>();
+      newSubscriptions->reserve(oldSubscriptions->size() - 1);
+      newSubscriptions->insert(
+          newSubscriptions->end(), oldSubscriptions->cbegin(), removingItem);
+      newSubscriptions->insert(
+          newSubscriptions->end(),
+          std::next(removingItem),
+          oldSubscriptions->cend());
+      std::atomic_store(
+          &subscriptions_,
+          std::shared_ptr<const SubscriptionsVector>(
+              std::move(newSubscriptions)));
+    }
+
+    // the slowest subscriber may have just left
+    requestUpstream();
+  }
+
+  // Requests as many items from upstream as every (or the quorum of)
+  // subscriber buffers can take, minus what has been requested already.
+  void requestUpstream() {
+    std::shared_ptr<Subscription> upstream;
+    int64_t delta;
+    {
+      std::lock_guard<std::mutex> lock(requestMutex_);
+      if (!upstream_) {
+        return;
+      }
+
+      // outstanding_ has to be read before the buffer sizes; onNext pushes
+      // into the buffers before decrementing it, so this order can only
+      // underestimate the available space
+      const auto outstanding = outstanding_.load();
+      auto subscriptions = std::atomic_load(&subscriptions_);
+      if (subscriptions->empty()) {
+        return;
+      }
+
+      delta = static_cast<int64_t>(freeSlots(*subscriptions)) - outstanding;
+      if (delta <= 0) {
+        return;
+      }
+      outstanding_.fetch_add(delta);
+      upstream = upstream_;
+    }
+
+    // upstream may emit synchronously from request(), so it must not be
+    // called while holding the lock
+    upstream->request(delta);
+  }
+
+  size_t freeSlots(const SubscriptionsVector& subscriptions) {
+    if (quorum_ == 0 || quorum_ >= subscriptions.size()) {
+      size_t minFree = bufferSize_;
+      for (const auto& subscription : subscriptions) {
+        minFree = std::min(minFree, subscription->freeSlots());
+      }
+      return minFree;
+    }
+
+    freeSlots_.clear();
+    for (const auto& subscription : subscriptions) {
+      freeSlots_.push_back(subscription->freeSlots());
+    }
+    auto nth = freeSlots_.begin() + (quorum_ - 1);
+    std::nth_element(
+        freeSlots_.begin(), nth, freeSlots_.end(), std::greater<size_t>());
+    return *nth;
+  }
+
+  class MulticastSubscription : public Subscription {
+   public:
+    MulticastSubscription(
+        std::shared_ptr<Subscriber<T>> subscriber,
+        std::weak_ptr<MulticastProcessor> processor,
+        size_t bufferSize)
+        : subscriber_(std::move(subscriber)),
+          processor_(std::move(processor)),
+          // ProducerConsumerQueue keeps one slot empty
+          queue_(static_cast<uint32_t>(bufferSize + 1)),
+          bufferSize_(bufferSize) {}
+
+    void request(int64_t n) override {
+      if (n <= 0) {
+        return;
+      }
+      credits::add(&requested_, n);
+      drain(false);
+    }
+
+    void cancel() override {
+      if (cancelled_.exchange(true)) {
+        return;
+      }
+      if (auto processor = processor_.lock()) {
+        processor->removeSubscription(this);
+      }
+      drain(false);
+    }
+
+    bool isCancelled() const {
+      return cancelled_;
+    }
+
+    size_t freeSlots() const {
+      return bufferSize_ - std::min(bufferSize_, queue_.sizeGuess());
+    }
+
+    // Called from the (serialized) upstream only.
+    bool push(T value) {
+      return queue_.write(std::move(value));
+    }
+
+    // Called from the (serialized) upstream only.  Buffered items are still
+    // delivered before the terminal signal.
+    void terminate(folly::exception_wrapper ex) {
+      if (done_.load(std::memory_order_relaxed)) {
+        return;
+      }
+      error_ = std::move(ex);
+      done_.store(true, std::memory_order_release);
+      drain(true);
+    }
+
+    // Emits buffered items for as long as the subscriber has credits.  Only a
+    // single thread drains at a time, other callers just mark the work as
+    // missed and leave.
+    void drain(bool fromUpstream) {
+      if (wip_.fetch_add(1) != 0) {
+        return;
+      }
+
+      bool replenish = false;
+      int missed = 1;
+      do {
+        size_t emitted = 0;
+        drainLoop(emitted);
+
+        // onNext() replenishes upstream credits itself once all the buffers
+        // have been drained.  The accounting has to happen before wip_ is
+        // released, another thread may start draining right after.
+        if (!fromUpstream && emitted > 0) {
+          consumed_ += emitted;
+          if (consumed_ >= bufferSize_ / 2 || queue_.isEmpty()) {
+            consumed_ = 0;
+            replenish = true;
+          }
+        }
+        missed = wip_.fetch_sub(missed) - missed;
+      } while (missed != 0);
+
+      if (replenish) {
+        if (auto processor = processor_.lock()) {
+          processor->requestUpstream();
+        }
+      }
+    }
+
+   private:
+    void drainLoop(size_t& emitted) {
+      while (subscriber_) {
+        if (cancelled_) {
+          subscriber_.reset();
+          while (queue_.frontPtr()) {
+            queue_.popFront();
+          }
+          return;
+        }
+
+        // done_ has to be read before the queue, the upstream pushes the
+        // last item before setting it
+        const bool done = done_.load(std::memory_order_acquire);
+        auto next = queue_.frontPtr();
+        if (!next) {
+          if (done) {
+            cancelled_ = true;
+            auto subscriber = std::exchange(subscriber_, nullptr);
+            if (error_) {
+              subscriber->onError(std::move(error_));
+            } else {
+              subscriber->onComplete();
+            }
+          }
+          return;
+        }
+
+        if (requested_.load() <= 0) {
+          return;
+        }
+
+        auto value = std::move(*next);
+        queue_.popFront();
+        credits::consume(&requested_, 1);
+        ++emitted;
+        subscriber_->onNext(std::move(value));
+      }
+    }
+
+    std::shared_ptr<Subscriber<T>> subscriber_;
+    std::weak_ptr<MulticastProcessor> processor_;
+    folly::ProducerConsumerQueue<T> queue_;
+    const size_t bufferSize_;
+
+    std::atomic<int64_t> requested_{0};
+    std::atomic<int> wip_{0};
+    std::atomic<bool> cancelled_{false};
+    std::atomic<bool> done_{false};
+    folly::exception_wrapper error_;
+
+    // items emitted since the last upstream replenish, only touched while
+    // holding wip_
+    size_t consumed_{0};
+  };
+
+  const size_t bufferSize_;
+  const int64_t replenishThreshold_;
+  const size_t quorum_;
+  Copy copy_;
+
+  // read without locking, replaced under writeMutex_
+  std::shared_ptr<const SubscriptionsVector> subscriptions_;
+  std::mutex writeMutex_;
+  bool done_{false};
+  folly::exception_wrapper error_;
+
+  // items requested from upstream but not received yet
+  std::atomic<int64_t> outstanding_{0};
+  std::mutex requestMutex_;
+  std::shared_ptr<Subscription> upstream_;
+  bool upstreamTerminated_{false};
+  std::vector<size_t> freeSlots_;
+};
+
+} // namespace flowable
+} // namespace yarpl
@@ -0,0 +1,215 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yarpl/flowable/MulticastProcessor.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "yarpl/Flowable.h"
+#include "yarpl/flowable/TestSubscriber.h"
+
+using namespace yarpl;
+using namespace yarpl::flowable;
+
+TEST(MulticastProcessorTest, OnNextMultipleSubscribersTest) {
+  auto mp = MulticastProcessor<int64_t>::create(4);
+
+  auto subscriber1 = std::make_shared<TestSubscriber<int64_t>>();
+  mp->subscribe(subscriber1);
+  auto subscriber2 = std::make_shared<TestSubscriber<int64_t>>();
+  mp->subscribe(subscriber2);
+
+  Flowable<>::range(1, 10)->subscribe(mp);
+
+  EXPECT_EQ(subscriber1->values().size(), 10ULL);
+  EXPECT_EQ(subscriber2->values().size(), 10ULL);
+  EXPECT_TRUE(subscriber1->isComplete());
+  EXPECT_TRUE(subscriber2->isComplete());
+}
+
+TEST(MulticastProcessorTest, SlowestSubscriberPacesUpstream) {
+  auto mp = MulticastProcessor<int64_t>::create(4);
+
+  auto fast = std::make_shared<TestSubscriber<int64_t>>();
+  mp->subscribe(fast);
+  auto slow = std::make_shared<TestSubscriber<int64_t>>(1);
+  mp->subscribe(slow);
+
+  Flowable<>::range(0, 100)->subscribe(mp);
+
+  // the slow subscriber got one item and has a full buffer
+  EXPECT_EQ(slow->values(), std::vector<int64_t>({0}));
+  EXPECT_EQ(fast->values(), std::vector<int64_t>({0, 1, 2, 3, 4}));
+
+  slow->request(4);
+  EXPECT_EQ(slow->values(), std::vector<int64_t>({0, 1, 2, 3, 4}));
+  EXPECT_EQ(fast->values().size(), 9ULL);
+  EXPECT_FALSE(fast->isComplete());
+
+  slow->request(credits::kNoFlowControl);
+  EXPECT_EQ(slow->values().size(), 100ULL);
+  EXPECT_EQ(fast->values().size(), 100ULL);
+  EXPECT_TRUE(slow->isComplete());
+  EXPECT_TRUE(fast->isComplete());
+}
+
+TEST(MulticastProcessorTest, QuorumTerminatesLaggingSubscriber) {
+  auto mp = MulticastProcessor<int64_t>::create(4, 1);
+
+  auto fast = std::make_shared<TestSubscriber<int64_t>>();
+  mp->subscribe(fast);
+  auto slow = std::make_shared<TestSubscriber<int64_t>>(1);
+  mp->subscribe(slow);
+
+  Flowable<>::range(0, 100)->subscribe(mp);
+
+  EXPECT_EQ(fast->values().size(), 100ULL);
+  EXPECT_TRUE(fast->isComplete());
+
+  EXPECT_EQ(slow->values(), std::vector<int64_t>({0}));
+  EXPECT_FALSE(slow->isError());
+
+  // buffered items are delivered before the error
+  slow->request(credits::kNoFlowControl);
+  EXPECT_EQ(slow->values(), std::vector<int64_t>({0, 1, 2, 3, 4}));
+  EXPECT_TRUE(slow->isError());
+  EXPECT_EQ(
+      slow->exceptionWrapper().type(), typeid(MissingBackpressureException));
+}
+
+TEST(MulticastProcessorTest, CancelUnblocksUpstream) {
+  auto mp = MulticastProcessor<int64_t>::create(4);
+
+  auto fast = std::make_shared<TestSubscriber<int64_t>>();
+  mp->subscribe(fast);
+  auto slow = std::make_shared<TestSubscriber<int64_t>>(0);
+  mp->subscribe(slow);
+
+  Flowable<>::range(0, 100)->subscribe(mp);
+  EXPECT_EQ(fast->values().size(), 4ULL);
+
+  slow->cancel();
+  EXPECT_EQ(fast->values().size(), 100ULL);
+  EXPECT_TRUE(fast->isComplete());
+  EXPECT_TRUE(slow->values().empty());
+}
+
+TEST(MulticastProcessorTest, CompleteAfterBufferedItems) {
+  auto mp = MulticastProcessor<int64_t>::create(8);
+
+  auto subscriber = std::make_shared<TestSubscriber<int64_t>>(0);
+  mp->subscribe(subscriber);
+
+  Flowable<>::range(0, 3)->subscribe(mp);
+  EXPECT_FALSE(subscriber->isComplete());
+
+  subscriber->request(3);
+  EXPECT_EQ(subscriber->values(), std::vector<int64_t>({0, 1, 2}));
+  EXPECT_TRUE(subscriber->isComplete());
+
+  auto late = std::make_shared<TestSubscriber<int64_t>>();
+  mp->subscribe(late);
+  EXPECT_TRUE(late->values().empty());
+  EXPECT_TRUE(late->isComplete());
+}
+
+TEST(MulticastProcessorTest, OnErrorTest) {
+  auto mp = MulticastProcessor<int>::create();
+
+  auto subscriber = std::make_shared<TestSubscriber<int>>();
+  mp->subscribe(subscriber);
+
+  Flowable<int>::error(std::runtime_error("error!"))->subscribe(mp);
+
+  EXPECT_TRUE(subscriber->isError());
+  EXPECT_EQ(subscriber->getErrorMsg(), "error!");
+
+  auto late = std::make_shared<TestSubscriber<int>>();
+  mp->subscribe(late);
+  EXPECT_TRUE(late->isError());
+}
+
+TEST(MulticastProcessorTest, OnMultipleSubscribersMultithreadedTest) {
+  auto mp = MulticastProcessor<int64_t>::create(16);
+  constexpr size_t kSubscribers = 32;
+  constexpr int64_t kItems = 10000;
+
+  std::vector<std::shared_ptr<TestSubscriber<int64_t>>> subscribers;
+  for (size_t i = 0; i < kSubscribers; i++) {
+    subscribers.push_back(std::make_shared<TestSubscriber<int64_t>>(0));
+    mp->subscribe(subscribers.back());
+  }
+
+  std::vector<std::thread> threads;
+  for (auto& subscriber : subscribers) {
+    threads.push_back(std::thread([subscriber] {
+      for (int64_t i = 0; i < kItems; i += 10) {
+        subscriber->request(10);
+      }
+      subscriber->awaitTerminalEvent(std::chrono::seconds(5));
+    }));
+  }
+
+  Flowable<>::range(0, kItems)->subscribe(mp);
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (auto& subscriber : subscribers) {
+    EXPECT_EQ(subscriber->values().size(), static_cast<size_t>(kItems));
+    EXPECT_TRUE(subscriber->isComplete());
+  }
+}
+
+TEST(MulticastProcessorTest, ConcurrentRequestsAndOnNext) {
+  auto mp = MulticastProcessor<int64_t>::create(8);
+  constexpr int64_t kItems = 100000;
+
+  auto subscriber = std::make_shared<TestSubscriber<int64_t>>(0);
+  mp->subscribe(subscriber);
+
+  // Two threads drain the subscriber's buffer on request() while the
+  // upstream drains it on onNext() from a third one.
+  std::atomic<bool> go{false};
+  std::vector<std::thread> requesters;
+  for (int t = 0; t < 2; ++t) {
+    requesters.emplace_back([&] {
+      while (!go) {
+      }
+      for (int64_t i = 0; i < kItems / 2; ++i) {
+        subscriber->request(1);
+      }
+    });
+  }
+  std::thread upstream([&] {
+    while (!go) {
+    }
+    Flowable<>::range(0, kItems)->subscribe(mp);
+  });
+
+  go = true;
+  for (auto& thread : requesters) {
+    thread.join();
+  }
+  upstream.join();
+  subscriber->awaitTerminalEvent(std::chrono::seconds(5));
+
+  ASSERT_EQ(subscriber->values().size(), static_cast<size_t>(kItems));
+  for (int64_t i = 0; i < kItems; ++i) {
+    ASSERT_EQ(i, subscriber->values()[i]);
+  }
+  EXPECT_TRUE(subscriber->isComplete());
+}